@@ -0,0 +1,175 @@
+/**
+ * @file bench_broadcast_fanout.c
+ * @brief Benchmark of the fan-out latency of the broadcast ring.
+ *
+ * For 1 to BROADCAST_MAX_READERS subscriber processes, publishes BENCH_FRAMES commands one
+ * every BENCH_PERIOD_US and measures, in every subscriber, the time from the publication of
+ * each command to its read after waking up on the ring. Prints the median latency of the
+ * median subscriber, the 99th percentile of the slowest one, the worst latency and the lost
+ * commands.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "broadcast_ring.h"
+
+#define BENCH_SHM "/shm_aeb_bench_broadcast"
+#define BENCH_CAPACITY 1024
+#define BENCH_FRAMES 2000
+#define BENCH_PERIOD_US 200
+#define BENCH_TIMEOUT_MS 2000
+
+typedef struct
+{
+    uint64_t p50_ns;
+    uint64_t p99_ns;
+    uint64_t max_ns;
+    uint64_t received;
+    uint64_t lost;
+} bench_result;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Subscriber process: receives the commands and sends its latencies to the parent.
+ */
+static void run_subscriber(int ready_fd, int result_fd)
+{
+    static uint64_t latencies[BENCH_FRAMES];
+    bench_result result = {0};
+    broadcast_ring ring;
+    broadcast_reader reader;
+    can_msg frame;
+    uint64_t published_ns;
+
+    if (broadcast_attach(&ring, BENCH_SHM) != 0 || broadcast_subscribe(&ring, &reader) != 0)
+    {
+        exit(EXIT_FAILURE);
+    }
+    char ready = 1;
+    write(ready_fd, &ready, 1);
+
+    while (result.received < BENCH_FRAMES && broadcast_wait(&reader, BENCH_TIMEOUT_MS) == 0)
+    {
+        while (result.received < BENCH_FRAMES && broadcast_read(&reader, &frame, &published_ns) == 0)
+        {
+            latencies[result.received++] = now_ns() - published_ns;
+        }
+    }
+
+    if (result.received > 0)
+    {
+        qsort(latencies, result.received, sizeof(latencies[0]), compare_u64);
+        result.p50_ns = latencies[result.received / 2];
+        result.p99_ns = latencies[result.received * 99 / 100];
+        result.max_ns = latencies[result.received - 1];
+    }
+    result.lost = atomic_load(&reader.cursor->lost);
+    write(result_fd, &result, sizeof(result));
+    broadcast_unsubscribe(&reader);
+    broadcast_detach(&ring);
+    exit(EXIT_SUCCESS);
+}
+
+/**
+ * @brief Runs one round with `subscribers` processes.
+ *
+ * @return 0 if every subscriber received every command, -1 otherwise.
+ */
+static int run_round(int subscribers)
+{
+    int ready_pipe[2], result_pipe[2];
+    pid_t pids[BROADCAST_MAX_READERS];
+    broadcast_ring ring;
+
+    if (broadcast_create(BENCH_SHM, BENCH_CAPACITY) != 0 || broadcast_attach(&ring, BENCH_SHM) != 0 ||
+        pipe(ready_pipe) != 0 || pipe(result_pipe) != 0)
+    {
+        fprintf(stderr, "Benchmark: it wasn't possible to create the broadcast ring\n");
+        exit(EXIT_FAILURE);
+    }
+    fflush(stdout); // Not inherited by the subscribers
+    for (int i = 0; i < subscribers; i++)
+    {
+        pids[i] = fork();
+        if (pids[i] == 0)
+        {
+            run_subscriber(ready_pipe[1], result_pipe[1]);
+        }
+    }
+    for (int i = 0; i < subscribers; i++)
+    {
+        char ready;
+        read(ready_pipe[0], &ready, 1);
+    }
+
+    can_msg command = {.identifier = ID_AEB_S, .dataFrame = BASE_DATA_FRAME};
+    struct timespec period = {.tv_sec = 0, .tv_nsec = BENCH_PERIOD_US * 1000L};
+    for (unsigned int i = 0; i < BENCH_FRAMES; i++)
+    {
+        command.dataFrame[0] = i & 1;
+        broadcast_publish(&ring, &command);
+        nanosleep(&period, NULL);
+    }
+
+    uint64_t p50[BROADCAST_MAX_READERS], p99[BROADCAST_MAX_READERS], max_ns = 0, lost = 0;
+    int complete = 1;
+    for (int i = 0; i < subscribers; i++)
+    {
+        bench_result result = {0};
+        if (read(result_pipe[0], &result, sizeof(result)) != sizeof(result) || result.received != BENCH_FRAMES)
+        {
+            complete = 0;
+        }
+        p50[i] = result.p50_ns;
+        p99[i] = result.p99_ns;
+        max_ns = result.max_ns > max_ns ? result.max_ns : max_ns;
+        lost += result.lost;
+    }
+    for (int i = 0; i < subscribers; i++)
+    {
+        waitpid(pids[i], NULL, 0);
+    }
+    qsort(p50, subscribers, sizeof(p50[0]), compare_u64);
+    qsort(p99, subscribers, sizeof(p99[0]), compare_u64);
+
+    printf("  %2d subscribers: p50 %7.1f us | p99 %7.1f us | max %8.1f us | lost %llu\n", subscribers,
+           p50[subscribers / 2] / 1e3, p99[subscribers - 1] / 1e3, max_ns / 1e3, (unsigned long long)lost);
+
+    broadcast_detach(&ring);
+    broadcast_destroy(BENCH_SHM);
+    close(ready_pipe[0]);
+    close(ready_pipe[1]);
+    close(result_pipe[0]);
+    close(result_pipe[1]);
+    return complete ? 0 : -1;
+}
+
+int main()
+{
+    int status = EXIT_SUCCESS;
+
+    printf("Broadcast ring fan-out, %d commands every %d us:\n", BENCH_FRAMES, BENCH_PERIOD_US);
+    for (int subscribers = 1; subscribers <= BROADCAST_MAX_READERS; subscribers *= 2)
+    {
+        if (run_round(subscribers) != 0)
+        {
+            status = EXIT_FAILURE;
+        }
+    }
+    return status;
+}
@@ -0,0 +1,116 @@
+/**
+ * @file bench_calibration_map.c
+ * @brief Benchmark of the threshold lookup of the controller decision with calibration maps.
+ *
+ * Decides BENCH_DECISIONS times, as getAEBState does, whether a TTC is below the alarm and
+ * braking thresholds, with the thresholds given as:
+ * - scalars (no map);
+ * - 1D maps by speed with CALIBRATION_MAP_POINTS breakpoints;
+ * - 2D maps by speed and relative acceleration with CALIBRATION_MAP_POINTS breakpoints each.
+ *
+ * The speeds, accelerations and TTCs are random and cover the breakpoints, so the segment found
+ * changes from one decision to the next. Prints the time per decision and the time the maps add.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "calibration.h"
+
+#define BENCH_DECISIONS 20000000
+#define BENCH_INPUTS 4096 // Power of two
+
+static double speeds[BENCH_INPUTS], accels[BENCH_INPUTS], ttcs[BENCH_INPUTS];
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * @brief Runs the decisions and returns the time per decision in nanoseconds.
+ */
+static double bench_decisions(const aeb_calibration *calibration, unsigned long *states)
+{
+    unsigned long count = 0;
+    double start_ns = now_ns();
+    for (unsigned int i = 0; i < BENCH_DECISIONS; i++)
+    {
+        unsigned int input = i & (BENCH_INPUTS - 1);
+        double alarm = calibration_threshold(&calibration->alarm_map, calibration->threshold_alarm, speeds[input],
+                                             accels[input]);
+        double braking = calibration_threshold(&calibration->braking_map, calibration->threshold_braking,
+                                               speeds[input], accels[input]);
+        count += (ttcs[input] < alarm) + (ttcs[input] < braking);
+    }
+    double elapsed_ns = now_ns() - start_ns;
+    *states = count; // Keeps the decisions from being optimized away
+    return elapsed_ns / BENCH_DECISIONS;
+}
+
+static void set_or_exit(aeb_calibration *calibration, const char *line)
+{
+    if (calibration_set(calibration, line) != 0)
+    {
+        fprintf(stderr, "Invalid calibration line: %s\n", line);
+        exit(EXIT_FAILURE);
+    }
+}
+
+int main()
+{
+    srand(42);
+    for (int i = 0; i < BENCH_INPUTS; i++)
+    {
+        speeds[i] = rand() % 9000 / 100.0;       // 0 to 90 km/h
+        accels[i] = -10.0 + rand() % 1200 / 100.0; // -10 to 2 m/s^2
+        ttcs[i] = rand() % 400 / 100.0;          // 0 to 4 s
+    }
+
+    aeb_calibration scalar = CALIBRATION_DEFAULTS;
+
+    aeb_calibration by_speed = scalar;
+    set_or_exit(&by_speed, "threshold_alarm_map.speed = 5 10 20 30 40 50 60 70");
+    set_or_exit(&by_speed, "threshold_alarm_map.value = 1.4 1.6 1.8 2.0 2.2 2.4 2.6 2.8");
+    set_or_exit(&by_speed, "threshold_braking_map.speed = 5 10 20 30 40 50 60 70");
+    set_or_exit(&by_speed, "threshold_braking_map.value = 0.6 0.7 0.8 0.9 1.0 1.1 1.2 1.3");
+
+    aeb_calibration by_speed_accel = scalar;
+    char line[1024];
+    for (int map = 0; map < 2; map++)
+    {
+        const char *name = map == 0 ? "threshold_alarm_map" : "threshold_braking_map";
+        snprintf(line, sizeof(line), "%s.speed = 5 10 20 30 40 50 60 70", name);
+        set_or_exit(&by_speed_accel, line);
+        snprintf(line, sizeof(line), "%s.accel = -8 -6 -4 -3 -2 -1 0 1", name);
+        set_or_exit(&by_speed_accel, line);
+        int length = snprintf(line, sizeof(line), "%s.value =", name);
+        for (int i = 0; i < CALIBRATION_MAP_POINTS; i++)
+        {
+            for (int j = 0; j < CALIBRATION_MAP_POINTS; j++)
+            {
+                double value = (map == 0 ? 1.4 : 0.6) + 0.15 * i + 0.05 * (CALIBRATION_MAP_POINTS - 1 - j);
+                length += snprintf(line + length, sizeof(line) - length, " %.2f", value);
+            }
+        }
+        set_or_exit(&by_speed_accel, line);
+    }
+    if (calibration_prepare(&by_speed) != 0 || calibration_prepare(&by_speed_accel) != 0)
+    {
+        exit(EXIT_FAILURE);
+    }
+
+    unsigned long states;
+    printf("Threshold lookup, %d decisions (alarm and braking thresholds):\n", BENCH_DECISIONS);
+    double scalar_ns = bench_decisions(&scalar, &states);
+    printf("  scalar      : %5.2f ns/decision (%lu thresholds crossed)\n", scalar_ns, states);
+    double speed_ns = bench_decisions(&by_speed, &states);
+    printf("  1D %d points : %5.2f ns/decision (+%.2f ns, %lu thresholds crossed)\n", CALIBRATION_MAP_POINTS, speed_ns,
+           speed_ns - scalar_ns, states);
+    double speed_accel_ns = bench_decisions(&by_speed_accel, &states);
+    printf("  2D %dx%d     : %5.2f ns/decision (+%.2f ns, %lu thresholds crossed)\n", CALIBRATION_MAP_POINTS,
+           CALIBRATION_MAP_POINTS, speed_accel_ns, speed_accel_ns - scalar_ns, states);
+    return EXIT_SUCCESS;
+}
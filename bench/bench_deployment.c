@@ -0,0 +1,274 @@
+/**
+ * @file bench_deployment.c
+ * @brief Benchmark of the multi-process and single-process deployments.
+ *
+ * Runs the frame path of the system, sensors -> controller -> actuators, in both layouts:
+ * - processes: three processes connected by the POSIX message queues of mq_utils.c, as run by
+ *   main_bin;
+ * - threads: three threads of one process connected by the SPSC queues that mq_inproc.c uses
+ *   in aeb_all_bin.
+ *
+ * The sensors stage sends BENCH_FRAMES frames, one every BENCH_PERIOD_US, each carrying its
+ * send time; the controller forwards them and the actuators measure the end-to-end latency.
+ * The controller and the actuators poll their queue and sleep BENCH_POLL_US when it is empty,
+ * as the modules do. Each stage is pinned to CPU (stage modulo online CPUs). Prints the median
+ * and 99th percentile latency and the CPU time and context switches of the run per frame.
+ */
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include "mq_utils.h"
+#include "spsc_queue.h"
+
+#define BENCH_FRAMES 5000
+#define BENCH_PERIOD_US 1000 // 1 kHz, as the sensors with -r 1000
+#define BENCH_POLL_US 50
+#define BENCH_MQ_SENSORS "/mq_aeb_bench_sensors"
+#define BENCH_MQ_ACTUATORS "/mq_aeb_bench_actuators"
+#define BENCH_QUEUE_CAPACITY 16
+
+typedef enum
+{
+    STAGE_SENSORS,
+    STAGE_CONTROLLER,
+    STAGE_ACTUATORS
+} bench_stage;
+
+// Transport of one layout: receive from the stage's input, send to its output
+typedef struct
+{
+    int (*receive)(void *in, can_msg *frame);
+    int (*send)(void *out, can_msg *frame);
+    void *in;
+    void *out;
+} bench_link;
+
+static uint64_t latencies[BENCH_FRAMES];
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void pin_stage(bench_stage stage)
+{
+    cpu_set_t cpu;
+    CPU_ZERO(&cpu);
+    CPU_SET(stage % sysconf(_SC_NPROCESSORS_ONLN), &cpu);
+    sched_setaffinity(0, sizeof(cpu), &cpu); // Calling thread
+}
+
+static void poll_receive(const bench_link *link, can_msg *frame)
+{
+    struct timespec idle = {.tv_sec = 0, .tv_nsec = BENCH_POLL_US * 1000L};
+    while (link->receive(link->in, frame) != 0)
+    {
+        nanosleep(&idle, NULL);
+    }
+}
+
+/**
+ * @brief Runs one stage of the frame path.
+ */
+static void run_stage(bench_stage stage, const bench_link *link)
+{
+    can_msg frame = {.identifier = ID_SPEED_S, .dataFrame = BASE_DATA_FRAME};
+    struct timespec period = {.tv_sec = 0, .tv_nsec = BENCH_PERIOD_US * 1000L};
+
+    pin_stage(stage);
+    for (unsigned int i = 0; i < BENCH_FRAMES; i++)
+    {
+        uint64_t sent_ns;
+        switch (stage)
+        {
+        case STAGE_SENSORS:
+            sent_ns = now_ns();
+            memcpy(frame.dataFrame, &sent_ns, sizeof(sent_ns));
+            while (link->send(link->out, &frame) != 0) // Full: the controller is behind
+            {
+                sched_yield();
+            }
+            nanosleep(&period, NULL);
+            break;
+        case STAGE_CONTROLLER:
+            poll_receive(link, &frame);
+            while (link->send(link->out, &frame) != 0)
+            {
+                sched_yield();
+            }
+            break;
+        case STAGE_ACTUATORS:
+            poll_receive(link, &frame);
+            memcpy(&sent_ns, frame.dataFrame, sizeof(sent_ns));
+            latencies[i] = now_ns() - sent_ns;
+            break;
+        }
+    }
+}
+
+static int mq_receive_frame(void *in, can_msg *frame)
+{
+    return read_mq(*(mqd_t *)in, frame);
+}
+
+static int mq_send_frame(void *out, can_msg *frame)
+{
+    return write_mq(*(mqd_t *)out, frame) == 0 ? 0 : -1;
+}
+
+static int spsc_receive_frame(void *in, can_msg *frame)
+{
+    return spsc_pop(in, frame);
+}
+
+static int spsc_send_frame(void *out, can_msg *frame)
+{
+    return spsc_push(out, frame);
+}
+
+/**
+ * @brief Prints the latency and CPU use of one layout.
+ */
+static void print_result(const char *layout, const struct rusage *usage, double wall_s)
+{
+    qsort(latencies, BENCH_FRAMES, sizeof(latencies[0]), compare_u64);
+    double cpu_s = usage->ru_utime.tv_sec + usage->ru_utime.tv_usec / 1e6 + usage->ru_stime.tv_sec +
+                   usage->ru_stime.tv_usec / 1e6;
+    printf("  %-9s: p50 %6.1f us | p99 %7.1f us | CPU %5.2f us/frame (%4.1f%% of the run) | %4.2f ctx switches/frame\n",
+           layout, latencies[BENCH_FRAMES / 2] / 1e3, latencies[BENCH_FRAMES * 99 / 100] / 1e3,
+           cpu_s * 1e6 / BENCH_FRAMES, cpu_s * 100 / wall_s,
+           (double)(usage->ru_nvcsw + usage->ru_nivcsw) / BENCH_FRAMES);
+}
+
+static void add_usage(struct rusage *total, const struct rusage *usage)
+{
+    timeradd(&total->ru_utime, &usage->ru_utime, &total->ru_utime);
+    timeradd(&total->ru_stime, &usage->ru_stime, &total->ru_stime);
+    total->ru_nvcsw += usage->ru_nvcsw;
+    total->ru_nivcsw += usage->ru_nivcsw;
+}
+
+/**
+ * @brief Multi-process layout: the actuators stage runs in this process and reads the latencies.
+ */
+static void bench_processes(void)
+{
+    mqd_t sensors_mq = create_mq(BENCH_MQ_SENSORS);
+    mqd_t actuators_mq = create_mq(BENCH_MQ_ACTUATORS);
+    bench_link links[3] = {
+        {mq_receive_frame, mq_send_frame, NULL, &sensors_mq},
+        {mq_receive_frame, mq_send_frame, &sensors_mq, &actuators_mq},
+        {mq_receive_frame, mq_send_frame, &actuators_mq, NULL}};
+    struct rusage before, after, children;
+    pid_t pids[2];
+
+    fflush(stdout); // Not inherited by the children
+    getrusage(RUSAGE_SELF, &before);
+    uint64_t start_ns = now_ns();
+    for (int stage = STAGE_SENSORS; stage <= STAGE_CONTROLLER; stage++)
+    {
+        pids[stage] = fork();
+        if (pids[stage] == 0)
+        {
+            run_stage(stage, &links[stage]);
+            exit(EXIT_SUCCESS);
+        }
+    }
+    run_stage(STAGE_ACTUATORS, &links[STAGE_ACTUATORS]);
+    waitpid(pids[0], NULL, 0);
+    waitpid(pids[1], NULL, 0);
+    double wall_s = (now_ns() - start_ns) / 1e9;
+
+    getrusage(RUSAGE_SELF, &after);
+    getrusage(RUSAGE_CHILDREN, &children);
+    timersub(&after.ru_utime, &before.ru_utime, &after.ru_utime);
+    timersub(&after.ru_stime, &before.ru_stime, &after.ru_stime);
+    after.ru_nvcsw -= before.ru_nvcsw;
+    after.ru_nivcsw -= before.ru_nivcsw;
+    add_usage(&after, &children);
+    print_result("processes", &after, wall_s);
+
+    mq_close(sensors_mq);
+    mq_close(actuators_mq);
+    mq_unlink(BENCH_MQ_SENSORS);
+    mq_unlink(BENCH_MQ_ACTUATORS);
+}
+
+typedef struct
+{
+    bench_stage stage;
+    const bench_link *link;
+} bench_thread;
+
+static void *run_stage_thread(void *arg)
+{
+    bench_thread *thread = arg;
+    run_stage(thread->stage, thread->link);
+    return NULL;
+}
+
+/**
+ * @brief Single-process layout: one thread per stage.
+ */
+static void bench_threads(void)
+{
+    spsc_queue sensors_queue, actuators_queue;
+    spsc_init(&sensors_queue, BENCH_QUEUE_CAPACITY, sizeof(can_msg));
+    spsc_init(&actuators_queue, BENCH_QUEUE_CAPACITY, sizeof(can_msg));
+    bench_link links[3] = {
+        {spsc_receive_frame, spsc_send_frame, NULL, &sensors_queue},
+        {spsc_receive_frame, spsc_send_frame, &sensors_queue, &actuators_queue},
+        {spsc_receive_frame, spsc_send_frame, &actuators_queue, NULL}};
+    bench_thread threads[3];
+    pthread_t ids[3];
+    struct rusage before, after;
+
+    getrusage(RUSAGE_SELF, &before);
+    uint64_t start_ns = now_ns();
+    for (int stage = STAGE_ACTUATORS; stage >= STAGE_SENSORS; stage--)
+    {
+        threads[stage] = (bench_thread){.stage = stage, .link = &links[stage]};
+        pthread_create(&ids[stage], NULL, run_stage_thread, &threads[stage]);
+    }
+    for (int stage = STAGE_SENSORS; stage <= STAGE_ACTUATORS; stage++)
+    {
+        pthread_join(ids[stage], NULL);
+    }
+    double wall_s = (now_ns() - start_ns) / 1e9;
+
+    getrusage(RUSAGE_SELF, &after);
+    timersub(&after.ru_utime, &before.ru_utime, &after.ru_utime);
+    timersub(&after.ru_stime, &before.ru_stime, &after.ru_stime);
+    after.ru_nvcsw -= before.ru_nvcsw;
+    after.ru_nivcsw -= before.ru_nivcsw;
+    print_result("threads", &after, wall_s);
+
+    spsc_destroy(&sensors_queue);
+    spsc_destroy(&actuators_queue);
+}
+
+int main()
+{
+    printf("Deployment, %d frames sensors -> controller -> actuators every %d us (%ld CPUs):\n",
+           BENCH_FRAMES, BENCH_PERIOD_US, sysconf(_SC_NPROCESSORS_ONLN));
+    bench_processes();
+    bench_threads();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,75 @@
+/**
+ * @file bench_flight_recorder.c
+ * @brief Benchmark of the always-on cost of the flight recorder.
+ *
+ * Records BENCH_ENTRIES frame, decision and actuators entries into a private flight
+ * recorder segment and prints the time per entry of each kind, then dumps the segment
+ * to check that the last entries are readable.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "flight_recorder.h"
+
+#define BENCH_ENTRIES 10000000UL
+#define BENCH_SHM "/shm_aeb_bench_flight_recorder"
+#define BENCH_CAPACITY 4096
+
+static double elapsed_s(const struct timespec *start, const struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int main()
+{
+    if (flight_recorder_create(BENCH_SHM, BENCH_CAPACITY) != 0 ||
+        flight_recorder_attach(BENCH_SHM, FR_SOURCE_CONTROLLER) != 0)
+    {
+        fprintf(stderr, "Benchmark: it wasn't possible to create the flight recorder\n");
+        return EXIT_FAILURE;
+    }
+
+    can_msg frame = {.identifier = ID_SPEED_S, .dataFrame = BASE_DATA_FRAME};
+    actuators_abstraction actuators = 0;
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (unsigned long i = 0; i < BENCH_ENTRIES; i++)
+    {
+        frame.dataFrame[0] = (uint8_t)i;
+        flight_recorder_frame(FR_ENTRY_FRAME_RX, &frame);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double frame_s = elapsed_s(&start, &end);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (unsigned long i = 0; i < BENCH_ENTRIES; i++)
+    {
+        flight_recorder_decision(i & 3, (double)i * 1e-6);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double decision_s = elapsed_s(&start, &end);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (unsigned long i = 0; i < BENCH_ENTRIES; i++)
+    {
+        actuators = (i & 1) ? ACTUATOR_BIT_ALARM_LED : 0;
+        flight_recorder_actuators(actuators);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double actuators_s = elapsed_s(&start, &end);
+
+    flight_recorder_detach();
+    FILE *sink = fopen("/dev/null", "w");
+    long dumped = flight_recorder_dump(BENCH_SHM, sink);
+    fclose(sink);
+    flight_recorder_destroy(BENCH_SHM);
+
+    printf("Flight recorder, %lu entries of each kind:\n", BENCH_ENTRIES);
+    printf("  frame:     %.1f ns/entry\n", frame_s * 1e9 / BENCH_ENTRIES);
+    printf("  decision:  %.1f ns/entry\n", decision_s * 1e9 / BENCH_ENTRIES);
+    printf("  actuators: %.1f ns/entry\n", actuators_s * 1e9 / BENCH_ENTRIES);
+    printf("  dumped:    %ld of %d entries\n", dumped, BENCH_CAPACITY);
+    return dumped == BENCH_CAPACITY ? EXIT_SUCCESS : EXIT_FAILURE;
+}
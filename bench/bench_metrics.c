@@ -0,0 +1,87 @@
+/**
+ * @file bench_metrics.c
+ * @brief Benchmark of the cost of the metrics for the publishing threads and for aeb_stat.
+ *
+ * Registers a block in a private metrics segment and prints the time per update of:
+ * - metrics_add on the registered block (single writer: load and store);
+ * - metrics_add on an unregistered handle (module started without main_bin);
+ * - an atomic fetch-and-add on the same counter, what a counter shared by several writers costs;
+ * - metrics_now_ns, read twice per controller cycle for its cycle time.
+ * Then prints the time aeb_stat takes to copy one block.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "metrics.h"
+
+#define BENCH_UPDATES 100000000UL
+#define BENCH_READS 1000000UL
+#define BENCH_SHM "/shm_aeb_bench_metrics"
+
+static const metric_desc bench_desc[] = {{"frames", METRIC_COUNTER}, {"depth", METRIC_GAUGE}};
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * @brief Adds BENCH_UPDATES times to the first metric and returns the time per update in nanoseconds.
+ */
+static double bench_add(metrics *m)
+{
+    double start_ns = now_ns();
+    for (unsigned long i = 0; i < BENCH_UPDATES; i++)
+    {
+        metrics_add(m, 0, 1);
+    }
+    return (now_ns() - start_ns) / BENCH_UPDATES;
+}
+
+int main()
+{
+    metrics registered, unregistered = {0};
+    if (metrics_create(BENCH_SHM) != 0 ||
+        metrics_register(&registered, BENCH_SHM, "bench", bench_desc, sizeof(bench_desc) / sizeof(bench_desc[0])) != 0)
+    {
+        fprintf(stderr, "Benchmark: it wasn't possible to create the metrics segment\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("Metrics, %lu updates:\n", BENCH_UPDATES);
+    printf("  metrics_add, registered   : %5.2f ns/update\n", bench_add(&registered));
+    printf("  metrics_add, unregistered : %5.2f ns/update\n", bench_add(&unregistered));
+
+    double start_ns = now_ns();
+    for (unsigned long i = 0; i < BENCH_UPDATES; i++)
+    {
+        atomic_fetch_add_explicit(&registered.block->value[0], 1, memory_order_relaxed);
+    }
+    printf("  atomic fetch-and-add      : %5.2f ns/update\n", (now_ns() - start_ns) / BENCH_UPDATES);
+
+    start_ns = now_ns();
+    for (unsigned long i = 0; i < BENCH_READS; i++)
+    {
+        metrics_now_ns();
+    }
+    printf("  metrics_now_ns            : %5.2f ns/call\n", (now_ns() - start_ns) / BENCH_READS);
+
+    const metrics_header *header = metrics_open(BENCH_SHM);
+    metrics_sample sample;
+    unsigned long copied = 0;
+    start_ns = now_ns();
+    for (unsigned long i = 0; i < BENCH_READS; i++)
+    {
+        copied += metrics_read(header, 0, &sample);
+    }
+    printf("  metrics_read (aeb_stat)   : %5.2f ns/block (%lu copies, frames=%llu)\n",
+           (now_ns() - start_ns) / BENCH_READS, copied, (unsigned long long)sample.value[0]);
+
+    metrics_close(header);
+    metrics_release(&registered);
+    metrics_destroy(BENCH_SHM);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,93 @@
+/**
+ * @file bench_sensors_batch.c
+ * @brief Benchmark of the batch CAN encoders against the scalar conv2CAN functions.
+ *
+ * Encodes BENCH_ROWS random rows into Speed and Obstacle frames with both paths, checks
+ * that the frames are identical and prints the time per row of each path.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sensors.h"
+
+#define BENCH_ROWS 10000000UL
+#define BENCH_POOL_ROWS 1000000UL // Distinct random rows, reused to reach BENCH_ROWS
+#define BENCH_CHUNK_ROWS 65536UL  // Rows encoded per call, as a trace generator would do
+
+can_msg conv2CANVelocityData(bool vehicle_direction, double relative_velocity, double relative_acceleration);
+can_msg conv2CANObstacleData(bool has_obstacle, double obstacle_distance);
+
+static double elapsed_s(const struct timespec *start, const struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static double random_between(double min, double max)
+{
+    return min + (max - min) * ((double)rand() / RAND_MAX);
+}
+
+int main()
+{
+    sensors_input_data *pool = malloc(BENCH_POOL_ROWS * sizeof(sensors_input_data));
+    can_msg *scalar_out = malloc(2 * BENCH_CHUNK_ROWS * sizeof(can_msg));
+    can_msg *batch_out = malloc(2 * BENCH_CHUNK_ROWS * sizeof(can_msg));
+    if (pool == NULL || scalar_out == NULL || batch_out == NULL)
+    {
+        perror("Benchmark: it wasn't possible to allocate the buffers");
+        return EXIT_FAILURE;
+    }
+
+    srand(42);
+    for (size_t i = 0; i < BENCH_POOL_ROWS; i++)
+    {
+        pool[i].relative_velocity = random_between(0.0, MAX_SPEED_S);
+        pool[i].has_obstacle = rand() % 2;
+        pool[i].obstacle_distance = random_between(0.0, MAX_OBSTACLE_S);
+        pool[i].reverse_enabled = rand() % 2;
+        pool[i].relative_acceleration = random_between(MIN_ACCELERATION_S, MAX_ACCELERATION_S);
+    }
+
+    struct timespec start, end;
+    double scalar_s = 0.0, batch_s = 0.0;
+    size_t mismatches = 0;
+
+    for (size_t done = 0; done < BENCH_ROWS; done += BENCH_CHUNK_ROWS)
+    {
+        size_t count = BENCH_ROWS - done < BENCH_CHUNK_ROWS ? BENCH_ROWS - done : BENCH_CHUNK_ROWS;
+        const sensors_input_data *rows = &pool[done % (BENCH_POOL_ROWS - BENCH_CHUNK_ROWS)];
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (size_t i = 0; i < count; i++)
+        {
+            scalar_out[i] = conv2CANVelocityData(rows[i].reverse_enabled, rows[i].relative_velocity,
+                                                 rows[i].relative_acceleration);
+            scalar_out[count + i] = conv2CANObstacleData(rows[i].has_obstacle, rows[i].obstacle_distance);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        scalar_s += elapsed_s(&start, &end);
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        conv2CANVelocityDataBatch(rows, count, batch_out);
+        conv2CANObstacleDataBatch(rows, count, batch_out + count);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        batch_s += elapsed_s(&start, &end);
+
+        for (size_t i = 0; i < 2 * count; i++)
+        {
+            mismatches += memcmp(&scalar_out[i], &batch_out[i], sizeof(can_msg)) != 0;
+        }
+    }
+
+    printf("Rows encoded: %lu (Speed + Obstacle frames)\n", BENCH_ROWS);
+    printf("Scalar: %8.3f s  %6.2f ns/row\n", scalar_s, scalar_s * 1e9 / BENCH_ROWS);
+    printf("Batch:  %8.3f s  %6.2f ns/row  (%.2fx)\n", batch_s, batch_s * 1e9 / BENCH_ROWS, scalar_s / batch_s);
+    printf("Mismatching frames: %zu\n", mismatches);
+
+    free(pool);
+    free(scalar_out);
+    free(batch_out);
+    return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,154 @@
+/**
+ * @file bench_startup.c
+ * @brief Benchmark of the startup time of the separate binaries and of the multicall binary.
+ *
+ * Starts the programs run by main_bin (sensors, controller, actuators) BENCH_STARTS times each,
+ * as main_bin does (posix_spawn), from:
+ * - separate: their own dynamically linked binaries, bin/<program>_bin;
+ * - multicall: bin/aeb, dynamically linked, dispatching on argv[0];
+ * - static: bin/aeb_static, the same binary statically linked.
+ *
+ * Each program is given an invalid option, so it exits as soon as main has parsed its options:
+ * the time from posix_spawn to waitpid is the cost of starting the process (exec, dynamic
+ * linking, relocations, page faults) and of main_bin waiting for it. Prints the median and mean
+ * of that time, the page faults per start and the size of the binaries of each variant.
+ *
+ * Run from the repository root after `make` and `make multicall`.
+ */
+
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#define BENCH_STARTS 300
+#define BENCH_PROGRAMS 3
+
+extern char **environ;
+
+static char *programs[BENCH_PROGRAMS] = {"sensors_bin", "aeb_controller_bin", "actuators_bin"};
+
+// Every binary of the system when built separately
+static const char *separate_binaries[] = {"bin/main_bin", "bin/sensors_bin", "bin/aeb_controller_bin",
+                                          "bin/actuators_bin", "bin/actuator_sub_bin", "bin/aeb_loop_bin",
+                                          "bin/aeb_logcat", "bin/aeb_logq", "bin/aeb_sketch", "bin/aeb_flightrec",
+                                          "bin/aeb_calibrate", "bin/aeb_stat"};
+
+typedef struct
+{
+    const char *name;
+    const char *multicall; // Multicall binary, or NULL for bin/<program>
+    const char *const *binaries;
+    size_t binary_count;
+} bench_variant;
+
+static const char *multicall_binary[] = {"bin/aeb"};
+static const char *static_binary[] = {"bin/aeb_static"};
+
+static const bench_variant variants[] = {
+    {"separate", NULL, separate_binaries, sizeof(separate_binaries) / sizeof(separate_binaries[0])},
+    {"multicall", "bin/aeb", multicall_binary, 1},
+    {"static", "bin/aeb_static", static_binary, 1}};
+
+static double startups_us[BENCH_PROGRAMS * BENCH_STARTS];
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Starts a program with an invalid option and waits for it to exit.
+ *
+ * @return Time from posix_spawn to waitpid in microseconds.
+ */
+static double start_program(const char *path, char *program, posix_spawn_file_actions_t *actions)
+{
+    char *argv[] = {program, "-Z", NULL};
+    pid_t pid;
+
+    double start_us = now_us();
+    int error = posix_spawn(&pid, path, actions, NULL, argv, environ);
+    if (error != 0)
+    {
+        fprintf(stderr, "Error executing %s: %s (run make and make multicall first)\n", path, strerror(error));
+        exit(EXIT_FAILURE);
+    }
+    waitpid(pid, NULL, 0);
+    return now_us() - start_us;
+}
+
+static void bench_variant_startup(const bench_variant *variant, posix_spawn_file_actions_t *actions)
+{
+    char path[64];
+    struct rusage before, after;
+    long long bytes = 0;
+    size_t count = 0;
+
+    for (size_t i = 0; i < variant->binary_count; i++)
+    {
+        struct stat info;
+        if (stat(variant->binaries[i], &info) == 0)
+        {
+            bytes += info.st_size;
+        }
+    }
+
+    getrusage(RUSAGE_CHILDREN, &before);
+    for (int round = 0; round < BENCH_STARTS; round++)
+    {
+        for (int p = 0; p < BENCH_PROGRAMS; p++)
+        {
+            if (variant->multicall != NULL)
+            {
+                snprintf(path, sizeof(path), "%s", variant->multicall);
+            }
+            else
+            {
+                snprintf(path, sizeof(path), "bin/%s", programs[p]);
+            }
+            startups_us[count++] = start_program(path, programs[p], actions);
+        }
+    }
+    getrusage(RUSAGE_CHILDREN, &after);
+
+    double total_us = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        total_us += startups_us[i];
+    }
+    qsort(startups_us, count, sizeof(startups_us[0]), compare_double);
+    printf("  %-9s: p50 %6.1f us | mean %6.1f us | %5.1f page faults/start | binaries %5lld KiB\n", variant->name,
+           startups_us[count / 2], total_us / count, (double)(after.ru_minflt - before.ru_minflt) / count,
+           bytes / 1024);
+}
+
+int main()
+{
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0); // Usage messages
+
+    printf("Startup, %d starts of sensors, controller and actuators (posix_spawn to exit):\n", BENCH_STARTS);
+    for (size_t i = 0; i < sizeof(variants) / sizeof(variants[0]); i++)
+    {
+        bench_variant_startup(&variants[i], &actions);
+    }
+
+    posix_spawn_file_actions_destroy(&actions);
+    return EXIT_SUCCESS;
+}
@@ -2,17 +2,92 @@
 #define ACTUATORS_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include "dbc.h"
 
-typedef struct{
-    bool belt_tightness;
-    bool door_lock;
-    bool should_activate_abs;
-    bool alarm_led;
-    bool alarm_buzzer;
-} actuators_abstraction;
+// Actuators state: one ACTUATOR_BIT_* per actuator, set when the actuator is active
+typedef uint8_t actuators_abstraction;
+
+#define ACTUATOR_BIT_BELT_TIGHTNESS 0x01
+#define ACTUATOR_BIT_DOOR_LOCK      0x02
+#define ACTUATOR_BIT_ABS            0x04
+#define ACTUATOR_BIT_ALARM_LED      0x08
+#define ACTUATOR_BIT_ALARM_BUZZER   0x10
+#define ACTUATOR_BITS_ALL           0x1F
+
+// States commanded by the ID_AEB_S frame
+#define ACTUATORS_STATE_IDLE    ACTUATOR_BIT_DOOR_LOCK
+#define ACTUATORS_STATE_ALARM   (ACTUATOR_BIT_DOOR_LOCK | ACTUATOR_BIT_ALARM_LED | ACTUATOR_BIT_ALARM_BUZZER)
+#define ACTUATORS_STATE_BRAKING (ACTUATOR_BIT_BELT_TIGHTNESS | ACTUATOR_BIT_ABS | ACTUATOR_BIT_ALARM_LED | ACTUATOR_BIT_ALARM_BUZZER)
+
+/**
+ * @brief Tells whether an actuator is active.
+ *
+ * @param state Actuators state.
+ * @param bit ACTUATOR_BIT_* of the actuator.
+ * @return 1 if the actuator is active, 0 otherwise.
+ */
+static inline int actuatorIsActive(actuators_abstraction state, actuators_abstraction bit)
+{
+    return (state & bit) != 0;
+}
+
+/**
+ * @brief Actuators state commanded by an ID_AEB_S frame.
+ *
+ * The state is read from a lookup table indexed by the brake (`dataFrame[1] == 0x01`) and
+ * warning (`dataFrame[0] == 0x01`) bytes; the brake takes precedence over the warning.
+ */
+static inline actuators_abstraction actuatorsStateFromAebS(const can_msg *frame)
+{
+    static const actuators_abstraction aeb_s_states[4] = {
+        ACTUATORS_STATE_IDLE,    // Neither warning nor brake
+        ACTUATORS_STATE_ALARM,   // Warning only
+        ACTUATORS_STATE_BRAKING, // Brake only
+        ACTUATORS_STATE_BRAKING  // Brake takes precedence over the warning
+    };
+    unsigned int warning = frame->dataFrame[0] == 0x01;
+    unsigned int brake = frame->dataFrame[1] == 0x01;
+    return aeb_s_states[brake << 1 | warning];
+}
+
+/**
+ * @brief Builds an ID_ACTUATORS_CMD frame that commands an actuators state.
+ *
+ * Sent by the controller instead of ID_AEB_S when it runs with `-k`.
+ */
+static inline can_msg actuatorsCommandFrame(actuators_abstraction state)
+{
+    can_msg frame = {.identifier = ID_ACTUATORS_CMD, .dataFrame = BASE_DATA_FRAME};
+    frame.dataFrame[0] = state;
+    return frame;
+}
+
+/**
+ * @brief Actuators state commanded by a frame of either command channel.
+ *
+ * @param frame ID_AEB_S frame, or ID_ACTUATORS_CMD frame carrying the state in `dataFrame[0]`.
+ * @param state Receives the commanded state; left unchanged if the frame commands none.
+ * @return 1 if the frame commands a state, 0 for any other frame (ID_EMPTY included) and for a
+ *         mask with bits outside ACTUATOR_BITS_ALL.
+ */
+static inline int actuatorsStateFromCommand(const can_msg *frame, actuators_abstraction *state)
+{
+    if (frame->identifier == ID_AEB_S)
+    {
+        *state = actuatorsStateFromAebS(frame);
+        return 1;
+    }
+    if (frame->identifier == ID_ACTUATORS_CMD && (frame->dataFrame[0] & ~ACTUATOR_BITS_ALL) == 0)
+    {
+        *state = frame->dataFrame[0];
+        return 1;
+    }
+    return 0;
+}
 
 void actuatorsTranslateCanMsg(can_msg captured_frame);
+void actuatorsStep(const can_msg *command);
 void updateInternalActuatorsState(can_msg captured_frame);
 void print_info_output();
 
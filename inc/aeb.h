@@ -0,0 +1,17 @@
+/**
+ * @file aeb.h
+ * @brief Program table of the multicall binary (aeb.c).
+ */
+
+#ifndef AEB_H
+#define AEB_H
+
+typedef struct
+{
+    const char *name; // Name of the program when built on its own
+    int (*program_main)(int argc, char *argv[]);
+} aeb_program;
+
+const aeb_program *find_program(const char *name);
+
+#endif
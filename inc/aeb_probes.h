@@ -0,0 +1,106 @@
+/**
+ * @file aeb_probes.h
+ * @brief USDT static tracepoints of the hot paths, for perf, bpftrace and SystemTap.
+ *
+ * Each AEB_PROBEn(name, ...) site becomes a probe `aeb:name` of the binary: a single `nop` in
+ * the code and an entry of the `.note.stapsdt` ELF section giving its address and where its
+ * arguments are (register, memory or constant). A tracer attaching to the probe replaces the
+ * `nop` with a breakpoint; while nothing is attached the site costs that `nop`, the arguments
+ * being values the code already holds. The probes of a binary are listed with
+ * `readelf -n bin/aeb_controller_bin` or `bpftrace -l 'usdt:bin/aeb_controller_bin:*'`.
+ *
+ * The macros of `<sys/sdt.h>` (systemtap-sdt-dev) are used when the header is installed.
+ * Otherwise, on x86-64 and AArch64 with GCC or Clang, the same note is emitted here; elsewhere,
+ * or when built with `-DAEB_NO_PROBES`, the probes compile to nothing. The arguments must be
+ * integers; a negative size in the note marks a signed argument.
+ *
+ * Probes of the provider `aeb`:
+ * - `frame_send(identifier)`: sensors, frame written to the sensors queue;
+ * - `frame_receive(identifier)`: controller, frame read from the sensors queue;
+ * - `frame_decode(identifier)`: controller, frame decoded into the internal state;
+ * - `ttc(ttc_us, state)`: controller, ttc_calc result in microseconds and decided state;
+ * - `state_change(previous, state, now_ms)`: controller, AEB state transition (previous -1 at start);
+ * - `actuator_apply(identifier, actuators)`: actuators, command applied (ACTUATOR_BIT_* mask);
+ * - `log_event(event_id, actuators)`: log_utils, state of the actuators logged.
+ */
+
+#ifndef AEB_PROBES_H
+#define AEB_PROBES_H
+
+#include <stdint.h>
+
+#if defined(AEB_NO_PROBES)
+
+#define AEB_PROBE1(name, a1) ((void)0)
+#define AEB_PROBE2(name, a1, a2) ((void)0)
+#define AEB_PROBE3(name, a1, a2, a3) ((void)0)
+
+#elif defined(__has_include) && __has_include(<sys/sdt.h>)
+
+#include <sys/sdt.h>
+#define AEB_PROBE1(name, a1) DTRACE_PROBE1(aeb, name, a1)
+#define AEB_PROBE2(name, a1, a2) DTRACE_PROBE2(aeb, name, a1, a2)
+#define AEB_PROBE3(name, a1, a2, a3) DTRACE_PROBE3(aeb, name, a1, a2, a3)
+
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__aarch64__))
+
+// Size of an integer argument in the note, negative if it is signed (printed negated by %n)
+#define AEB_PROBE_SIZE(x) ((((__typeof__(x))-1 < 1) ? 1 : -1) * (int)sizeof(x))
+
+// stapsdt note, version 3: probe address, base address (for prelink), no semaphore, names, arguments
+#define AEB_PROBE_NOTE(name, args)                                                      \
+    "990: nop\n"                                                                        \
+    ".pushsection .note.stapsdt,\"?\",\"note\"\n"                                       \
+    ".balign 4\n"                                                                       \
+    ".4byte 992f-991f, 994f-993f, 3\n"                                                  \
+    "991: .asciz \"stapsdt\"\n"                                                         \
+    "992: .balign 4\n"                                                                  \
+    "993: .8byte 990b\n"                                                                \
+    ".8byte _.stapsdt.base\n"                                                           \
+    ".8byte 0\n"                                                                        \
+    ".asciz \"aeb\"\n"                                                                  \
+    ".asciz \"" #name "\"\n"                                                            \
+    ".asciz \"" args "\"\n"                                                             \
+    "994: .balign 4\n"                                                                  \
+    ".popsection\n"                                                                     \
+    ".ifndef _.stapsdt.base\n"                                                          \
+    ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n"             \
+    ".weak _.stapsdt.base\n"                                                            \
+    ".hidden _.stapsdt.base\n"                                                          \
+    "_.stapsdt.base: .space 1\n"                                                        \
+    ".size _.stapsdt.base, 1\n"                                                         \
+    ".popsection\n"                                                                     \
+    ".endif\n"
+
+#define AEB_PROBE1(name, x1)                                                            \
+    __asm__ __volatile__(AEB_PROBE_NOTE(name, "%n[s1]@%[a1]")                           \
+                         ::[s1] "n"(AEB_PROBE_SIZE(x1)), [a1] "nor"(x1))
+#define AEB_PROBE2(name, x1, x2)                                                        \
+    __asm__ __volatile__(AEB_PROBE_NOTE(name, "%n[s1]@%[a1] %n[s2]@%[a2]")              \
+                         ::[s1] "n"(AEB_PROBE_SIZE(x1)), [a1] "nor"(x1),                \
+                         [s2] "n"(AEB_PROBE_SIZE(x2)), [a2] "nor"(x2))
+#define AEB_PROBE3(name, x1, x2, x3)                                                    \
+    __asm__ __volatile__(AEB_PROBE_NOTE(name, "%n[s1]@%[a1] %n[s2]@%[a2] %n[s3]@%[a3]") \
+                         ::[s1] "n"(AEB_PROBE_SIZE(x1)), [a1] "nor"(x1),                \
+                         [s2] "n"(AEB_PROBE_SIZE(x2)), [a2] "nor"(x2),                  \
+                         [s3] "n"(AEB_PROBE_SIZE(x3)), [a3] "nor"(x3))
+
+#else
+
+#define AEB_PROBE1(name, a1) ((void)0)
+#define AEB_PROBE2(name, a1, a2) ((void)0)
+#define AEB_PROBE3(name, a1, a2, a3) ((void)0)
+
+#endif
+
+/**
+ * @brief Converts a time in seconds to integer microseconds for a probe argument.
+ *
+ * @return The time in microseconds, INT64_MAX if it is infinite, not a number or out of range.
+ */
+static inline int64_t aeb_probe_us(double seconds)
+{
+    return seconds > -1e12 && seconds < 1e12 ? (int64_t)(seconds * 1e6) : INT64_MAX;
+}
+
+#endif
@@ -0,0 +1,77 @@
+/**
+ * @file aeb_stats.h
+ * @brief Run statistics of the AEB controller, kept as quantile sketches.
+ *
+ * The controller feeds every decision to aeb_stats_update, which keeps sketches of the
+ * computed TTC, of the time spent in each controller state and of the lead time between
+ * the alarm and the brake. The sketches are saved to AEB_STATS_PATH and can be merged
+ * across runs with aeb_sketch.
+ */
+
+#ifndef AEB_STATS_H
+#define AEB_STATS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "quantile_sketch.h"
+
+#define AEB_STATS_PATH "log/stats.qsk"
+#define AEB_STATS_MAGIC "AEBQSK"
+#define AEB_STATS_VERSION 1
+#define AEB_STATS_NAME_MAX 24
+#define AEB_STATS_SAVE_INTERVAL_MS 10000 // The controller saves its sketches this often
+#define AEB_STATS_TTC_MAX 99.0           // ttc_calc result when no collision is possible
+
+// Controller states, in the order of aeb_controller_state
+#define AEB_STATS_STATE_ACTIVE 0
+#define AEB_STATS_STATE_ALARM 1
+#define AEB_STATS_STATE_BRAKE 2
+#define AEB_STATS_STATE_STANDBY 3
+#define AEB_STATS_STATES 4
+
+typedef enum
+{
+    AEB_STATS_TTC,                                       // Computed TTC (s) while a collision is possible
+    AEB_STATS_DWELL,                                     // Time (s) in each state, one sketch per state
+    AEB_STATS_ALARM_TO_BRAKE = AEB_STATS_DWELL + AEB_STATS_STATES, // Time (s) from entering ALARM to BRAKE
+    AEB_STATS_SKETCHES
+} aeb_stats_sketch;
+
+typedef struct
+{
+    qsketch sketches[AEB_STATS_SKETCHES];
+    int state;      // Current state, -1 before the first decision
+    long entered_ms; // When the current state was entered
+    long alarm_ms;   // When ALARM was entered, -1 if the brake can't follow it
+} aeb_stats;
+
+typedef struct
+{
+    char magic[8]; // AEB_STATS_MAGIC
+    uint32_t version;
+    uint32_t sketches;
+    uint32_t buckets;
+    uint32_t reserved;
+    double relative_accuracy;
+    double min_value;
+} aeb_stats_file_header;
+
+void aeb_stats_init(aeb_stats *stats);
+
+long aeb_stats_now_ms(void);
+
+void aeb_stats_update(aeb_stats *stats, int state, double ttc, long now_ms);
+
+void aeb_stats_finish(aeb_stats *stats, long now_ms);
+
+void aeb_stats_merge(aeb_stats *into, const aeb_stats *from);
+
+const char *aeb_stats_name(int sketch);
+
+int aeb_stats_save(const aeb_stats *stats, const char *path);
+
+int aeb_stats_load(aeb_stats *stats, const char *path);
+
+void aeb_stats_print(const aeb_stats *stats, FILE *out);
+
+#endif
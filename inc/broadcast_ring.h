@@ -0,0 +1,87 @@
+/**
+ * @file broadcast_ring.h
+ * @brief Single-writer, multi-reader broadcast ring of CAN frames in POSIX shared memory.
+ *
+ * main_bin creates the segment before starting the other processes; the controller publishes
+ * every command it sends to the actuators, and each actuator subscriber process reads every
+ * published frame through its own cursor. Readers never consume a frame for the others: the
+ * writer stores each frame once and every reader copies it out of the same slot.
+ *
+ * The writer never waits for the readers. A reader that falls more than a lap behind skips to
+ * the oldest frame still kept and counts the frames it lost.
+ */
+
+#ifndef BROADCAST_RING_H
+#define BROADCAST_RING_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include "dbc.h"
+
+#define BROADCAST_MAGIC "AEBBCST"
+#define BROADCAST_MAX_READERS 16
+#define BROADCAST_CACHE_LINE 64
+
+typedef struct
+{
+    _Atomic uint64_t sequence; // Position + 1 once the frame is complete, 0 while it is written
+    uint64_t timestamp_ns;     // CLOCK_MONOTONIC time of the publication
+    uint32_t identifier;
+    uint8_t data[8];
+    uint32_t reserved;
+} broadcast_slot;
+
+// Cursor of one reader, on its own cache line so the readers don't slow each other down
+typedef struct
+{
+    _Alignas(BROADCAST_CACHE_LINE) _Atomic uint32_t in_use;
+    int32_t pid;                // Owner, so the cursor of a dead reader can be reclaimed
+    _Atomic uint64_t position;  // Next frame to be read
+    _Atomic uint64_t lost;      // Frames overwritten before being read
+} broadcast_cursor;
+
+typedef struct
+{
+    char magic[8];
+    uint32_t capacity; // Slots, power of two
+    uint32_t slot_size;
+    _Alignas(BROADCAST_CACHE_LINE) _Atomic uint64_t next; // Position of the next frame
+    _Atomic uint32_t futex;   // Bumped by every publication, waited on by the readers
+    _Atomic uint32_t waiters; // Readers sleeping on the futex
+    broadcast_cursor cursors[BROADCAST_MAX_READERS];
+} broadcast_header;
+
+// Mapping of a broadcast ring in the calling process
+typedef struct
+{
+    broadcast_header *header;
+    broadcast_slot *slots;
+    size_t size;
+} broadcast_ring;
+
+typedef struct
+{
+    broadcast_ring *ring;
+    broadcast_cursor *cursor;
+    uint64_t position; // Private copy of the cursor position
+} broadcast_reader;
+
+int broadcast_create(const char *name, uint32_t capacity);
+
+int broadcast_attach(broadcast_ring *ring, const char *name);
+
+void broadcast_detach(broadcast_ring *ring);
+
+void broadcast_destroy(const char *name);
+
+void broadcast_publish(broadcast_ring *ring, const can_msg *frame);
+
+int broadcast_subscribe(broadcast_ring *ring, broadcast_reader *reader);
+
+void broadcast_unsubscribe(broadcast_reader *reader);
+
+int broadcast_read(broadcast_reader *reader, can_msg *frame, uint64_t *timestamp_ns);
+
+int broadcast_wait(broadcast_reader *reader, unsigned int timeout_ms);
+
+#endif
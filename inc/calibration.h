@@ -0,0 +1,170 @@
+/**
+ * @file calibration.h
+ * @brief Calibration parameters of the controller in POSIX shared memory, retunable at runtime.
+ *
+ * main_bin creates the calibration block from a text file (`name = value` lines) before it
+ * starts the other processes. The controller takes a snapshot of the block once per cycle and
+ * decides with that copy, so new values are applied from the next cycle on, without a restart
+ * and without a lock in the decision path. `aeb_calibrate` reads and updates the block while
+ * the system is running.
+ *
+ * The block is protected by a sequence lock: a writer makes the sequence odd with a
+ * compare-and-swap while it writes and even again once done, and a reader retries when the
+ * sequence was odd or changed during its copy. Every value written is validated first, so a
+ * reader never sees an inconsistent set of parameters. [SwR-13] (@ref SwR-13)
+ *
+ * Each TTC threshold is either a scalar or a calibration map: a table by speed (1D) or by speed
+ * and relative acceleration (2D), interpolated linearly between its breakpoints and held
+ * constant beyond them. calibration_prepare computes the slope of each segment and the scale of
+ * each acceleration interval when a map is loaded, so calibration_map_eval only finds the
+ * segment, with comparisons added up instead of branches, and does a multiply-add per axis.
+ */
+
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdatomic.h>
+#include "constants.h"
+
+#define CALIBRATION_MAGIC "AEBCAL1"
+#define CALIBRATION_READ_RETRIES 1000 // Copies attempted before the previous snapshot is kept
+#define CALIBRATION_MAP_POINTS 8      // Breakpoints per axis of a calibration map
+#define CALIBRATION_MAP_VALUES (CALIBRATION_MAP_POINTS * CALIBRATION_MAP_POINTS)
+
+// Threshold as a function of speed, or of speed and relative acceleration
+typedef struct
+{
+    uint32_t speed_points; // Breakpoints by speed (at least 2); 0 = the scalar threshold is used
+    uint32_t accel_points; // Breakpoints by relative acceleration (at least 2); 0 = map by speed only
+    uint32_t value_count;  // speed_points x accel_points values (speed_points for a map by speed)
+    uint32_t reserved;
+    double speed[CALIBRATION_MAP_POINTS];       // km/h, increasing; unused entries hold +inf
+    double accel[CALIBRATION_MAP_POINTS];       // m/s^2, increasing; unused entries hold +inf
+    double value[CALIBRATION_MAP_VALUES];       // Threshold in seconds, row by row of speed
+    double slope[CALIBRATION_MAP_VALUES];       // Change of value per km/h up to the next speed
+    double accel_scale[CALIBRATION_MAP_POINTS]; // 1 / (accel[j + 1] - accel[j])
+} calibration_map;
+
+// Calibratable parameters of the AEB decision [SwR-13] (@ref SwR-13)
+typedef struct
+{
+    double threshold_alarm;   // TTC below which the alarm is triggered, in seconds [SwR-2]
+    double threshold_braking; // TTC below which the vehicle brakes, in seconds [SwR-3]
+    double min_spd_enabled;   // Minimum speed for which AEB is enabled, in km/h [SwR-7]
+    double max_spd_enabled;   // Maximum speed for which AEB is enabled, in km/h [Sys-F-9]
+    calibration_map alarm_map;   // threshold_alarm by speed (and acceleration), if used
+    calibration_map braking_map; // threshold_braking by speed (and acceleration), if used
+} aeb_calibration;
+
+// Compile-time values, used when there is no calibration block or file
+#define CALIBRATION_DEFAULTS                                                                                   \
+    {                                                                                                          \
+        .threshold_alarm = THRESHOLD_ALARM, .threshold_braking = THRESHOLD_BRAKING,                            \
+        .min_spd_enabled = MIN_SPD_ENABLED, .max_spd_enabled = MAX_SPD_ENABLED                                 \
+    }
+
+typedef struct
+{
+    char magic[8];
+    _Atomic uint32_t sequence; // Odd while the values are written; sequence / 2 updates were made
+    uint32_t values_size;
+    aeb_calibration values;
+} calibration_header;
+
+// Mapping of the calibration block in the calling process
+typedef struct
+{
+    calibration_header *header;
+    uint32_t version; // Sequence of the last snapshot
+} calibration;
+
+int calibration_create(const char *name, const aeb_calibration *values);
+
+int calibration_attach(calibration *cal, const char *name);
+
+void calibration_detach(calibration *cal);
+
+void calibration_destroy(const char *name);
+
+int calibration_prepare(aeb_calibration *values);
+
+int calibration_validate(const aeb_calibration *values);
+
+int calibration_write(calibration *cal, const aeb_calibration *values);
+
+int calibration_snapshot(calibration *cal, aeb_calibration *values);
+
+int calibration_set(aeb_calibration *values, const char *line);
+
+int calibration_load(const char *path, aeb_calibration *values);
+
+void calibration_print(const aeb_calibration *values, FILE *out);
+
+/**
+ * @brief Segment of a map axis that holds x: the last breakpoint not above x, at most points - 2.
+ *
+ * Counts the breakpoints not above x over the whole axis (unused entries are +inf), so the
+ * number of comparisons doesn't depend on x.
+ */
+static inline uint32_t calibration_map_segment(const double *breakpoints, uint32_t points, double x)
+{
+    uint32_t segment = 0;
+    for (uint32_t k = 1; k < CALIBRATION_MAP_POINTS; k++)
+    {
+        segment += x >= breakpoints[k];
+    }
+    uint32_t last = points - 2;
+    return segment < last ? segment : last;
+}
+
+/**
+ * @brief Clamps x to [low, high]; a NaN gives low. Compiles to min/max instructions, unlike fmin
+ * and fmax, which are library calls on x86 because of their NaN rules.
+ */
+static inline double calibration_clamp(double x, double low, double high)
+{
+    x = x > low ? x : low;
+    return x < high ? x : high;
+}
+
+/**
+ * @brief Evaluates a prepared calibration map (speed_points > 0).
+ *
+ * @param map Map prepared by calibration_prepare.
+ * @param speed Speed in km/h, clamped to the breakpoints of the map.
+ * @param accel Relative acceleration in m/s^2, clamped to the breakpoints (ignored by a 1D map).
+ * @return Interpolated threshold.
+ */
+static inline double calibration_map_eval(const calibration_map *map, double speed, double accel)
+{
+    uint32_t speed_points = map->speed_points;
+    speed = calibration_clamp(speed, map->speed[0], map->speed[speed_points - 1]);
+    uint32_t i = calibration_map_segment(map->speed, speed_points, speed);
+    double along_speed = speed - map->speed[i];
+    if (map->accel_points == 0)
+    {
+        return map->value[i] + along_speed * map->slope[i];
+    }
+
+    uint32_t accel_points = map->accel_points;
+    accel = calibration_clamp(accel, map->accel[0], map->accel[accel_points - 1]);
+    uint32_t j = calibration_map_segment(map->accel, accel_points, accel);
+    uint32_t cell = i * accel_points + j;
+    double low = map->value[cell] + along_speed * map->slope[cell];
+    double high = map->value[cell + 1] + along_speed * map->slope[cell + 1];
+    return low + (accel - map->accel[j]) * map->accel_scale[j] * (high - low);
+}
+
+/**
+ * @brief Threshold at a speed and relative acceleration: from the map if it is used, otherwise
+ * the scalar value.
+ */
+static inline double calibration_threshold(const calibration_map *map, double scalar, double speed, double accel)
+{
+    return map->speed_points == 0 ? scalar : calibration_map_eval(map, speed, accel);
+}
+
+#endif
@@ -11,6 +11,7 @@
  * - Specifies shared memory and semaphore names for synchronization.
  * - Includes calibration thresholds for triggering alarms and braking in the AEB system.
  * - Provides speed limits for enabling the AEB system.
+ * - Defines the scenario row interval and the per-frame transmit periods of the sensors.
  * - Implementates calibration values [SwR-13] (@ref SwR-13)
  *
  */
@@ -27,8 +28,23 @@
 #define SEM_NAME "/sem_aeb"
 #define SHM_PERMISSIONS 0666
 
+#define FLIGHT_RECORDER_SHM "/shm_aeb_flight_recorder"
+#define FLIGHT_RECORDER_ENTRIES 4096 ///< Entries kept by the flight recorder (power of two)
+#define FLIGHT_RECORDER_DUMP_PATH "log/flight_recorder.txt"
 
-// Define the critical TTC thresholds (in seconds) below which AEB will be triggered
+#define BROADCAST_SHM "/shm_aeb_actuators_broadcast"
+#define BROADCAST_CAPACITY 256 ///< Actuator commands kept by the broadcast ring (power of two)
+
+#define MAILBOX_SHM "/shm_aeb_actuators_mailbox"
+
+#define CALIBRATION_SHM "/shm_aeb_calibration"
+#define CALIBRATION_PATH "cal/calibration.txt" ///< Calibration loaded by main_bin at startup
+
+#define METRICS_SHM "/shm_aeb_metrics"
+
+
+// Define the critical TTC thresholds (in seconds) below which AEB will be triggered. These are
+// the default calibration: the controller uses the values of the calibration block (calibration.h).
 //! Threshold for triggering the alarm (TTC < 2.0 seconds). [SwR-2] (@ref SwR-2)
 #define THRESHOLD_ALARM 2.0 /// [SwR-2] (@ref SwR-2) < Threshold for triggering the alarm (TTC < 2.0 seconds)
 //! Threshold for triggering the braking system (TTC < 1.0 second). [SwR-3] (@ref SwR-3)
@@ -38,4 +54,12 @@
 //! Minimum speed for which AEB is enabled in km/h [SwR-7] (@ref SwR-7)
 #define MIN_SPD_ENABLED 10.0 /// [SwR-7] < Minimum speed for which AEB is enabled in km/h
 
+//! Interval between two rows of the scenario file, in milliseconds
+#define SCENARIO_ROW_PERIOD_MS 1000
+// Transmit periods (in milliseconds) used by the sensors when bus timing is enabled
+#define TX_PERIOD_SPEED_MS 10     ///< Period of the ID_SPEED_S frame
+#define TX_PERIOD_OBSTACLE_MS 20  ///< Period of the ID_OBSTACLE_S frame
+#define TX_PERIOD_PEDALS_MS 100   ///< Period of the ID_PEDALS frame
+#define TX_PERIOD_CAR_C_MS 100    ///< Period of the ID_CAR_C frame
+
 #endif
\ No newline at end of file
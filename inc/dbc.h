@@ -25,6 +25,8 @@
 #define ID_CAR_C 0x0CFFAF27
 #define ID_AEB_S 0x18FFA027
 #define ID_EMPTY 0x00000000
+// Actuators command: dataFrame[0] is the actuators state (ACTUATOR_BIT_* in actuators.h)
+#define ID_ACTUATORS_CMD 0x18FFA127
 
 // left most: least significant, right most: most significant
 #define BASE_DATA_FRAME {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}
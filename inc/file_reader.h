@@ -7,6 +7,9 @@
 // Função para abrir o arquivo e pular o cabeçalho
 FILE* open_file(const char* filename);
 
+// Opens a file, named pipe or stdin ("-") for streaming, skipping the header only if present
+FILE* open_stream(const char* path);
+
 // Função para ler uma linha do arquivo
 int read_sensor_data(FILE *file, sensors_input_data *sensor_data);
 
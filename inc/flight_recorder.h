@@ -0,0 +1,76 @@
+/**
+ * @file flight_recorder.h
+ * @brief Crash-survivable flight recorder ring in POSIX shared memory.
+ *
+ * main_bin creates the segment before starting the other processes; the sensors, the
+ * controller and the actuators attach to it and record the frames they send or receive,
+ * the controller decisions with their TTC and the actuators states. The segment lives in
+ * the kernel, so the last FLIGHT_RECORDER_ENTRIES entries survive the death of any writer
+ * and can be dumped by main_bin or by aeb_flightrec.
+ */
+
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "dbc.h"
+#include "actuators.h"
+
+#define FLIGHT_RECORDER_MAGIC "AEBFREC"
+#define FLIGHT_RECORDER_HEADER_SIZE 128 // Entries start on their own cache line
+
+typedef enum
+{
+    FR_SOURCE_SENSORS = 1,
+    FR_SOURCE_CONTROLLER,
+    FR_SOURCE_ACTUATORS
+} flight_recorder_source;
+
+typedef enum
+{
+    FR_ENTRY_FRAME_TX = 1, // CAN frame sent
+    FR_ENTRY_FRAME_RX,     // CAN frame received
+    FR_ENTRY_DECISION,     // Controller state and TTC
+    FR_ENTRY_ACTUATORS     // Actuators state (ACTUATOR_BIT_* mask)
+} flight_recorder_kind;
+
+typedef struct
+{
+    _Atomic uint32_t sequence; // Ticket + 1 once the entry is complete, 0 while it is written
+    uint32_t identifier;       // CAN identifier of a frame entry
+    uint64_t timestamp_ns;     // CLOCK_REALTIME
+    uint8_t data[8];           // Frame data
+    float ttc;                 // TTC of a decision entry
+    uint8_t source;            // flight_recorder_source
+    uint8_t kind;              // flight_recorder_kind
+    uint8_t state;             // Controller state or packed actuators state
+    uint8_t reserved;
+} flight_recorder_entry;
+
+typedef struct
+{
+    char magic[8];
+    uint32_t capacity; // Entries, power of two
+    uint32_t entry_size;
+    _Alignas(64) _Atomic uint64_t next; // Next ticket, shared by every writer
+} flight_recorder_header;
+
+int flight_recorder_create(const char *name, uint32_t capacity);
+
+int flight_recorder_attach(const char *name, flight_recorder_source source);
+
+void flight_recorder_detach(void);
+
+void flight_recorder_destroy(const char *name);
+
+void flight_recorder_frame(flight_recorder_kind kind, const can_msg *frame);
+
+void flight_recorder_decision(uint8_t state, double ttc);
+
+void flight_recorder_actuators(actuators_abstraction actuators);
+
+long flight_recorder_dump(const char *name, FILE *out);
+
+#endif
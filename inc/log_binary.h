@@ -0,0 +1,84 @@
+/**
+ * @file log_binary.h
+ * @brief Binary event log format written by log_utils and decoded by aeb_logcat.
+ *
+ * A binary log is a log_bin_file_header followed by blocks. Each block is a
+ * log_bin_block_header and `count` fixed-size log_bin_record entries; its checksum is
+ * the CRC-32 of the ID_AEB field, the count and the records. All fields are stored in
+ * the byte order of the host that wrote the log (little-endian on the targets we run).
+ */
+
+#ifndef LOG_BINARY_H
+#define LOG_BINARY_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "log_utils.h"
+
+#define LOG_BIN_MAGIC "AEBLOG"
+#define LOG_BIN_BLOCK_MAGIC 0x4B4C4241u // "ABLK"
+#define LOG_BIN_VERSION 1
+#define LOG_BIN_BLOCK_RECORDS 64
+
+typedef struct
+{
+    char magic[6];          // LOG_BIN_MAGIC, without the terminator
+    uint16_t version;       // LOG_BIN_VERSION
+    uint16_t record_size;   // sizeof(log_bin_record)
+    uint16_t block_records; // Maximum records per block
+    uint32_t reserved;
+} log_bin_file_header;
+
+typedef struct
+{
+    uint32_t magic;              // LOG_BIN_BLOCK_MAGIC
+    uint32_t checksum;           // CRC-32 of id_aeb, count and the records
+    char id_aeb[LOG_ID_AEB_MAX]; // ID_AEB shared by every record of the block
+    uint16_t count;              // Records in this block
+    uint16_t reserved;
+} log_bin_block_header;
+
+typedef struct
+{
+    int64_t timestamp_ms;
+    uint32_t event_id;
+    uint8_t actuators; // ACTUATOR_BIT_* mask
+    uint8_t kind;      // log_record_kind
+    uint16_t count;    // Suppressed events covered by a summary record
+} log_bin_record;
+
+typedef struct
+{
+    log_bin_block_header header;
+    log_bin_record records[LOG_BIN_BLOCK_RECORDS];
+} log_bin_block;
+
+typedef enum
+{
+    LOG_BIN_BLOCK_OK,
+    LOG_BIN_BLOCK_END,        // End of the file
+    LOG_BIN_BLOCK_BAD_HEADER, // Not a block header: the rest of the file can't be trusted
+    LOG_BIN_BLOCK_TRUNCATED,  // Last block cut short (e.g. the writer was killed)
+    LOG_BIN_BLOCK_CHECKSUM    // Corrupted records, the next block can still be read
+} log_bin_block_status;
+
+void log_bin_pack(log_bin_record *entry, const log_record *record);
+
+void log_bin_unpack(log_record *record, const log_bin_record *entry);
+
+uint32_t log_bin_crc32(uint32_t crc, const void *data, size_t size);
+
+int log_bin_write_file_header(FILE *file);
+
+void log_bin_append(log_bin_block *block, FILE *file, const log_record *record);
+
+void log_bin_write_block(log_bin_block *block, FILE *file);
+
+int log_bin_read_file_header(FILE *in, log_bin_file_header *header);
+
+log_bin_block_status log_bin_read_block(FILE *in, const log_bin_file_header *file_header, log_bin_block *block);
+
+long log_bin_decode(FILE *in, FILE *out);
+
+#endif
@@ -0,0 +1,103 @@
+/**
+ * @file log_index.h
+ * @brief Sidecar index of a text or binary event log, used by aeb_logq.
+ *
+ * The index of `<log>` is stored in `<log>.idx` and is rebuilt whenever the log changed
+ * size or modification time. It holds:
+ * - a sparse timestamp index: the location of every LOG_INDEX_STRIDE-th record;
+ * - one posting list per EVENT_ID: the timestamp and location of each of its records;
+ * - a posting list of the state transitions: records whose actuators state differs from
+ *   the previous record.
+ *
+ * Postings are sorted by timestamp (logs are appended in time order), so time-range,
+ * event-ID and transition queries are binary searches followed by reads of the matching
+ * records only.
+ */
+
+#ifndef LOG_INDEX_H
+#define LOG_INDEX_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "log_utils.h"
+#include "log_binary.h"
+
+#define LOG_INDEX_MAGIC "AEBLIDX"
+#define LOG_INDEX_VERSION 1
+#define LOG_INDEX_SUFFIX ".idx"
+#define LOG_INDEX_STRIDE 256 // Records between two entries of the sparse timestamp index
+
+// Location of a record: byte offset of its line (text) or of its block (binary), and its
+// index in the block
+#define LOG_INDEX_LOCATION(offset, record) (((uint64_t)(offset) << 8) | (record))
+#define LOG_INDEX_OFFSET(location) ((location) >> 8)
+#define LOG_INDEX_RECORD(location) ((unsigned int)((location) & 0xFF))
+
+typedef struct
+{
+    int64_t timestamp_ms;
+    uint64_t location;
+} log_index_posting;
+
+typedef struct
+{
+    uint32_t event_id;
+    uint32_t reserved;
+    uint64_t first; // Position of its first posting in the postings array
+    uint64_t count;
+} log_index_event;
+
+typedef struct
+{
+    char magic[8];       // LOG_INDEX_MAGIC
+    uint32_t version;    // LOG_INDEX_VERSION
+    uint32_t format;     // log_format of the indexed log
+    uint64_t log_size;   // Size of the log when it was indexed
+    int64_t log_mtime_ns; // Modification time of the log when it was indexed
+    uint64_t records;
+    uint64_t sparse_count;
+    uint64_t event_count;
+    uint64_t transition_count;
+} log_index_header;
+
+// Reader of the records of a text or binary log, in file order or at a location
+typedef struct
+{
+    FILE *file;
+    log_format format;
+    log_bin_file_header bin_header;
+    log_bin_block block; // Binary block being read
+    long block_offset;   // Offset of that block (-1 = none)
+    unsigned int next_record;
+} log_index_reader;
+
+typedef struct
+{
+    const log_index_header *header;
+    const log_index_posting *sparse;
+    const log_index_event *events;
+    const log_index_posting *postings;
+    const log_index_posting *transitions;
+    size_t map_size;
+    log_index_reader reader; // Indexed log, for reading the matching records
+} log_index;
+
+typedef struct
+{
+    long from_ms;        // Inclusive (LONG_MIN = no lower bound)
+    long to_ms;          // Inclusive (LONG_MAX = no upper bound)
+    bool by_event;       // Only records with event_id
+    uint32_t event_id;
+    bool transitions;    // Only state transitions
+} log_query;
+
+int log_index_build(const char *log_path, const char *index_path);
+
+int log_index_open(log_index *index, const char *log_path);
+
+void log_index_close(log_index *index);
+
+long log_index_query(log_index *index, const log_query *query, FILE *out);
+
+#endif
@@ -0,0 +1,57 @@
+/**
+ * @file log_journal.h
+ * @brief Memory-mapped append-only event journal.
+ *
+ * The journal is a preallocated file made of a one-page log_journal_header followed by
+ * `capacity` log_bin_record slots. The writer stores a record in the next slot with plain
+ * memory stores and then publishes it by advancing the commit index in the header with
+ * release ordering. Readers, in the same or another process, load the commit index with
+ * acquire ordering and only read the records below it, so the journal can be read while
+ * it is being written and, after a crash, holds exactly the records committed before it.
+ */
+
+#ifndef LOG_JOURNAL_H
+#define LOG_JOURNAL_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "log_utils.h"
+#include "log_binary.h"
+
+#define LOG_JOURNAL_MAGIC "AEBJRNL"
+#define LOG_JOURNAL_VERSION 1
+#define LOG_JOURNAL_HEADER_SIZE 4096 // Records start on their own page
+#define LOG_JOURNAL_RECORDS (1UL << 20) // Default capacity (16 MiB of records)
+#define LOG_JOURNAL_SYNC_RECORDS 256 // Appends between two asynchronous msync calls
+
+typedef struct
+{
+    char magic[8];           // LOG_JOURNAL_MAGIC, with the terminator
+    uint32_t version;        // LOG_JOURNAL_VERSION
+    uint32_t record_size;    // sizeof(log_bin_record)
+    uint64_t capacity;       // Record slots in the file
+    _Atomic uint64_t committed; // Records [0, committed) are complete
+    char id_aeb[LOG_ID_AEB_MAX]; // ID_AEB of the records (set by the first append)
+} log_journal_header;
+
+typedef struct
+{
+    log_journal_header *header;
+    log_bin_record *records;
+    size_t map_size;
+    uint64_t synced; // Records already handed to msync
+} log_journal;
+
+int log_journal_open(log_journal *journal, const char *path, uint64_t capacity);
+
+int log_journal_append(log_journal *journal, const log_record *record);
+
+void log_journal_sync(log_journal *journal);
+
+void log_journal_close(log_journal *journal);
+
+long log_journal_decode(const char *path, FILE *out);
+
+#endif
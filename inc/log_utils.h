@@ -4,8 +4,96 @@
 #include <stdio.h>
 #include <actuators.h>
 #include <stdint.h>
+#include <stdbool.h>
+
+#define LOG_FILE_PATH "log/log.txt"
+#define LOG_BINARY_PATH "log/log.bin"
+#define LOG_JOURNAL_PATH "log/journal.bin"
+#define LOG_LINE_MAX 192
+#define LOG_RING_CAPACITY 1024 // Default number of records waiting for the logger thread
+#define LOG_ID_AEB_MAX 8
+#define LOG_PATH_MAX 256
+#define LOG_ROTATE_KEEP 4 // Default number of rotated segments kept (path.1 ... path.N)
+#define LOG_SUMMARY_INTERVAL_MS 10000 // Default period of the summary records of suppressed events
+#define LOG_HEADER "ID_AEB | EVENT_ID | TIMESTAMP | MESSAGE | BELT_TIGHTNESS | DOOR_LOCK | ABS_ACTIVATION | ALARM_LED | ALARM_BUZZER\n"
+
+// When the buffered log writer hands its data to the file
+typedef enum
+{
+    LOG_FLUSH_EVERY_EVENT, // After every event
+    LOG_FLUSH_EVERY_N,     // After every flush_every_n events
+    LOG_FLUSH_INTERVAL     // When flush_interval_ms elapsed since the last flush
+} log_flush_policy;
+
+// How the events are stored in the log file
+typedef enum
+{
+    LOG_FORMAT_TEXT,  // One formatted line per event
+    LOG_FORMAT_BINARY, // Fixed-size records in checksummed blocks (see log_binary.h)
+    LOG_FORMAT_JOURNAL // Binary records in a memory-mapped preallocated file (see log_journal.h)
+} log_format;
+
+// Which events are written to the log file
+typedef enum
+{
+    LOG_FILTER_ALL,        // Every call to log_event
+    LOG_FILTER_TRANSITIONS // Only changes of the actuators state (ALARM/BRAKE entries and exits
+                           // included) plus periodic summaries of the suppressed events
+} log_filter;
+
+typedef struct
+{
+    const char *path;
+    log_format format;
+    log_filter filter;
+    unsigned int summary_interval_ms; // 0 = LOG_SUMMARY_INTERVAL_MS
+    log_flush_policy flush_policy;
+    unsigned int flush_every_n;
+    unsigned int flush_interval_ms;
+    bool async;                  // Hand the events to a logger thread instead of writing them
+    unsigned int ring_capacity;  // Records in the logger ring (power of two, 0 = LOG_RING_CAPACITY)
+    unsigned long rotate_max_bytes;  // Segment size that triggers a rotation (0 = no size limit)
+    unsigned int rotate_interval_ms; // Segment age that triggers a rotation (0 = no time limit)
+    unsigned int rotate_keep;        // Rotated segments kept (0 = LOG_ROTATE_KEEP)
+    unsigned long journal_records;   // Record slots of a new journal (0 = LOG_JOURNAL_RECORDS)
+} log_config;
+
+typedef enum
+{
+    LOG_RECORD_EVENT,  // One call to log_event
+    LOG_RECORD_SUMMARY // `count` suppressed events, the last of which is described by the record
+} log_record_kind;
+
+// Compact event record passed from log_event to the logger thread
+typedef struct
+{
+    long timestamp_ms;
+    uint32_t event_id;
+    char id_aeb[LOG_ID_AEB_MAX];
+    actuators_abstraction actuators;
+    uint8_t kind;   // log_record_kind
+    uint16_t count; // Suppressed events covered by a summary record
+} log_record;
+
+// Opens the log file once and keeps it open until log_shutdown
+int log_init(const log_config *config);
+
+// Hands the buffered events to the file
+void log_flush(void);
+
+// Flushes and closes the log file opened by log_init
+void log_shutdown(void);
+
+// Formats one event in the text log format
+int log_format_line(char *line, size_t size, const log_record *record);
+
+// Events discarded because the logger ring or the journal was full
+unsigned long log_dropped_events(void);
+
+// Bytes of records written to the log since log_init
+unsigned long log_written_bytes(void);
 
 // Function to register log events in a file
 void log_event(const char *id_aeb, uint32_t event_id, actuators_abstraction actuators);
 
-#endif
\ No newline at end of file
+#endif
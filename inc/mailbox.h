@@ -0,0 +1,69 @@
+/**
+ * @file mailbox.h
+ * @brief Latest-value mailbox of CAN frames in POSIX shared memory, one slot per CAN ID.
+ *
+ * Posting a frame overwrites the previous frame with the same identifier, so a reader always
+ * gets the newest frame in constant time instead of working through a queue. Each slot is
+ * protected by a sequence lock: the writer makes the sequence odd while it writes and even
+ * again once done, and a reader retries when the sequence was odd or changed during its copy.
+ *
+ * Each CAN ID must have a single writer process.
+ */
+
+#ifndef MAILBOX_H
+#define MAILBOX_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include "dbc.h"
+
+#define MAILBOX_MAGIC "AEBMBOX"
+#define MAILBOX_SLOTS 16       // CAN IDs the mailbox can hold (power of two)
+#define MAILBOX_READ_RETRIES 1000 // Copies attempted before a slot is reported busy
+#define MAILBOX_CACHE_LINE 64
+
+typedef enum
+{
+    MAILBOX_SLOT_FREE,
+    MAILBOX_SLOT_CLAIMED, // Identifier being set by a writer
+    MAILBOX_SLOT_READY
+} mailbox_slot_state;
+
+// One CAN ID, on its own cache line so that IDs written by different processes don't interfere
+typedef struct
+{
+    _Alignas(MAILBOX_CACHE_LINE) _Atomic uint32_t state; // mailbox_slot_state
+    uint32_t identifier;
+    _Atomic uint32_t sequence; // Odd while the frame is written; sequence / 2 frames were posted
+    uint32_t reserved;
+    uint64_t timestamp_ns; // CLOCK_MONOTONIC time of the last post
+    uint8_t data[8];
+} mailbox_slot;
+
+typedef struct
+{
+    char magic[8];
+    uint32_t slots;
+    uint32_t slot_size;
+    _Alignas(MAILBOX_CACHE_LINE) mailbox_slot slot[MAILBOX_SLOTS];
+} mailbox_header;
+
+// Mapping of a mailbox in the calling process
+typedef struct
+{
+    mailbox_header *header;
+} mailbox;
+
+int mailbox_create(const char *name);
+
+int mailbox_attach(mailbox *box, const char *name);
+
+void mailbox_detach(mailbox *box);
+
+void mailbox_destroy(const char *name);
+
+int mailbox_post(mailbox *box, const can_msg *frame);
+
+int mailbox_take(mailbox *box, uint32_t identifier, can_msg *frame, uint32_t *version);
+
+#endif
@@ -0,0 +1,158 @@
+/**
+ * @file metrics.h
+ * @brief Per-thread counters and gauges of the running processes in POSIX shared memory.
+ *
+ * main_bin creates the metrics segment before it starts the other processes. Each thread that
+ * publishes metrics claims a block of the segment with metrics_register, giving the names and
+ * kinds of its metrics. The thread is then the only writer of the block, so an update is a
+ * relaxed load and store of a value on cache lines no other thread writes: no lock, no atomic
+ * read-modify-write and no system call. aeb_stat maps the segment and samples the blocks.
+ *
+ * A block is released when its thread exits, or claimed again once the process that held it is
+ * gone. Without the segment (a module started on its own) the handle stays unregistered and
+ * the updates do nothing.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#define METRICS_MAGIC "AEBMTRC"
+#define METRICS_BLOCKS 16     // Threads that can publish metrics at the same time
+#define METRICS_PER_BLOCK 16  // Metrics of a block
+#define METRICS_NAME_MAX 16   // Name of a block or of a metric, with its terminating null
+#define METRICS_CACHE_LINE 64
+
+typedef enum
+{
+    METRICS_BLOCK_FREE,
+    METRICS_BLOCK_CLAIMED, // Names being set by the registering thread
+    METRICS_BLOCK_READY
+} metrics_block_state;
+
+typedef enum
+{
+    METRIC_COUNTER, // Increasing total; aeb_stat shows its change per interval
+    METRIC_GAUGE    // Current value; aeb_stat shows it as is
+} metric_kind;
+
+// Metric registered by a thread, in the order of its index
+typedef struct
+{
+    const char *name;
+    metric_kind kind;
+} metric_desc;
+
+// Metrics of one thread; the values are on their own cache lines, written by that thread only
+typedef struct
+{
+    _Alignas(METRICS_CACHE_LINE) _Atomic uint32_t state; // metrics_block_state
+    _Atomic uint32_t generation;                          // Incremented each time the block is claimed
+    int32_t pid;
+    uint32_t count;
+    char name[METRICS_NAME_MAX];
+    uint8_t kind[METRICS_PER_BLOCK];
+    char metric_name[METRICS_PER_BLOCK][METRICS_NAME_MAX];
+    _Alignas(METRICS_CACHE_LINE) _Atomic uint64_t value[METRICS_PER_BLOCK];
+} metrics_block;
+
+typedef struct
+{
+    char magic[8];
+    uint32_t blocks;
+    uint32_t block_size;
+    _Alignas(METRICS_CACHE_LINE) metrics_block block[METRICS_BLOCKS];
+} metrics_header;
+
+// Block registered by the calling thread (block is NULL when it isn't registered)
+typedef struct
+{
+    metrics_header *header;
+    metrics_block *block;
+} metrics;
+
+// Copy of a block taken by a reader
+typedef struct
+{
+    uint32_t generation;
+    int32_t pid;
+    uint32_t count;
+    char name[METRICS_NAME_MAX];
+    uint8_t kind[METRICS_PER_BLOCK];
+    char metric_name[METRICS_PER_BLOCK][METRICS_NAME_MAX];
+    uint64_t value[METRICS_PER_BLOCK];
+} metrics_sample;
+
+int metrics_create(const char *name);
+
+int metrics_register(metrics *m, const char *segment, const char *block_name, const metric_desc *desc,
+                     uint32_t count);
+
+void metrics_release(metrics *m);
+
+void metrics_destroy(const char *name);
+
+const metrics_header *metrics_open(const char *name);
+
+void metrics_close(const metrics_header *header);
+
+int metrics_read(const metrics_header *header, uint32_t index, metrics_sample *sample);
+
+/**
+ * @brief Adds to a metric of the block of the calling thread (nothing if it isn't registered).
+ *
+ * The thread is the only writer of the value, so a plain load and store are enough; readers see
+ * either the old or the new value.
+ */
+static inline void metrics_add(metrics *m, uint32_t metric, uint64_t amount)
+{
+    if (m->block == NULL)
+    {
+        return;
+    }
+    _Atomic uint64_t *value = &m->block->value[metric];
+    atomic_store_explicit(value, atomic_load_explicit(value, memory_order_relaxed) + amount, memory_order_relaxed);
+}
+
+/**
+ * @brief Sets a gauge of the block of the calling thread (nothing if it isn't registered).
+ */
+static inline void metrics_set(metrics *m, uint32_t metric, uint64_t value)
+{
+    if (m->block == NULL)
+    {
+        return;
+    }
+    atomic_store_explicit(&m->block->value[metric], value, memory_order_relaxed);
+}
+
+/**
+ * @brief Raises a gauge to value if it is lower (the block of the calling thread only).
+ */
+static inline void metrics_max(metrics *m, uint32_t metric, uint64_t value)
+{
+    if (m->block == NULL)
+    {
+        return;
+    }
+    _Atomic uint64_t *current = &m->block->value[metric];
+    if (value > atomic_load_explicit(current, memory_order_relaxed))
+    {
+        atomic_store_explicit(current, value, memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief CLOCK_MONOTONIC time in nanoseconds, for the cycle time gauges (read through the vDSO).
+ */
+static inline uint64_t metrics_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+#endif
@@ -0,0 +1,39 @@
+/**
+ * @file mpsc_queue.h
+ * @brief Lock-free multi-producer/single-consumer queue of fixed-size elements.
+ *
+ * The queue is a bounded ring where every slot carries a sequence number, so any number
+ * of producer threads can reserve slots with a compare-and-swap on the tail counter and
+ * one consumer thread can drain them without locks. A producer never waits: when the
+ * ring is full the push fails and the caller decides what to do with the element.
+ * The capacity must be a power of two.
+ */
+
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include "spsc_queue.h"
+
+typedef struct
+{
+    _Alignas(SPSC_CACHE_LINE) atomic_size_t head; // Next element to be read (consumer side)
+    _Alignas(SPSC_CACHE_LINE) atomic_size_t tail; // Next slot to be reserved (producers side)
+    _Alignas(SPSC_CACHE_LINE) size_t capacity;
+    size_t elem_size;
+    atomic_size_t *sequence; // Per-slot sequence number, tells who owns the slot
+    unsigned char *buffer;
+} mpsc_queue;
+
+int mpsc_init(mpsc_queue *queue, size_t capacity, size_t elem_size);
+
+void mpsc_destroy(mpsc_queue *queue);
+
+int mpsc_push(mpsc_queue *queue, const void *elem);
+
+int mpsc_pop(mpsc_queue *queue, void *elem);
+
+size_t mpsc_size(mpsc_queue *queue);
+
+#endif
@@ -15,4 +15,6 @@ int read_mq(mqd_t mq_receiver, can_msg *msg_read);
 
 int write_mq(mqd_t mq_sender, can_msg *msg);
 
+long depth_mq(mqd_t mqd);
+
 #endif
\ No newline at end of file
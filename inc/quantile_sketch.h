@@ -0,0 +1,40 @@
+/**
+ * @file quantile_sketch.h
+ * @brief Mergeable quantile sketch of positive values with a bounded relative error.
+ *
+ * Values are counted in logarithmic buckets (DDSketch): bucket i holds the values in
+ * (QSKETCH_MIN_VALUE * gamma^(i-1), QSKETCH_MIN_VALUE * gamma^i] with
+ * gamma = (1 + alpha) / (1 - alpha), so every quantile is returned within a relative error
+ * alpha = QSKETCH_RELATIVE_ACCURACY. The bucket array has a fixed size, so the memory does
+ * not depend on the number of values, and two sketches are merged by adding their buckets,
+ * which gives exactly the sketch of the union of their values.
+ */
+
+#ifndef QUANTILE_SKETCH_H
+#define QUANTILE_SKETCH_H
+
+#include <stdint.h>
+
+#define QSKETCH_RELATIVE_ACCURACY 0.01
+#define QSKETCH_MIN_VALUE 1e-3 // Smaller values are counted as 0 (1 ms for values in seconds)
+#define QSKETCH_BUCKETS 1024   // Up to QSKETCH_MIN_VALUE * gamma^1024, about 8e5
+
+typedef struct
+{
+    uint64_t count;
+    uint64_t zero_count; // Values below QSKETCH_MIN_VALUE
+    double min;
+    double max;
+    double sum;
+    uint64_t buckets[QSKETCH_BUCKETS];
+} qsketch;
+
+void qsketch_init(qsketch *sketch);
+
+void qsketch_add(qsketch *sketch, double value);
+
+void qsketch_merge(qsketch *into, const qsketch *from);
+
+double qsketch_quantile(const qsketch *sketch, double q);
+
+#endif
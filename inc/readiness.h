@@ -0,0 +1,26 @@
+/**
+ * @file readiness.h
+ * @brief Readiness handshake between main_bin and the processes it starts.
+ *
+ * main_bin gives each child the write end of a pipe as file descriptor READINESS_FD and names
+ * it in the READINESS_ENV environment variable. A child calls readiness_notify once its queues,
+ * shared memory and log are open, which writes one byte to the pipe; main_bin counts the bytes
+ * with readiness_wait before it starts the next stage of the data flow. A process started
+ * without main_bin has no READINESS_ENV and readiness_notify does nothing.
+ *
+ * aeb_all_bin runs the modules as threads of its own process, so it sets a hook with
+ * readiness_set_hook instead, which readiness_notify calls once per module.
+ */
+
+#ifndef READINESS_H
+#define READINESS_H
+
+#define READINESS_ENV "AEB_READY_FD"
+#define READINESS_FD 9               // Descriptor of the pipe in the children
+#define READINESS_TIMEOUT_MS 2000    // main_bin goes on without the processes not ready by then
+
+void readiness_notify(void);
+void readiness_set_hook(void (*hook)(void));
+int readiness_wait(int fd, int expected, int timeout_ms);
+
+#endif
@@ -0,0 +1,75 @@
+/**
+ * @file sensors.h
+ * @brief Declares the transmit scheduling helpers of the sensors module.
+ *
+ * The sensors module emits each CAN frame according to its own transmit period.
+ * A schedule table holds one entry per CAN identifier, and a single periodic timer
+ * ticking at the greatest common divisor of all periods drives the emission.
+ * Frames sent between two scenario rows carry values interpolated between those rows.
+ * Batch encoders convert whole arrays of rows for offline trace generation.
+ * The scenario replay advances one timer tick per call to sensorsStep, so the sender thread
+ * and the single-thread event loop of aeb_loop_bin share the same emission logic.
+ */
+
+#ifndef SENSORS_H
+#define SENSORS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "dbc.h"
+#include "sensors_input.h"
+
+/**
+ * @brief Transmit period and next deadline of one CAN frame sent by the sensors.
+ */
+typedef struct
+{
+    uint32_t identifier;       // CAN identifier of the frame
+    unsigned int period_ms;    // Transmit period of the frame
+    unsigned long next_due_ms; // Time (since the start of the emission) of the next transmission
+} can_tx_schedule;
+
+/**
+ * @brief Greatest common divisor of two periods, the longest timer tick on which both fall.
+ */
+static inline unsigned int periodGcd(unsigned int a, unsigned int b)
+{
+    while (b != 0)
+    {
+        unsigned int r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+unsigned int txScheduleTick(const can_tx_schedule *schedule, size_t size, unsigned int row_period_ms);
+void txScheduleRestart(can_tx_schedule *schedule, size_t size, unsigned long now_ms);
+size_t txScheduleDue(can_tx_schedule *schedule, size_t size, unsigned long now_ms, uint32_t *due_ids);
+#define SENSORS_TX_FRAMES 4 ///< Frames in the transmit schedule, the most sensorsStep can return
+
+/**
+ * @brief Scenario replay of the sensors, advanced one timer tick at a time by sensorsStep().
+ */
+typedef struct
+{
+    bool (*next_row)(void *source, sensors_input_data *row); // Fetches the next row, false at the end
+    void *source;                                             // Passed to next_row
+    sensors_input_data current;                               // Row being sent
+    sensors_input_data next;                                  // Row the values are interpolated towards
+    bool has_row;                                             // False once every row was sent
+    bool has_next;                                            // False while sending the last row
+    unsigned long row_start_ms;                               // Time at which current started being sent
+    unsigned int tick_ms;                                     // Interval at which sensorsStep must be called
+} sensors_replay;
+
+void sensorsReplayStart(sensors_replay *replay, bool (*next_row)(void *source, sensors_input_data *row), void *source);
+size_t sensorsStep(sensors_replay *replay, unsigned long now_ms, can_msg *frames);
+can_msg encodeSensorsFrame(uint32_t identifier, const sensors_input_data *data);
+void conv2CANVelocityDataBatch(const sensors_input_data *rows, size_t count, can_msg *out);
+void conv2CANObstacleDataBatch(const sensors_input_data *rows, size_t count, can_msg *out);
+sensors_input_data interpolateSensorsData(const sensors_input_data *current, const sensors_input_data *next,
+                                          double elapsed_s, double row_period_s);
+
+#endif
@@ -0,0 +1,37 @@
+/**
+ * @file spsc_queue.h
+ * @brief Lock-free single-producer/single-consumer queue of fixed-size elements.
+ *
+ * The queue is a ring buffer whose head and tail counters are C11 atomics, so one
+ * producer thread and one consumer thread can exchange elements without locks.
+ * The capacity must be a power of two.
+ */
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+#define SPSC_CACHE_LINE 64
+
+typedef struct
+{
+    _Alignas(SPSC_CACHE_LINE) atomic_size_t head; // Next element to be read (consumer side)
+    _Alignas(SPSC_CACHE_LINE) atomic_size_t tail; // Next free slot to be written (producer side)
+    _Alignas(SPSC_CACHE_LINE) size_t capacity;
+    size_t elem_size;
+    unsigned char *buffer;
+} spsc_queue;
+
+int spsc_init(spsc_queue *queue, size_t capacity, size_t elem_size);
+
+void spsc_destroy(spsc_queue *queue);
+
+int spsc_push(spsc_queue *queue, const void *elem);
+
+int spsc_pop(spsc_queue *queue, void *elem);
+
+size_t spsc_size(spsc_queue *queue);
+
+#endif
@@ -0,0 +1,130 @@
+/**
+ * @file actuator_subscriber.c
+ * @brief One actuator ECU, fed by the broadcast ring of the controller commands.
+ *
+ * Each process drives a single actuator (belt, door lock, ABS, LED or buzzer). It reads every
+ * command published by the controller through its own cursor of the broadcast ring, so any
+ * number of actuators receive the same commands without a process forwarding them.
+ *
+ * Usage: `actuator_sub_bin -a belt|door|abs|led|buzzer`. main_bin starts one per actuator
+ * when run with `-a`. Like actuators_bin, it exits once no command arrived for
+ * LOOP_EMPTY_ITERATIONS_MAX periods of 200 ms. The commands it read and lost and the times its
+ * actuator switched are published in the metrics segment, in a block named after the actuator.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "constants.h"
+#include "actuators.h"
+#include "broadcast_ring.h"
+#include "readiness.h"
+#include "metrics.h"
+
+#define LOOP_EMPTY_ITERATIONS_MAX 11
+#define SUBSCRIBER_WAIT_MS 200
+
+enum
+{
+    SUB_METRIC_COMMANDS_IN,
+    SUB_METRIC_LOST,
+    SUB_METRIC_SWITCHES,
+    SUB_METRICS
+};
+
+typedef struct
+{
+    const char *option;
+    const char *name;
+    actuators_abstraction bit;
+} actuator_subscriber;
+
+static const actuator_subscriber subscribers[] = {
+    {"belt", "BELT_TIGHTNESS", ACTUATOR_BIT_BELT_TIGHTNESS},
+    {"door", "DOOR_LOCK", ACTUATOR_BIT_DOOR_LOCK},
+    {"abs", "ABS_ACTIVATION", ACTUATOR_BIT_ABS},
+    {"led", "ALARM_LED", ACTUATOR_BIT_ALARM_LED},
+    {"buzzer", "ALARM_BUZZER", ACTUATOR_BIT_ALARM_BUZZER}};
+
+#ifndef TEST_MODE
+int main(int argc, char *argv[])
+{
+    const actuator_subscriber *actuator = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "a:")) != -1)
+    {
+        for (size_t i = 0; opt == 'a' && i < sizeof(subscribers) / sizeof(subscribers[0]); i++)
+        {
+            if (strcmp(optarg, subscribers[i].option) == 0)
+            {
+                actuator = &subscribers[i];
+            }
+        }
+    }
+    if (actuator == NULL)
+    {
+        fprintf(stderr, "Usage: %s -a belt|door|abs|led|buzzer\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    broadcast_ring ring;
+    broadcast_reader reader;
+    if (broadcast_attach(&ring, BROADCAST_SHM) != 0 || broadcast_subscribe(&ring, &reader) != 0)
+    {
+        fprintf(stderr, "Actuator %s: no broadcast ring or no free cursor\n", actuator->name);
+        exit(EXIT_FAILURE);
+    }
+    static const metric_desc metric_names[SUB_METRICS] = {
+        {"commands_in", METRIC_COUNTER}, {"lost", METRIC_COUNTER}, {"switches", METRIC_COUNTER}};
+    char block_name[METRICS_NAME_MAX];
+    snprintf(block_name, sizeof(block_name), "sub_%s", actuator->option);
+    metrics subscriber_metrics;
+    metrics_register(&subscriber_metrics, METRICS_SHM, block_name, metric_names, SUB_METRICS);
+    readiness_notify(); // Subscribed: receives every command from now on
+
+    int active = actuatorIsActive(ACTUATORS_STATE_IDLE, actuator->bit);
+    int empty_counter = 0;
+    uint64_t lost = 0;
+    can_msg command;
+
+    while (empty_counter < LOOP_EMPTY_ITERATIONS_MAX)
+    {
+        if (broadcast_wait(&reader, SUBSCRIBER_WAIT_MS) != 0)
+        {
+            empty_counter++;
+            continue;
+        }
+        empty_counter = 0;
+        while (broadcast_read(&reader, &command, NULL) == 0)
+        {
+            metrics_add(&subscriber_metrics, SUB_METRIC_COMMANDS_IN, 1);
+            actuators_abstraction state;
+            if (!actuatorsStateFromCommand(&command, &state))
+            {
+                continue; // ID_EMPTY: standby, the actuator keeps its state
+            }
+            int commanded = actuatorIsActive(state, actuator->bit);
+            if (commanded != active)
+            {
+                active = commanded;
+                metrics_add(&subscriber_metrics, SUB_METRIC_SWITCHES, 1);
+                printf("Actuator %s: %s\n", actuator->name, active ? "ON" : "OFF");
+            }
+        }
+        if (atomic_load(&reader.cursor->lost) != lost)
+        {
+            lost = atomic_load(&reader.cursor->lost);
+            metrics_set(&subscriber_metrics, SUB_METRIC_LOST, lost);
+            fprintf(stderr, "Actuator %s: %llu commands lost\n", actuator->name, (unsigned long long)lost);
+        }
+    }
+
+    printf("Actuator %s: no command received, exiting\n", actuator->name);
+    broadcast_unsubscribe(&reader);
+    broadcast_detach(&ring);
+    metrics_release(&subscriber_metrics);
+    return EXIT_SUCCESS;
+}
+#endif
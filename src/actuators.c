@@ -18,24 +18,39 @@
 #include "actuators.h"
 #include "dbc.h"
 #include "log_utils.h"
+#include "flight_recorder.h"
+#include "mailbox.h"
+#include "readiness.h"
+#include "metrics.h"
+#include "aeb_probes.h"
 
 #define LOOP_EMPTY_ITERATIONS_MAX 11
 
+// Metrics of the actuators thread, sampled by aeb_stat
+enum
+{
+    ACT_METRIC_COMMANDS_IN,
+    ACT_METRIC_IDLE_CYCLES, // Cycles without a new command
+    ACT_METRIC_QUEUE_DEPTH,
+    ACT_METRIC_LOG_BYTES,
+    ACT_METRIC_LOG_DROPS,
+    ACT_METRICS
+};
+
 void *actuatorsResponseLoop(void *arg);
 void actuatorsTranslateCanMsg(can_msg captured_frame);
 void updateInternalActuatorsState(can_msg captured_frame);
+int readActuatorsCommand(can_msg *command);
+void actuatorsStep(const can_msg *command);
 
-mqd_t actuators_mq;
+static mqd_t actuators_mq; // Module private: the modules also run as threads of aeb_all_bin
+mailbox actuators_mailbox; // Attached with -m: commands read from the latest-value mailbox
 pthread_t actuators_id;
+metrics actuators_metrics; // Metrics block of the actuators thread (registered by main)
 
-actuators_abstraction actuators_state = {
-    .belt_tightness = false,
-    .door_lock = true,
-    .should_activate_abs = false,
-    .alarm_led = false,
-    .alarm_buzzer = false};
+actuators_abstraction actuators_state = ACTUATORS_STATE_IDLE;
 
-can_msg captured_can_frame = {
+static can_msg captured_can_frame = {
     .identifier = 0x0CFFB027,
     .dataFrame = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}};
 
@@ -50,9 +65,70 @@ can_msg captured_can_frame = {
 // 	$(CC) $(CFLAGS) -DTEST_MODE test/test_actuators.c src/actuators.c test/unity.c -o test/test_actuators -Iinc -Itest -lpthread
 //Put the flag TEST_MODE in the Makefile: -DTEST_MODE
 #ifndef TEST_MODE 
-int main()
+int main(int argc, char *argv[])
 {
+    // Events are written by the logger thread, so disk latency doesn't delay the commands
+    log_config logging = {.path = LOG_FILE_PATH, .flush_policy = LOG_FLUSH_EVERY_EVENT, .async = true};
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:t:sbjTr:i:k:m")) != -1)
+    {
+        switch (opt)
+        {
+        case 'm': // Only the newest command, from the mailbox created by main_bin
+            if (mailbox_attach(&actuators_mailbox, MAILBOX_SHM) != 0)
+            {
+                fprintf(stderr, "Actuators: no actuators mailbox\n");
+                exit(EXIT_FAILURE);
+            }
+            break;
+        case 'j': // Memory-mapped journal, decoded with aeb_logcat
+            logging.path = LOG_JOURNAL_PATH;
+            logging.format = LOG_FORMAT_JOURNAL;
+            break;
+        case 'r': // Rotate the log when a segment reaches this size (bytes)
+            logging.rotate_max_bytes = strtoul(optarg, NULL, 10);
+            break;
+        case 'i': // Rotate the log when a segment is this old (milliseconds)
+            logging.rotate_interval_ms = atoi(optarg);
+            break;
+        case 'k': // Rotated segments kept
+            logging.rotate_keep = atoi(optarg);
+            break;
+        case 'T': // Only state transitions, with periodic summaries of the repeated events
+            logging.filter = LOG_FILTER_TRANSITIONS;
+            break;
+        case 'b': // Binary log, decoded with aeb_logcat
+            logging.path = LOG_BINARY_PATH;
+            logging.format = LOG_FORMAT_BINARY;
+            break;
+        case 's': // Write the log from the actuators thread
+            logging.async = false;
+            break;
+        case 'n': // Flush the log every N events
+            logging.flush_policy = LOG_FLUSH_EVERY_N;
+            logging.flush_every_n = atoi(optarg);
+            break;
+        case 't': // Flush the log every T milliseconds
+            logging.flush_policy = LOG_FLUSH_INTERVAL;
+            logging.flush_interval_ms = atoi(optarg);
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-s] [-b | -j] [-T] [-n events | -t milliseconds] [-r bytes] [-i milliseconds] [-k segments] [-m]\n", argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // Keep the log file open for the whole run [SwR-4]
+    log_init(&logging);
+
     actuators_mq = open_mq(ACTUATORS_MQ);
+    flight_recorder_attach(FLIGHT_RECORDER_SHM, FR_SOURCE_ACTUATORS);
+    static const metric_desc metric_names[ACT_METRICS] = {
+        {"commands_in", METRIC_COUNTER}, {"idle_cycles", METRIC_COUNTER}, {"queue_depth", METRIC_GAUGE},
+        {"log_bytes", METRIC_COUNTER},   {"log_drops", METRIC_COUNTER}};
+    metrics_register(&actuators_metrics, METRICS_SHM, "actuators", metric_names, ACT_METRICS);
+    readiness_notify(); // Log and queue open: main_bin may start the data flow
 
     int actuators_thread;
     actuators_thread = pthread_create(&actuators_id, NULL, actuatorsResponseLoop, NULL);
@@ -63,6 +139,11 @@ int main()
     }
     actuators_thread = pthread_join(actuators_id, NULL);
 
+    log_shutdown();
+    flight_recorder_detach();
+    mailbox_detach(&actuators_mailbox);
+    metrics_release(&actuators_metrics);
+
     return 0;
 }
 #endif 
@@ -80,10 +161,12 @@ int main()
  * @return NULL
  *
  * @details
- * - Reads messages from the `actuators_mq` message queue using `read_mq`.
- * - If a message is successfully read, it resets the `empty_mq_counter` and processes the message using `actuatorsTranslateCanMsg`.
- * - If the queue is empty, increments the `empty_mq_counter`.
- * - Logs each processed message using `log_event`, including the current state of the actuators.
+ * - Reads the next command using `readActuatorsCommand`.
+ * - If a message is successfully read, it resets the `empty_mq_counter`; otherwise it increments it.
+ * - Each iteration is one `actuatorsStep`, which applies the message (if any) and logs the current
+ *   state of the actuators.
+ * - Publishes the commands read, the idle cycles, the depth of the queue and the bytes written
+ *   and dropped by the log in the metrics segment created by main_bin.
  * - Waits for 200 milliseconds between iterations using `usleep`.
  * - Exits the loop and prints a message when the `empty_mq_counter` reaches `LOOP_EMPTY_ITERATIONS_MAX`.
  *
@@ -96,20 +179,25 @@ void *actuatorsResponseLoop(void *arg)
     int empty_mq_counter = 0;
     while (empty_mq_counter < LOOP_EMPTY_ITERATIONS_MAX)
     {
-        if (read_mq(actuators_mq, &captured_can_frame) != -1)
+        can_msg command;
+        if (readActuatorsCommand(&command) != -1)
         {
             empty_mq_counter = 0;
-            actuatorsTranslateCanMsg(captured_can_frame);
+            metrics_add(&actuators_metrics, ACT_METRIC_COMMANDS_IN, 1);
+            actuatorsStep(&command);
         }
         else
         {
             empty_mq_counter++;
+            metrics_add(&actuators_metrics, ACT_METRIC_IDLE_CYCLES, 1);
+            actuatorsStep(NULL);
         }
 
-        uint32_t event_id = captured_can_frame.identifier; 
-
-        log_event("AEB1", event_id, actuators_state); // [SwR-4]
-
+        long depth = actuators_mailbox.header == NULL ? depth_mq(actuators_mq) : -1;
+        if (depth >= 0)
+            metrics_set(&actuators_metrics, ACT_METRIC_QUEUE_DEPTH, depth);
+        metrics_set(&actuators_metrics, ACT_METRIC_LOG_BYTES, log_written_bytes());
+        metrics_set(&actuators_metrics, ACT_METRIC_LOG_DROPS, log_dropped_events());
 
         usleep(200000); // Deprected, change for function other later
     }
@@ -118,6 +206,73 @@ void *actuatorsResponseLoop(void *arg)
     return NULL;
 }
 
+/**
+ * @brief Applies one command to the actuators and logs their state.
+ *
+ * The command, when there is one, is recorded in the flight recorder and translated into the
+ * actuators' state. The state is then logged with the identifier of the last command applied,
+ * once per cycle whether or not a new command arrived. Used by the actuators thread and by the
+ * single-thread event loop of aeb_loop_bin.
+ *
+ * @param command Command read in this cycle, or NULL if there is none.
+ *
+ * Implements [SwR-4](@ref SwR-4)
+ *
+ * \anchor actuatorsStep
+ */
+void actuatorsStep(const can_msg *command)
+{
+    if (command != NULL)
+    {
+        captured_can_frame = *command;
+        flight_recorder_frame(FR_ENTRY_FRAME_RX, &captured_can_frame);
+        actuatorsTranslateCanMsg(captured_can_frame);
+        AEB_PROBE2(actuator_apply, captured_can_frame.identifier, actuators_state);
+        flight_recorder_actuators(actuators_state);
+    }
+
+    log_event("AEB1", captured_can_frame.identifier, actuators_state); // [SwR-4]
+}
+
+/**
+ * @brief Reads the next command for the actuators.
+ *
+ * Without a mailbox, the next frame of the `actuators_mq` message queue is read. With the
+ * mailbox (`-m`), only the newest command matters: the newest ID_AEB_S frame (or ID_ACTUATORS_CMD
+ * frame, when the controller runs with `-k`) is read if it changed since the last call, otherwise
+ * the newest ID_EMPTY frame if it changed (the controller is alive but in standby). Each call is
+ * O(1), however many commands the controller posted in between.
+ *
+ * @param command Receives the command.
+ * @return 0 if a command was read, -1 if there is no new command.
+ *
+ * \anchor readActuatorsCommand
+ */
+int readActuatorsCommand(can_msg *command)
+{
+    static uint32_t aeb_s_version = 0;
+    static uint32_t mask_version = 0;
+    static uint32_t empty_version = 0;
+
+    if (actuators_mailbox.header == NULL)
+    {
+        return read_mq(actuators_mq, command);
+    }
+    can_msg empty;
+    int new_empty = mailbox_take(&actuators_mailbox, ID_EMPTY, &empty, &empty_version) == 1;
+    if (mailbox_take(&actuators_mailbox, ID_AEB_S, command, &aeb_s_version) == 1 ||
+        mailbox_take(&actuators_mailbox, ID_ACTUATORS_CMD, command, &mask_version) == 1)
+    {
+        return 0;
+    }
+    if (new_empty)
+    {
+        *command = empty;
+        return 0;
+    }
+    return -1;
+}
+
 /**
  * @brief Translates a CAN message into actuator commands.
  *
@@ -132,6 +287,8 @@ void *actuatorsResponseLoop(void *arg)
  * @details
  * - If the identifier is `ID_AEB_S`, the function calls `updateInternalActuatorsState` to update
  *   the actuators' internal state based on the message's data.
+ * - If the identifier is `ID_ACTUATORS_CMD`, the state in `dataFrame[0]` becomes the actuators'
+ *   state, unless it has bits outside `ACTUATOR_BITS_ALL`.
  * - If the identifier is `ID_EMPTY`, the function does nothing, as it represents an empty message.
  * - For any other identifier, the function logs a warning indicating that the identifier is unknown.
  *
@@ -147,6 +304,11 @@ void actuatorsTranslateCanMsg(can_msg captured_frame)
     case ID_AEB_S:
         updateInternalActuatorsState(captured_frame);
         break;
+    case ID_ACTUATORS_CMD:
+        // The state is carried as is; a command with unknown bits is ignored
+        if (!actuatorsStateFromCommand(&captured_frame, &actuators_state))
+            printf("Actuators: invalid actuators command 0x%02X\n", captured_frame.dataFrame[0]);
+        break;
     case ID_EMPTY:
         //printf("Actuators: Empty message received\n");
         break;
@@ -167,6 +329,7 @@ void actuatorsTranslateCanMsg(can_msg captured_frame)
  * @param captured_frame The captured CAN message containing the data to update the actuators' state.
  *
  * @details
+ * The state is read from the lookup table of actuatorsStateFromAebS():
  * - If `dataFrame[1] == 0x01`, the function sets the actuators to an active state, enabling
  *   features like belt tightness, ABS activation, and alarms.
  * - If `dataFrame[0] == 0x01`, the function sets the actuators to a partially active state,
@@ -185,28 +348,5 @@ void actuatorsTranslateCanMsg(can_msg captured_frame)
  */
 void updateInternalActuatorsState(can_msg captured_frame)
 {
-    if (captured_frame.dataFrame[1] == 0x01)
-    {
-        actuators_state.belt_tightness = true;
-        actuators_state.door_lock = false;
-        actuators_state.should_activate_abs = true;
-        actuators_state.alarm_led = true;
-        actuators_state.alarm_buzzer = true;
-    }
-    else if (captured_frame.dataFrame[0] == 0x01)
-    {
-        actuators_state.belt_tightness = false;
-        actuators_state.door_lock = true;
-        actuators_state.should_activate_abs = false;
-        actuators_state.alarm_led = true;
-        actuators_state.alarm_buzzer = true;
-    }
-    else
-    {
-        actuators_state.belt_tightness = false;
-        actuators_state.door_lock = true;
-        actuators_state.should_activate_abs = false;
-        actuators_state.alarm_led = false;
-        actuators_state.alarm_buzzer = false;
-    }
-}
\ No newline at end of file
+    actuators_state = actuatorsStateFromAebS(&captured_frame);
+}
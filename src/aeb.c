@@ -0,0 +1,94 @@
+/**
+ * @file aeb.c
+ * @brief Multicall binary: every program of the system in one executable.
+ *
+ * Each program is compiled again with its `main` renamed to `<program>_main` (see the Makefile)
+ * and linked into `aeb`, which runs the one named by its own name or by its first argument:
+ * - `aeb sensors -b` (the `_bin` suffix of the name can be left out);
+ * - a link named `sensors_bin` to `aeb`, run as `sensors_bin -b`.
+ *
+ * The launcher, run as `aeb main`, starts the other programs from the same executable. The
+ * processes of the system then share one set of pages in the page cache, and the static
+ * build (`aeb_static`) also saves the dynamic linking of each process.
+ */
+
+#include <libgen.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "aeb.h"
+
+int main_main(int argc, char *argv[]);
+int sensors_main(int argc, char *argv[]);
+int aeb_controller_main(int argc, char *argv[]);
+int actuators_main(int argc, char *argv[]);
+int actuator_subscriber_main(int argc, char *argv[]);
+int aeb_loop_main(int argc, char *argv[]);
+int aeb_logcat_main(int argc, char *argv[]);
+int aeb_logq_main(int argc, char *argv[]);
+int aeb_sketch_main(int argc, char *argv[]);
+int aeb_flightrec_main(int argc, char *argv[]);
+int aeb_calibrate_main(int argc, char *argv[]);
+int aeb_stat_main(int argc, char *argv[]);
+
+static const aeb_program programs[] = {
+    {"main_bin", main_main},
+    {"sensors_bin", sensors_main},
+    {"aeb_controller_bin", aeb_controller_main},
+    {"actuators_bin", actuators_main},
+    {"actuator_sub_bin", actuator_subscriber_main},
+    {"aeb_loop_bin", aeb_loop_main},
+    {"aeb_logcat", aeb_logcat_main},
+    {"aeb_logq", aeb_logq_main},
+    {"aeb_sketch", aeb_sketch_main},
+    {"aeb_flightrec", aeb_flightrec_main},
+    {"aeb_calibrate", aeb_calibrate_main},
+    {"aeb_stat", aeb_stat_main}};
+#define AEB_PROGRAMS (sizeof(programs) / sizeof(programs[0]))
+
+/**
+ * @brief Finds a program by its name, with or without the `_bin` suffix.
+ *
+ * @return The program, NULL if no program has this name.
+ */
+const aeb_program *find_program(const char *name)
+{
+    size_t length = strlen(name);
+    for (size_t i = 0; i < AEB_PROGRAMS; i++)
+    {
+        const char *program = programs[i].name;
+        size_t program_length = strlen(program);
+        if (strcmp(program, name) == 0 ||
+            (program_length == length + 4 && strncmp(program, name, length) == 0 && strcmp(program + length, "_bin") == 0))
+        {
+            return &programs[i];
+        }
+    }
+    return NULL;
+}
+
+#ifndef TEST_MODE
+int main(int argc, char *argv[])
+{
+    char invoked[256];
+    snprintf(invoked, sizeof(invoked), "%s", argv[0]);
+
+    const aeb_program *program = find_program(basename(invoked)); // Run through a link
+    if (program != NULL)
+    {
+        return program->program_main(argc, argv);
+    }
+    if (argc > 1 && (program = find_program(argv[1])) != NULL)
+    {
+        return program->program_main(argc - 1, argv + 1);
+    }
+
+    fprintf(stderr, "Usage: %s <program> [options]\nPrograms:", argv[0]);
+    for (size_t i = 0; i < AEB_PROGRAMS; i++)
+    {
+        fprintf(stderr, " %s", programs[i].name);
+    }
+    fprintf(stderr, "\n");
+    return EXIT_FAILURE;
+}
+#endif
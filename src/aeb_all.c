@@ -0,0 +1,162 @@
+/**
+ * @file aeb_all.c
+ * @brief Single-process deployment: sensors, controller and actuators as pinned threads.
+ *
+ * main_bin runs every module in its own process, connected by POSIX message queues, which
+ * costs three address spaces and system calls and context switches for every frame. aeb_all_bin
+ * links the same modules into one process instead:
+ * - each module is compiled again with its `main` renamed to `<module>_main` (see the Makefile),
+ *   and runs it on its own thread, so its setup and loops are the ones of its own binary;
+ * - the message queue utilities are replaced by mq_inproc.c, which connects the threads with
+ *   lock-free SPSC queues;
+ * - each module thread is pinned to a CPU before it starts, and the threads it creates inherit
+ *   that CPU;
+ * - the modules are started one after the other, each once the previous one is ready (its
+ *   readiness_notify calls a hook here instead of writing to main_bin's pipe). Their mains parse
+ *   their options with getopt, whose state is global to the process, so no two of them parse at
+ *   the same time.
+ *
+ * Usage: `aeb_all_bin [-c sensors_cpu,controller_cpu,actuators_cpu]`. By default the modules
+ * run on CPUs 0, 1 and 2 (modulo the number of online CPUs).
+ *
+ * The flight recorder, the actuator subscribers and the mailbox need the shared memory created
+ * by main_bin, so they are disabled in this deployment. The metrics segment is created here as
+ * well, so aeb_stat shows the block of each module thread.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "constants.h"
+#include "metrics.h"
+#include "readiness.h"
+
+#define AEB_ALL_MODULES 3
+
+int sensors_main(int argc, char *argv[]);
+int aeb_controller_main(int argc, char *argv[]);
+int actuators_main(int argc, char *argv[]);
+
+typedef struct
+{
+    char *name;
+    int (*module_main)(int argc, char *argv[]);
+    int cpu;
+    pthread_t thread;
+} aeb_all_module;
+
+static aeb_all_module modules[AEB_ALL_MODULES] = {
+    {"sensors", sensors_main, 0},
+    {"aeb_controller", aeb_controller_main, 1},
+    {"actuators", actuators_main, 2}};
+
+static sem_t module_ready; // Posted by each module once its options are parsed and its queues open
+
+static void moduleReady(void)
+{
+    sem_post(&module_ready);
+}
+
+/**
+ * @brief Waits until the module started last is ready.
+ *
+ * @return 0 if it is ready, -1 if it isn't after READINESS_TIMEOUT_MS.
+ */
+static int waitModuleReady(void)
+{
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += READINESS_TIMEOUT_MS / 1000;
+    deadline.tv_nsec += (READINESS_TIMEOUT_MS % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L)
+    {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    int waited;
+    while ((waited = sem_timedwait(&module_ready, &deadline)) == -1 && errno == EINTR)
+    {
+    }
+    return waited;
+}
+
+/**
+ * @brief Thread of one module: runs its main without options.
+ */
+static void *run_module(void *arg)
+{
+    aeb_all_module *module = arg;
+    char *argv[] = {module->name, NULL};
+    module->module_main(1, argv);
+    return NULL;
+}
+
+#ifndef TEST_MODE
+int main(int argc, char *argv[])
+{
+    int cpus[AEB_ALL_MODULES] = {0, 1, 2}; // Sensors, controller, actuators
+    int opt;
+
+    while ((opt = getopt(argc, argv, "c:")) != -1)
+    {
+        if (opt != 'c' || sscanf(optarg, "%d,%d,%d", &cpus[0], &cpus[1], &cpus[2]) != AEB_ALL_MODULES)
+        {
+            fprintf(stderr, "Usage: %s [-c sensors_cpu,controller_cpu,actuators_cpu]\n", argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    for (int i = 0; i < AEB_ALL_MODULES; i++)
+    {
+        modules[i].cpu = cpus[i] % online;
+    }
+
+    printf("Main process PID: %d\n", getpid());
+    if (metrics_create(METRICS_SHM) != 0)
+    {
+        fprintf(stderr, "Metrics disabled\n");
+    }
+    sem_init(&module_ready, 0, 0);
+    readiness_set_hook(moduleReady);
+
+    // Consumers first, so they are waiting when the first frame is sent
+    for (int i = AEB_ALL_MODULES - 1; i >= 0; i--)
+    {
+        optind = 1; // The module parses its (empty) options with getopt, the previous one is done
+        pthread_attr_t attr;
+        cpu_set_t cpu;
+        CPU_ZERO(&cpu);
+        CPU_SET(modules[i].cpu, &cpu);
+        pthread_attr_init(&attr);
+        pthread_attr_setaffinity_np(&attr, sizeof(cpu), &cpu);
+
+        if (pthread_create(&modules[i].thread, &attr, run_module, &modules[i]) != 0)
+        {
+            perror("Error creating module thread");
+            exit(1);
+        }
+        pthread_attr_destroy(&attr);
+        if (waitModuleReady() != 0)
+        {
+            fprintf(stderr, "Module %s not ready after %d ms, going on\n", modules[i].name, READINESS_TIMEOUT_MS);
+        }
+        printf("Module %s running on CPU %d\n", modules[i].name, modules[i].cpu);
+    }
+
+    for (int i = 0; i < AEB_ALL_MODULES; i++)
+    {
+        pthread_join(modules[i].thread, NULL);
+    }
+    metrics_destroy(METRICS_SHM);
+    sem_destroy(&module_ready);
+
+    printf("Execution finished, check out log/log.txt for info!\n");
+    return EXIT_SUCCESS;
+}
+#endif
@@ -0,0 +1,66 @@
+/**
+ * @file aeb_calibrate.c
+ * @brief Reads and retunes the calibration of the running controller.
+ *
+ * Applies a calibration file and then each `name=value` argument (a map is given as a quoted
+ * list, e.g. `"threshold_alarm_map.value=1.6 2 2.6"`) to the calibration block
+ * created by main_bin, and prints the resulting values. Without arguments it only prints them.
+ * The controller uses the new values from its next cycle on. Invalid values are rejected and
+ * leave the block unchanged. [SwR-13] (@ref SwR-13)
+ *
+ * Usage: `aeb_calibrate [-f calibration] [name=value ...]`.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "constants.h"
+#include "calibration.h"
+
+#ifndef TEST_MODE
+int main(int argc, char *argv[])
+{
+    const char *path = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "f:")) != -1)
+    {
+        if (opt != 'f')
+        {
+            fprintf(stderr, "Usage: %s [-f calibration] [name=value ...]\n", argv[0]);
+            exit(EXIT_FAILURE);
+        }
+        path = optarg;
+    }
+
+    calibration cal;
+    aeb_calibration values;
+    if (calibration_attach(&cal, CALIBRATION_SHM) != 0 || calibration_snapshot(&cal, &values) != 1)
+    {
+        fprintf(stderr, "No calibration block: is main_bin running?\n");
+        exit(EXIT_FAILURE);
+    }
+
+    int update = path != NULL || optind < argc;
+    if (path != NULL && calibration_load(path, &values) != 0)
+    {
+        exit(EXIT_FAILURE);
+    }
+    for (int i = optind; i < argc; i++)
+    {
+        if (calibration_set(&values, argv[i]) != 0)
+        {
+            fprintf(stderr, "Invalid calibration parameter: %s\n", argv[i]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (update && (calibration_prepare(&values) != 0 || calibration_write(&cal, &values) != 0))
+    {
+        exit(EXIT_FAILURE);
+    }
+
+    calibration_print(&values, stdout);
+    calibration_detach(&cal);
+    return EXIT_SUCCESS;
+}
+#endif
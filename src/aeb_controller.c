@@ -25,6 +25,14 @@
 #include "dbc.h"
 #include "actuators.h"
 #include "ttc_control.h"
+#include "flight_recorder.h"
+#include "aeb_stats.h"
+#include "broadcast_ring.h"
+#include "mailbox.h"
+#include "readiness.h"
+#include "calibration.h"
+#include "metrics.h"
+#include "aeb_probes.h"
 
 #define LOOP_EMPTY_ITERATIONS_MAX 11
 
@@ -41,6 +49,19 @@ typedef enum
     AEB_STATE_STANDBY /**< AEB system is in standby, waiting for data or conditions */
 } aeb_controller_state;
 
+// Metrics of the controller thread, sampled by aeb_stat
+enum
+{
+    CTRL_METRIC_FRAMES_IN,
+    CTRL_METRIC_COMMANDS_OUT,
+    CTRL_METRIC_SEND_ERRORS,
+    CTRL_METRIC_DECISIONS, // One counter per aeb_controller_state, in the order of the enum
+    CTRL_METRIC_QUEUE_DEPTH = CTRL_METRIC_DECISIONS + 4,
+    CTRL_METRIC_CYCLE_US,
+    CTRL_METRIC_CYCLE_MAX_US,
+    CTRL_METRICS
+};
+
 // Function prototypes
 void *mainWorkingLoop(void *arg);
 void print_info();
@@ -51,10 +72,19 @@ void updateInternalObstacleState(can_msg captured_frame);
 void updateInternalCarCState(can_msg captured_frame);
 can_msg updateCanMsgOutput(aeb_controller_state state);
 aeb_controller_state getAEBState(sensors_input_data aeb_internal_state, double ttc);
+can_msg aebControllerStep(can_msg captured_frame, aeb_stats *stats, long now_ms);
 
 // Global variables for message queues and internal state
-mqd_t sensors_mq, actuators_mq; /**< Message queues for sensors and actuators */
+#ifndef TEST_MODE // Module private, used by the production loop only
+static mqd_t sensors_mq, actuators_mq; /**< Message queues for sensors and actuators */
+static mailbox actuators_mailbox;   /**< Latest-value transport of the actuator commands (-m) */
+#endif
 pthread_t aeb_controller_id;    /**< Thread ID for the AEB controller */
+broadcast_ring actuators_broadcast; /**< Fan-out of the actuator commands to the actuator subscribers */
+calibration controller_calibration;  /**< Calibration block created by main_bin (not attached: defaults) */
+aeb_calibration active_calibration = CALIBRATION_DEFAULTS; /**< Snapshot used by the current cycle [SwR-13] */
+metrics controller_metrics; /**< Metrics block of the controller thread (not registered: not published) */
+bool mask_commands = false; /**< Commands sent as ID_ACTUATORS_CMD masks instead of ID_AEB_S (-k) */
 
 sensors_input_data aeb_internal_state = {
     .relative_velocity = 0.0,
@@ -93,11 +123,36 @@ can_msg empty_msg = { // [SwR-5]
  *       a preprocessor check (`#ifndef TEST_MODE_CONTROLLER`).
  */
 #ifndef TEST_MODE // Main for the AEB controller process in production
-int main()
+int main(int argc, char *argv[])
 {
+    int opt;
+    while ((opt = getopt(argc, argv, "mk")) != -1)
+    {
+        switch (opt)
+        {
+        case 'm': // Commands posted to the mailbox created by main_bin instead of queued
+            if (mailbox_attach(&actuators_mailbox, MAILBOX_SHM) != 0)
+            {
+                fprintf(stderr, "AEB Controller: no actuators mailbox\n");
+                exit(EXIT_FAILURE);
+            }
+            break;
+        case 'k': // Actuators state as a one-byte ID_ACTUATORS_CMD mask
+            mask_commands = true;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-m] [-k]\n", argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
     // Open message queues for communication with sensors and actuators
     sensors_mq = open_mq(SENSORS_MQ);
     actuators_mq = open_mq(ACTUATORS_MQ);
+    flight_recorder_attach(FLIGHT_RECORDER_SHM, FR_SOURCE_CONTROLLER);
+    broadcast_attach(&actuators_broadcast, BROADCAST_SHM); // Not published if main_bin didn't create it
+    calibration_attach(&controller_calibration, CALIBRATION_SHM); // Compile-time values without it
+    readiness_notify(); // Queues open: main_bin may start the sensors
 
     // Create the AEB controller thread
     int controller_thread = pthread_create(&aeb_controller_id, NULL, mainWorkingLoop, NULL);
@@ -110,6 +165,9 @@ int main()
 
     // Wait for the controller thread to finish
     controller_thread = pthread_join(aeb_controller_id, NULL);
+    broadcast_detach(&actuators_broadcast);
+    mailbox_detach(&actuators_mailbox);
+    calibration_detach(&controller_calibration);
 
     return 0;
 }
@@ -117,8 +175,13 @@ int main()
 /**
  * @brief Main loop for the AEB controller that processes sensor data and makes decisions.
  *
- * This function continuously checks the message queue for new sensor data, processes it,
- * and sends commands to the actuators based on the calculated AEB state.
+ * This function continuously checks the message queue for new sensor data, processes it
+ * (see aebControllerStep), and sends the resulting command to the actuators through the message
+ * queue or, when started with `-m`, the latest-value mailbox. Each command is also
+ * published to the actuator subscribers through the broadcast ring. Every decision is
+ * added to the run statistics, which are saved to AEB_STATS_PATH periodically and on exit.
+ * The thread publishes its frame counts, the depth of the sensors queue and its cycle time
+ * in the metrics segment created by main_bin.
  *
  * Requirements [SwR-5] (@ref SwR-5), [SwR-6] (@ref SwR-6) and [SwR-9] (@ref SwR-9)
  *
@@ -127,7 +190,15 @@ int main()
  */
 void *mainWorkingLoop(void *arg)
 {
-    aeb_controller_state state = AEB_STATE_STANDBY;
+    static aeb_stats run_stats; // Constant size, whatever the length of the run
+    aeb_stats_init(&run_stats);
+    long last_save_ms = aeb_stats_now_ms();
+    static const metric_desc metric_names[CTRL_METRICS] = {
+        {"frames_in", METRIC_COUNTER}, {"commands_out", METRIC_COUNTER}, {"send_errors", METRIC_COUNTER},
+        {"active", METRIC_COUNTER},    {"alarm", METRIC_COUNTER},        {"brake", METRIC_COUNTER},
+        {"standby", METRIC_COUNTER},   {"queue_depth", METRIC_GAUGE},    {"cycle_us", METRIC_GAUGE},
+        {"cycle_max_us", METRIC_GAUGE}};
+    metrics_register(&controller_metrics, METRICS_SHM, "controller", metric_names, CTRL_METRICS);
 
     int empty_mq_counter = 0;
     while (empty_mq_counter < LOOP_EMPTY_ITERATIONS_MAX)
@@ -135,27 +206,42 @@ void *mainWorkingLoop(void *arg)
         if (read_mq(sensors_mq, &captured_can_frame) != -1) // Reads message from sensors [SwR-9]
         {
             empty_mq_counter = 0; // Reset counter if data is received
+            uint64_t cycle_start_ns = metrics_now_ns();
+            flight_recorder_frame(FR_ENTRY_FRAME_RX, &captured_can_frame);
 
-            translateAndCallCanMsg(captured_can_frame); // Process the received CAN message
-
-            double ttc = ttc_calc(aeb_internal_state.obstacle_distance, aeb_internal_state.relative_velocity,
-                                  aeb_internal_state.relative_acceleration);
-
-            state = getAEBState(aeb_internal_state, ttc);
-
-            out_can_frame = updateCanMsgOutput(state);
-
-            if (state == AEB_STATE_STANDBY)         // [SwR-5]
-                write_mq(actuators_mq, &empty_msg); // Send empty message when in standby state
+            can_msg command = aebControllerStep(captured_can_frame, &run_stats, aeb_stats_now_ms());
+            int sent;
+            if (actuators_mailbox.header != NULL)
+                sent = mailbox_post(&actuators_mailbox, &command); // Replaces the previous command of its ID
             else
-                write_mq(actuators_mq, &out_can_frame); // Send the appropriate message based on the current state
+                sent = write_mq(actuators_mq, &command); // Empty message when in standby state
+            broadcast_publish(&actuators_broadcast, &command); // Same command to every actuator subscriber
+
+            uint64_t cycle_us = (metrics_now_ns() - cycle_start_ns) / 1000;
+            metrics_add(&controller_metrics, CTRL_METRIC_FRAMES_IN, 1);
+            metrics_add(&controller_metrics, sent == 0 ? CTRL_METRIC_COMMANDS_OUT : CTRL_METRIC_SEND_ERRORS, 1);
+            long depth = depth_mq(sensors_mq);
+            if (depth >= 0)
+                metrics_set(&controller_metrics, CTRL_METRIC_QUEUE_DEPTH, depth);
+            metrics_set(&controller_metrics, CTRL_METRIC_CYCLE_US, cycle_us);
+            metrics_max(&controller_metrics, CTRL_METRIC_CYCLE_MAX_US, cycle_us);
         }
         else
             empty_mq_counter++; // Increment counter if no message is received
 
+        if (aeb_stats_now_ms() - last_save_ms >= AEB_STATS_SAVE_INTERVAL_MS)
+        {
+            aeb_stats_save(&run_stats, AEB_STATS_PATH);
+            last_save_ms = aeb_stats_now_ms();
+        }
+
         usleep(200000); // Wait for a short period before the next iteration (to be replaced later)
     }
 
+    aeb_stats_finish(&run_stats, aeb_stats_now_ms());
+    aeb_stats_save(&run_stats, AEB_STATS_PATH);
+    metrics_release(&controller_metrics);
+
     printf("AEB Controller: empty_mq_counter reached the limit, exiting\n");
     return NULL;
 }
@@ -178,6 +264,54 @@ void print_info()
 }
 #endif
 
+/**
+ * @brief Processes one sensor frame and computes the command for the actuators.
+ *
+ * The frame updates the internal state, the TTC is computed from it and the AEB state is
+ * decided, recorded in the flight recorder, added to the run statistics and counted in the
+ * metrics of the controller. The decision uses a snapshot of the calibration block taken at
+ * the start of the cycle, so parameters retuned with aeb_calibrate apply from the next frame
+ * on [SwR-13] (@ref SwR-13). Used by the controller thread for every frame it reads and by
+ * the single-thread event loop of aeb_loop_bin.
+ *
+ * Requirements [SwR-5] (@ref SwR-5) and [SwR-6] (@ref SwR-6)
+ *
+ * @param captured_frame Sensor frame to be processed.
+ * @param stats Run statistics that receive the decision.
+ * @param now_ms Time of the decision, for the run statistics (aeb_stats_now_ms or a virtual clock).
+ * @return The ID_AEB_S command (ID_ACTUATORS_CMD with `-k`), or the empty message when in standby state.
+ *
+ * \anchor aebControllerStep
+ */
+can_msg aebControllerStep(can_msg captured_frame, aeb_stats *stats, long now_ms)
+{
+    AEB_PROBE1(frame_receive, captured_frame.identifier);
+    uint32_t previous_version = controller_calibration.version;
+    if (calibration_snapshot(&controller_calibration, &active_calibration) == 1 && previous_version != 0)
+    {
+        printf("AEB Controller: calibration updated\n");
+    }
+
+    translateAndCallCanMsg(captured_frame); // Process the received CAN message
+    AEB_PROBE1(frame_decode, captured_frame.identifier);
+
+    double ttc = ttc_calc(aeb_internal_state.obstacle_distance, aeb_internal_state.relative_velocity,
+                          aeb_internal_state.relative_acceleration);
+
+    aeb_controller_state state = getAEBState(aeb_internal_state, ttc);
+    AEB_PROBE2(ttc, aeb_probe_us(ttc), (int)state);
+    flight_recorder_decision(state, ttc);
+    metrics_add(&controller_metrics, CTRL_METRIC_DECISIONS + state, 1);
+    aeb_stats_update(stats, state, aeb_internal_state.has_obstacle ? ttc : AEB_STATS_TTC_MAX, now_ms);
+
+    out_can_frame = updateCanMsgOutput(state);
+    if (state == AEB_STATE_STANDBY)
+    {
+        return empty_msg; // [SwR-5]
+    }
+    return mask_commands ? actuatorsCommandFrame(actuatorsStateFromAebS(&out_can_frame)) : out_can_frame;
+}
+
 /**
  * @brief Translates the received CAN message and calls the appropriate handler
  * function based on the message identifier.
@@ -441,8 +575,11 @@ can_msg updateCanMsgOutput(aeb_controller_state state)
  *
  * This function evaluates the current AEB state based on multiple sensor
  * parameters, such as relative velocity, obstacle presence, and TTC (Time to Collision).
+ * The thresholds and the speed range are those of the current calibration snapshot; a threshold
+ * with a calibration map is interpolated at the current speed and relative acceleration.
  *
- * Requirements [SwR-7] (@ref SwR-7), [SwR-8] (@ref SwR-8), [SwR-12] (@ref SwR-12) and [SwR-16] (@ref SwR-16)
+ * Requirements [SwR-7] (@ref SwR-7), [SwR-8] (@ref SwR-8), [SwR-12] (@ref SwR-12), [SwR-13] (@ref SwR-13)
+ * and [SwR-16] (@ref SwR-16)
  *
  * @param aeb_internal_state The current sensor data for the AEB system.
  * @param ttc The time-to-collision value, calculated based on obstacle distance and vehicle speed.
@@ -455,16 +592,25 @@ aeb_controller_state getAEBState(sensors_input_data aeb_internal_state, double t
     if (aeb_internal_state.aeb_system_enabled == false)
         return AEB_STATE_STANDBY;
 
+    double threshold_alarm = calibration_threshold(&active_calibration.alarm_map, active_calibration.threshold_alarm,
+                                                   aeb_internal_state.relative_velocity,
+                                                   aeb_internal_state.relative_acceleration);
+    double threshold_braking = calibration_threshold(&active_calibration.braking_map,
+                                                     active_calibration.threshold_braking,
+                                                     aeb_internal_state.relative_velocity,
+                                                     aeb_internal_state.relative_acceleration);
+
     if (aeb_internal_state.brake_pedal == false && aeb_internal_state.accelerator_pedal == false &&
-        aeb_internal_state.relative_velocity >= MIN_SPD_ENABLED && aeb_internal_state.relative_velocity <= MAX_SPD_ENABLED)
+        aeb_internal_state.relative_velocity >= active_calibration.min_spd_enabled &&
+        aeb_internal_state.relative_velocity <= active_calibration.max_spd_enabled)
     {
-        if (ttc < THRESHOLD_BRAKING)
+        if (ttc < threshold_braking)
             return AEB_STATE_BRAKE;
-        if (ttc < THRESHOLD_ALARM)
+        if (ttc < threshold_alarm)
             return AEB_STATE_ALARM;
     }
 
-    if (ttc < THRESHOLD_ALARM)
+    if (ttc < threshold_alarm)
         my_new_state = AEB_STATE_ALARM;
 
     return my_new_state;
@@ -0,0 +1,39 @@
+/**
+ * @file aeb_flightrec.c
+ * @brief On-demand dump of the flight recorder.
+ *
+ * Prints the entries kept in the flight recorder shared memory, oldest first. It can be run
+ * while main_bin is running or after a process died, as long as main_bin didn't remove the
+ * segment yet.
+ *
+ * Usage: `aeb_flightrec [output]`. Without arguments it prints to stdout.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "constants.h"
+#include "flight_recorder.h"
+
+#ifndef TEST_MODE
+int main(int argc, char *argv[])
+{
+    FILE *out = stdout;
+    if (argc > 1)
+    {
+        out = fopen(argv[1], "w");
+        if (out == NULL)
+        {
+            perror("Error opening output file");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    long entries = flight_recorder_dump(FLIGHT_RECORDER_SHM, out);
+
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+    return entries < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+#endif
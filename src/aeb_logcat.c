@@ -0,0 +1,67 @@
+/**
+ * @file aeb_logcat.c
+ * @brief Offline decoder of the binary event log.
+ *
+ * Prints a binary log (`actuators_bin -b`) or a journal (`actuators_bin -j`) in the same
+ * text format as log/log.txt. Journals are recognized by their header and can be decoded
+ * while the actuators are still writing them.
+ *
+ * Usage: `aeb_logcat [binary_log [text_output]]`. Without arguments it decodes log/log.bin
+ * to stdout; `-` reads the binary log from stdin.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "log_utils.h"
+#include "log_binary.h"
+#include "log_journal.h"
+
+#ifndef TEST_MODE
+int main(int argc, char *argv[])
+{
+    const char *in_path = argc > 1 ? argv[1] : LOG_BINARY_PATH;
+    FILE *out = stdout;
+    if (argc > 2)
+    {
+        out = fopen(argv[2], "w");
+        if (out == NULL)
+        {
+            perror("Error opening output file");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    FILE *in = strcmp(in_path, "-") == 0 ? stdin : fopen(in_path, "rb");
+    if (in == NULL)
+    {
+        perror("Error opening binary log");
+        exit(EXIT_FAILURE);
+    }
+
+    long decoded;
+    char magic[sizeof(LOG_JOURNAL_MAGIC)] = {0};
+    if (in != stdin && fread(magic, sizeof(magic), 1, in) == 1 && memcmp(magic, LOG_JOURNAL_MAGIC, sizeof(magic)) == 0)
+    {
+        decoded = log_journal_decode(in_path, out);
+    }
+    else
+    {
+        if (in != stdin)
+        {
+            rewind(in);
+        }
+        decoded = log_bin_decode(in, out);
+    }
+
+    if (in != stdin)
+    {
+        fclose(in);
+    }
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+    return decoded < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+#endif
@@ -0,0 +1,61 @@
+/**
+ * @file aeb_logq.c
+ * @brief Indexed queries over a text or binary event log.
+ *
+ * Builds the sidecar index `<log>.idx` on first use (and again whenever the log changed),
+ * then prints the matching records in the text log format.
+ *
+ * Usage: `aeb_logq [-f from_ms] [-t to_ms] [-e event_id] [-x] [log]`. Without a log it
+ * queries log/log.txt.
+ * - `-f` / `-t`: time range, inclusive, in milliseconds since the epoch (TIMESTAMP column).
+ * - `-e`: only records with this EVENT_ID (hexadecimal, as printed in the log).
+ * - `-x`: only state transitions (records that change the actuators state).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <unistd.h>
+#include "log_utils.h"
+#include "log_index.h"
+
+#ifndef TEST_MODE
+int main(int argc, char *argv[])
+{
+    log_query query = {.from_ms = LONG_MIN, .to_ms = LONG_MAX};
+    int opt;
+
+    while ((opt = getopt(argc, argv, "f:t:e:x")) != -1)
+    {
+        switch (opt)
+        {
+        case 'f':
+            query.from_ms = strtol(optarg, NULL, 10);
+            break;
+        case 't':
+            query.to_ms = strtol(optarg, NULL, 10);
+            break;
+        case 'e':
+            query.by_event = true;
+            query.event_id = strtoul(optarg, NULL, 16);
+            break;
+        case 'x':
+            query.transitions = true;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-f from_ms] [-t to_ms] [-e event_id] [-x] [log]\n", argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    const char *log_path = optind < argc ? argv[optind] : LOG_FILE_PATH;
+
+    log_index index;
+    if (log_index_open(&index, log_path) != 0)
+    {
+        exit(EXIT_FAILURE);
+    }
+    log_index_query(&index, &query, stdout);
+    log_index_close(&index);
+    return EXIT_SUCCESS;
+}
+#endif
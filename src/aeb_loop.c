@@ -0,0 +1,270 @@
+/**
+ * @file aeb_loop.c
+ * @brief Cooperative deployment: sensors, controller and actuators as tasks of a single thread.
+ *
+ * aeb_loop_bin runs the three modules as run-to-completion tasks of one event loop, with no
+ * thread, lock or IPC between them. Each task is the step function of its module, called at
+ * the module's own period:
+ * - sensors: sensorsStep, at the tick of the transmit schedule, replaying the scenario;
+ * - controller: aebControllerStep on the next sensor frame, every AEB_LOOP_CYCLE_MS;
+ * - actuators: actuatorsStep on the next command, every AEB_LOOP_CYCLE_MS.
+ *
+ * The tasks exchange frames through in-memory FIFOs. A single timerfd ticks at the greatest
+ * common divisor of the task periods, and on every tick the due tasks run in pipeline order
+ * (sensors, controller, actuators). The loop runs each missed tick in turn instead of skipping
+ * it, so the order of execution and every decision depend only on the scenario. The
+ * controller and the actuators stop after LOOP_EMPTY_ITERATIONS_MAX cycles without input, as in
+ * their own processes.
+ *
+ * Usage: `aeb_loop_bin [-x] [scenario]`. The scenario is tcs/cenario.txt by default. With `-x`
+ * the loop doesn't wait for the timer: the virtual clock jumps from tick to tick, so a scenario
+ * is replayed as fast as possible with the same decisions.
+ *
+ * The log is written synchronously by the loop (no logger thread). The flight recorder, the
+ * actuator subscribers and the mailbox are not used.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+#include "constants.h"
+#include "file_reader.h"
+#include "sensors.h"
+#include "actuators.h"
+#include "log_utils.h"
+#include "aeb_stats.h"
+#include "spsc_queue.h"
+
+#define AEB_LOOP_CYCLE_MS 200 // Period of the controller and actuators loops
+#define AEB_LOOP_QUEUE_CAPACITY 16
+#define LOOP_EMPTY_ITERATIONS_MAX 11
+
+can_msg aebControllerStep(can_msg captured_frame, aeb_stats *stats, long now_ms);
+
+/**
+ * @brief Task of the event loop.
+ */
+typedef struct
+{
+    unsigned int period_ms;
+    bool (*step)(unsigned long now_ms); // Runs the task once; returns false when it is over
+    unsigned long next_due_ms;
+    bool running;
+} aeb_loop_task;
+
+static spsc_queue sensor_frames;      // Sensors -> controller
+static spsc_queue actuator_commands;  // Controller -> actuators
+static sensors_replay replay;
+static aeb_stats run_stats;
+static unsigned long dropped_frames;  // Frames sent to a full FIFO
+
+/**
+ * @brief Reads the next scenario row from the file.
+ */
+static bool readScenarioRow(void *source, sensors_input_data *row)
+{
+    return read_sensor_data(source, row);
+}
+
+static void pushFrame(spsc_queue *queue, const can_msg *frame)
+{
+    if (spsc_push(queue, frame) != 0)
+    {
+        dropped_frames++;
+    }
+}
+
+/**
+ * @brief Sensors task: sends the frames due at this tick.
+ */
+static bool sensorsTask(unsigned long now_ms)
+{
+    can_msg frames[SENSORS_TX_FRAMES];
+    size_t count = sensorsStep(&replay, now_ms, frames);
+    for (size_t i = 0; i < count; i++)
+    {
+        pushFrame(&sensor_frames, &frames[i]);
+    }
+    if (!replay.has_row)
+    {
+        printf("EOF reached.\n");
+    }
+    return replay.has_row;
+}
+
+/**
+ * @brief Controller task: decides on the next sensor frame and commands the actuators.
+ */
+static bool controllerTask(unsigned long now_ms)
+{
+    static int empty_cycles = 0;
+    static unsigned long last_save_ms = 0;
+    can_msg frame;
+
+    if (spsc_pop(&sensor_frames, &frame) == 0)
+    {
+        empty_cycles = 0;
+        can_msg command = aebControllerStep(frame, &run_stats, now_ms);
+        pushFrame(&actuator_commands, &command);
+    }
+    else
+    {
+        empty_cycles++;
+    }
+
+    if (now_ms - last_save_ms >= AEB_STATS_SAVE_INTERVAL_MS)
+    {
+        aeb_stats_save(&run_stats, AEB_STATS_PATH);
+        last_save_ms = now_ms;
+    }
+    if (empty_cycles < LOOP_EMPTY_ITERATIONS_MAX)
+    {
+        return true;
+    }
+    aeb_stats_finish(&run_stats, now_ms);
+    aeb_stats_save(&run_stats, AEB_STATS_PATH);
+    printf("AEB Controller: empty_mq_counter reached the limit, exiting\n");
+    return false;
+}
+
+/**
+ * @brief Actuators task: applies the next command and logs the actuators state.
+ */
+static bool actuatorsTask(unsigned long now_ms)
+{
+    static int empty_cycles = 0;
+    can_msg command;
+
+    if (spsc_pop(&actuator_commands, &command) == 0)
+    {
+        empty_cycles = 0;
+        actuatorsStep(&command);
+    }
+    else
+    {
+        empty_cycles++;
+        actuatorsStep(NULL);
+    }
+
+    if (empty_cycles < LOOP_EMPTY_ITERATIONS_MAX)
+    {
+        return true;
+    }
+    printf("Actuators: empty_mq_counter reached the limit, exiting\n");
+    return false;
+}
+
+/**
+ * @brief Runs the tasks until every one of them is over.
+ *
+ * @param tasks Tasks, in the order they run when due at the same tick.
+ * @param count Number of tasks.
+ * @param wait If false, ticks follow each other without waiting for the timer.
+ */
+static void runTasks(aeb_loop_task *tasks, size_t count, bool wait)
+{
+    unsigned int tick_ms = tasks[0].period_ms;
+    for (size_t i = 1; i < count; i++)
+    {
+        tick_ms = periodGcd(tick_ms, tasks[i].period_ms);
+    }
+
+    struct itimerspec timer_spec = {
+        .it_interval = {.tv_sec = tick_ms / 1000, .tv_nsec = (tick_ms % 1000) * 1000000L},
+        .it_value = {.tv_sec = tick_ms / 1000, .tv_nsec = (tick_ms % 1000) * 1000000L}};
+    int timer_fd = timerfd_create(CLOCK_MONOTONIC, 0);
+    if (timer_fd == -1 || timerfd_settime(timer_fd, 0, &timer_spec, NULL) == -1)
+    {
+        perror("AEB loop: it wasn't possible to create the timer\n");
+        exit(55);
+    }
+
+    unsigned long now_ms = 0;
+    uint64_t pending_ticks = 1; // The first tick runs at once
+    size_t running = count;
+    while (running > 0)
+    {
+        for (; pending_ticks > 0 && running > 0; pending_ticks--, now_ms += tick_ms)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                if (!tasks[i].running || tasks[i].next_due_ms > now_ms)
+                {
+                    continue;
+                }
+                tasks[i].next_due_ms += tasks[i].period_ms;
+                tasks[i].running = tasks[i].step(now_ms);
+                running -= !tasks[i].running;
+            }
+        }
+
+        if (!wait)
+        {
+            pending_ticks = 1;
+        }
+        else if (running > 0 && read(timer_fd, &pending_ticks, sizeof(pending_ticks)) != sizeof(pending_ticks))
+        {
+            pending_ticks = 0; // Interrupted: wait again
+        }
+    }
+    close(timer_fd);
+}
+
+#ifndef TEST_MODE
+int main(int argc, char *argv[])
+{
+    const char *scenario = "tcs/cenario.txt";
+    bool wait = true;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "x")) != -1)
+    {
+        if (opt != 'x')
+        {
+            fprintf(stderr, "Usage: %s [-x] [scenario]\n", argv[0]);
+            exit(EXIT_FAILURE);
+        }
+        wait = false; // Replay as fast as possible
+    }
+    if (optind < argc)
+    {
+        scenario = argv[optind];
+    }
+
+    // The loop is the only thread: events are written as they happen [SwR-4]
+    log_config logging = {.path = LOG_FILE_PATH, .flush_policy = LOG_FLUSH_EVERY_EVENT, .async = false};
+    log_init(&logging);
+
+    if (spsc_init(&sensor_frames, AEB_LOOP_QUEUE_CAPACITY, sizeof(can_msg)) != 0 ||
+        spsc_init(&actuator_commands, AEB_LOOP_QUEUE_CAPACITY, sizeof(can_msg)) != 0)
+    {
+        perror("AEB loop: it wasn't possible to create the task queues\n");
+        exit(55);
+    }
+    FILE *file = open_file(scenario);
+    sensorsReplayStart(&replay, readScenarioRow, file);
+    aeb_stats_init(&run_stats);
+
+    // Pipeline order: a frame sent at a tick is decided and applied at the same tick
+    aeb_loop_task tasks[] = {
+        {replay.tick_ms, sensorsTask, 0, true},        // Sensors
+        {AEB_LOOP_CYCLE_MS, controllerTask, 0, true}, // Controller
+        {AEB_LOOP_CYCLE_MS, actuatorsTask, 0, true}}; // Actuators
+    runTasks(tasks, sizeof(tasks) / sizeof(tasks[0]), wait);
+
+    if (dropped_frames > 0)
+    {
+        printf("AEB loop: %lu frames dropped, the task queues were full\n", dropped_frames);
+    }
+    fclose(file);
+    spsc_destroy(&sensor_frames);
+    spsc_destroy(&actuator_commands);
+    log_shutdown();
+
+    printf("Execution finished, check out log/log.txt for info!\n");
+    return EXIT_SUCCESS;
+}
+#endif
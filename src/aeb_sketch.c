@@ -0,0 +1,63 @@
+/**
+ * @file aeb_sketch.c
+ * @brief Merges the statistics of many controller runs into fleet-level percentiles.
+ *
+ * Usage: `aeb_sketch [-o merged.qsk] [stats.qsk ...]`. Without files it prints the
+ * statistics of the last run (log/stats.qsk). With `-o` the merged sketches are also
+ * saved, so they can be merged again later.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "aeb_stats.h"
+
+#ifndef TEST_MODE
+int main(int argc, char *argv[])
+{
+    const char *out_path = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "o:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'o':
+            out_path = optarg;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-o merged.qsk] [stats.qsk ...]\n", argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // Sketches are large: keep them off the stack
+    static aeb_stats merged, run;
+    aeb_stats_init(&merged);
+
+    int runs = 0;
+    const char *default_path = AEB_STATS_PATH;
+    char **paths = optind < argc ? &argv[optind] : (char **)&default_path;
+    int path_count = optind < argc ? argc - optind : 1;
+    for (int i = 0; i < path_count; i++)
+    {
+        if (aeb_stats_load(&run, paths[i]) == 0)
+        {
+            aeb_stats_merge(&merged, &run);
+            runs++;
+        }
+    }
+    if (runs == 0)
+    {
+        exit(EXIT_FAILURE);
+    }
+
+    printf("%d run(s)\n", runs);
+    aeb_stats_print(&merged, stdout);
+    if (out_path != NULL && aeb_stats_save(&merged, out_path) != 0)
+    {
+        exit(EXIT_FAILURE);
+    }
+    return EXIT_SUCCESS;
+}
+#endif
@@ -0,0 +1,111 @@
+/**
+ * @file aeb_stat.c
+ * @brief Samples the metrics segment of the running processes, like vmstat.
+ *
+ * Prints one line per registered thread: its block name, its pid and its metrics. A counter is
+ * shown as its total on the first line of a thread and as its change since the previous sample
+ * afterwards; a gauge is shown as is. aeb_stat only reads the shared memory, so it adds no work
+ * and no system call to the processes it observes.
+ *
+ * Usage: `aeb_stat [interval [count]]`. The interval is in seconds (e.g. 0.5). Without an
+ * interval a single sample is printed; without a count it samples until the segment is removed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "constants.h"
+#include "metrics.h"
+
+#ifndef TEST_MODE
+static metrics_sample previous[METRICS_BLOCKS];
+static int has_previous[METRICS_BLOCKS];
+
+/**
+ * @brief Prints one line per registered block.
+ *
+ * @return 0 on success, -1 if there is no metrics segment.
+ */
+static int print_sample(double elapsed_s)
+{
+    const metrics_header *header = metrics_open(METRICS_SHM);
+    if (header == NULL)
+    {
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < METRICS_BLOCKS; i++)
+    {
+        metrics_sample sample;
+        if (metrics_read(header, i, &sample) != 1)
+        {
+            has_previous[i] = 0;
+            continue;
+        }
+        // Deltas only against the same registration of the same block
+        int delta = has_previous[i] && previous[i].generation == sample.generation && previous[i].pid == sample.pid;
+
+        printf("%8.1f %-11s %7d ", elapsed_s, sample.name, sample.pid);
+        for (uint32_t j = 0; j < sample.count; j++)
+        {
+            uint64_t value = sample.value[j];
+            if (sample.kind[j] == METRIC_COUNTER && delta)
+            {
+                value -= previous[i].value[j];
+            }
+            printf(" %s=%llu", sample.metric_name[j], (unsigned long long)value);
+        }
+        printf("\n");
+
+        previous[i] = sample;
+        has_previous[i] = 1;
+    }
+    metrics_close(header);
+    fflush(stdout);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    double interval_s = 0;
+    long count = 1;
+
+    if (argc > 3 || (argc > 1 && (interval_s = atof(argv[1])) <= 0))
+    {
+        fprintf(stderr, "Usage: %s [interval [count]]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    if (argc > 1)
+    {
+        count = argc > 2 ? atol(argv[2]) : -1; // -1: until the segment is removed
+    }
+
+    struct timespec start, now;
+    struct timespec interval = {.tv_sec = (time_t)interval_s,
+                                .tv_nsec = (long)((interval_s - (time_t)interval_s) * 1e9)};
+    const metrics_header *header = metrics_open(METRICS_SHM);
+    if (header == NULL)
+    {
+        fprintf(stderr, "No metrics segment: is main_bin running?\n");
+        exit(EXIT_FAILURE);
+    }
+    metrics_close(header);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    printf("%8s %-11s %7s  %s\n", "time_s", "block", "pid", "metrics (counters: change since the previous line)");
+    for (long sample = 0; count < 0 || sample < count; sample++)
+    {
+        if (sample > 0)
+        {
+            nanosleep(&interval, NULL);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        double elapsed_s = (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+        if (print_sample(elapsed_s) != 0)
+        {
+            break; // main_bin removed the segment at the end of the run
+        }
+    }
+    return EXIT_SUCCESS;
+}
+#endif
@@ -0,0 +1,244 @@
+/**
+ * @file aeb_stats.c
+ * @brief Run statistics of the AEB controller (see aeb_stats.h).
+ *
+ * A statistics file is an aeb_stats_file_header followed by the AEB_STATS_SKETCHES
+ * sketches, each preceded by its name. The header records the bucket layout, so files
+ * written with another sketch configuration are rejected instead of merged. Like the
+ * binary log, the file is stored in the byte order of the host that wrote it.
+ */
+
+#include <math.h>
+#include <string.h>
+#include <time.h>
+#include "aeb_stats.h"
+#include "aeb_probes.h"
+
+static const char *sketch_names[AEB_STATS_SKETCHES] = {
+    "ttc", "dwell_active", "dwell_alarm", "dwell_brake", "dwell_standby", "alarm_to_brake"};
+
+/**
+ * @brief Empties the statistics of a run.
+ *
+ * @param stats Statistics to be initialized.
+ * \anchor aeb_stats_init
+ */
+void aeb_stats_init(aeb_stats *stats)
+{
+    for (int i = 0; i < AEB_STATS_SKETCHES; i++)
+    {
+        qsketch_init(&stats->sketches[i]);
+    }
+    stats->state = -1;
+    stats->entered_ms = 0;
+    stats->alarm_ms = -1;
+}
+
+/**
+ * @brief Current CLOCK_MONOTONIC time, in milliseconds.
+ *
+ * \anchor aeb_stats_now_ms
+ */
+long aeb_stats_now_ms(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Adds one controller decision to the statistics.
+ *
+ * @param stats Statistics of the run.
+ * @param state State decided by the controller (aeb_controller_state).
+ * @param ttc TTC that led to it, in seconds; values of no possible collision are ignored.
+ * @param now_ms Time of the decision (aeb_stats_now_ms).
+ * \anchor aeb_stats_update
+ */
+void aeb_stats_update(aeb_stats *stats, int state, double ttc, long now_ms)
+{
+    if (ttc > 0.0 && ttc < AEB_STATS_TTC_MAX)
+    {
+        qsketch_add(&stats->sketches[AEB_STATS_TTC], ttc);
+    }
+    if (state == stats->state || state < 0 || state >= AEB_STATS_STATES)
+    {
+        return;
+    }
+
+    AEB_PROBE3(state_change, stats->state, state, now_ms);
+    if (stats->state >= 0)
+    {
+        qsketch_add(&stats->sketches[AEB_STATS_DWELL + stats->state], (now_ms - stats->entered_ms) / 1000.0);
+    }
+    if (state == AEB_STATS_STATE_ALARM)
+    {
+        stats->alarm_ms = now_ms;
+    }
+    else if (state == AEB_STATS_STATE_BRAKE)
+    {
+        if (stats->alarm_ms >= 0)
+        {
+            qsketch_add(&stats->sketches[AEB_STATS_ALARM_TO_BRAKE], (now_ms - stats->alarm_ms) / 1000.0);
+        }
+        stats->alarm_ms = -1;
+    }
+    else
+    {
+        stats->alarm_ms = -1; // The alarm ended without braking
+    }
+    stats->state = state;
+    stats->entered_ms = now_ms;
+}
+
+/**
+ * @brief Closes the time spent in the current state, at the end of the run.
+ *
+ * @param stats Statistics of the run.
+ * @param now_ms End of the run (aeb_stats_now_ms).
+ * \anchor aeb_stats_finish
+ */
+void aeb_stats_finish(aeb_stats *stats, long now_ms)
+{
+    if (stats->state >= 0)
+    {
+        qsketch_add(&stats->sketches[AEB_STATS_DWELL + stats->state], (now_ms - stats->entered_ms) / 1000.0);
+    }
+    stats->state = -1;
+    stats->alarm_ms = -1;
+}
+
+/**
+ * @brief Adds the sketches of another run.
+ *
+ * @param into Statistics that receive the values.
+ * @param from Statistics to be merged.
+ * \anchor aeb_stats_merge
+ */
+void aeb_stats_merge(aeb_stats *into, const aeb_stats *from)
+{
+    for (int i = 0; i < AEB_STATS_SKETCHES; i++)
+    {
+        qsketch_merge(&into->sketches[i], &from->sketches[i]);
+    }
+}
+
+/**
+ * @brief Name of a sketch, as stored in the statistics file.
+ *
+ * \anchor aeb_stats_name
+ */
+const char *aeb_stats_name(int sketch)
+{
+    return sketch >= 0 && sketch < AEB_STATS_SKETCHES ? sketch_names[sketch] : "unknown";
+}
+
+/**
+ * @brief Writes the sketches of a run to a statistics file.
+ *
+ * @param stats Statistics to be saved.
+ * @param path Statistics file, replaced atomically.
+ * @return 0 on success, -1 on write error.
+ * \anchor aeb_stats_save
+ */
+int aeb_stats_save(const aeb_stats *stats, const char *path)
+{
+    char tmp_path[256];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE *file = fopen(tmp_path, "wb");
+    if (file == NULL)
+    {
+        perror("Error opening the statistics file");
+        return -1;
+    }
+
+    aeb_stats_file_header header = {
+        .version = AEB_STATS_VERSION,
+        .sketches = AEB_STATS_SKETCHES,
+        .buckets = QSKETCH_BUCKETS,
+        .relative_accuracy = QSKETCH_RELATIVE_ACCURACY,
+        .min_value = QSKETCH_MIN_VALUE};
+    memcpy(header.magic, AEB_STATS_MAGIC, sizeof(AEB_STATS_MAGIC));
+
+    int written = fwrite(&header, sizeof(header), 1, file);
+    for (int i = 0; i < AEB_STATS_SKETCHES; i++)
+    {
+        char name[AEB_STATS_NAME_MAX] = {0};
+        strncpy(name, sketch_names[i], sizeof(name) - 1);
+        written += fwrite(name, sizeof(name), 1, file);
+        written += fwrite(&stats->sketches[i], sizeof(qsketch), 1, file);
+    }
+    if (fclose(file) != 0 || written != 1 + 2 * AEB_STATS_SKETCHES || rename(tmp_path, path) != 0)
+    {
+        perror("Error writing the statistics file");
+        remove(tmp_path);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Reads the sketches of a statistics file.
+ *
+ * @param stats Statistics that receive the sketches.
+ * @param path Statistics file.
+ * @return 0 on success, -1 if the file is missing or isn't a compatible statistics file.
+ * \anchor aeb_stats_load
+ */
+int aeb_stats_load(aeb_stats *stats, const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+    {
+        perror("Error opening the statistics file");
+        return -1;
+    }
+
+    aeb_stats_init(stats);
+    aeb_stats_file_header header;
+    int valid = fread(&header, sizeof(header), 1, file) == 1 &&
+                memcmp(header.magic, AEB_STATS_MAGIC, sizeof(AEB_STATS_MAGIC)) == 0 &&
+                header.version == AEB_STATS_VERSION && header.sketches == AEB_STATS_SKETCHES &&
+                header.buckets == QSKETCH_BUCKETS && header.relative_accuracy == QSKETCH_RELATIVE_ACCURACY &&
+                header.min_value == QSKETCH_MIN_VALUE;
+
+    for (int i = 0; valid && i < AEB_STATS_SKETCHES; i++)
+    {
+        char name[AEB_STATS_NAME_MAX];
+        valid = fread(name, sizeof(name), 1, file) == 1 && strncmp(name, sketch_names[i], sizeof(name)) == 0 &&
+                fread(&stats->sketches[i], sizeof(qsketch), 1, file) == 1;
+    }
+    fclose(file);
+
+    if (!valid)
+    {
+        fprintf(stderr, "%s: not a compatible statistics file\n", path);
+        aeb_stats_init(stats);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Prints the count and the main percentiles of every sketch.
+ *
+ * \anchor aeb_stats_print
+ */
+void aeb_stats_print(const aeb_stats *stats, FILE *out)
+{
+    static const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+    fprintf(out, "%-16s %10s %10s %10s %10s %10s %10s %10s\n", "SKETCH (s)", "COUNT", "MIN", "P50", "P90", "P99",
+            "P99.9", "MAX");
+    for (int i = 0; i < AEB_STATS_SKETCHES; i++)
+    {
+        const qsketch *sketch = &stats->sketches[i];
+        fprintf(out, "%-16s %10llu %10.3f", sketch_names[i], (unsigned long long)sketch->count,
+                sketch->count > 0 ? sketch->min : NAN);
+        for (size_t q = 0; q < sizeof(quantiles) / sizeof(quantiles[0]); q++)
+        {
+            fprintf(out, " %10.3f", qsketch_quantile(sketch, quantiles[q]));
+        }
+        fprintf(out, " %10.3f\n", sketch->count > 0 ? sketch->max : NAN);
+    }
+}
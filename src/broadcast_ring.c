@@ -0,0 +1,341 @@
+/**
+ * @file broadcast_ring.c
+ * @brief Writer and readers of the shared memory broadcast ring.
+ *
+ * The writer owns the `next` position, so publishing needs no read-modify-write: the slot's
+ * sequence is cleared, the frame is stored with plain stores, the sequence is set to
+ * position + 1 and `next` is advanced, both with release ordering. A reader accepts a slot
+ * only if its sequence is the expected one before and after copying it (as the flight
+ * recorder dumper does), so a frame overwritten while it was copied is detected and counted
+ * as lost.
+ *
+ * Sleeping readers wait on a futex word bumped by every publication; the writer makes the
+ * wake-up system call only when some reader is sleeping.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include "broadcast_ring.h"
+#include "constants.h"
+
+_Static_assert(sizeof(broadcast_slot) == 32, "Broadcast slot must be 32 bytes");
+_Static_assert(sizeof(broadcast_header) % BROADCAST_CACHE_LINE == 0, "Broadcast slots must start on a cache line");
+
+static size_t segment_size(uint32_t capacity)
+{
+    return sizeof(broadcast_header) + (size_t)capacity * sizeof(broadcast_slot);
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * @brief Creates (or resets) the broadcast ring segment.
+ *
+ * @param name POSIX shared memory name, e.g. BROADCAST_SHM.
+ * @param capacity Number of slots (power of two).
+ * @return 0 on success, -1 on invalid capacity or shared memory error.
+ * \anchor broadcast_create
+ */
+int broadcast_create(const char *name, uint32_t capacity)
+{
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0)
+    {
+        return -1;
+    }
+
+    int fd = shm_open(name, O_CREAT | O_RDWR, SHM_PERMISSIONS);
+    if (fd == -1)
+    {
+        perror("Error creating broadcast ring");
+        return -1;
+    }
+    size_t size = segment_size(capacity);
+    if (ftruncate(fd, 0) != 0 || ftruncate(fd, size) != 0)
+    {
+        perror("Error sizing broadcast ring");
+        close(fd);
+        return -1;
+    }
+    broadcast_header *header = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (header == MAP_FAILED)
+    {
+        perror("Error mapping broadcast ring");
+        return -1;
+    }
+
+    // The segment is zero filled: every sequence is 0 (empty) and every cursor is free
+    header->capacity = capacity;
+    header->slot_size = sizeof(broadcast_slot);
+    atomic_init(&header->next, 0);
+    atomic_thread_fence(memory_order_release);
+    memcpy(header->magic, BROADCAST_MAGIC, sizeof(BROADCAST_MAGIC));
+
+    munmap(header, size);
+    return 0;
+}
+
+/**
+ * @brief Maps an existing broadcast ring and checks its header.
+ *
+ * @param ring Receives the mapping.
+ * @param name POSIX shared memory name used by broadcast_create.
+ * @return 0 on success, -1 if there is no valid broadcast ring, e.g. a capacity that is not a
+ * nonzero power of two (ring->header stays NULL).
+ * \anchor broadcast_attach
+ */
+int broadcast_attach(broadcast_ring *ring, const char *name)
+{
+    ring->header = NULL;
+    ring->slots = NULL;
+
+    int fd = shm_open(name, O_RDWR, SHM_PERMISSIONS);
+    if (fd == -1)
+    {
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(broadcast_header))
+    {
+        close(fd);
+        return -1;
+    }
+    broadcast_header *header = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (header == MAP_FAILED)
+    {
+        return -1;
+    }
+    uint32_t capacity = header->capacity; // The positions are masked with capacity - 1
+    if (memcmp(header->magic, BROADCAST_MAGIC, sizeof(BROADCAST_MAGIC)) != 0 ||
+        header->slot_size != sizeof(broadcast_slot) || capacity == 0 || (capacity & (capacity - 1)) != 0 ||
+        segment_size(capacity) > (size_t)st.st_size)
+    {
+        munmap(header, st.st_size);
+        return -1;
+    }
+    ring->slots = (broadcast_slot *)((char *)header + sizeof(broadcast_header));
+    ring->size = st.st_size;
+    ring->header = header;
+    return 0;
+}
+
+/**
+ * @brief Unmaps a broadcast ring; further publications through it are ignored.
+ *
+ * \anchor broadcast_detach
+ */
+void broadcast_detach(broadcast_ring *ring)
+{
+    if (ring->header == NULL)
+    {
+        return;
+    }
+    munmap(ring->header, ring->size);
+    ring->header = NULL;
+    ring->slots = NULL;
+}
+
+/**
+ * @brief Removes the broadcast ring name (mappings stay valid until detached).
+ *
+ * \anchor broadcast_destroy
+ */
+void broadcast_destroy(const char *name)
+{
+    shm_unlink(name);
+}
+
+/**
+ * @brief Publishes a frame to every reader. Only one process may publish to a ring.
+ *
+ * @param ring Ring attached by the writer; nothing is done if it isn't attached.
+ * @param frame Frame to be published.
+ * \anchor broadcast_publish
+ */
+void broadcast_publish(broadcast_ring *ring, const can_msg *frame)
+{
+    broadcast_header *header = ring->header;
+    if (header == NULL)
+    {
+        return;
+    }
+    uint64_t position = atomic_load_explicit(&header->next, memory_order_relaxed);
+    broadcast_slot *slot = &ring->slots[position & (header->capacity - 1)];
+
+    atomic_store_explicit(&slot->sequence, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    slot->timestamp_ns = now_ns();
+    slot->identifier = frame->identifier;
+    memcpy(slot->data, frame->dataFrame, sizeof(slot->data));
+    atomic_store_explicit(&slot->sequence, position + 1, memory_order_release);
+    atomic_store_explicit(&header->next, position + 1, memory_order_release);
+
+    atomic_fetch_add(&header->futex, 1);
+    if (atomic_load(&header->waiters) != 0)
+    {
+        syscall(SYS_futex, &header->futex, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+    }
+}
+
+/**
+ * @brief Claims a reader cursor, positioned on the next frame to be published.
+ *
+ * The cursor of a reader whose process died is reclaimed.
+ *
+ * @param ring Attached ring.
+ * @param reader Receives the reader.
+ * @return 0 on success, -1 if every cursor is in use.
+ * \anchor broadcast_subscribe
+ */
+int broadcast_subscribe(broadcast_ring *ring, broadcast_reader *reader)
+{
+    broadcast_header *header = ring->header;
+    for (int i = 0; i < BROADCAST_MAX_READERS; i++)
+    {
+        broadcast_cursor *cursor = &header->cursors[i];
+        uint32_t free_cursor = 0;
+        if (!atomic_compare_exchange_strong(&cursor->in_use, &free_cursor, 1))
+        {
+            if (cursor->pid == getpid() || kill(cursor->pid, 0) == 0 || errno != ESRCH)
+            {
+                continue;
+            }
+            // Owner is gone: take the cursor over unless another reader just did
+            uint32_t used = 1;
+            int32_t dead_pid = cursor->pid;
+            if (!atomic_compare_exchange_strong(&cursor->in_use, &used, 2) || cursor->pid != dead_pid)
+            {
+                continue;
+            }
+        }
+        cursor->pid = getpid();
+        reader->ring = ring;
+        reader->cursor = cursor;
+        reader->position = atomic_load_explicit(&header->next, memory_order_acquire);
+        atomic_store_explicit(&cursor->position, reader->position, memory_order_relaxed);
+        atomic_store_explicit(&cursor->lost, 0, memory_order_relaxed);
+        atomic_store_explicit(&cursor->in_use, 1, memory_order_release);
+        return 0;
+    }
+    return -1;
+}
+
+/**
+ * @brief Releases the cursor of a reader.
+ *
+ * \anchor broadcast_unsubscribe
+ */
+void broadcast_unsubscribe(broadcast_reader *reader)
+{
+    if (reader->cursor == NULL)
+    {
+        return;
+    }
+    reader->cursor->pid = 0;
+    atomic_store_explicit(&reader->cursor->in_use, 0, memory_order_release);
+    reader->cursor = NULL;
+}
+
+/**
+ * @brief Reads the next frame of a reader, without waiting.
+ *
+ * @param reader Subscribed reader.
+ * @param frame Receives the frame.
+ * @param timestamp_ns Receives the CLOCK_MONOTONIC time of its publication (may be NULL).
+ * @return 0 if a frame was read, -1 if the reader is up to date.
+ * \anchor broadcast_read
+ */
+int broadcast_read(broadcast_reader *reader, can_msg *frame, uint64_t *timestamp_ns)
+{
+    broadcast_header *header = reader->ring->header;
+    for (;;)
+    {
+        uint64_t next = atomic_load_explicit(&header->next, memory_order_acquire);
+        if (reader->position == next)
+        {
+            return -1;
+        }
+        if (next - reader->position > header->capacity)
+        {
+            // Lapped by the writer: resume at the oldest frame still kept
+            atomic_fetch_add_explicit(&reader->cursor->lost, next - header->capacity - reader->position,
+                                      memory_order_relaxed);
+            reader->position = next - header->capacity;
+        }
+
+        const broadcast_slot *slot = &reader->ring->slots[reader->position & (header->capacity - 1)];
+        uint64_t expected = reader->position + 1;
+        if (atomic_load_explicit(&((broadcast_slot *)slot)->sequence, memory_order_acquire) == expected)
+        {
+            broadcast_slot copy;
+            memcpy(&copy, slot, sizeof(copy));
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&((broadcast_slot *)slot)->sequence, memory_order_relaxed) == expected)
+            {
+                frame->identifier = copy.identifier;
+                memcpy(frame->dataFrame, copy.data, sizeof(frame->dataFrame));
+                if (timestamp_ns != NULL)
+                {
+                    *timestamp_ns = copy.timestamp_ns;
+                }
+                reader->position++;
+                atomic_store_explicit(&reader->cursor->position, reader->position, memory_order_relaxed);
+                return 0;
+            }
+        }
+        // Overwritten by a newer lap while it was copied
+        atomic_fetch_add_explicit(&reader->cursor->lost, 1, memory_order_relaxed);
+        reader->position++;
+    }
+}
+
+/**
+ * @brief Sleeps until the reader has a frame to read.
+ *
+ * @param reader Subscribed reader.
+ * @param timeout_ms Maximum time to wait.
+ * @return 0 if a frame can be read, -1 on timeout.
+ * \anchor broadcast_wait
+ */
+int broadcast_wait(broadcast_reader *reader, unsigned int timeout_ms)
+{
+    broadcast_header *header = reader->ring->header;
+    uint64_t deadline_ns = now_ns() + (uint64_t)timeout_ms * 1000000ULL;
+
+    for (;;)
+    {
+        uint32_t seen = atomic_load(&header->futex);
+        if (atomic_load_explicit(&header->next, memory_order_acquire) != reader->position)
+        {
+            return 0;
+        }
+        uint64_t now = now_ns();
+        if (now >= deadline_ns)
+        {
+            return -1;
+        }
+        struct timespec timeout = {.tv_sec = (deadline_ns - now) / 1000000000ULL,
+                                   .tv_nsec = (deadline_ns - now) % 1000000000ULL};
+
+        // A publication after `seen` was loaded changes the word, so the wait returns at once
+        atomic_fetch_add(&header->waiters, 1);
+        syscall(SYS_futex, &header->futex, FUTEX_WAIT, seen, &timeout, NULL, 0);
+        atomic_fetch_sub(&header->waiters, 1);
+    }
+}
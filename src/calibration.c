@@ -0,0 +1,586 @@
+/**
+ * @file calibration.c
+ * @brief Calibration block in shared memory: creation, sequence lock updates and snapshots,
+ *        and the calibration file parser.
+ *
+ * The block holds a single set of parameters. Writers (main_bin at startup, aeb_calibrate at
+ * runtime) take the block by moving the sequence from an even to an odd value with a
+ * compare-and-swap, store the values with plain stores and release the sequence as the next
+ * even value. A snapshot copies the values between two loads of the sequence, as mailbox_take
+ * does, and never blocks the writer.
+ */
+
+#include <fcntl.h>
+#include <sched.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "calibration.h"
+
+// Names of the parameters in the calibration file and in aeb_calibrate
+static const struct
+{
+    const char *name;
+    size_t offset;
+} calibration_fields[] = {
+    {"threshold_alarm", offsetof(aeb_calibration, threshold_alarm)},
+    {"threshold_braking", offsetof(aeb_calibration, threshold_braking)},
+    {"min_spd_enabled", offsetof(aeb_calibration, min_spd_enabled)},
+    {"max_spd_enabled", offsetof(aeb_calibration, max_spd_enabled)}};
+#define CALIBRATION_FIELDS (sizeof(calibration_fields) / sizeof(calibration_fields[0]))
+
+// Maps of the thresholds: `<map>.speed`, `<map>.accel` and `<map>.value` lists in the file
+static const struct
+{
+    const char *name;
+    size_t offset;
+} calibration_maps[] = {
+    {"threshold_alarm_map", offsetof(aeb_calibration, alarm_map)},
+    {"threshold_braking_map", offsetof(aeb_calibration, braking_map)}};
+#define CALIBRATION_MAPS (sizeof(calibration_maps) / sizeof(calibration_maps[0]))
+
+/**
+ * @brief Creates (or resets) the calibration block with the given values.
+ *
+ * @param name POSIX shared memory name, e.g. CALIBRATION_SHM.
+ * @param values Initial values, validated with calibration_validate.
+ * @return 0 on success, -1 on invalid values or shared memory error.
+ * \anchor calibration_create
+ */
+int calibration_create(const char *name, const aeb_calibration *values)
+{
+    if (calibration_validate(values) != 0)
+    {
+        return -1;
+    }
+    int fd = shm_open(name, O_CREAT | O_RDWR, SHM_PERMISSIONS);
+    if (fd == -1)
+    {
+        perror("Error creating calibration block");
+        return -1;
+    }
+    if (ftruncate(fd, 0) != 0 || ftruncate(fd, sizeof(calibration_header)) != 0)
+    {
+        perror("Error sizing calibration block");
+        close(fd);
+        return -1;
+    }
+    calibration_header *header = mmap(NULL, sizeof(calibration_header), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (header == MAP_FAILED)
+    {
+        perror("Error mapping calibration block");
+        return -1;
+    }
+
+    header->values = *values;
+    header->values_size = sizeof(aeb_calibration);
+    atomic_store_explicit(&header->sequence, 2, memory_order_relaxed); // One update: the initial values
+    atomic_thread_fence(memory_order_release);
+    memcpy(header->magic, CALIBRATION_MAGIC, sizeof(CALIBRATION_MAGIC));
+
+    munmap(header, sizeof(calibration_header));
+    return 0;
+}
+
+/**
+ * @brief Maps an existing calibration block and checks its header.
+ *
+ * @param cal Receives the mapping.
+ * @param name POSIX shared memory name used by calibration_create.
+ * @return 0 on success, -1 if there is no valid block (cal->header stays NULL).
+ * \anchor calibration_attach
+ */
+int calibration_attach(calibration *cal, const char *name)
+{
+    cal->header = NULL;
+    cal->version = 0;
+
+    int fd = shm_open(name, O_RDWR, SHM_PERMISSIONS);
+    if (fd == -1)
+    {
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(calibration_header))
+    {
+        close(fd);
+        return -1;
+    }
+    calibration_header *header = mmap(NULL, sizeof(calibration_header), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (header == MAP_FAILED)
+    {
+        return -1;
+    }
+    if (memcmp(header->magic, CALIBRATION_MAGIC, sizeof(CALIBRATION_MAGIC)) != 0 ||
+        header->values_size != sizeof(aeb_calibration))
+    {
+        munmap(header, sizeof(calibration_header));
+        return -1;
+    }
+    cal->header = header;
+    return 0;
+}
+
+/**
+ * @brief Unmaps a calibration block.
+ *
+ * \anchor calibration_detach
+ */
+void calibration_detach(calibration *cal)
+{
+    if (cal->header == NULL)
+    {
+        return;
+    }
+    munmap(cal->header, sizeof(calibration_header));
+    cal->header = NULL;
+}
+
+/**
+ * @brief Removes the calibration block name (mappings stay valid until detached).
+ *
+ * \anchor calibration_destroy
+ */
+void calibration_destroy(const char *name)
+{
+    shm_unlink(name);
+}
+
+/**
+ * @brief Checks the shape of a map, so that it can be evaluated without reading out of it.
+ */
+static int map_shape_valid(const calibration_map *map)
+{
+    if (map->speed_points == 0)
+    {
+        return 1; // Not used
+    }
+    uint32_t rows = map->accel_points == 0 ? 1 : map->accel_points;
+    return map->speed_points >= 2 && map->speed_points <= CALIBRATION_MAP_POINTS && map->accel_points != 1 &&
+           map->accel_points <= CALIBRATION_MAP_POINTS && map->value_count == map->speed_points * rows;
+}
+
+/**
+ * @brief Checks that the breakpoints of an axis increase and pads the unused entries with +inf.
+ */
+static int prepare_axis(double *breakpoints, uint32_t points)
+{
+    for (uint32_t k = 0; k < points; k++)
+    {
+        if (!isfinite(breakpoints[k]) || (k > 0 && !(breakpoints[k] > breakpoints[k - 1])))
+        {
+            return -1;
+        }
+    }
+    for (uint32_t k = points; k < CALIBRATION_MAP_POINTS; k++)
+    {
+        breakpoints[k] = INFINITY;
+    }
+    return 0;
+}
+
+/**
+ * @brief Checks a map loaded from a file and computes its slopes and acceleration scales.
+ */
+static int prepare_map(calibration_map *map, const char *name)
+{
+    if (map->speed_points == 0)
+    {
+        return 0;
+    }
+    if (!map_shape_valid(map))
+    {
+        fprintf(stderr, "Calibration: %s needs 2 to %d speeds, no acceleration or 2 to %d, and a value for each pair\n",
+                name, CALIBRATION_MAP_POINTS, CALIBRATION_MAP_POINTS);
+        return -1;
+    }
+    if (prepare_axis(map->speed, map->speed_points) != 0 || prepare_axis(map->accel, map->accel_points) != 0)
+    {
+        fprintf(stderr, "Calibration: the breakpoints of %s must increase\n", name);
+        return -1;
+    }
+
+    uint32_t rows = map->accel_points == 0 ? 1 : map->accel_points;
+    for (uint32_t i = 0; i < map->speed_points; i++)
+    {
+        for (uint32_t j = 0; j < rows; j++)
+        {
+            uint32_t cell = i * rows + j;
+            if (!isfinite(map->value[cell]))
+            {
+                fprintf(stderr, "Calibration: the values of %s must be numbers\n", name);
+                return -1;
+            }
+            map->slope[cell] = i + 1 < map->speed_points ? (map->value[cell + rows] - map->value[cell]) /
+                                                               (map->speed[i + 1] - map->speed[i])
+                                                         : 0.0;
+        }
+    }
+    for (uint32_t j = 0; j + 1 < map->accel_points; j++)
+    {
+        map->accel_scale[j] = 1.0 / (map->accel[j + 1] - map->accel[j]);
+    }
+    return 0;
+}
+
+/**
+ * @brief Prepares the maps of a set of parameters and validates it.
+ *
+ * Checks the breakpoints and values of each map, pads its unused breakpoints and computes the
+ * slopes used by calibration_map_eval. Called on every set of parameters loaded from a file or
+ * given to aeb_calibrate, before it is written.
+ *
+ * @return 0 if the values are valid, -1 otherwise (with a message on stderr).
+ * \anchor calibration_prepare
+ */
+int calibration_prepare(aeb_calibration *values)
+{
+    for (size_t m = 0; m < CALIBRATION_MAPS; m++)
+    {
+        if (prepare_map((calibration_map *)((char *)values + calibration_maps[m].offset), calibration_maps[m].name) != 0)
+        {
+            return -1;
+        }
+    }
+    return calibration_validate(values);
+}
+
+/**
+ * @brief Adds the breakpoints of a map axis to a sorted list without duplicates.
+ */
+static uint32_t merge_breakpoints(double *list, uint32_t count, const double *breakpoints, uint32_t points)
+{
+    for (uint32_t k = 0; k < points; k++)
+    {
+        uint32_t at = 0;
+        while (at < count && list[at] < breakpoints[k])
+        {
+            at++;
+        }
+        if (at < count && list[at] == breakpoints[k])
+        {
+            continue;
+        }
+        memmove(&list[at + 1], &list[at], (count - at) * sizeof(list[0]));
+        list[at] = breakpoints[k];
+        count++;
+    }
+    return count;
+}
+
+/**
+ * @brief Checks that a set of parameters can be used by the controller.
+ *
+ * The thresholds must be positive, with the braking threshold below the alarm threshold, and
+ * the speed range must not be empty. With maps, the thresholds are compared at every pair of
+ * breakpoints of both maps: both are linear in speed and in acceleration between those, so
+ * this holds everywhere if it holds there.
+ *
+ * @return 0 if the values are valid, -1 otherwise (with a message on stderr).
+ * \anchor calibration_validate
+ */
+int calibration_validate(const aeb_calibration *values)
+{
+    const calibration_map *alarm = &values->alarm_map, *braking = &values->braking_map;
+    if (!map_shape_valid(alarm) || !map_shape_valid(braking))
+    {
+        fprintf(stderr, "Calibration: invalid threshold map\n");
+        return -1;
+    }
+
+    double speeds[2 * CALIBRATION_MAP_POINTS] = {0.0}, accels[2 * CALIBRATION_MAP_POINTS] = {0.0};
+    uint32_t speed_count = merge_breakpoints(speeds, 0, alarm->speed, alarm->speed_points);
+    speed_count = merge_breakpoints(speeds, speed_count, braking->speed, braking->speed_points);
+    uint32_t accel_count = merge_breakpoints(accels, 0, alarm->accel, alarm->speed_points ? alarm->accel_points : 0);
+    accel_count = merge_breakpoints(accels, accel_count, braking->accel, braking->speed_points ? braking->accel_points : 0);
+
+    for (uint32_t i = 0; i < (speed_count ? speed_count : 1); i++)
+    {
+        for (uint32_t j = 0; j < (accel_count ? accel_count : 1); j++)
+        {
+            double alarm_ttc = calibration_threshold(alarm, values->threshold_alarm, speeds[i], accels[j]);
+            double braking_ttc = calibration_threshold(braking, values->threshold_braking, speeds[i], accels[j]);
+            if (!(braking_ttc > 0.0 && braking_ttc < alarm_ttc))
+            {
+                fprintf(stderr, "Calibration: threshold_braking must be positive and below threshold_alarm"
+                                " (%g km/h, %g m/s^2)\n", speeds[i], accels[j]);
+                return -1;
+            }
+        }
+    }
+    if (!(values->min_spd_enabled >= 0.0 && values->min_spd_enabled <= values->max_spd_enabled))
+    {
+        fprintf(stderr, "Calibration: min_spd_enabled must be between 0 and max_spd_enabled\n");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Replaces the values of the calibration block.
+ *
+ * @param cal Attached calibration block.
+ * @param values New values, validated with calibration_validate.
+ * @return 0 on success, -1 if the block isn't attached or the values are invalid.
+ * \anchor calibration_write
+ */
+int calibration_write(calibration *cal, const aeb_calibration *values)
+{
+    if (cal->header == NULL || calibration_validate(values) != 0)
+    {
+        return -1;
+    }
+
+    // Take the block: even -> odd. Another writer holds it while the sequence is odd.
+    uint32_t sequence = atomic_load_explicit(&cal->header->sequence, memory_order_relaxed);
+    while ((sequence & 1) ||
+           !atomic_compare_exchange_weak_explicit(&cal->header->sequence, &sequence, sequence + 1,
+                                                  memory_order_relaxed, memory_order_relaxed))
+    {
+        if (sequence & 1)
+        {
+            sched_yield();
+            sequence = atomic_load_explicit(&cal->header->sequence, memory_order_relaxed);
+        }
+    }
+    atomic_thread_fence(memory_order_release);
+    cal->header->values = *values;
+    atomic_store_explicit(&cal->header->sequence, sequence + 2, memory_order_release);
+    return 0;
+}
+
+/**
+ * @brief Copies the values of the calibration block if they changed since the last snapshot.
+ *
+ * Never blocks: when a writer holds the block for CALIBRATION_READ_RETRIES copies, the caller
+ * keeps deciding with its previous snapshot.
+ *
+ * @param cal Attached calibration block; cal->version is updated on a new snapshot.
+ * @param values Receives the values when they changed; left as is otherwise.
+ * @return 1 if new values were copied, 0 if they didn't change (or the block stayed busy), -1 if
+ *         the block isn't attached.
+ * \anchor calibration_snapshot
+ */
+int calibration_snapshot(calibration *cal, aeb_calibration *values)
+{
+    if (cal->header == NULL)
+    {
+        return -1;
+    }
+
+    for (int retry = 0; retry < CALIBRATION_READ_RETRIES; retry++)
+    {
+        uint32_t before = atomic_load_explicit(&cal->header->sequence, memory_order_acquire);
+        if (before & 1)
+        {
+            sched_yield(); // Being written
+            continue;
+        }
+        if (before == cal->version)
+        {
+            return 0;
+        }
+        aeb_calibration copy = cal->header->values;
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&cal->header->sequence, memory_order_relaxed) == before)
+        {
+            *values = copy;
+            cal->version = before;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Reads a list of numbers up to the end of a line.
+ *
+ * @return Number of values read, or -1 if the list holds something else or more than max values.
+ */
+static int parse_list(const char *text, double *list, int max)
+{
+    int count = 0;
+    for (;;)
+    {
+        char *end;
+        text += strspn(text, " \t\r\n");
+        if (*text == '\0')
+        {
+            return count;
+        }
+        double value = strtod(text, &end);
+        if (end == text || count == max)
+        {
+            return -1;
+        }
+        list[count++] = value;
+        text = end;
+    }
+}
+
+/**
+ * @brief Applies a `<map>.speed`, `<map>.accel` or `<map>.value` list to a threshold map.
+ */
+static int set_map(aeb_calibration *values, const char *name, const char *field, const char *list)
+{
+    for (size_t m = 0; m < CALIBRATION_MAPS; m++)
+    {
+        if (strncmp(name, calibration_maps[m].name, field - name) != 0 || calibration_maps[m].name[field - name] != '\0')
+        {
+            continue;
+        }
+        calibration_map *map = (calibration_map *)((char *)values + calibration_maps[m].offset);
+        int count;
+        if (strcmp(field, ".speed") == 0 && (count = parse_list(list, map->speed, CALIBRATION_MAP_POINTS)) >= 0)
+        {
+            map->speed_points = count; // An empty list disables the map
+            return 0;
+        }
+        if (strcmp(field, ".accel") == 0 && (count = parse_list(list, map->accel, CALIBRATION_MAP_POINTS)) >= 0)
+        {
+            map->accel_points = count;
+            return 0;
+        }
+        if (strcmp(field, ".value") == 0 && (count = parse_list(list, map->value, CALIBRATION_MAP_VALUES)) >= 0)
+        {
+            map->value_count = count;
+            return 0;
+        }
+        return -1;
+    }
+    return -1;
+}
+
+/**
+ * @brief Applies one `name = value` line of a calibration file to a set of parameters.
+ *
+ * Blank lines and lines starting with `#` are ignored. A map is given by the lists
+ * `<map>.speed = s1 s2 ...`, `<map>.accel = a1 a2 ...` (2D maps only) and `<map>.value = ...`,
+ * the values row by row of speed. The values are not validated (see calibration_prepare).
+ *
+ * @return 0 if the line was applied or ignored, -1 if the name is unknown or the value invalid.
+ * \anchor calibration_set
+ */
+int calibration_set(aeb_calibration *values, const char *line)
+{
+    char name[48];
+    double value;
+    int list_start = -1;
+
+    line += strspn(line, " \t");
+    if (*line == '\0' || *line == '\n' || *line == '\r' || *line == '#')
+    {
+        return 0;
+    }
+    if (sscanf(line, "%47[a-z_.] = %n", name, &list_start) != 1 || list_start < 0)
+    {
+        return -1;
+    }
+    char *field = strchr(name, '.');
+    if (field != NULL)
+    {
+        return set_map(values, name, field, line + list_start);
+    }
+    for (size_t i = 0; i < CALIBRATION_FIELDS; i++)
+    {
+        if (strcmp(name, calibration_fields[i].name) == 0)
+        {
+            if (parse_list(line + list_start, &value, 1) != 1)
+            {
+                return -1;
+            }
+            *(double *)((char *)values + calibration_fields[i].offset) = value;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Reads a calibration file over a set of parameters.
+ *
+ * Parameters not named in the file keep their values. The values are applied only if every line
+ * is valid and the result passes calibration_prepare.
+ *
+ * @param path Calibration file.
+ * @param values Parameters to be updated.
+ * @return 0 on success, -1 if the file can't be read or holds an invalid line or value.
+ * \anchor calibration_load
+ */
+int calibration_load(const char *path, aeb_calibration *values)
+{
+    FILE *file = fopen(path, "r");
+    if (file == NULL)
+    {
+        perror("Error opening calibration file");
+        return -1;
+    }
+
+    aeb_calibration loaded = *values;
+    char line[1024];
+    int line_number = 0, result = 0;
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        line_number++;
+        if (calibration_set(&loaded, line) != 0)
+        {
+            fprintf(stderr, "%s:%d: invalid calibration line: %s", path, line_number, line);
+            result = -1;
+        }
+    }
+    fclose(file);
+
+    if (result == 0 && calibration_prepare(&loaded) == 0)
+    {
+        *values = loaded;
+        return 0;
+    }
+    return -1;
+}
+
+/**
+ * @brief Writes a set of parameters in the calibration file format.
+ *
+ * \anchor calibration_print
+ */
+void calibration_print(const aeb_calibration *values, FILE *out)
+{
+    for (size_t i = 0; i < CALIBRATION_FIELDS; i++)
+    {
+        fprintf(out, "%s = %g\n", calibration_fields[i].name,
+                *(const double *)((const char *)values + calibration_fields[i].offset));
+    }
+    for (size_t m = 0; m < CALIBRATION_MAPS; m++)
+    {
+        const calibration_map *map = (const calibration_map *)((const char *)values + calibration_maps[m].offset);
+        if (map->speed_points == 0)
+        {
+            continue;
+        }
+        fprintf(out, "%s.speed =", calibration_maps[m].name);
+        for (uint32_t k = 0; k < map->speed_points; k++)
+        {
+            fprintf(out, " %g", map->speed[k]);
+        }
+        if (map->accel_points > 0)
+        {
+            fprintf(out, "\n%s.accel =", calibration_maps[m].name);
+            for (uint32_t k = 0; k < map->accel_points; k++)
+            {
+                fprintf(out, " %g", map->accel[k]);
+            }
+        }
+        fprintf(out, "\n%s.value =", calibration_maps[m].name);
+        for (uint32_t k = 0; k < map->value_count; k++)
+        {
+            fprintf(out, " %g", map->value[k]);
+        }
+        fprintf(out, "\n");
+    }
+}
@@ -9,6 +9,8 @@
 
 #include "file_reader.h"
 #include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
 
 /**
  * @brief Opens a file for reading and skips the first line (header).
@@ -33,6 +35,37 @@ FILE* open_file(const char* filename) {
     return file;
 }
 
+/**
+ * @brief Opens a streaming input (regular file, named pipe or stdin) for reading sensor rows.
+ * 
+ * Unlike open_file, the first line is only skipped if it is a header, i.e. if it doesn't
+ * start with a number, so a generator can write rows straight away. Opening a named pipe
+ * blocks until a writer opens it.
+ * 
+ * @param path Path of the input, or "-" to read from stdin.
+ * @return FILE* Pointer to the opened stream.
+ * @note If the input cannot be opened, the program exits with an error.
+ * \anchor open_stream
+ */
+FILE* open_stream(const char* path) {
+    FILE *file = (strcmp(path, "-") == 0) ? stdin : fopen(path, "r");
+    if (file == NULL) {
+        perror("Erro ao abrir o arquivo");
+        exit(EXIT_FAILURE);
+    }
+
+    // Skip header, if there is one
+    int first = fgetc(file);
+    if (first != EOF) {
+        ungetc(first, file);
+        if (!isdigit(first) && first != '-' && first != '+' && first != '.' && !isspace(first)) {
+            char header[100];
+            fgets(header, sizeof(header), file);
+        }
+    }
+
+    return file;
+}
 
 /**
  * @brief Reads a line from the file and fills the sensor data structure.
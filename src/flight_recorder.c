@@ -0,0 +1,362 @@
+/**
+ * @file flight_recorder.c
+ * @brief Writers and dumper of the shared memory flight recorder.
+ *
+ * A writer takes a ticket with one atomic fetch-and-add on the shared `next` counter, which
+ * selects the slot (ticket modulo capacity), so the three processes write concurrently
+ * without locks. The slot's sequence is cleared, the entry is filled with plain stores and
+ * the sequence is set to ticket + 1 with release ordering. The dumper accepts a slot only
+ * if its sequence is the expected one before and after copying it, which skips entries
+ * being written or already overwritten by a newer lap.
+ *
+ * Recording costs a clock_gettime and a fetch-and-add; when the process isn't attached
+ * (e.g. a module started alone) the recording functions return immediately.
+ */
+
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "flight_recorder.h"
+#include "constants.h"
+
+
+_Static_assert(sizeof(flight_recorder_entry) == 32, "Flight recorder entry must be 32 bytes");
+_Static_assert(sizeof(flight_recorder_header) <= FLIGHT_RECORDER_HEADER_SIZE, "Flight recorder header must fit its lines");
+
+static flight_recorder_header *recorder = NULL;
+static flight_recorder_entry *recorder_entries = NULL;
+static size_t recorder_size = 0;
+static uint8_t recorder_source = 0;
+
+static size_t segment_size(uint32_t capacity)
+{
+    return FLIGHT_RECORDER_HEADER_SIZE + (size_t)capacity * sizeof(flight_recorder_entry);
+}
+
+/**
+ * @brief Maps an existing flight recorder segment and checks its header, including a capacity
+ * that is a nonzero power of two.
+ *
+ * @return Mapped header, or NULL (size in *size).
+ */
+static flight_recorder_header *map_segment(const char *name, int flags, int prot, size_t *size)
+{
+    int fd = shm_open(name, flags, SHM_PERMISSIONS);
+    if (fd == -1)
+    {
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < FLIGHT_RECORDER_HEADER_SIZE)
+    {
+        close(fd);
+        return NULL;
+    }
+    flight_recorder_header *header = mmap(NULL, st.st_size, prot, MAP_SHARED, fd, 0);
+    close(fd);
+    if (header == MAP_FAILED)
+    {
+        return NULL;
+    }
+    uint32_t capacity = header->capacity; // The tickets are masked with capacity - 1
+    if (memcmp(header->magic, FLIGHT_RECORDER_MAGIC, sizeof(FLIGHT_RECORDER_MAGIC)) != 0 ||
+        header->entry_size != sizeof(flight_recorder_entry) || capacity == 0 || (capacity & (capacity - 1)) != 0 ||
+        segment_size(capacity) > (size_t)st.st_size)
+    {
+        munmap(header, st.st_size);
+        return NULL;
+    }
+    *size = st.st_size;
+    return header;
+}
+
+/**
+ * @brief Creates (or resets) the flight recorder segment.
+ *
+ * @param name POSIX shared memory name, e.g. FLIGHT_RECORDER_SHM.
+ * @param capacity Number of entries (power of two).
+ * @return 0 on success, -1 on invalid capacity or shared memory error.
+ * \anchor flight_recorder_create
+ */
+int flight_recorder_create(const char *name, uint32_t capacity)
+{
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0)
+    {
+        return -1;
+    }
+
+    int fd = shm_open(name, O_CREAT | O_RDWR, SHM_PERMISSIONS);
+    if (fd == -1)
+    {
+        perror("Error creating flight recorder");
+        return -1;
+    }
+    size_t size = segment_size(capacity);
+    if (ftruncate(fd, 0) != 0 || ftruncate(fd, size) != 0)
+    {
+        perror("Error sizing flight recorder");
+        close(fd);
+        return -1;
+    }
+    flight_recorder_header *header = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (header == MAP_FAILED)
+    {
+        perror("Error mapping flight recorder");
+        return -1;
+    }
+
+    // The segment is zero filled: every sequence is 0 (empty)
+    header->capacity = capacity;
+    header->entry_size = sizeof(flight_recorder_entry);
+    atomic_init(&header->next, 0);
+    atomic_thread_fence(memory_order_release);
+    memcpy(header->magic, FLIGHT_RECORDER_MAGIC, sizeof(FLIGHT_RECORDER_MAGIC));
+
+    munmap(header, size);
+    return 0;
+}
+
+/**
+ * @brief Attaches the calling process to the flight recorder as a writer.
+ *
+ * @param name POSIX shared memory name used by flight_recorder_create.
+ * @param source Process written in the entries.
+ * @return 0 on success, -1 if there is no flight recorder (recording stays disabled).
+ * \anchor flight_recorder_attach
+ */
+int flight_recorder_attach(const char *name, flight_recorder_source source)
+{
+    flight_recorder_detach();
+
+    size_t size;
+    flight_recorder_header *header = map_segment(name, O_RDWR, PROT_READ | PROT_WRITE, &size);
+    if (header == NULL)
+    {
+        return -1;
+    }
+    recorder_entries = (flight_recorder_entry *)((char *)header + FLIGHT_RECORDER_HEADER_SIZE);
+    recorder_size = size;
+    recorder_source = source;
+    recorder = header;
+    return 0;
+}
+
+/**
+ * @brief Detaches the calling process; further entries are ignored.
+ *
+ * \anchor flight_recorder_detach
+ */
+void flight_recorder_detach(void)
+{
+    if (recorder == NULL)
+    {
+        return;
+    }
+    munmap(recorder, recorder_size);
+    recorder = NULL;
+    recorder_entries = NULL;
+}
+
+/**
+ * @brief Removes the flight recorder segment name (mappings stay valid until detached).
+ *
+ * \anchor flight_recorder_destroy
+ */
+void flight_recorder_destroy(const char *name)
+{
+    shm_unlink(name);
+}
+
+/**
+ * @brief Reserves the next slot and marks it as being written.
+ *
+ * @param ticket Receives the ticket that completes the entry.
+ */
+static flight_recorder_entry *begin_entry(uint64_t *ticket)
+{
+    *ticket = atomic_fetch_add_explicit(&recorder->next, 1, memory_order_relaxed);
+    flight_recorder_entry *entry = &recorder_entries[*ticket & (recorder->capacity - 1)];
+
+    atomic_store_explicit(&entry->sequence, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    entry->timestamp_ns = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    entry->source = recorder_source;
+    return entry;
+}
+
+static void commit_entry(flight_recorder_entry *entry, uint64_t ticket)
+{
+    atomic_store_explicit(&entry->sequence, (uint32_t)(ticket + 1), memory_order_release);
+}
+
+/**
+ * @brief Records a CAN frame sent or received by the calling process.
+ *
+ * @param kind FR_ENTRY_FRAME_TX or FR_ENTRY_FRAME_RX.
+ * @param frame Frame to be recorded.
+ * \anchor flight_recorder_frame
+ */
+void flight_recorder_frame(flight_recorder_kind kind, const can_msg *frame)
+{
+    if (recorder == NULL)
+    {
+        return;
+    }
+    uint64_t ticket;
+    flight_recorder_entry *entry = begin_entry(&ticket);
+    entry->kind = kind;
+    entry->identifier = frame->identifier;
+    memcpy(entry->data, frame->dataFrame, sizeof(entry->data));
+    entry->ttc = 0.0f;
+    entry->state = 0;
+    commit_entry(entry, ticket);
+}
+
+/**
+ * @brief Records a controller decision.
+ *
+ * @param state Controller state (aeb_controller_state).
+ * @param ttc Time to collision that led to it, in seconds.
+ * \anchor flight_recorder_decision
+ */
+void flight_recorder_decision(uint8_t state, double ttc)
+{
+    if (recorder == NULL)
+    {
+        return;
+    }
+    uint64_t ticket;
+    flight_recorder_entry *entry = begin_entry(&ticket);
+    entry->kind = FR_ENTRY_DECISION;
+    entry->identifier = 0;
+    entry->ttc = (float)ttc;
+    entry->state = state;
+    commit_entry(entry, ticket);
+}
+
+/**
+ * @brief Records the actuators state.
+ *
+ * @param actuators State to be recorded (ACTUATOR_BIT_* mask).
+ * \anchor flight_recorder_actuators
+ */
+void flight_recorder_actuators(actuators_abstraction actuators)
+{
+    if (recorder == NULL)
+    {
+        return;
+    }
+    uint64_t ticket;
+    flight_recorder_entry *entry = begin_entry(&ticket);
+    entry->kind = FR_ENTRY_ACTUATORS;
+    entry->identifier = 0;
+    entry->ttc = 0.0f;
+    entry->state = actuators;
+    commit_entry(entry, ticket);
+}
+
+static const char *source_name(uint8_t source)
+{
+    switch (source)
+    {
+    case FR_SOURCE_SENSORS:
+        return "SENSORS";
+    case FR_SOURCE_CONTROLLER:
+        return "CONTROLLER";
+    case FR_SOURCE_ACTUATORS:
+        return "ACTUATORS";
+    default:
+        return "UNKNOWN";
+    }
+}
+
+/**
+ * @brief Prints one entry of the dump.
+ */
+static void print_entry(FILE *out, const flight_recorder_entry *entry)
+{
+    fprintf(out, "%llu.%06llu | %-10s | ", (unsigned long long)(entry->timestamp_ns / 1000000000ULL),
+            (unsigned long long)(entry->timestamp_ns % 1000000000ULL) / 1000, source_name(entry->source));
+    switch (entry->kind)
+    {
+    case FR_ENTRY_FRAME_TX:
+    case FR_ENTRY_FRAME_RX:
+        fprintf(out, "%s | %08X |", entry->kind == FR_ENTRY_FRAME_TX ? "TX" : "RX", entry->identifier);
+        for (int i = 0; i < 8; i++)
+        {
+            fprintf(out, " %02X", entry->data[i]);
+        }
+        fputc('\n', out);
+        break;
+    case FR_ENTRY_DECISION:
+        fprintf(out, "DECISION | STATE %u | TTC %.3f\n", entry->state, entry->ttc);
+        break;
+    case FR_ENTRY_ACTUATORS:
+        fprintf(out, "ACTUATORS | %d | %d | %d | %d | %d\n",
+                (entry->state & ACTUATOR_BIT_BELT_TIGHTNESS) != 0, (entry->state & ACTUATOR_BIT_DOOR_LOCK) != 0,
+                (entry->state & ACTUATOR_BIT_ABS) != 0, (entry->state & ACTUATOR_BIT_ALARM_LED) != 0,
+                (entry->state & ACTUATOR_BIT_ALARM_BUZZER) != 0);
+        break;
+    default:
+        fprintf(out, "UNKNOWN\n");
+        break;
+    }
+}
+
+/**
+ * @brief Prints the entries kept by the flight recorder, oldest first.
+ *
+ * Can be called from any process, while the writers are running or after they died.
+ *
+ * @param name POSIX shared memory name used by flight_recorder_create.
+ * @param out Stream that receives the dump.
+ * @return Number of printed entries, or -1 if there is no flight recorder.
+ * \anchor flight_recorder_dump
+ */
+long flight_recorder_dump(const char *name, FILE *out)
+{
+    size_t size;
+    flight_recorder_header *header = map_segment(name, O_RDONLY, PROT_READ, &size);
+    if (header == NULL)
+    {
+        fprintf(stderr, "Flight recorder %s not found\n", name);
+        return -1;
+    }
+    const flight_recorder_entry *entries = (const flight_recorder_entry *)((char *)header + FLIGHT_RECORDER_HEADER_SIZE);
+
+    uint64_t next = atomic_load_explicit(&header->next, memory_order_acquire);
+    uint64_t first = next > header->capacity ? next - header->capacity : 0;
+    long printed = 0;
+
+    fprintf(out, "TIMESTAMP | SOURCE | ENTRY | DETAILS\n");
+    for (uint64_t ticket = first; ticket < next; ticket++)
+    {
+        const flight_recorder_entry *slot = &entries[ticket & (header->capacity - 1)];
+        uint32_t expected = (uint32_t)(ticket + 1);
+
+        if (atomic_load_explicit(&((flight_recorder_entry *)slot)->sequence, memory_order_acquire) != expected)
+        {
+            continue; // Being written, or overwritten by a newer entry
+        }
+        flight_recorder_entry copy;
+        memcpy(&copy, slot, sizeof(copy));
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&((flight_recorder_entry *)slot)->sequence, memory_order_relaxed) != expected)
+        {
+            continue;
+        }
+        print_entry(out, &copy);
+        printed++;
+    }
+
+    munmap(header, size);
+    return printed;
+}
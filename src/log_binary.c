@@ -0,0 +1,278 @@
+/**
+ * @file log_binary.c
+ * @brief Writer and decoder of the binary event log.
+ *
+ * The writer keeps the records of the current block in memory and writes the whole block
+ * (header, checksum and records) when it is full, when the ID_AEB changes or when the log
+ * is flushed, so a block is never split across writes. The decoder checks every block and
+ * prints its records in the text log format.
+ */
+
+#include <string.h>
+#include "log_binary.h"
+#include "actuators.h"
+
+_Static_assert(sizeof(log_bin_file_header) == 16, "Binary log file header must be 16 bytes");
+_Static_assert(sizeof(log_bin_block_header) == 20, "Binary log block header must be 20 bytes");
+_Static_assert(sizeof(log_bin_record) == 16, "Binary log record must be 16 bytes");
+
+/**
+ * @brief Converts an event to its fixed-size binary record.
+ *
+ * @param entry Binary record that receives the event.
+ * @param record Event to be converted (its ID_AEB is stored apart).
+ * \anchor log_bin_pack
+ */
+void log_bin_pack(log_bin_record *entry, const log_record *record)
+{
+    entry->timestamp_ms = record->timestamp_ms;
+    entry->event_id = record->event_id;
+    entry->actuators = record->actuators;
+    entry->kind = record->kind;
+    entry->count = record->count;
+}
+
+/**
+ * @brief Fills an event from its binary record (the ID_AEB is left untouched).
+ *
+ * @param record Event that receives the data.
+ * @param entry Binary record to be converted.
+ * \anchor log_bin_unpack
+ */
+void log_bin_unpack(log_record *record, const log_bin_record *entry)
+{
+    record->timestamp_ms = entry->timestamp_ms;
+    record->event_id = entry->event_id;
+    record->actuators = entry->actuators;
+    record->kind = entry->kind;
+    record->count = entry->count;
+}
+
+/**
+ * @brief Updates a CRC-32 (IEEE 802.3, reflected) with a buffer.
+ *
+ * @param crc CRC of the previous data, 0 to start.
+ * @param data Data to be added.
+ * @param size Size of the data in bytes.
+ * @return Updated CRC.
+ * \anchor log_bin_crc32
+ */
+uint32_t log_bin_crc32(uint32_t crc, const void *data, size_t size)
+{
+    static uint32_t table[256];
+    static int table_ready = 0;
+    const unsigned char *bytes = data;
+
+    if (!table_ready)
+    {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t c = i;
+            for (int bit = 0; bit < 8; bit++)
+            {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+        table_ready = 1;
+    }
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++)
+    {
+        crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+/**
+ * @brief Checksum of a block: its ID_AEB, its count and its records.
+ */
+static uint32_t block_checksum(const log_bin_block_header *header, const log_bin_record *records)
+{
+    uint32_t crc = log_bin_crc32(0, header->id_aeb, sizeof(header->id_aeb));
+    crc = log_bin_crc32(crc, &header->count, sizeof(header->count));
+    return log_bin_crc32(crc, records, header->count * sizeof(log_bin_record));
+}
+
+/**
+ * @brief Writes the file header of a new binary log.
+ *
+ * @param file Binary log, positioned at its beginning.
+ * @return 0 on success, -1 on write error.
+ * \anchor log_bin_write_file_header
+ */
+int log_bin_write_file_header(FILE *file)
+{
+    log_bin_file_header header = {
+        .version = LOG_BIN_VERSION,
+        .record_size = sizeof(log_bin_record),
+        .block_records = LOG_BIN_BLOCK_RECORDS};
+    memcpy(header.magic, LOG_BIN_MAGIC, sizeof(header.magic));
+    return fwrite(&header, sizeof(header), 1, file) == 1 ? 0 : -1;
+}
+
+/**
+ * @brief Writes the records of the current block, if any, and starts an empty block.
+ *
+ * @param block Block being filled.
+ * @param file Binary log.
+ * \anchor log_bin_write_block
+ */
+void log_bin_write_block(log_bin_block *block, FILE *file)
+{
+    if (block->header.count == 0)
+    {
+        return;
+    }
+    block->header.magic = LOG_BIN_BLOCK_MAGIC;
+    block->header.checksum = block_checksum(&block->header, block->records);
+    // Header and records are written apart: the records array is 8-byte aligned in memory
+    fwrite(&block->header, sizeof(block->header), 1, file);
+    fwrite(block->records, sizeof(log_bin_record), block->header.count, file);
+    block->header.count = 0;
+}
+
+/**
+ * @brief Adds a record to the current block, writing the block first if it is full or
+ * if the record has another ID_AEB.
+ *
+ * @param block Block being filled.
+ * @param file Binary log.
+ * @param record Event to be added.
+ * \anchor log_bin_append
+ */
+void log_bin_append(log_bin_block *block, FILE *file, const log_record *record)
+{
+    if (block->header.count > 0 && strncmp(block->header.id_aeb, record->id_aeb, LOG_ID_AEB_MAX) != 0)
+    {
+        log_bin_write_block(block, file);
+    }
+    if (block->header.count == 0)
+    {
+        memset(block->header.id_aeb, 0, sizeof(block->header.id_aeb));
+        strncpy(block->header.id_aeb, record->id_aeb, LOG_ID_AEB_MAX - 1);
+        block->header.reserved = 0;
+    }
+
+    log_bin_pack(&block->records[block->header.count++], record);
+
+    if (block->header.count == LOG_BIN_BLOCK_RECORDS)
+    {
+        log_bin_write_block(block, file);
+    }
+}
+
+/**
+ * @brief Reads and checks the file header of a binary log.
+ *
+ * @param in Binary log, positioned at its beginning.
+ * @param header Receives the file header.
+ * @return 0 on success, -1 if the file isn't a binary log (or has an unsupported version).
+ * \anchor log_bin_read_file_header
+ */
+int log_bin_read_file_header(FILE *in, log_bin_file_header *header)
+{
+    if (fread(header, sizeof(*header), 1, in) != 1 ||
+        memcmp(header->magic, LOG_BIN_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != LOG_BIN_VERSION ||
+        header->record_size != sizeof(log_bin_record) ||
+        header->block_records > LOG_BIN_BLOCK_RECORDS)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Reads the next block of a binary log and checks it.
+ *
+ * @param in Binary log, positioned at a block header.
+ * @param file_header File header of the log.
+ * @param block Receives the block.
+ * @return LOG_BIN_BLOCK_OK, or the reason why the block can't be used.
+ * \anchor log_bin_read_block
+ */
+log_bin_block_status log_bin_read_block(FILE *in, const log_bin_file_header *file_header, log_bin_block *block)
+{
+    if (fread(&block->header, sizeof(block->header), 1, in) != 1)
+    {
+        return LOG_BIN_BLOCK_END;
+    }
+    if (block->header.magic != LOG_BIN_BLOCK_MAGIC || block->header.count > file_header->block_records)
+    {
+        return LOG_BIN_BLOCK_BAD_HEADER;
+    }
+    if (fread(block->records, sizeof(log_bin_record), block->header.count, in) != block->header.count)
+    {
+        return LOG_BIN_BLOCK_TRUNCATED;
+    }
+    if (block_checksum(&block->header, block->records) != block->header.checksum)
+    {
+        return LOG_BIN_BLOCK_CHECKSUM;
+    }
+    return LOG_BIN_BLOCK_OK;
+}
+
+/**
+ * @brief Decodes a binary log into the text log format.
+ *
+ * Blocks with a wrong checksum are reported on stderr and skipped. A truncated last block
+ * (e.g. the writer was killed) ends the decoding.
+ *
+ * @param in Binary log, positioned at its beginning.
+ * @param out Stream that receives the text log, header included.
+ * @return Number of decoded records, or -1 if the file isn't a binary log.
+ * \anchor log_bin_decode
+ */
+long log_bin_decode(FILE *in, FILE *out)
+{
+    log_bin_file_header file_header;
+    if (log_bin_read_file_header(in, &file_header) != 0)
+    {
+        fprintf(stderr, "Not a binary AEB log (or unsupported version)\n");
+        return -1;
+    }
+
+    fputs(LOG_HEADER, out);
+
+    long decoded = 0;
+    long block_index = 0;
+    log_bin_block block;
+    char line[LOG_LINE_MAX];
+
+    log_bin_block_status status;
+
+    while ((status = log_bin_read_block(in, &file_header, &block)) != LOG_BIN_BLOCK_END)
+    {
+        if (status == LOG_BIN_BLOCK_BAD_HEADER)
+        {
+            fprintf(stderr, "Block %ld: bad block header, stopping\n", block_index);
+            break;
+        }
+        if (status == LOG_BIN_BLOCK_TRUNCATED)
+        {
+            fprintf(stderr, "Block %ld: truncated, stopping\n", block_index);
+            break;
+        }
+        if (status == LOG_BIN_BLOCK_CHECKSUM)
+        {
+            fprintf(stderr, "Block %ld: checksum mismatch, %u records skipped\n", block_index, block.header.count);
+            block_index++;
+            continue;
+        }
+
+        log_record record;
+        memcpy(record.id_aeb, block.header.id_aeb, LOG_ID_AEB_MAX);
+        record.id_aeb[LOG_ID_AEB_MAX - 1] = '\0';
+        for (uint16_t i = 0; i < block.header.count; i++)
+        {
+            log_bin_unpack(&record, &block.records[i]);
+            log_format_line(line, sizeof(line), &record);
+            fputs(line, out);
+            decoded++;
+        }
+        block_index++;
+    }
+    return decoded;
+}
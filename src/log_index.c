@@ -0,0 +1,587 @@
+/**
+ * @file log_index.c
+ * @brief Builder and query engine of the sidecar log index.
+ *
+ * The index is built in two passes over the log. The first pass counts the records of
+ * every EVENT_ID and the transitions and collects the sparse timestamp index, which gives
+ * the final size of the index; the second pass fills the posting lists directly in the
+ * memory-mapped index file, so building needs little memory even for multi-GB logs.
+ * The index is written to a temporary file and renamed, so a reader never sees a
+ * partial index.
+ *
+ * Queries assume that the timestamps of the log never decrease, which holds for the logs
+ * written by log_utils (one writer, records appended in time order).
+ */
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "log_index.h"
+#include "actuators.h"
+
+_Static_assert(sizeof(log_index_header) == 64, "Log index header must be 64 bytes");
+_Static_assert(LOG_BIN_BLOCK_RECORDS <= 256, "Record index must fit the location");
+
+/**
+ * @brief Opens a log for reading; binary logs are recognized by their file header.
+ * @return 0 on success, -1 if the log can't be opened.
+ */
+static int reader_open(log_index_reader *reader, const char *log_path)
+{
+    reader->file = fopen(log_path, "rb");
+    if (reader->file == NULL)
+    {
+        return -1;
+    }
+    reader->format = LOG_FORMAT_BINARY;
+    if (log_bin_read_file_header(reader->file, &reader->bin_header) != 0)
+    {
+        reader->format = LOG_FORMAT_TEXT;
+        rewind(reader->file);
+    }
+    reader->block_offset = -1;
+    reader->block.header.count = 0;
+    reader->next_record = 0;
+    return 0;
+}
+
+static void reader_close(log_index_reader *reader)
+{
+    if (reader->file != NULL)
+    {
+        fclose(reader->file);
+        reader->file = NULL;
+    }
+}
+
+/**
+ * @brief Parses one line of the text log format (see log_format_line).
+ * @return 0 on success, -1 for the header or a malformed line.
+ */
+static int parse_line(const char *line, log_record *record)
+{
+    char message[16];
+    int actuators[5];
+
+    if (sscanf(line, "%7[^ |] | %x | %ld | %15[^|]| %d | %d | %d | %d | %d", record->id_aeb, &record->event_id,
+               &record->timestamp_ms, message, &actuators[0], &actuators[1], &actuators[2], &actuators[3],
+               &actuators[4]) != 9)
+    {
+        return -1;
+    }
+    record->actuators = (actuators[0] ? ACTUATOR_BIT_BELT_TIGHTNESS : 0) | (actuators[1] ? ACTUATOR_BIT_DOOR_LOCK : 0) |
+                        (actuators[2] ? ACTUATOR_BIT_ABS : 0) | (actuators[3] ? ACTUATOR_BIT_ALARM_LED : 0) |
+                        (actuators[4] ? ACTUATOR_BIT_ALARM_BUZZER : 0);
+    record->kind = LOG_RECORD_EVENT;
+    record->count = 0;
+    if (strncmp(message, "SUMMARY", 7) == 0)
+    {
+        record->kind = LOG_RECORD_SUMMARY;
+        record->count = atoi(message + 7);
+    }
+    return 0;
+}
+
+/**
+ * @brief Reads the binary block at the current position of the log.
+ * @return 0 on success, 1 for a block to be skipped, -1 at the end of the usable data.
+ */
+static int reader_load_block(log_index_reader *reader)
+{
+    reader->block_offset = ftell(reader->file);
+    reader->next_record = 0;
+    log_bin_block_status status = log_bin_read_block(reader->file, &reader->bin_header, &reader->block);
+    if (status == LOG_BIN_BLOCK_OK)
+    {
+        return 0;
+    }
+    reader->block.header.count = 0;
+    reader->block_offset = -1;
+    return status == LOG_BIN_BLOCK_CHECKSUM ? 1 : -1;
+}
+
+/**
+ * @brief Reads the next record of the log.
+ *
+ * @param location Receives the location of the record.
+ * @return 1 if a record was read, 0 at the end of the log.
+ */
+static int reader_next(log_index_reader *reader, log_record *record, uint64_t *location)
+{
+    if (reader->format == LOG_FORMAT_TEXT)
+    {
+        char line[LOG_LINE_MAX];
+        long offset = ftell(reader->file);
+        while (fgets(line, sizeof(line), reader->file) != NULL)
+        {
+            if (parse_line(line, record) == 0)
+            {
+                *location = LOG_INDEX_LOCATION(offset, 0);
+                return 1;
+            }
+            offset = ftell(reader->file);
+        }
+        return 0;
+    }
+
+    while (reader->block_offset == -1 || reader->next_record >= reader->block.header.count)
+    {
+        int loaded = reader_load_block(reader);
+        if (loaded < 0)
+        {
+            return 0;
+        }
+    }
+    memcpy(record->id_aeb, reader->block.header.id_aeb, LOG_ID_AEB_MAX);
+    record->id_aeb[LOG_ID_AEB_MAX - 1] = '\0';
+    log_bin_unpack(record, &reader->block.records[reader->next_record]);
+    *location = LOG_INDEX_LOCATION(reader->block_offset, reader->next_record);
+    reader->next_record++;
+    return 1;
+}
+
+/**
+ * @brief Positions the reader so that reader_next returns the record at a location.
+ * @return 0 on success, -1 if the location can't be read.
+ */
+static int reader_seek(log_index_reader *reader, uint64_t location)
+{
+    long offset = (long)LOG_INDEX_OFFSET(location);
+
+    if (reader->format == LOG_FORMAT_TEXT)
+    {
+        return fseek(reader->file, offset, SEEK_SET);
+    }
+    // Consecutive hits usually fall in the same block, which is read once
+    if (reader->block_offset != offset)
+    {
+        if (fseek(reader->file, offset, SEEK_SET) != 0 || reader_load_block(reader) != 0)
+        {
+            return -1;
+        }
+    }
+    reader->next_record = LOG_INDEX_RECORD(location);
+    return reader->next_record < reader->block.header.count ? 0 : -1;
+}
+
+static int compare_events(const void *a, const void *b)
+{
+    uint32_t id_a = ((const log_index_event *)a)->event_id;
+    uint32_t id_b = ((const log_index_event *)b)->event_id;
+    return (id_a > id_b) - (id_a < id_b);
+}
+
+/**
+ * @brief Finds the entry of an EVENT_ID in a sorted event table.
+ */
+static log_index_event *find_event(const log_index_event *events, uint64_t count, uint32_t event_id)
+{
+    log_index_event key = {.event_id = event_id};
+    return bsearch(&key, events, count, sizeof(log_index_event), compare_events);
+}
+
+/**
+ * @brief Tells whether a record changes the actuators state of the previous event.
+ *
+ * @param previous State of the previous event, -1 before the first one.
+ */
+static bool is_transition(const log_record *record, int *previous)
+{
+    if (record->kind != LOG_RECORD_EVENT)
+    {
+        return false; // A summary repeats the state of the events it replaces
+    }
+    bool changed = record->actuators != *previous;
+    *previous = record->actuators;
+    return changed;
+}
+
+/**
+ * @brief Builds the index of a log.
+ *
+ * @param log_path Text or binary log.
+ * @param index_path Index file to be (re)written.
+ * @return 0 on success, -1 if the log can't be read or the index can't be written.
+ * \anchor log_index_build
+ */
+int log_index_build(const char *log_path, const char *index_path)
+{
+    struct stat st;
+    log_index_reader reader;
+    if (stat(log_path, &st) != 0 || reader_open(&reader, log_path) != 0)
+    {
+        perror("Error opening the log to be indexed");
+        return -1;
+    }
+
+    // First pass: sizes of the posting lists and sparse timestamp index
+    log_record record;
+    uint64_t location;
+    uint64_t records = 0, transition_count = 0, event_count = 0, sparse_count = 0;
+    size_t event_capacity = 16, sparse_capacity = 1024;
+    log_index_event *events = malloc(event_capacity * sizeof(log_index_event));
+    log_index_posting *sparse = malloc(sparse_capacity * sizeof(log_index_posting));
+    log_index_event *last_event = NULL;
+    int previous = -1;
+
+    while (events != NULL && sparse != NULL && reader_next(&reader, &record, &location))
+    {
+        if (records % LOG_INDEX_STRIDE == 0)
+        {
+            if (sparse_count == sparse_capacity)
+            {
+                sparse_capacity *= 2;
+                sparse = realloc(sparse, sparse_capacity * sizeof(log_index_posting));
+                if (sparse == NULL)
+                {
+                    break;
+                }
+            }
+            sparse[sparse_count++] = (log_index_posting){record.timestamp_ms, location};
+        }
+
+        // The log holds a handful of EVENT_IDs, usually in long runs
+        if (last_event == NULL || last_event->event_id != record.event_id)
+        {
+            last_event = NULL;
+            for (uint64_t i = 0; i < event_count; i++)
+            {
+                if (events[i].event_id == record.event_id)
+                {
+                    last_event = &events[i];
+                }
+            }
+            if (last_event == NULL)
+            {
+                if (event_count == event_capacity)
+                {
+                    event_capacity *= 2;
+                    events = realloc(events, event_capacity * sizeof(log_index_event));
+                    if (events == NULL)
+                    {
+                        break;
+                    }
+                }
+                last_event = &events[event_count++];
+                *last_event = (log_index_event){.event_id = record.event_id};
+            }
+        }
+        last_event->count++;
+
+        transition_count += is_transition(&record, &previous);
+        records++;
+    }
+    reader_close(&reader);
+    if (events == NULL || sparse == NULL)
+    {
+        perror("Error allocating the log index");
+        free(events);
+        free(sparse);
+        return -1;
+    }
+
+    qsort(events, event_count, sizeof(log_index_event), compare_events);
+    uint64_t first = 0;
+    for (uint64_t i = 0; i < event_count; i++)
+    {
+        events[i].first = first;
+        first += events[i].count;
+    }
+
+    // Second pass: posting lists filled in the mapped index
+    size_t size = sizeof(log_index_header) + (sparse_count + records + transition_count) * sizeof(log_index_posting) +
+                  event_count * sizeof(log_index_event);
+    char tmp_path[LOG_PATH_MAX + 8];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", index_path);
+
+    int fd = open(tmp_path, O_CREAT | O_TRUNC | O_RDWR, 0644);
+    char *map = MAP_FAILED;
+    if (fd != -1 && ftruncate(fd, size) == 0)
+    {
+        map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (fd != -1)
+    {
+        close(fd);
+    }
+    if (map == MAP_FAILED || reader_open(&reader, log_path) != 0)
+    {
+        perror("Error writing the log index");
+        if (map != MAP_FAILED)
+        {
+            munmap(map, size);
+        }
+        unlink(tmp_path);
+        free(events);
+        free(sparse);
+        return -1;
+    }
+
+    log_index_header *header = (log_index_header *)map;
+    log_index_posting *sparse_out = (log_index_posting *)(header + 1);
+    log_index_event *events_out = (log_index_event *)(sparse_out + sparse_count);
+    log_index_posting *postings = (log_index_posting *)(events_out + event_count);
+    log_index_posting *transitions = postings + records;
+
+    memcpy(sparse_out, sparse, sparse_count * sizeof(log_index_posting));
+    memcpy(events_out, events, event_count * sizeof(log_index_event));
+
+    // Records appended after the first pass are left for the next rebuild
+    uint64_t filled = 0, transition = 0;
+    previous = -1;
+    while (filled < records && reader_next(&reader, &record, &location))
+    {
+        log_index_event *event = find_event(events, event_count, record.event_id);
+        if (event != NULL && event->reserved < event->count)
+        {
+            postings[event->first + event->reserved++] = (log_index_posting){record.timestamp_ms, location};
+        }
+        if (is_transition(&record, &previous) && transition < transition_count)
+        {
+            transitions[transition++] = (log_index_posting){record.timestamp_ms, location};
+        }
+        filled++;
+    }
+    reader_close(&reader);
+
+    header->version = LOG_INDEX_VERSION;
+    header->format = reader.format;
+    header->log_size = st.st_size;
+    header->log_mtime_ns = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+    header->records = records;
+    header->sparse_count = sparse_count;
+    header->event_count = event_count;
+    header->transition_count = transition_count;
+    memcpy(header->magic, LOG_INDEX_MAGIC, sizeof(header->magic));
+
+    munmap(map, size);
+    free(events);
+    free(sparse);
+
+    if (rename(tmp_path, index_path) != 0)
+    {
+        perror("Error writing the log index");
+        unlink(tmp_path);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Maps an index if it matches the current state of its log.
+ * @return 0 on success, -1 if the index is missing or stale.
+ */
+static int map_index(log_index *index, const char *index_path, const struct stat *log_st)
+{
+    int fd = open(index_path, O_RDONLY);
+    if (fd == -1)
+    {
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(log_index_header))
+    {
+        close(fd);
+        return -1;
+    }
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        return -1;
+    }
+
+    const log_index_header *header = map;
+    uint64_t postings = header->sparse_count + header->records + header->transition_count;
+    if (memcmp(header->magic, LOG_INDEX_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != LOG_INDEX_VERSION ||
+        header->log_size != (uint64_t)log_st->st_size ||
+        header->log_mtime_ns != (int64_t)log_st->st_mtim.tv_sec * 1000000000 + log_st->st_mtim.tv_nsec ||
+        sizeof(log_index_header) + postings * sizeof(log_index_posting) +
+                header->event_count * sizeof(log_index_event) != (uint64_t)st.st_size)
+    {
+        munmap(map, st.st_size);
+        return -1;
+    }
+
+    index->header = header;
+    index->sparse = (const log_index_posting *)(header + 1);
+    index->events = (const log_index_event *)(index->sparse + header->sparse_count);
+    index->postings = (const log_index_posting *)(index->events + header->event_count);
+    index->transitions = index->postings + header->records;
+    index->map_size = st.st_size;
+    return 0;
+}
+
+/**
+ * @brief Opens the index of a log, building it first if it is missing or stale.
+ *
+ * @param index Index to be opened.
+ * @param log_path Text or binary log; its index is `<log_path>.idx`.
+ * @return 0 on success, -1 if the log can't be read or indexed.
+ * \anchor log_index_open
+ */
+int log_index_open(log_index *index, const char *log_path)
+{
+    char index_path[LOG_PATH_MAX];
+    struct stat st;
+    memset(index, 0, sizeof(*index));
+
+    if (snprintf(index_path, sizeof(index_path), "%s%s", log_path, LOG_INDEX_SUFFIX) >= (int)sizeof(index_path))
+    {
+        fprintf(stderr, "Log path too long: %s\n", log_path);
+        return -1;
+    }
+    if (stat(log_path, &st) != 0)
+    {
+        perror("Error opening the log");
+        return -1;
+    }
+    if (map_index(index, index_path, &st) != 0 &&
+        (log_index_build(log_path, index_path) != 0 || map_index(index, index_path, &st) != 0))
+    {
+        fprintf(stderr, "Log index %s can't be used\n", index_path);
+        return -1;
+    }
+    if (reader_open(&index->reader, log_path) != 0)
+    {
+        perror("Error opening the log");
+        log_index_close(index);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Unmaps an index and closes its log.
+ *
+ * \anchor log_index_close
+ */
+void log_index_close(log_index *index)
+{
+    if (index->header != NULL)
+    {
+        munmap((void *)index->header, index->map_size);
+        index->header = NULL;
+    }
+    reader_close(&index->reader);
+}
+
+/**
+ * @brief First posting whose timestamp is not before a time.
+ */
+static uint64_t lower_bound(const log_index_posting *postings, uint64_t count, long from_ms)
+{
+    uint64_t low = 0, high = count;
+    while (low < high)
+    {
+        uint64_t middle = low + (high - low) / 2;
+        if (postings[middle].timestamp_ms < from_ms)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+static void print_record(FILE *out, const log_record *record)
+{
+    char line[LOG_LINE_MAX];
+    log_format_line(line, sizeof(line), record);
+    fputs(line, out);
+}
+
+/**
+ * @brief Prints the records of a posting list that fall in the time range of a query.
+ */
+static long query_postings(log_index *index, const log_index_posting *postings, uint64_t count,
+                           const log_query *query, FILE *out)
+{
+    long printed = 0;
+    log_record record;
+    uint64_t location;
+
+    for (uint64_t i = lower_bound(postings, count, query->from_ms);
+         i < count && postings[i].timestamp_ms <= query->to_ms; i++)
+    {
+        if (reader_seek(&index->reader, postings[i].location) != 0 ||
+            !reader_next(&index->reader, &record, &location))
+        {
+            continue;
+        }
+        if (query->by_event && record.event_id != query->event_id)
+        {
+            continue;
+        }
+        print_record(out, &record);
+        printed++;
+    }
+    return printed;
+}
+
+/**
+ * @brief Prints the records of the log that match a query, in the text log format.
+ *
+ * Event-ID and transition queries read only the matching records; time-range queries
+ * start at the sparse index entry before the range and read the records of the range.
+ *
+ * @param index Opened index.
+ * @param query Time range and filters.
+ * @param out Stream that receives the records, header included.
+ * @return Number of printed records.
+ * \anchor log_index_query
+ */
+long log_index_query(log_index *index, const log_query *query, FILE *out)
+{
+    fputs(LOG_HEADER, out);
+    if (query->from_ms > query->to_ms)
+    {
+        return 0;
+    }
+
+    if (query->transitions)
+    {
+        return query_postings(index, index->transitions, index->header->transition_count, query, out);
+    }
+    if (query->by_event)
+    {
+        const log_index_event *event = find_event(index->events, index->header->event_count, query->event_id);
+        return event == NULL ? 0 : query_postings(index, index->postings + event->first, event->count, query, out);
+    }
+
+    uint64_t start = lower_bound(index->sparse, index->header->sparse_count, query->from_ms);
+    if (start > 0)
+    {
+        start--; // Records before the first sparse entry of the range may be in it
+    }
+    if (start >= index->header->sparse_count || reader_seek(&index->reader, index->sparse[start].location) != 0)
+    {
+        return 0;
+    }
+
+    long printed = 0;
+    log_record record;
+    uint64_t location;
+    for (uint64_t read = 0; read < index->header->records - start * LOG_INDEX_STRIDE &&
+                            reader_next(&index->reader, &record, &location);
+         read++)
+    {
+        if (record.timestamp_ms > query->to_ms)
+        {
+            break;
+        }
+        if (record.timestamp_ms >= query->from_ms)
+        {
+            print_record(out, &record);
+            printed++;
+        }
+    }
+    return printed;
+}
@@ -0,0 +1,245 @@
+/**
+ * @file log_journal.c
+ * @brief Memory-mapped append-only event journal used by log_utils (LOG_FORMAT_JOURNAL).
+ *
+ * The file is created at its full size with posix_fallocate, so appends never allocate
+ * blocks nor change the file size; they are stores to the shared mapping. Dirty pages are
+ * handed to the kernel with msync(MS_ASYNC) every LOG_JOURNAL_SYNC_RECORDS appends and on
+ * log_journal_sync, so the writer never waits for the disk.
+ *
+ * Only one writer may append at a time (the logger thread, or the thread calling log_event).
+ */
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "log_journal.h"
+
+_Static_assert(sizeof(log_journal_header) <= LOG_JOURNAL_HEADER_SIZE, "Journal header must fit its page");
+
+/**
+ * @brief Checks the header of an existing journal.
+ */
+static int journal_header_valid(const log_journal_header *header, size_t file_size)
+{
+    return memcmp(header->magic, LOG_JOURNAL_MAGIC, sizeof(LOG_JOURNAL_MAGIC)) == 0 &&
+           header->version == LOG_JOURNAL_VERSION &&
+           header->record_size == sizeof(log_bin_record) &&
+           LOG_JOURNAL_HEADER_SIZE + header->capacity * sizeof(log_bin_record) <= file_size &&
+           atomic_load_explicit(&header->committed, memory_order_acquire) <= header->capacity;
+}
+
+/**
+ * @brief Opens a journal for appending, creating and preallocating it if needed.
+ *
+ * An existing journal keeps its capacity and resumes after its last committed record;
+ * a record written but not committed before a crash is overwritten by the next append.
+ *
+ * @param journal Journal to be opened.
+ * @param path Path of the journal file.
+ * @param capacity Record slots of a new journal (0 = LOG_JOURNAL_RECORDS).
+ * @return 0 on success, -1 if the file can't be created, mapped or isn't a journal.
+ * \anchor log_journal_open
+ */
+int log_journal_open(log_journal *journal, const char *path, uint64_t capacity)
+{
+    if (capacity == 0)
+    {
+        capacity = LOG_JOURNAL_RECORDS;
+    }
+
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd == -1)
+    {
+        perror("Error opening log journal");
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        perror("Error reading log journal size");
+        close(fd);
+        return -1;
+    }
+    int created = st.st_size == 0;
+    size_t map_size = created ? LOG_JOURNAL_HEADER_SIZE + capacity * sizeof(log_bin_record) : (size_t)st.st_size;
+
+    if (created && posix_fallocate(fd, 0, (off_t)map_size) != 0)
+    {
+        perror("Error preallocating log journal");
+        close(fd);
+        return -1;
+    }
+
+    void *map = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd); // The mapping keeps the file open
+    if (map == MAP_FAILED)
+    {
+        perror("Error mapping log journal");
+        return -1;
+    }
+
+    journal->header = map;
+    journal->records = (log_bin_record *)((char *)map + LOG_JOURNAL_HEADER_SIZE);
+    journal->map_size = map_size;
+
+    if (created)
+    {
+        memcpy(journal->header->magic, LOG_JOURNAL_MAGIC, sizeof(LOG_JOURNAL_MAGIC));
+        journal->header->version = LOG_JOURNAL_VERSION;
+        journal->header->record_size = sizeof(log_bin_record);
+        journal->header->capacity = capacity;
+        atomic_store_explicit(&journal->header->committed, 0, memory_order_release);
+    }
+    else if (!journal_header_valid(journal->header, map_size))
+    {
+        fprintf(stderr, "%s is not a valid log journal\n", path);
+        munmap(map, map_size);
+        journal->header = NULL;
+        return -1;
+    }
+
+    journal->synced = atomic_load_explicit(&journal->header->committed, memory_order_relaxed);
+    return 0;
+}
+
+/**
+ * @brief Appends a record and commits it.
+ *
+ * @param journal Journal opened by log_journal_open.
+ * @param record Event to be appended.
+ * @return 0 on success, -1 if the journal is full.
+ * \anchor log_journal_append
+ */
+int log_journal_append(log_journal *journal, const log_record *record)
+{
+    log_journal_header *header = journal->header;
+    uint64_t index = atomic_load_explicit(&header->committed, memory_order_relaxed);
+
+    if (index == header->capacity)
+    {
+        return -1;
+    }
+    if (index == 0 && header->id_aeb[0] == '\0')
+    {
+        strncpy(header->id_aeb, record->id_aeb, LOG_ID_AEB_MAX - 1);
+    }
+
+    log_bin_pack(&journal->records[index], record);
+    // Publish: readers that see the new index also see the record
+    atomic_store_explicit(&header->committed, index + 1, memory_order_release);
+
+    if (index + 1 - journal->synced >= LOG_JOURNAL_SYNC_RECORDS)
+    {
+        log_journal_sync(journal);
+    }
+    return 0;
+}
+
+/**
+ * @brief Schedules the write back of the records appended since the last sync and of the
+ * header, without waiting for it (msync with MS_ASYNC).
+ *
+ * @param journal Journal opened by log_journal_open.
+ * \anchor log_journal_sync
+ */
+void log_journal_sync(log_journal *journal)
+{
+    uint64_t committed = atomic_load_explicit(&journal->header->committed, memory_order_relaxed);
+    if (committed == journal->synced)
+    {
+        return;
+    }
+
+    long page = sysconf(_SC_PAGESIZE);
+    size_t begin = LOG_JOURNAL_HEADER_SIZE + journal->synced * sizeof(log_bin_record);
+    size_t end = LOG_JOURNAL_HEADER_SIZE + committed * sizeof(log_bin_record);
+    begin -= begin % page;
+
+    // Records first, then the page holding the commit index
+    msync((char *)journal->header + begin, end - begin, MS_ASYNC);
+    msync(journal->header, LOG_JOURNAL_HEADER_SIZE, MS_ASYNC);
+    journal->synced = committed;
+}
+
+/**
+ * @brief Syncs and unmaps a journal.
+ *
+ * @param journal Journal opened by log_journal_open.
+ * \anchor log_journal_close
+ */
+void log_journal_close(log_journal *journal)
+{
+    if (journal->header == NULL)
+    {
+        return;
+    }
+    log_journal_sync(journal);
+    munmap(journal->header, journal->map_size);
+    journal->header = NULL;
+}
+
+/**
+ * @brief Prints the committed records of a journal in the text log format.
+ *
+ * The journal is mapped read-only, so it can be decoded while a writer appends to it;
+ * the records committed at the time of the call are printed.
+ *
+ * @param path Path of the journal file.
+ * @param out Stream that receives the text log, header included.
+ * @return Number of decoded records, or -1 if the file isn't a journal.
+ * \anchor log_journal_decode
+ */
+long log_journal_decode(const char *path, FILE *out)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd == -1)
+    {
+        perror("Error opening log journal");
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < LOG_JOURNAL_HEADER_SIZE)
+    {
+        fprintf(stderr, "%s is not a valid log journal\n", path);
+        close(fd);
+        return -1;
+    }
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        perror("Error mapping log journal");
+        return -1;
+    }
+
+    const log_journal_header *header = map;
+    if (!journal_header_valid(header, st.st_size))
+    {
+        fprintf(stderr, "%s is not a valid log journal\n", path);
+        munmap(map, st.st_size);
+        return -1;
+    }
+
+    uint64_t committed = atomic_load_explicit(&((log_journal_header *)header)->committed, memory_order_acquire);
+    const log_bin_record *records = (const log_bin_record *)((const char *)map + LOG_JOURNAL_HEADER_SIZE);
+    log_record record;
+    char line[LOG_LINE_MAX];
+
+    memcpy(record.id_aeb, header->id_aeb, LOG_ID_AEB_MAX);
+    record.id_aeb[LOG_ID_AEB_MAX - 1] = '\0';
+    fputs(LOG_HEADER, out);
+    for (uint64_t i = 0; i < committed; i++)
+    {
+        log_bin_unpack(&record, &records[i]);
+        log_format_line(line, sizeof(line), &record);
+        fputs(line, out);
+    }
+
+    munmap(map, st.st_size);
+    return (long)committed;
+}
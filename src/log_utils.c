@@ -2,19 +2,614 @@
  * @file log_utils.c
  * @brief Utilitary file for event tracking in actuators abstraction.
  *
- * This file provides functionality to log events with timestamps 
+ * This file provides functionality to log events with timestamps
  * and relevant actuator states.
+ *
+ * After log_init, the log file stays open: the header is written once, each event is
+ * formatted into a reusable buffer and appended to a fully buffered stream, and the
+ * stream is flushed according to the configured log_flush_policy. Without log_init,
+ * log_event opens, appends to and closes the file on every call.
+ *
+ * With log_config.async, log_event only timestamps the event and pushes a log_record into
+ * a lock-free MPSC ring; a logger thread formats and writes the records in batches. When
+ * the ring is full the record is dropped and counted, so the caller never waits on the disk.
+ *
+ * With LOG_FORMAT_BINARY the records are not formatted at all: they are packed into the
+ * checksummed blocks described in log_binary.h and decoded offline by aeb_logcat.
+ *
+ * With LOG_FILTER_TRANSITIONS, an event is written only when the actuators state differs
+ * from the last written one. Repeated events are counted and written as one SUMMARY record
+ * (the last suppressed event plus the count) when summary_interval_ms elapsed, right
+ * before the next transition, or on log_shutdown. The filter runs where the records are
+ * written, i.e. in the logger thread in asynchronous mode.
+ *
+ * With rotate_max_bytes or rotate_interval_ms, the log is a series of segments. The next
+ * segment is prepared in advance as "<path>.spare": created, header written and its blocks
+ * reserved with fallocate(FALLOC_FL_KEEP_SIZE), so appends don't allocate blocks. At the
+ * switch the rotated segments are shifted (<path>.1 is the newest, older than rotate_keep
+ * are deleted), the active segment is linked as <path>.1 and the spare is renamed over
+ * <path>, which atomically replaces it for any reader.
+ *
+ * LOG_FORMAT_JOURNAL replaces the stdio stream with the memory-mapped journal of
+ * log_journal.c; flushing it means an asynchronous msync. Rotation doesn't apply to it.
  */
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <time.h>
 #include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <fcntl.h>
 #include "log_utils.h"
+#include "mpsc_queue.h"
+#include "log_binary.h"
+#include "log_journal.h"
+#include "aeb_probes.h"
+
+#define LOG_STREAM_BUFFER_SIZE 65536
+#define LOG_BATCH_MAX 64        // Records written by the logger thread between flush checks
+#define LOG_IDLE_POLL_US 1000   // Logger thread sleep when the ring is empty
+
+static bool log_open = false;
+static FILE *log_file = NULL;
+static log_journal journal;
+static log_config active_config;
+static char log_line[LOG_LINE_MAX];
+static char log_stream_buffers[2][LOG_STREAM_BUFFER_SIZE]; // Active and spare segments
+static int active_buffer = 0;
+static unsigned int events_since_flush = 0;
+static struct timespec last_flush;
+static log_bin_block bin_block;
+
+static char log_path[LOG_PATH_MAX];
+static char spare_path[LOG_PATH_MAX + 8];
+static FILE *spare_file = NULL;
+static unsigned long segment_bytes = 0;
+static unsigned long segment_header_bytes = 0;
+static struct timespec segment_opened;
+
+static struct
+{
+    bool has_last;            // A record was written since log_init
+    unsigned char last_state; // Packed actuators state of the last written record
+    log_record suppressed;    // Last suppressed event
+    uint16_t suppressed_count;
+    struct timespec last_written;
+} filter_state;
+
+static mpsc_queue log_ring;
+static pthread_t logger_id;
+static atomic_bool logger_running = false;
+static atomic_bool flush_requested = false;
+static atomic_ulong dropped_events = 0;
+static atomic_ulong written_bytes = 0; // Written by one thread at a time, read by the actuators metrics
+
+/**
+ * @brief Captures the timestamp and the data of one event.
+ *
+ * @param record Record that receives the event.
+ * @param id_aeb Identifier for the AEB system (truncated to LOG_ID_AEB_MAX - 1 characters).
+ * @param event_id The unique event identifier.
+ * @param actuators Structure containing actuator state information.
+ */
+static void fill_log_record(log_record *record, const char *id_aeb, uint32_t event_id,
+                            actuators_abstraction actuators)
+{
+    // Getting the timestamp instead just the date, because it's more useful (miliseconds)
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    record->timestamp_ms = ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+    record->event_id = event_id;
+    strncpy(record->id_aeb, id_aeb, LOG_ID_AEB_MAX - 1);
+    record->id_aeb[LOG_ID_AEB_MAX - 1] = '\0';
+    record->actuators = actuators;
+    record->kind = LOG_RECORD_EVENT;
+    record->count = 0;
+}
+
+/**
+ * @brief Formats one event in the log line format.
+ *
+ * Summary records have "SUMMARY <count>" in the MESSAGE column instead of "WARNING".
+ *
+ * @param line Buffer that receives the line.
+ * @param size Size of the buffer.
+ * @param record Event to be formatted.
+ * @return Length of the formatted line.
+ *
+ * \anchor log_format_line
+ */
+int log_format_line(char *line, size_t size, const log_record *record)
+{
+    char message[16] = "WARNING";
+    if (record->kind == LOG_RECORD_SUMMARY) {
+        snprintf(message, sizeof(message), "SUMMARY %u", record->count);
+    }
+
+    // Event id is written as a 8 character hexadecimal string
+    return snprintf(line, size, "%s | %08X | %07ld | %s | %d | %d | %d | %d | %d\n",
+                    record->id_aeb,
+                    record->event_id,
+                    record->timestamp_ms,
+                    message,
+                    actuatorIsActive(record->actuators, ACTUATOR_BIT_BELT_TIGHTNESS),
+                    actuatorIsActive(record->actuators, ACTUATOR_BIT_DOOR_LOCK),
+                    actuatorIsActive(record->actuators, ACTUATOR_BIT_ABS),
+                    actuatorIsActive(record->actuators, ACTUATOR_BIT_ALARM_LED),
+                    actuatorIsActive(record->actuators, ACTUATOR_BIT_ALARM_BUZZER));
+}
+
+/**
+ * @brief Milliseconds elapsed since a CLOCK_MONOTONIC instant.
+ */
+static long elapsed_ms(const struct timespec *since)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - since->tv_sec) * 1000 + (now.tv_nsec - since->tv_nsec) / 1000000;
+}
+
+static void flush_log_stream(void);
+
+/**
+ * @brief Writes the header of an empty segment.
+ * @return Bytes in the segment after the header.
+ */
+static unsigned long write_log_file_header(FILE *file)
+{
+    fseek(file, 0, SEEK_END);
+    if (ftell(file) == 0) {
+        // If the file is empty, write the header
+        if (active_config.format == LOG_FORMAT_BINARY) {
+            log_bin_write_file_header(file);
+        } else {
+            fputs(LOG_HEADER, file);
+        }
+    }
+    fflush(file);
+    return (unsigned long)ftell(file);
+}
+
+static bool rotation_enabled(void)
+{
+    return active_config.format != LOG_FORMAT_JOURNAL &&
+           (active_config.rotate_max_bytes > 0 || active_config.rotate_interval_ms > 0);
+}
+
+/**
+ * @brief Reserves the blocks of a whole segment without changing the file size.
+ *
+ * Filesystems without fallocate support just keep allocating on append.
+ */
+static void preallocate_segment(FILE *file)
+{
+    if (active_config.rotate_max_bytes > 0) {
+        fallocate(fileno(file), FALLOC_FL_KEEP_SIZE, 0, (off_t)active_config.rotate_max_bytes);
+    }
+}
 
+/**
+ * @brief Releases the blocks reserved past the data of a segment that won't grow anymore.
+ */
+static void trim_segment(FILE *file)
+{
+    if (active_config.rotate_max_bytes > 0) {
+        fflush(file);
+        if (ftruncate(fileno(file), ftell(file)) != 0) {
+            perror("Error trimming log segment");
+        }
+    }
+}
+
+/**
+ * @brief Creates the next segment as <path>.spare, ready to take over the active one.
+ */
+static void prepare_spare_segment(void)
+{
+    spare_file = fopen(spare_path, "w");
+    if (spare_file == NULL) {
+        perror("Error creating spare log segment");
+        return;
+    }
+    setvbuf(spare_file, log_stream_buffers[active_buffer ^ 1], _IOFBF, LOG_STREAM_BUFFER_SIZE);
+    write_log_file_header(spare_file);
+    preallocate_segment(spare_file);
+}
+
+/**
+ * @brief Closes the active segment and switches to the spare one.
+ */
+static void rotate_log_segment(void)
+{
+    char from[LOG_PATH_MAX + 16];
+    char to[LOG_PATH_MAX + 16];
+
+    if (spare_file == NULL) {
+        prepare_spare_segment();
+        if (spare_file == NULL) {
+            // Keep writing to the active segment, try again in a full segment
+            segment_bytes = segment_header_bytes;
+            clock_gettime(CLOCK_MONOTONIC, &segment_opened);
+            return;
+        }
+    }
+
+    // Partial binary block and buffered lines stay in the segment they belong to
+    flush_log_stream();
+
+    for (unsigned int k = active_config.rotate_keep - 1; k >= 1; k--) {
+        snprintf(from, sizeof(from), "%s.%u", log_path, k);
+        snprintf(to, sizeof(to), "%s.%u", log_path, k + 1);
+        rename(from, to);
+    }
+    snprintf(to, sizeof(to), "%s.1", log_path);
+    remove(to);
+    if (link(log_path, to) != 0) {
+        rename(log_path, to);
+    }
+    // Atomic switch: <path> is always a complete segment
+    rename(spare_path, log_path);
+
+    trim_segment(log_file);
+    fclose(log_file);
+    log_file = spare_file;
+    spare_file = NULL;
+    active_buffer ^= 1;
+
+    segment_bytes = segment_header_bytes;
+    clock_gettime(CLOCK_MONOTONIC, &segment_opened);
+    prepare_spare_segment();
+}
+
+/**
+ * @brief Rotates the log if the next write would exceed the segment size or if the
+ * segment is older than the rotation interval, then accounts for the write.
+ *
+ * @param next_bytes Size of the next write.
+ */
+static void rotate_log_if_needed(unsigned long next_bytes)
+{
+    if (!rotation_enabled()) {
+        return;
+    }
+    bool full = active_config.rotate_max_bytes > 0 &&
+                segment_bytes + next_bytes > active_config.rotate_max_bytes &&
+                segment_bytes > segment_header_bytes;
+    bool old = active_config.rotate_interval_ms > 0 &&
+               elapsed_ms(&segment_opened) >= (long)active_config.rotate_interval_ms;
+    if (full || old) {
+        rotate_log_segment();
+    }
+    segment_bytes += next_bytes;
+}
+
+/**
+ * @brief Appends one record to the open log stream.
+ */
+static void write_log_record(const log_record *record)
+{
+    unsigned long size;
+    if (active_config.format == LOG_FORMAT_JOURNAL) {
+        if (log_journal_append(&journal, record) != 0) {
+            atomic_fetch_add_explicit(&dropped_events, 1, memory_order_relaxed);
+            return;
+        }
+        size = sizeof(log_bin_record);
+    } else if (active_config.format == LOG_FORMAT_BINARY) {
+        size = sizeof(log_bin_record) + (bin_block.header.count == 0 ? sizeof(log_bin_block_header) : 0);
+        rotate_log_if_needed(size);
+        log_bin_append(&bin_block, log_file, record);
+    } else {
+        int length = log_format_line(log_line, sizeof(log_line), record);
+        size = length;
+        rotate_log_if_needed(size);
+        fwrite(log_line, 1, length, log_file);
+    }
+    atomic_store_explicit(&written_bytes, atomic_load_explicit(&written_bytes, memory_order_relaxed) + size,
+                          memory_order_relaxed);
+    events_since_flush++;
+}
+
+/**
+ * @brief Writes the summary of the suppressed events, if any.
+ */
+static void write_log_summary(void)
+{
+    if (filter_state.suppressed_count == 0) {
+        return;
+    }
+    log_record summary = filter_state.suppressed;
+    summary.kind = LOG_RECORD_SUMMARY;
+    summary.count = filter_state.suppressed_count;
+    write_log_record(&summary);
+
+    filter_state.suppressed_count = 0;
+    clock_gettime(CLOCK_MONOTONIC, &filter_state.last_written);
+}
+
+/**
+ * @brief Writes a record if the configured log_filter keeps it, otherwise counts it.
+ */
+static void filter_log_record(const log_record *record)
+{
+    if (active_config.filter == LOG_FILTER_ALL) {
+        write_log_record(record);
+        return;
+    }
+
+    unsigned char state = record->actuators;
+    if (!filter_state.has_last || state != filter_state.last_state) {
+        // Transition: close the suppressed interval before it
+        write_log_summary();
+        write_log_record(record);
+        filter_state.has_last = true;
+        filter_state.last_state = state;
+        clock_gettime(CLOCK_MONOTONIC, &filter_state.last_written);
+        return;
+    }
+
+    filter_state.suppressed = *record;
+    filter_state.suppressed_count++;
+    if (filter_state.suppressed_count == UINT16_MAX ||
+        elapsed_ms(&filter_state.last_written) >= (long)active_config.summary_interval_ms) {
+        write_log_summary();
+    }
+}
+
+/**
+ * @brief Hands everything written so far, including a partial binary block, to the file.
+ */
+static void flush_log_stream(void)
+{
+    if (active_config.format == LOG_FORMAT_JOURNAL) {
+        log_journal_sync(&journal);
+    } else {
+        if (active_config.format == LOG_FORMAT_BINARY) {
+            log_bin_write_block(&bin_block, log_file);
+        }
+        fflush(log_file);
+    }
+    events_since_flush = 0;
+    clock_gettime(CLOCK_MONOTONIC, &last_flush);
+}
+
+/**
+ * @brief Flushes the stream if the configured policy says so.
+ */
+static void apply_flush_policy(void)
+{
+    bool flush = false;
+    switch (active_config.flush_policy) {
+    case LOG_FLUSH_EVERY_EVENT:
+        flush = events_since_flush > 0;
+        break;
+    case LOG_FLUSH_EVERY_N:
+        flush = events_since_flush >= active_config.flush_every_n;
+        break;
+    case LOG_FLUSH_INTERVAL:
+        flush = events_since_flush > 0 && elapsed_ms(&last_flush) >= (long)active_config.flush_interval_ms;
+        break;
+    }
+    if (flush) {
+        flush_log_stream();
+    }
+}
+
+/**
+ * @brief Logger thread: drains the ring in batches and writes the records to the log file.
+ *
+ * The flush policy is applied after each batch, so LOG_FLUSH_EVERY_EVENT flushes once per
+ * batch instead of once per record. When the thread is stopped it drains what is left.
+ *
+ * @param arg Unused parameter (can be NULL).
+ * @return NULL
+ */
+static void *loggerLoop(void *arg)
+{
+    log_record record;
+
+    for (;;) {
+        bool running = atomic_load_explicit(&logger_running, memory_order_acquire);
+        int written = 0;
+
+        while (written < LOG_BATCH_MAX && mpsc_pop(&log_ring, &record) == 0) {
+            filter_log_record(&record);
+            written++;
+        }
+
+        if (atomic_exchange(&flush_requested, false)) {
+            flush_log_stream();
+        } else {
+            apply_flush_policy();
+        }
+
+        if (written == 0) {
+            if (!running && mpsc_size(&log_ring) == 0) {
+                break;
+            }
+            usleep(LOG_IDLE_POLL_US);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Opens the log file and keeps it open for the following events.
+ *
+ * The header is written if the file is empty. The stream is fully buffered, so events only
+ * reach the file when the flush policy says so (or on log_flush/log_shutdown). With
+ * config->async the logger thread is started and owns the stream until log_shutdown.
+ *
+ * @param config Path and flush policy of the log.
+ * @return 0 on success, -1 if the file can't be opened.
+ *
+ * \anchor log_init
+ */
+int log_init(const log_config *config)
+{
+    log_shutdown();
+
+    active_config = *config;
+    if (active_config.format == LOG_FORMAT_JOURNAL) {
+        if (log_journal_open(&journal, config->path, active_config.journal_records) != 0) {
+            return -1;
+        }
+    } else {
+        log_file = fopen(config->path, "a");
+        if (log_file == NULL) {
+            perror("Error opening log file");
+            return -1;
+        }
+        active_buffer = 0;
+        setvbuf(log_file, log_stream_buffers[active_buffer], _IOFBF, LOG_STREAM_BUFFER_SIZE);
+    }
+
+    if (active_config.flush_every_n == 0) {
+        active_config.flush_every_n = 1;
+    }
+    if (active_config.summary_interval_ms == 0) {
+        active_config.summary_interval_ms = LOG_SUMMARY_INTERVAL_MS;
+    }
+    if (active_config.rotate_keep == 0) {
+        active_config.rotate_keep = LOG_ROTATE_KEEP;
+    }
+
+    if (log_file != NULL) {
+        //Check if the file is empty
+        segment_bytes = write_log_file_header(log_file);
+        segment_header_bytes = active_config.format == LOG_FORMAT_BINARY ? sizeof(log_bin_file_header) : strlen(LOG_HEADER);
+    }
+    if (rotation_enabled()) {
+        snprintf(log_path, sizeof(log_path), "%s", config->path);
+        snprintf(spare_path, sizeof(spare_path), "%s.spare", log_path);
+        preallocate_segment(log_file);
+        clock_gettime(CLOCK_MONOTONIC, &segment_opened);
+        prepare_spare_segment();
+    }
+
+    bin_block.header.count = 0;
+    memset(&filter_state, 0, sizeof(filter_state));
+    events_since_flush = 0;
+    clock_gettime(CLOCK_MONOTONIC, &last_flush);
+    atomic_store(&dropped_events, 0);
+    atomic_store(&written_bytes, 0);
+    log_open = true;
+
+    if (active_config.async) {
+        size_t capacity = active_config.ring_capacity != 0 ? active_config.ring_capacity : LOG_RING_CAPACITY;
+        if (mpsc_init(&log_ring, capacity, sizeof(log_record)) != 0) {
+            fprintf(stderr, "Error creating log ring: capacity must be a power of two\n");
+            active_config.async = false;
+            log_shutdown();
+            return -1;
+        }
+        atomic_store(&logger_running, true);
+        if (pthread_create(&logger_id, NULL, loggerLoop, NULL) != 0) {
+            perror("Error creating logger thread");
+            atomic_store(&logger_running, false);
+            mpsc_destroy(&log_ring);
+            active_config.async = false;
+            log_shutdown();
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Hands the buffered events to the log file.
+ *
+ * In asynchronous mode the flush is requested to the logger thread, which does it after
+ * writing the records already in the ring.
+ *
+ * \anchor log_flush
+ */
+void log_flush(void)
+{
+    if (!log_open) {
+        return;
+    }
+    if (active_config.async) {
+        atomic_store(&flush_requested, true);
+        return;
+    }
+    flush_log_stream();
+}
+
+/**
+ * @brief Flushes and closes the log file opened by log_init.
+ *
+ * In asynchronous mode the logger thread writes the remaining records before it is joined.
+ * The number of dropped events, if any, is reported on stderr. A pending summary of
+ * suppressed events is written before the file is closed.
+ *
+ * \anchor log_shutdown
+ */
+void log_shutdown(void)
+{
+    if (!log_open) {
+        return;
+    }
+    if (active_config.async) {
+        atomic_store_explicit(&logger_running, false, memory_order_release);
+        pthread_join(logger_id, NULL);
+        mpsc_destroy(&log_ring);
+        active_config.async = false;
+    }
+    write_log_summary();
+    flush_log_stream();
+
+    unsigned long dropped = atomic_load(&dropped_events);
+    if (dropped > 0) {
+        fprintf(stderr, "Log: %lu events dropped, logger ring or journal was full\n", dropped);
+    }
+    if (active_config.format == LOG_FORMAT_JOURNAL) {
+        log_journal_close(&journal);
+    } else {
+        trim_segment(log_file);
+        fclose(log_file);
+        log_file = NULL;
+    }
+    if (spare_file != NULL) {
+        fclose(spare_file);
+        spare_file = NULL;
+        remove(spare_path);
+    }
+    log_open = false;
+}
+
+/**
+ * @brief Gets the number of events dropped because the logger ring or the journal was full.
+ *
+ * @return Dropped events since the last log_init.
+ *
+ * \anchor log_dropped_events
+ */
+unsigned long log_dropped_events(void)
+{
+    return atomic_load(&dropped_events);
+}
+
+/**
+ * @brief Gets the number of bytes of records handed to the log stream.
+ *
+ * @return Bytes of the events and summaries written since the last log_init, not counting the
+ * file headers.
+ *
+ * \anchor log_written_bytes
+ */
+unsigned long log_written_bytes(void)
+{
+    return atomic_load_explicit(&written_bytes, memory_order_relaxed);
+}
 
 /**
  * @brief Logs an event to a file with a timestamp and actuator data.
  *
- * This function logs an event by appending it to a log file. It records the event ID, 
+ * This function logs an event by appending it to a log file. It records the event ID,
  * the timestamp (in milliseconds), and actuator states in a structured format.
  *
  * @param id_aeb Identifier for the AEB system.
@@ -23,44 +618,47 @@
  *
  * \anchor log_event
  *
- * @note This function is a called from the actuators module, and it is used as a way to guarantee tava 
+ * @note This function is a called from the actuators module, and it is used as a way to guarantee tava
  * every change to the AEB internal state is captured and stored on the log file.
  */
 
 void log_event(const char *id_aeb, uint32_t event_id, actuators_abstraction actuators) {
-    FILE *log_file = fopen("log/log.txt", "a");
-    if (log_file == NULL) {
+    AEB_PROBE2(log_event, event_id, actuators);
+    log_record record;
+    fill_log_record(&record, id_aeb, event_id, actuators);
+
+    if (log_open && active_config.async) {
+        // Asynchronous writer: never wait on the logger thread, count the event if the ring is full
+        if (mpsc_push(&log_ring, &record) != 0) {
+            atomic_fetch_add_explicit(&dropped_events, 1, memory_order_relaxed);
+        }
+        return;
+    }
+
+    if (log_open) {
+        // Persistent writer: no open/seek/close, only a copy into the stream buffer
+        filter_log_record(&record);
+        apply_flush_policy();
+        return;
+    }
+
+    FILE *file = fopen(LOG_FILE_PATH, "a");
+    if (file == NULL) {
         perror("Error opening log file");
         return;
     }
 
     //Check if the file is empty
-    fseek(log_file, 0, SEEK_END);
-    if (ftell(log_file) == 0) {
+    fseek(file, 0, SEEK_END);
+    if (ftell(file) == 0) {
         // If the file is empty, write the header
-        fprintf(log_file, "ID_AEB | EVENT_ID | TIMESTAMP | MESSAGE | BELT_TIGHTNESS | DOOR_LOCK | ABS_ACTIVATION | ALARM_LED | ALARM_BUZZER\n");
+        fputs(LOG_HEADER, file);
     }
-    fseek(log_file, 0, SEEK_END); // Move the file pointer to the end of the file
-
-    // Getting the timestamp instead just the date, because it's more useful (miliseconds)
-    struct timespec ts;
-    clock_gettime(CLOCK_REALTIME, &ts);
-    long timestamp_ms = ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
-
-    // Convert id to hexadecimal string
-    char event_id_str[9]; // 8 caracteres + '\0'
-    snprintf(event_id_str, sizeof(event_id_str), "%08X", event_id);
 
     // Write in file in desired format
-    fprintf(log_file, "%s | %s | %07ld | WARNING | %d | %d | %d | %d | %d\n",
-            id_aeb,
-            event_id_str,
-            timestamp_ms,
-            actuators.belt_tightness,
-            actuators.door_lock,
-            actuators.should_activate_abs,
-            actuators.alarm_led,
-            actuators.alarm_buzzer);
+    char line[LOG_LINE_MAX];
+    log_format_line(line, sizeof(line), &record);
+    fputs(line, file);
 
-    fclose(log_file);
+    fclose(file);
 }
@@ -0,0 +1,248 @@
+/**
+ * @file mailbox.c
+ * @brief Writer and readers of the shared memory latest-value mailbox.
+ *
+ * The slot of a CAN ID is found by hashing the identifier and probing the next slots; the
+ * first post of an ID claims a free slot with a compare-and-swap, later posts and every read
+ * find it in the first probes. A post is a sequence lock write: sequence made odd, frame
+ * stored with plain stores, sequence made even with release ordering. A read copies the
+ * frame between two loads of the sequence and keeps the copy only if both are the same even
+ * value, as the flight recorder dumper does with its entries.
+ */
+
+#include <fcntl.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "mailbox.h"
+#include "constants.h"
+
+_Static_assert((MAILBOX_SLOTS & (MAILBOX_SLOTS - 1)) == 0, "Mailbox slots must be a power of two");
+_Static_assert(sizeof(mailbox_slot) == MAILBOX_CACHE_LINE, "Mailbox slot must fill one cache line");
+
+/**
+ * @brief Creates (or resets) the mailbox segment.
+ *
+ * @param name POSIX shared memory name, e.g. MAILBOX_SHM.
+ * @return 0 on success, -1 on shared memory error.
+ * \anchor mailbox_create
+ */
+int mailbox_create(const char *name)
+{
+    int fd = shm_open(name, O_CREAT | O_RDWR, SHM_PERMISSIONS);
+    if (fd == -1)
+    {
+        perror("Error creating mailbox");
+        return -1;
+    }
+    if (ftruncate(fd, 0) != 0 || ftruncate(fd, sizeof(mailbox_header)) != 0)
+    {
+        perror("Error sizing mailbox");
+        close(fd);
+        return -1;
+    }
+    mailbox_header *header = mmap(NULL, sizeof(mailbox_header), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (header == MAP_FAILED)
+    {
+        perror("Error mapping mailbox");
+        return -1;
+    }
+
+    // The segment is zero filled: every slot is free
+    header->slots = MAILBOX_SLOTS;
+    header->slot_size = sizeof(mailbox_slot);
+    atomic_thread_fence(memory_order_release);
+    memcpy(header->magic, MAILBOX_MAGIC, sizeof(MAILBOX_MAGIC));
+
+    munmap(header, sizeof(mailbox_header));
+    return 0;
+}
+
+/**
+ * @brief Maps an existing mailbox and checks its header.
+ *
+ * @param box Receives the mapping.
+ * @param name POSIX shared memory name used by mailbox_create.
+ * @return 0 on success, -1 if there is no valid mailbox (box->header stays NULL).
+ * \anchor mailbox_attach
+ */
+int mailbox_attach(mailbox *box, const char *name)
+{
+    box->header = NULL;
+
+    int fd = shm_open(name, O_RDWR, SHM_PERMISSIONS);
+    if (fd == -1)
+    {
+        return -1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(mailbox_header))
+    {
+        close(fd);
+        return -1;
+    }
+    mailbox_header *header = mmap(NULL, sizeof(mailbox_header), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (header == MAP_FAILED)
+    {
+        return -1;
+    }
+    if (memcmp(header->magic, MAILBOX_MAGIC, sizeof(MAILBOX_MAGIC)) != 0 || header->slots != MAILBOX_SLOTS ||
+        header->slot_size != sizeof(mailbox_slot))
+    {
+        munmap(header, sizeof(mailbox_header));
+        return -1;
+    }
+    box->header = header;
+    return 0;
+}
+
+/**
+ * @brief Unmaps a mailbox.
+ *
+ * \anchor mailbox_detach
+ */
+void mailbox_detach(mailbox *box)
+{
+    if (box->header == NULL)
+    {
+        return;
+    }
+    munmap(box->header, sizeof(mailbox_header));
+    box->header = NULL;
+}
+
+/**
+ * @brief Removes the mailbox name (mappings stay valid until detached).
+ *
+ * \anchor mailbox_destroy
+ */
+void mailbox_destroy(const char *name)
+{
+    shm_unlink(name);
+}
+
+static unsigned int home_slot(uint32_t identifier)
+{
+    return (identifier * 2654435761u) >> 16 & (MAILBOX_SLOTS - 1);
+}
+
+/**
+ * @brief Finds the slot of a CAN ID, claiming a free one if asked to.
+ *
+ * @return Slot, or NULL if the ID has no slot (and none could be claimed).
+ */
+static mailbox_slot *find_slot(mailbox_header *header, uint32_t identifier, int claim)
+{
+    for (unsigned int probe = 0; probe < MAILBOX_SLOTS; probe++)
+    {
+        mailbox_slot *slot = &header->slot[(home_slot(identifier) + probe) & (MAILBOX_SLOTS - 1)];
+        uint32_t state = atomic_load_explicit(&slot->state, memory_order_acquire);
+
+        if (state == MAILBOX_SLOT_FREE)
+        {
+            if (!claim)
+            {
+                return NULL; // IDs are never removed, so a free slot ends the probe sequence
+            }
+            if (atomic_compare_exchange_strong(&slot->state, &state, MAILBOX_SLOT_CLAIMED))
+            {
+                slot->identifier = identifier;
+                atomic_store_explicit(&slot->state, MAILBOX_SLOT_READY, memory_order_release);
+                return slot;
+            }
+        }
+        while (state == MAILBOX_SLOT_CLAIMED) // Another writer is setting its identifier
+        {
+            sched_yield();
+            state = atomic_load_explicit(&slot->state, memory_order_acquire);
+        }
+        if (slot->identifier == identifier)
+        {
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Posts a frame, replacing the previous frame with the same identifier.
+ *
+ * @param box Attached mailbox; nothing is done if it isn't attached.
+ * @param frame Frame to be posted.
+ * @return 0 on success, -1 if the mailbox isn't attached or already holds MAILBOX_SLOTS IDs.
+ * \anchor mailbox_post
+ */
+int mailbox_post(mailbox *box, const can_msg *frame)
+{
+    if (box->header == NULL)
+    {
+        return -1;
+    }
+    mailbox_slot *slot = find_slot(box->header, frame->identifier, 1);
+    if (slot == NULL)
+    {
+        return -1;
+    }
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    uint32_t sequence = atomic_load_explicit(&slot->sequence, memory_order_relaxed);
+    atomic_store_explicit(&slot->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    slot->timestamp_ns = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    memcpy(slot->data, frame->dataFrame, sizeof(slot->data));
+    atomic_store_explicit(&slot->sequence, sequence + 2, memory_order_release);
+    return 0;
+}
+
+/**
+ * @brief Reads the newest frame of a CAN ID if it changed since the last read.
+ *
+ * @param box Attached mailbox.
+ * @param identifier CAN ID to be read.
+ * @param frame Receives the newest frame when one was posted since `*version`.
+ * @param version Version of the frame the caller holds (0 = none); updated on a new frame.
+ * @return 1 if a newer frame was read, 0 if there is none (or the slot stayed busy), -1 if no
+ *         frame with this identifier was ever posted.
+ * \anchor mailbox_take
+ */
+int mailbox_take(mailbox *box, uint32_t identifier, can_msg *frame, uint32_t *version)
+{
+    mailbox_slot *slot = find_slot(box->header, identifier, 0);
+    if (slot == NULL)
+    {
+        return -1;
+    }
+
+    for (int retry = 0; retry < MAILBOX_READ_RETRIES; retry++)
+    {
+        uint32_t before = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        if (before & 1)
+        {
+            sched_yield(); // Being written
+            continue;
+        }
+        if (before == *version)
+        {
+            return before == 0 ? -1 : 0;
+        }
+        uint8_t data[8];
+        memcpy(data, slot->data, sizeof(data));
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&slot->sequence, memory_order_relaxed) == before)
+        {
+            frame->identifier = identifier;
+            memcpy(frame->dataFrame, data, sizeof(frame->dataFrame));
+            *version = before;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -1,85 +1,358 @@
+#define _GNU_SOURCE // pipe2
+#include <errno.h>
 #include <stdio.h>
 #include <mqueue.h>
 #include <pthread.h>
 #include <unistd.h>
 #include <signal.h>
 #include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <limits.h>
+#include <spawn.h>
+#include <time.h>
 #include <sys/wait.h>
 #include "mq_utils.h"
 #include "constants.h"
+#include "flight_recorder.h"
+#include "broadcast_ring.h"
+#include "mailbox.h"
+#include "readiness.h"
+#include "calibration.h"
+#include "metrics.h"
+
+extern char **environ;
 
 mqd_t sensors_mq, actuators_mq;
 pid_t sensors_pid, controller_pid, actuators_pid;
 
-void wait_terminate_execution()
+// One subscriber process per actuator, fed by the broadcast ring (started with -a)
+char *subscriber_actuators[] = {"belt", "door", "abs", "led", "buzzer"};
+#define SUBSCRIBERS (sizeof(subscriber_actuators) / sizeof(subscriber_actuators[0]))
+pid_t subscriber_pids[SUBSCRIBERS];
+int subscribers_started = 0;
+
+char bin_dir[PATH_MAX] = "./bin"; // Directory of main_bin, where the other binaries are
+char multicall_exe[PATH_MAX] = "";  // Multicall binary main_bin runs in, if any: it runs the other programs too
+int ready_pipe[2] = {-1, -1};    // Readiness handshake: read end here, write end in every child
+int processes_ready = 0;
+
+// Writes the last flight recorder entries to FLIGHT_RECORDER_DUMP_PATH
+void dump_flight_recorder(const char *reason)
 {
-    waitpid(sensors_pid, NULL, 0);
-    waitpid(controller_pid, NULL, 0);
-    waitpid(actuators_pid, NULL, 0);
+    FILE *dump = fopen(FLIGHT_RECORDER_DUMP_PATH, "w");
+    if (dump == NULL)
+    {
+        perror("Error opening the flight recorder dump");
+        return;
+    }
+    fprintf(dump, "Flight recorder dump: %s\n", reason);
+    long entries = flight_recorder_dump(FLIGHT_RECORDER_SHM, dump);
+    fclose(dump);
+    printf("Flight recorder: %ld entries written to %s (%s)\n", entries, FLIGHT_RECORDER_DUMP_PATH, reason);
+}
 
+// Tells whether a child crashed or exited with an error
+int child_failed(int status)
+{
+    return WIFSIGNALED(status) || (WIFEXITED(status) && WEXITSTATUS(status) != 0);
+}
+
+// Sets the pid of a reaped child to 0, so it is neither signalled nor waited for again.
+// Returns 1 if pid is one of the children started by main_bin.
+int forget_child(pid_t pid)
+{
+    pid_t *children[] = {&sensors_pid, &controller_pid, &actuators_pid};
+    for (size_t i = 0; i < sizeof(children) / sizeof(children[0]); i++)
+    {
+        if (*children[i] == pid)
+        {
+            *children[i] = 0;
+            return 1;
+        }
+    }
+    for (int i = 0; i < subscribers_started; i++)
+    {
+        if (subscriber_pids[i] == pid)
+        {
+            subscriber_pids[i] = 0;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Sends SIGTERM to the children that are still running
+void stop_children(void)
+{
+    pid_t children[] = {sensors_pid, controller_pid, actuators_pid};
+    for (size_t i = 0; i < sizeof(children) / sizeof(children[0]); i++)
+    {
+        if (children[i] > 0)
+        {
+            kill(children[i], SIGTERM);
+        }
+    }
+    for (int i = 0; i < subscribers_started; i++)
+    {
+        if (subscriber_pids[i] > 0)
+        {
+            kill(subscriber_pids[i], SIGTERM);
+        }
+    }
+}
+
+// Waits for the children that were stopped
+void reap_children(void)
+{
+    pid_t pid;
+    while ((pid = waitpid(-1, NULL, 0)) > 0 || (pid == -1 && errno == EINTR))
+    {
+        forget_child(pid);
+    }
+}
+
+// Removes the shared memory segments created by main_bin (a segment that wasn't created is skipped)
+void destroy_segments(void)
+{
+    flight_recorder_destroy(FLIGHT_RECORDER_SHM);
+    broadcast_destroy(BROADCAST_SHM);
+    mailbox_destroy(MAILBOX_SHM);
+    calibration_destroy(CALIBRATION_SHM);
+    metrics_destroy(METRICS_SHM);
+}
+
+void close_queues(void)
+{
     printf("Closing message queue\n");
     close_mq(sensors_mq, SENSORS_MQ);
     close_mq(actuators_mq, ACTUATORS_MQ);
+}
 
+// Startup failed: stops the children already started and releases everything main_bin created
+void abort_startup(void)
+{
+    stop_children();
+    reap_children();
+    destroy_segments();
+    close_queues();
+    exit(EXIT_FAILURE);
+}
+
+// Waits for the children in the order they exit. When the first one crashes or fails, the flight
+// recorder is dumped at once, before the other processes overwrite the entries that led to it,
+// and the other processes are stopped.
+void wait_terminate_execution()
+{
+    int running = 3 + subscribers_started;
+    int failed = 0;
+    while (running > 0)
+    {
+        int status;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            break; // No child left
+        }
+        if (!forget_child(pid))
+        {
+            continue;
+        }
+        running--;
+        if (!failed && child_failed(status))
+        {
+            failed = 1;
+            dump_flight_recorder("a process crashed or failed");
+            stop_children();
+        }
+    }
+
+    destroy_segments();
+    close_queues();
 }
 
 void terminate_execution(int sig)
 {
-    printf("Closing message queue\n");
-    close_mq(sensors_mq, SENSORS_MQ);
-    close_mq(sensors_mq, ACTUATORS_MQ);
+    close_queues();
 
     printf("Closing child processes\n");
-    kill(sensors_pid, SIGTERM);
-    kill(controller_pid, SIGTERM);
-    kill(actuators_pid, SIGTERM);
+    stop_children();
+    reap_children();
 
-    waitpid(sensors_pid, NULL, 0);
-    waitpid(controller_pid, NULL, 0);
-    waitpid(actuators_pid, NULL, 0);
+    dump_flight_recorder("interrupted");
+    destroy_segments();
 
     printf("Execution terminated\n");
 
     exit(0);
 }
 
-pid_t create_processes(char *process_name)
+// Finds the directory of main_bin, so the other binaries are found whatever the working directory.
+// In the multicall binary (aeb.c, built with AEB_MULTICALL), the other programs are run from it;
+// this is decided at build time, so a copy of main_bin under another name never starts itself.
+void find_bin_dir(void)
+{
+    char exe[PATH_MAX];
+    ssize_t length = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+    if (length > 0)
+    {
+        exe[length] = '\0';
+#ifdef AEB_MULTICALL
+        strcpy(multicall_exe, exe);
+#endif
+        snprintf(bin_dir, sizeof(bin_dir), "%s", dirname(exe));
+    }
+}
+
+// Starts the binary bin_dir/name with the given arguments (argv[0] = name, NULL terminated), or the
+// multicall binary, which runs the program named by argv[0]. posix_spawn doesn't copy the address
+// space of main_bin, and the child gets the write end of the readiness pipe as READINESS_FD.
+pid_t create_processes(char *argv[])
 {
-    pid_t child_pid = fork();
+    char path[PATH_MAX];
+    posix_spawn_file_actions_t actions;
+    pid_t child_pid;
 
-    if (child_pid < 0)
+    if (multicall_exe[0] != '\0')
     {
-        perror("Error creating auxiliary process \n");
-        exit(1);
+        strcpy(path, multicall_exe);
     }
-    else if (child_pid == 0)
+    else if (snprintf(path, sizeof(path), "%s/%s", bin_dir, argv[0]) >= (int)sizeof(path))
     {
-        if (execl(process_name, process_name, NULL) == -1)
-        {
-            perror("Error executing the process");
-            exit(1);
-        }
+        fprintf(stderr, "Error executing %s: path too long\n", argv[0]);
+        abort_startup();
+    }
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, ready_pipe[1], READINESS_FD);
+
+    int error = posix_spawn(&child_pid, path, &actions, NULL, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    if (error != 0)
+    {
+        fprintf(stderr, "Error executing %s: %s\n", path, strerror(error));
+        abort_startup();
     }
 
     return child_pid;
 }
 
-int main()
+// Waits for the processes started since the last call to be ready, and tells how long it took
+double wait_ready(int expected, const char *stage, struct timespec *since)
+{
+    int ready = readiness_wait(ready_pipe[0], expected, READINESS_TIMEOUT_MS);
+    processes_ready += ready;
+    if (ready < expected)
+    {
+        fprintf(stderr, "Startup: %d of %d %s not ready after %d ms, going on\n", expected - ready, expected, stage,
+                READINESS_TIMEOUT_MS);
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - since->tv_sec) * 1e3 + (now.tv_nsec - since->tv_nsec) / 1e6;
+}
+
+int main(int argc, char *argv[])
 {
+    int start_subscribers = 0;
+    char *transport = NULL; // Option of the controller and actuators transport (NULL = message queue)
+    int mask_commands = 0;  // Controller commands the actuators with ID_ACTUATORS_CMD masks
+    const char *calibration_path = CALIBRATION_PATH;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "amkc:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'a': // Also run one subscriber process per actuator
+            start_subscribers = 1;
+            break;
+        case 'm': // Actuator commands through the latest-value mailbox
+            transport = "-m";
+            break;
+        case 'k': // Actuator commands as one-byte state masks
+            mask_commands = 1;
+            break;
+        case 'c': // Calibration file
+            calibration_path = optarg;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-a] [-m] [-k] [-c calibration]\n", argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
     printf("Main process PID: %d\n", getpid());
 
     // Initialize resources
     sensors_mq = create_mq(SENSORS_MQ);
-    sensors_mq = create_mq(ACTUATORS_MQ);
+    actuators_mq = create_mq(ACTUATORS_MQ);
+
+    // Created before the children so that all of them attach to it
+    if (flight_recorder_create(FLIGHT_RECORDER_SHM, FLIGHT_RECORDER_ENTRIES) != 0)
+    {
+        fprintf(stderr, "Flight recorder disabled\n");
+    }
+    if (broadcast_create(BROADCAST_SHM, BROADCAST_CAPACITY) != 0)
+    {
+        fprintf(stderr, "Actuator subscribers disabled\n");
+    }
+    if (transport != NULL && mailbox_create(MAILBOX_SHM) != 0)
+    {
+        abort_startup();
+    }
+    aeb_calibration calibration_values = CALIBRATION_DEFAULTS;
+    if (calibration_load(calibration_path, &calibration_values) != 0)
+    {
+        fprintf(stderr, "Calibration: %s not used, using the default values\n", calibration_path);
+    }
+    if (calibration_create(CALIBRATION_SHM, &calibration_values) != 0)
+    {
+        fprintf(stderr, "Calibration block disabled, the controller uses the default values\n");
+    }
+    if (metrics_create(METRICS_SHM) != 0)
+    {
+        fprintf(stderr, "Metrics disabled\n");
+    }
+
+    // Create auxiliary processes. The consumers are started first, and the sensors only once
+    // they are ready, so no frame or command is sent before its readers are there.
+    find_bin_dir();
+    if (pipe2(ready_pipe, O_CLOEXEC) != 0 || ready_pipe[1] == READINESS_FD)
+    {
+        perror("Error creating the readiness pipe");
+        abort_startup();
+    }
+    char ready_fd[8];
+    snprintf(ready_fd, sizeof(ready_fd), "%d", READINESS_FD);
+    setenv(READINESS_ENV, ready_fd, 1);
 
-    // Create auxiliary processes
-    char *sensors_process = "./bin/sensors_bin";
-    char *controller_process = "./bin/aeb_controller_bin";
-    char *actuators_process = "./bin/actuators_bin";
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; start_subscribers && i < (int)SUBSCRIBERS; i++)
+    {
+        subscriber_pids[i] = create_processes((char *[]){"actuator_sub_bin", "-a", subscriber_actuators[i], NULL});
+        subscribers_started++;
+    }
+    actuators_pid = create_processes((char *[]){"actuators_bin", transport, NULL});
+    char *controller_argv[4] = {"aeb_controller_bin"};
+    int controller_argc = 1;
+    if (transport != NULL)
+        controller_argv[controller_argc++] = transport;
+    if (mask_commands)
+        controller_argv[controller_argc++] = "-k";
+    controller_argv[controller_argc] = NULL;
+    controller_pid = create_processes(controller_argv);
+    double consumers_ms = wait_ready(subscribers_started + 2, "consumers", &start);
 
-    sensors_pid = create_processes(sensors_process);
-    controller_pid = create_processes(controller_process);
-    actuators_pid = create_processes(actuators_process);
+    sensors_pid = create_processes((char *[]){"sensors_bin", NULL});
+    double startup_ms = wait_ready(1, "sensors", &start);
+    close(ready_pipe[0]);
+    close(ready_pipe[1]);
+    printf("Startup: %d of %d processes ready in %.2f ms (consumers in %.2f ms)\n", processes_ready,
+           subscribers_started + 3, startup_ms, consumers_ms);
 
     signal(SIGINT, terminate_execution);
 
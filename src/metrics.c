@@ -0,0 +1,257 @@
+/**
+ * @file metrics.c
+ * @brief Registration of the metrics blocks and sampling of the shared memory metrics segment.
+ *
+ * A thread claims a block with a compare-and-swap of its state, as a mailbox writer claims a
+ * slot: a free block, or a block still marked ready whose process no longer exists. The names
+ * of the block and of its metrics are written while the block is claimed, then the block is
+ * made ready with release ordering. A reader copies a ready block between two loads of its
+ * generation and keeps the copy only if the block was neither released nor claimed again in
+ * between; each value is a single aligned 64-bit load, so it is never torn.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "metrics.h"
+#include "constants.h"
+
+_Static_assert(sizeof(metrics_block) % METRICS_CACHE_LINE == 0, "Metrics blocks must fill whole cache lines");
+
+/**
+ * @brief Maps the metrics segment and checks its header.
+ *
+ * @return Mapping, or NULL if there is no valid segment.
+ */
+static metrics_header *map_segment(const char *name, int flags, int prot)
+{
+    int fd = shm_open(name, flags, SHM_PERMISSIONS);
+    if (fd == -1)
+    {
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(metrics_header))
+    {
+        close(fd);
+        return NULL;
+    }
+    metrics_header *header = mmap(NULL, sizeof(metrics_header), prot, MAP_SHARED, fd, 0);
+    close(fd);
+    if (header == MAP_FAILED)
+    {
+        return NULL;
+    }
+    if (memcmp(header->magic, METRICS_MAGIC, sizeof(METRICS_MAGIC)) != 0 || header->blocks != METRICS_BLOCKS ||
+        header->block_size != sizeof(metrics_block))
+    {
+        munmap(header, sizeof(metrics_header));
+        return NULL;
+    }
+    return header;
+}
+
+/**
+ * @brief Creates (or resets) the metrics segment.
+ *
+ * @param name POSIX shared memory name, e.g. METRICS_SHM.
+ * @return 0 on success, -1 on shared memory error.
+ * \anchor metrics_create
+ */
+int metrics_create(const char *name)
+{
+    int fd = shm_open(name, O_CREAT | O_RDWR, SHM_PERMISSIONS);
+    if (fd == -1)
+    {
+        perror("Error creating metrics segment");
+        return -1;
+    }
+    if (ftruncate(fd, 0) != 0 || ftruncate(fd, sizeof(metrics_header)) != 0)
+    {
+        perror("Error sizing metrics segment");
+        close(fd);
+        return -1;
+    }
+    metrics_header *header = mmap(NULL, sizeof(metrics_header), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (header == MAP_FAILED)
+    {
+        perror("Error mapping metrics segment");
+        return -1;
+    }
+
+    // The segment is zero filled: every block is free
+    header->blocks = METRICS_BLOCKS;
+    header->block_size = sizeof(metrics_block);
+    atomic_thread_fence(memory_order_release);
+    memcpy(header->magic, METRICS_MAGIC, sizeof(METRICS_MAGIC));
+
+    munmap(header, sizeof(metrics_header));
+    return 0;
+}
+
+/**
+ * @brief Tells whether the process that holds a ready block still exists.
+ */
+static int owner_alive(int32_t pid)
+{
+    return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM);
+}
+
+/**
+ * @brief Claims a block of the metrics segment for the calling thread.
+ *
+ * The values of the block start at 0. The calling thread must be the only one to update the
+ * block, until it calls metrics_release.
+ *
+ * @param m Receives the block; left unregistered (updates ignored) on failure.
+ * @param segment POSIX shared memory name used by metrics_create.
+ * @param block_name Name shown by aeb_stat, e.g. "controller".
+ * @param desc Names and kinds of the metrics, in the order of their indexes.
+ * @param count Number of metrics, at most METRICS_PER_BLOCK.
+ * @return 0 on success, -1 if there is no segment or no free block.
+ * \anchor metrics_register
+ */
+int metrics_register(metrics *m, const char *segment, const char *block_name, const metric_desc *desc,
+                     uint32_t count)
+{
+    m->header = NULL;
+    m->block = NULL;
+    if (count > METRICS_PER_BLOCK)
+    {
+        return -1;
+    }
+    metrics_header *header = map_segment(segment, O_RDWR, PROT_READ | PROT_WRITE);
+    if (header == NULL)
+    {
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < METRICS_BLOCKS; i++)
+    {
+        metrics_block *block = &header->block[i];
+        uint32_t state = atomic_load_explicit(&block->state, memory_order_acquire);
+        if (state == METRICS_BLOCK_CLAIMED || (state == METRICS_BLOCK_READY && owner_alive(block->pid)))
+        {
+            continue;
+        }
+        if (!atomic_compare_exchange_strong(&block->state, &state, METRICS_BLOCK_CLAIMED))
+        {
+            continue; // Claimed by another thread in the meantime
+        }
+
+        atomic_fetch_add_explicit(&block->generation, 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        block->pid = getpid();
+        block->count = count;
+        snprintf(block->name, sizeof(block->name), "%s", block_name);
+        for (uint32_t j = 0; j < METRICS_PER_BLOCK; j++)
+        {
+            block->kind[j] = j < count ? desc[j].kind : METRIC_COUNTER;
+            snprintf(block->metric_name[j], sizeof(block->metric_name[j]), "%s", j < count ? desc[j].name : "");
+            atomic_store_explicit(&block->value[j], 0, memory_order_relaxed);
+        }
+        atomic_store_explicit(&block->state, METRICS_BLOCK_READY, memory_order_release);
+
+        m->header = header;
+        m->block = block;
+        return 0;
+    }
+    munmap(header, sizeof(metrics_header));
+    return -1;
+}
+
+/**
+ * @brief Releases the block of the calling thread and unmaps the segment.
+ *
+ * \anchor metrics_release
+ */
+void metrics_release(metrics *m)
+{
+    if (m->header == NULL)
+    {
+        return;
+    }
+    atomic_store_explicit(&m->block->state, METRICS_BLOCK_FREE, memory_order_release);
+    munmap(m->header, sizeof(metrics_header));
+    m->header = NULL;
+    m->block = NULL;
+}
+
+/**
+ * @brief Removes the metrics segment name (mappings stay valid until released or closed).
+ *
+ * \anchor metrics_destroy
+ */
+void metrics_destroy(const char *name)
+{
+    shm_unlink(name);
+}
+
+/**
+ * @brief Maps the metrics segment read-only, for sampling.
+ *
+ * @param name POSIX shared memory name used by metrics_create.
+ * @return Mapping, or NULL if there is no valid segment.
+ * \anchor metrics_open
+ */
+const metrics_header *metrics_open(const char *name)
+{
+    return map_segment(name, O_RDONLY, PROT_READ);
+}
+
+/**
+ * @brief Unmaps a segment mapped by metrics_open.
+ *
+ * \anchor metrics_close
+ */
+void metrics_close(const metrics_header *header)
+{
+    if (header != NULL)
+    {
+        munmap((void *)header, sizeof(metrics_header));
+    }
+}
+
+/**
+ * @brief Copies one block of the segment.
+ *
+ * Never waits for the writer: the values are read as they are at that moment.
+ *
+ * @param header Segment mapped by metrics_open.
+ * @param index Block, from 0 to METRICS_BLOCKS - 1.
+ * @param sample Receives the copy.
+ * @return 1 if the block is registered and was copied, 0 if it is free or being claimed.
+ * \anchor metrics_read
+ */
+int metrics_read(const metrics_header *header, uint32_t index, metrics_sample *sample)
+{
+    metrics_block *block = (metrics_block *)&header->block[index];
+    if (atomic_load_explicit(&block->state, memory_order_acquire) != METRICS_BLOCK_READY)
+    {
+        return 0;
+    }
+    uint32_t generation = atomic_load_explicit(&block->generation, memory_order_acquire);
+
+    sample->generation = generation;
+    sample->pid = block->pid;
+    sample->count = block->count < METRICS_PER_BLOCK ? block->count : METRICS_PER_BLOCK;
+    memcpy(sample->name, block->name, sizeof(sample->name));
+    memcpy(sample->kind, block->kind, sizeof(sample->kind));
+    memcpy(sample->metric_name, block->metric_name, sizeof(sample->metric_name));
+    sample->name[METRICS_NAME_MAX - 1] = '\0';
+    for (uint32_t j = 0; j < METRICS_PER_BLOCK; j++)
+    {
+        sample->metric_name[j][METRICS_NAME_MAX - 1] = '\0';
+        sample->value[j] = atomic_load_explicit(&block->value[j], memory_order_relaxed);
+    }
+
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&block->state, memory_order_relaxed) == METRICS_BLOCK_READY &&
+           atomic_load_explicit(&block->generation, memory_order_relaxed) == generation;
+}
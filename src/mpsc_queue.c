@@ -0,0 +1,149 @@
+/**
+ * @file mpsc_queue.c
+ * @brief Lock-free multi-producer/single-consumer queue used to hand records to a worker thread.
+ *
+ * Slot i of lap k is free for producers when its sequence equals i + k * capacity and
+ * holds an element when its sequence equals i + k * capacity + 1. A producer claims the
+ * slot by advancing the tail with a compare-and-swap, copies the element and publishes it
+ * with a release store of the sequence. The consumer reads the sequence with acquire
+ * ordering before copying, then hands the slot to the next lap.
+ */
+
+#include "mpsc_queue.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+/**
+ * @brief Initializes a queue and allocates its ring buffer.
+ *
+ * @param queue Queue to be initialized.
+ * @param capacity Number of elements the queue can hold (must be a power of two).
+ * @param elem_size Size in bytes of each element.
+ * @return 0 on success, -1 on invalid arguments or allocation failure.
+ * \anchor mpsc_init
+ */
+int mpsc_init(mpsc_queue *queue, size_t capacity, size_t elem_size)
+{
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0 || elem_size == 0)
+    {
+        return -1;
+    }
+
+    queue->buffer = malloc(capacity * elem_size);
+    queue->sequence = malloc(capacity * sizeof(atomic_size_t));
+    if (queue->buffer == NULL || queue->sequence == NULL)
+    {
+        free(queue->buffer);
+        free(queue->sequence);
+        queue->buffer = NULL;
+        queue->sequence = NULL;
+        return -1;
+    }
+
+    for (size_t i = 0; i < capacity; i++)
+    {
+        atomic_init(&queue->sequence[i], i);
+    }
+    queue->capacity = capacity;
+    queue->elem_size = elem_size;
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+    return 0;
+}
+
+/**
+ * @brief Releases the ring buffer of a queue.
+ *
+ * @param queue Queue to be destroyed.
+ * \anchor mpsc_destroy
+ */
+void mpsc_destroy(mpsc_queue *queue)
+{
+    free(queue->buffer);
+    free(queue->sequence);
+    queue->buffer = NULL;
+    queue->sequence = NULL;
+    queue->capacity = 0;
+}
+
+/**
+ * @brief Copies an element into the queue (any number of producer threads).
+ *
+ * @param queue Queue where the element will be stored.
+ * @param elem Pointer to the element to be copied.
+ * @return 0 on success, -1 if the queue is full.
+ * \anchor mpsc_push
+ */
+int mpsc_push(mpsc_queue *queue, const void *elem)
+{
+    size_t mask = queue->capacity - 1;
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+
+    for (;;)
+    {
+        atomic_size_t *sequence = &queue->sequence[tail & mask];
+        intptr_t diff = (intptr_t)atomic_load_explicit(sequence, memory_order_acquire) - (intptr_t)tail;
+
+        if (diff == 0)
+        {
+            // Slot is free for this lap, try to claim it (tail is reloaded on failure)
+            if (atomic_compare_exchange_weak_explicit(&queue->tail, &tail, tail + 1,
+                                                      memory_order_relaxed, memory_order_relaxed))
+            {
+                memcpy(queue->buffer + (tail & mask) * queue->elem_size, elem, queue->elem_size);
+                atomic_store_explicit(sequence, tail + 1, memory_order_release);
+                return 0;
+            }
+        }
+        else if (diff < 0)
+        {
+            // Slot still holds the element of the previous lap
+            return -1;
+        }
+        else
+        {
+            // Another producer claimed this slot first
+            tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * @brief Copies the oldest element out of the queue (consumer side only).
+ *
+ * @param queue Queue from which the element will be removed.
+ * @param elem Pointer to where the element will be copied.
+ * @return 0 on success, -1 if the queue is empty or the oldest element isn't published yet.
+ * \anchor mpsc_pop
+ */
+int mpsc_pop(mpsc_queue *queue, void *elem)
+{
+    size_t mask = queue->capacity - 1;
+    size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    atomic_size_t *sequence = &queue->sequence[head & mask];
+
+    if (atomic_load_explicit(sequence, memory_order_acquire) != head + 1)
+    {
+        return -1;
+    }
+
+    memcpy(elem, queue->buffer + (head & mask) * queue->elem_size, queue->elem_size);
+    atomic_store_explicit(sequence, head + queue->capacity, memory_order_release);
+    atomic_store_explicit(&queue->head, head + 1, memory_order_relaxed);
+    return 0;
+}
+
+/**
+ * @brief Gets the number of elements reserved in the queue.
+ *
+ * @param queue Queue to be inspected.
+ * @return Number of slots claimed by producers and not yet consumed.
+ * \anchor mpsc_size
+ */
+size_t mpsc_size(mpsc_queue *queue)
+{
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+    size_t head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    return tail - head;
+}
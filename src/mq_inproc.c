@@ -0,0 +1,169 @@
+/**
+ * @file mq_inproc.c
+ * @brief In-process replacement of the message queue utilities, for aeb_all_bin.
+ *
+ * Implements the functions of mq_utils.h over lock-free SPSC queues, so the sensors,
+ * controller and actuators modules run unchanged as threads of one process. A queue is
+ * identified by its name: create_mq and open_mq return the same descriptor for the same name,
+ * whichever module asks first. Each queue has one producer thread and one consumer thread
+ * (sensors -> controller, controller -> actuators), as with the POSIX queues.
+ *
+ * The queues hold MQ_INPROC_CAPACITY frames; like the non-blocking POSIX queues, a write to
+ * a full queue fails and a read from an empty queue returns -1 at once.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "mq_utils.h"
+#include "constants.h"
+#include "spsc_queue.h"
+
+#define MQ_INPROC_QUEUES 4
+#define MQ_INPROC_CAPACITY 16 // MQ_MAX_MESSAGES rounded up to a power of two
+
+typedef struct
+{
+    const char *name;
+    spsc_queue queue;
+} mq_inproc;
+
+static mq_inproc queues[MQ_INPROC_QUEUES];
+static pthread_mutex_t queues_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Gets the attributes of the in-process queues, in the mq_attr format.
+ *
+ * \anchor get_mq_attr_inproc
+ */
+struct mq_attr get_mq_attr()
+{
+    struct mq_attr attr;
+    attr.mq_flags = O_NONBLOCK;
+    attr.mq_curmsgs = 0;
+    attr.mq_maxmsg = MQ_INPROC_CAPACITY;
+    attr.mq_msgsize = MQ_MAX_MSG_SIZE;
+    return attr;
+}
+
+/**
+ * @brief Returns the descriptor of the queue with this name, creating the queue if needed.
+ */
+static mqd_t find_queue(const char *mq_name)
+{
+    mqd_t mqd = (mqd_t)-1;
+    pthread_mutex_lock(&queues_lock);
+    for (int i = 0; i < MQ_INPROC_QUEUES && mqd == (mqd_t)-1; i++)
+    {
+        if (queues[i].name != NULL && strcmp(queues[i].name, mq_name) == 0)
+        {
+            mqd = i;
+        }
+        else if (queues[i].name == NULL)
+        {
+            if (spsc_init(&queues[i].queue, MQ_INPROC_CAPACITY, sizeof(can_msg)) != 0)
+            {
+                break;
+            }
+            queues[i].name = mq_name;
+            mqd = i;
+        }
+    }
+    pthread_mutex_unlock(&queues_lock);
+    return mqd;
+}
+
+/**
+ * @brief Creates an in-process queue (or returns the one already created with this name).
+ *
+ * \anchor create_mq_inproc
+ */
+mqd_t create_mq(char *mq_name)
+{
+    mqd_t mqd = find_queue(mq_name);
+    if (mqd == (mqd_t)-1)
+    {
+        fprintf(stderr, "Error creating queue %s\n", mq_name);
+        return (mqd_t)-1;
+    }
+    printf("Queue %s created\n", mq_name);
+    return mqd;
+}
+
+/**
+ * @brief Opens an in-process queue (it is created if no module created it yet).
+ *
+ * \anchor open_mq_inproc
+ */
+mqd_t open_mq(char *mq_name)
+{
+    mqd_t mqd = find_queue(mq_name);
+    if (mqd == (mqd_t)-1)
+    {
+        fprintf(stderr, "Error opening queue %s\n", mq_name);
+    }
+    return mqd;
+}
+
+/**
+ * @brief Releases an in-process queue.
+ *
+ * \anchor close_mq_inproc
+ */
+void close_mq(mqd_t mqd, char *mq_name)
+{
+    printf("Closing %s queue\n", mq_name);
+    pthread_mutex_lock(&queues_lock);
+    if (mqd >= 0 && mqd < MQ_INPROC_QUEUES && queues[mqd].name != NULL)
+    {
+        spsc_destroy(&queues[mqd].queue);
+        queues[mqd].name = NULL;
+    }
+    pthread_mutex_unlock(&queues_lock);
+}
+
+/**
+ * @brief Reads a frame from an in-process queue.
+ *
+ * @return 0 on success, -1 if the queue is empty.
+ * \anchor read_mq_inproc
+ */
+int read_mq(mqd_t mq_receiver, can_msg *msg_read)
+{
+    if (mq_receiver < 0 || mq_receiver >= MQ_INPROC_QUEUES)
+    {
+        return -1;
+    }
+    return spsc_pop(&queues[mq_receiver].queue, msg_read);
+}
+
+/**
+ * @brief Writes a frame to an in-process queue.
+ *
+ * @return 0 on success, -1 if the queue is full.
+ * \anchor write_mq_inproc
+ */
+int write_mq(mqd_t mq_sender, can_msg *msg)
+{
+    if (mq_sender < 0 || mq_sender >= MQ_INPROC_QUEUES || spsc_push(&queues[mq_sender].queue, msg) != 0)
+    {
+        fprintf(stderr, "Error sending message. Queue is full\n");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Gets the number of frames waiting in an in-process queue.
+ *
+ * @return Number of frames in the queue, or -1 if there is no such queue.
+ * \anchor depth_mq_inproc
+ */
+long depth_mq(mqd_t mqd)
+{
+    if (mqd < 0 || mqd >= MQ_INPROC_QUEUES)
+    {
+        return -1;
+    }
+    return (long)spsc_size(&queues[mqd].queue);
+}
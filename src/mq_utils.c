@@ -132,4 +132,21 @@ int write_mq(mqd_t mq_sender, can_msg *msg)
         return -1;
     }
     return 0;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Gets the number of messages waiting in a POSIX message queue.
+ *
+ * @param mqd Identifier of the message queue.
+ * @return Number of messages in the queue, or -1 on failure.
+ * \anchor depth_mq
+ */
+long depth_mq(mqd_t mqd)
+{
+    struct mq_attr attr;
+    if (mq_getattr(mqd, &attr) == -1)
+    {
+        return -1;
+    }
+    return attr.mq_curmsgs;
+}
@@ -0,0 +1,134 @@
+/**
+ * @file quantile_sketch.c
+ * @brief Logarithmic-bucket quantile sketch (see quantile_sketch.h).
+ */
+
+#include <math.h>
+#include <string.h>
+#include "quantile_sketch.h"
+
+static double gamma_value(void)
+{
+    return (1.0 + QSKETCH_RELATIVE_ACCURACY) / (1.0 - QSKETCH_RELATIVE_ACCURACY);
+}
+
+/**
+ * @brief Empties a sketch.
+ *
+ * @param sketch Sketch to be initialized.
+ * \anchor qsketch_init
+ */
+void qsketch_init(qsketch *sketch)
+{
+    memset(sketch, 0, sizeof(*sketch));
+}
+
+/**
+ * @brief Adds a value to a sketch.
+ *
+ * Values above the range of the buckets are counted in the last bucket; min and max are
+ * kept exactly.
+ *
+ * @param sketch Sketch that receives the value.
+ * @param value Value to be added (negative values are counted as 0).
+ * \anchor qsketch_add
+ */
+void qsketch_add(qsketch *sketch, double value)
+{
+    if (sketch->count == 0 || value < sketch->min)
+    {
+        sketch->min = value;
+    }
+    if (sketch->count == 0 || value > sketch->max)
+    {
+        sketch->max = value;
+    }
+    sketch->count++;
+    sketch->sum += value;
+
+    if (value < QSKETCH_MIN_VALUE)
+    {
+        sketch->zero_count++;
+        return;
+    }
+    int bucket = (int)ceil(log(value / QSKETCH_MIN_VALUE) / log(gamma_value()));
+    if (bucket >= QSKETCH_BUCKETS)
+    {
+        bucket = QSKETCH_BUCKETS - 1;
+    }
+    sketch->buckets[bucket]++;
+}
+
+/**
+ * @brief Adds the values of a sketch to another one.
+ *
+ * @param into Sketch that receives the values.
+ * @param from Sketch to be merged.
+ * \anchor qsketch_merge
+ */
+void qsketch_merge(qsketch *into, const qsketch *from)
+{
+    if (from->count == 0)
+    {
+        return;
+    }
+    if (into->count == 0 || from->min < into->min)
+    {
+        into->min = from->min;
+    }
+    if (into->count == 0 || from->max > into->max)
+    {
+        into->max = from->max;
+    }
+    into->count += from->count;
+    into->zero_count += from->zero_count;
+    into->sum += from->sum;
+    for (int i = 0; i < QSKETCH_BUCKETS; i++)
+    {
+        into->buckets[i] += from->buckets[i];
+    }
+}
+
+/**
+ * @brief Estimates a quantile of the values of a sketch.
+ *
+ * @param sketch Sketch to be queried.
+ * @param q Quantile, from 0 (minimum) to 1 (maximum).
+ * @return Estimated value, within the relative accuracy of the sketch, or NAN if it is empty.
+ * \anchor qsketch_quantile
+ */
+double qsketch_quantile(const qsketch *sketch, double q)
+{
+    if (sketch->count == 0)
+    {
+        return NAN;
+    }
+    if (q <= 0.0)
+    {
+        return sketch->min;
+    }
+    if (q >= 1.0)
+    {
+        return sketch->max;
+    }
+
+    uint64_t rank = (uint64_t)(q * (sketch->count - 1));
+    uint64_t seen = sketch->zero_count;
+    if (rank < seen)
+    {
+        return sketch->min < 0.0 ? sketch->min : 0.0;
+    }
+
+    double gamma = gamma_value();
+    for (int i = 0; i < QSKETCH_BUCKETS; i++)
+    {
+        seen += sketch->buckets[i];
+        if (rank < seen)
+        {
+            // Value of the bucket with the lowest relative error to both of its bounds
+            double value = 2.0 * QSKETCH_MIN_VALUE * pow(gamma, i) / (gamma + 1.0);
+            return value < sketch->min ? sketch->min : value > sketch->max ? sketch->max : value;
+        }
+    }
+    return sketch->max;
+}
@@ -0,0 +1,112 @@
+/**
+ * @file readiness.c
+ * @brief Readiness handshake between main_bin and the processes it starts.
+ *
+ * All the children share one pipe. Each one writes a single byte, which a pipe delivers
+ * atomically, so main_bin only has to count the bytes it reads.
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "readiness.h"
+
+static void (*notify_hook)(void); // Launcher running the modules as threads (aeb_all_bin)
+
+/**
+ * @brief Tells the launcher that this process is ready to exchange frames.
+ *
+ * Calls the hook of an in-process launcher if there is one. Otherwise does nothing if the
+ * process wasn't started by main_bin, or if it was already notified.
+ *
+ * \anchor readiness_notify
+ */
+void readiness_notify(void)
+{
+    if (notify_hook != NULL)
+    {
+        notify_hook();
+        return;
+    }
+    const char *fd_env = getenv(READINESS_ENV);
+    if (fd_env == NULL)
+    {
+        return;
+    }
+    int fd = atoi(fd_env);
+    char ready = 1;
+    while (write(fd, &ready, 1) == -1 && errno == EINTR)
+    {
+    }
+    close(fd);
+    unsetenv(READINESS_ENV); // Once per process, and not inherited by its own children
+}
+
+/**
+ * @brief Sets the function readiness_notify calls instead of writing to the pipe.
+ *
+ * For a launcher that runs the modules as threads of its own process: the pipe is notified once
+ * per process, the hook once per module. Set it before the module threads are created.
+ *
+ * @param hook Called by each module once it is ready, or NULL to use the pipe again.
+ *
+ * \anchor readiness_set_hook
+ */
+void readiness_set_hook(void (*hook)(void))
+{
+    notify_hook = hook;
+}
+
+static long now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000L + ts.tv_nsec / 1000000L;
+}
+
+/**
+ * @brief Waits until a number of processes are ready.
+ *
+ * @param fd Read end of the readiness pipe.
+ * @param expected Number of processes to wait for.
+ * @param timeout_ms Longest time to wait, in milliseconds.
+ * @return Number of processes that notified before the timeout (expected if all of them did).
+ *
+ * \anchor readiness_wait
+ */
+int readiness_wait(int fd, int expected, int timeout_ms)
+{
+    long deadline_ms = now_ms() + timeout_ms;
+    int ready = 0;
+
+    while (ready < expected)
+    {
+        long left_ms = deadline_ms - now_ms();
+        struct pollfd pfd = {.fd = fd, .events = POLLIN};
+        int polled = left_ms > 0 ? poll(&pfd, 1, (int)left_ms) : 0;
+        if (polled == 0)
+        {
+            break; // Timed out
+        }
+        if (polled == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        char bytes[16];
+        size_t wanted = (size_t)(expected - ready) < sizeof(bytes) ? (size_t)(expected - ready) : sizeof(bytes);
+        ssize_t count = read(fd, bytes, wanted);
+        if (count > 0)
+        {
+            ready += count;
+        }
+        else if (count == 0 || errno != EINTR)
+        {
+            break; // Every write end was closed
+        }
+    }
+    return ready;
+}
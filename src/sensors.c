@@ -2,10 +2,15 @@
  * @file sensors.c
  * @brief Sensor module responsible for reading scenario data and converting it into CAN messages.
  * 
- * This module reads sensor data from a predefined scenario text file and encodes the information
- * into CAN frames. The resulting frames are sent via a POSIX message queue to other modules. 
+ * This module reads sensor data from a predefined scenario text file (or streams it from a named
+ * pipe or stdin) and encodes the information into CAN frames. The resulting frames are sent via
+ * a POSIX message queue to other modules. 
  * The data includes vehicle velocity, direction, AEB system  status, obstacle presence, and 
  * pedal activation.
+ *
+ * Reading and sending run as a two-stage pipeline: a reader thread prefetches parsed rows into
+ * double-buffered blocks, and the sender thread consumes them through lock-free queues, so
+ * disk stalls don't delay the emission of the frames.
  */
 
 #include <stdio.h>
@@ -18,85 +23,657 @@
 #include <stdbool.h>
 #include "dbc.h"
 #include "file_reader.h"
+#include "spsc_queue.h"
+#include "sensors.h"
+#include "flight_recorder.h"
+#include "readiness.h"
+#include "metrics.h"
+#include "aeb_probes.h"
+#include <stdint.h>
+#include <string.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+
+#define SENSORS_BLOCK_ROWS 32     // Rows parsed per block by the reader thread
+#define SENSORS_BLOCK_COUNT 2     // Double buffering: one block being sent, one being prefetched
+#define PIPELINE_POLL_US 1000     // Back-off while waiting for the other pipeline stage
+
+// Metrics of the sender thread, sampled by aeb_stat
+enum
+{
+    SENSORS_METRIC_FRAMES_OUT,
+    SENSORS_METRIC_SEND_ERRORS, // Frames dropped because the sensors queue was full
+    SENSORS_METRIC_MISSED_TICKS,
+    SENSORS_METRICS
+};
+
+/**
+ * @brief Block of parsed scenario rows exchanged between the reader and the sender threads.
+ */
+typedef struct
+{
+    sensors_input_data rows[SENSORS_BLOCK_ROWS];
+    size_t count; // Number of valid rows in the block
+    bool eof;     // The reader reached the end of the input while filling this block
+} sensors_block;
 
+/**
+ * @brief Result of fetching the next prefetched row.
+ */
+typedef enum
+{
+    SENSORS_ROW_READY,   // A row was copied
+    SENSORS_ROW_PENDING, // The reader has not produced the next row yet
+    SENSORS_ROW_EOF      // The end of the input was reached
+} sensors_row_status;
+
+void *readSensorsData(void *arg);
 void *getSensorsData(void *arg);
+sensors_row_status nextSensorsRow(sensors_input_data *row, bool wait);
 can_msg conv2CANCarClusterData(bool aeb_system_enabled);
 can_msg conv2CANVelocityData(bool vehicle_direction, double relative_velocity, double relative_acceleration);
 can_msg conv2CANObstacleData(bool has_obstacle, double obstacle_distance);
 can_msg conv2CANPedalsData(bool brake_pedal, bool accelerator_pedal);
+static size_t encodeDueSensorsFrames(const sensors_input_data *current, const sensors_input_data *next,
+                                     unsigned long now_ms, unsigned long row_start_ms, can_msg *frames);
 
-mqd_t sensors_mq;
-pthread_t sensors_id;
+#ifndef TEST_MODE
+static mqd_t sensors_mq; // Module private: the modules also run as threads of aeb_all_bin
+#endif
+pthread_t sensors_id, reader_id;
 sensors_input_data sensorsData;
 
-can_msg can_car_cluster, can_velocity_sensor, can_obstacle_sensor, can_pedals_sensor;
+sensors_block sensors_blocks[SENSORS_BLOCK_COUNT];
+spsc_queue filled_blocks; // Indexes of blocks ready to be sent (reader -> sender)
+spsc_queue free_blocks;   // Indexes of blocks already sent (sender -> reader)
+size_t rows_per_block = SENSORS_BLOCK_ROWS;
+bool streaming_input = false; // Rows come from a stream (-i) and are sent as soon as they arrive
+int rows_event_fd = -1;       // Signalled by the reader whenever a block is filled, in streaming mode
+metrics sensors_metrics;       // Metrics block of the sender thread
+
+// Transmit schedule, in the order the frames are sent when they are due at the same time.
+// By default every frame is sent once per scenario row; bus timing (-b) uses the per-signal periods
+// and -r sends every frame at a fixed rate.
+can_tx_schedule tx_schedule[] = {
+    {.identifier = ID_CAR_C, .period_ms = SCENARIO_ROW_PERIOD_MS},
+    {.identifier = ID_SPEED_S, .period_ms = SCENARIO_ROW_PERIOD_MS},
+    {.identifier = ID_OBSTACLE_S, .period_ms = SCENARIO_ROW_PERIOD_MS},
+    {.identifier = ID_PEDALS, .period_ms = SCENARIO_ROW_PERIOD_MS}};
+#define TX_SCHEDULE_SIZE (sizeof(tx_schedule) / sizeof(tx_schedule[0]))
+_Static_assert(TX_SCHEDULE_SIZE == SENSORS_TX_FRAMES, "SENSORS_TX_FRAMES must match the transmit schedule");
 
 #ifndef TEST_MODE 
-int main()
+int main(int argc, char *argv[])
 {
     int sensors_thr;
+    int opt;
+    const char *stream_path = NULL;
+
+    while ((opt = getopt(argc, argv, "br:i:")) != -1)
+    {
+        int rate_hz;
+        switch (opt)
+        {
+        case 'b': // Send each frame at its own bus period instead of once per row
+            tx_schedule[0].period_ms = TX_PERIOD_CAR_C_MS;
+            tx_schedule[1].period_ms = TX_PERIOD_SPEED_MS;
+            tx_schedule[2].period_ms = TX_PERIOD_OBSTACLE_MS;
+            tx_schedule[3].period_ms = TX_PERIOD_PEDALS_MS;
+            break;
+        case 'r': // Send every frame at the given rate, interpolating between rows
+            rate_hz = atoi(optarg);
+            if (rate_hz <= 0 || rate_hz > 1000 || 1000 % rate_hz != 0)
+            {
+                fprintf(stderr, "Sensors: the rate must be a divisor of 1000 Hz\n");
+                exit(EXIT_FAILURE);
+            }
+            for (size_t i = 0; i < TX_SCHEDULE_SIZE; i++)
+            {
+                tx_schedule[i].period_ms = 1000 / rate_hz;
+            }
+            break;
+        case 'i': // Stream rows from a file, a named pipe or stdin ("-")
+            stream_path = optarg;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-b] [-r rate_hz] [-i input|-]\n", argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
 
     sensors_mq = create_mq(SENSORS_MQ);
+    flight_recorder_attach(FLIGHT_RECORDER_SHM, FR_SOURCE_SENSORS); // Disabled when started without main_bin
 
-    const char *filename = "tcs/cenario.txt";
-    FILE *file = open_file(filename); // uses the modularized function to open the file
+    FILE *file;
+    if (stream_path != NULL)
+    {
+        // Every row is handed over on its own, so it is sent as soon as it is read
+        file = open_stream(stream_path);
+        streaming_input = true;
+        rows_per_block = 1;
+        rows_event_fd = eventfd(0, EFD_NONBLOCK);
+        if (rows_event_fd == -1)
+        {
+            perror("Sensors: it wasn't possible to create the pipeline event\n");
+            exit(52);
+        }
+    }
+    else
+    {
+        const char *filename = "tcs/cenario.txt";
+        file = open_file(filename); // uses the modularized function to open the file
+    }
 
-    sensors_thr = pthread_create(&sensors_id, NULL, getSensorsData, file); // Changed the argument from null to file(the last argument)
+    if (spsc_init(&filled_blocks, SENSORS_BLOCK_COUNT, sizeof(size_t)) != 0 ||
+        spsc_init(&free_blocks, SENSORS_BLOCK_COUNT, sizeof(size_t)) != 0)
+    {
+        perror("Sensors: it wasn't possible to create the pipeline queues\n");
+        exit(52);
+    }
+    for (size_t i = 0; i < SENSORS_BLOCK_COUNT; i++)
+    {
+        spsc_push(&free_blocks, &i);
+    }
+
+    readiness_notify(); // Input and queue open: the first frame goes out on the first tick
+    sensors_thr = pthread_create(&reader_id, NULL, readSensorsData, file);
+    if (sensors_thr != 0)
+    {
+        perror("Sensors: it wasn't possible to create the reader thread\n");
+        exit(52);
+    }
+
+    sensors_thr = pthread_create(&sensors_id, NULL, getSensorsData, NULL);
     if (sensors_thr != 0)
     {
         perror("Sensors: it wasn't possible to create the associated thread\n");
         exit(52);
     }
     sensors_thr = pthread_join(sensors_id, NULL);
+    sensors_thr = pthread_join(reader_id, NULL);
+
+    spsc_destroy(&filled_blocks);
+    spsc_destroy(&free_blocks);
+    if (rows_event_fd != -1)
+    {
+        close(rows_event_fd);
+    }
 
     return 0;
 }
 
 /**
- * @brief Function that encapsulates data from a file into CAN frames and sends it to the message queue.
+ * @brief Function that prefetches scenario rows from a file into blocks for the sender thread.
  * 
- * This function is runned by the thread sensors_thr. It calls the other functions of the program
- * to read data from the file, encode it into CAN frames and send it to sensors message queue. 
+ * This function is runned by the reader thread. It takes a free block, fills it with parsed rows
+ * and hands it to the sender through the filled_blocks queue, so file I/O never happens on the
+ * thread that emits the CAN frames. Only SENSORS_BLOCK_COUNT blocks exist, which bounds the
+ * memory used no matter the size of the input. In streaming mode each block holds a single row
+ * and the sender is woken up through rows_event_fd.
  * 
  * @param arg Arguments passed to the thread (in this case it is the file pointer).
  * @return NULL.
  * 
 */
-void* getSensorsData(void *arg)
+void *readSensorsData(void *arg)
 {
     FILE *file = (FILE *) arg;
-    while (1)
+    size_t block_idx;
+    bool eof = false;
+    uint64_t one = 1;
+
+    while (!eof)
     {
-        // Read a new line from the file [SwR-9]
-        if (read_sensor_data(file, &sensorsData))
+        while (spsc_pop(&free_blocks, &block_idx) != 0)
         {
-            can_car_cluster = conv2CANCarClusterData(sensorsData.aeb_system_enabled);
-            can_velocity_sensor = conv2CANVelocityData(sensorsData.reverse_enabled, sensorsData.relative_velocity, sensorsData.relative_acceleration); // [SwR-10]
-            can_obstacle_sensor = conv2CANObstacleData(sensorsData.has_obstacle, sensorsData.obstacle_distance);
-            can_pedals_sensor = conv2CANPedalsData(sensorsData.brake_pedal, sensorsData.accelerator_pedal);
+            usleep(PIPELINE_POLL_US); // Both blocks are still waiting to be sent
+        }
 
-            write_mq(sensors_mq, &can_car_cluster);
-            write_mq(sensors_mq, &can_velocity_sensor);
-            write_mq(sensors_mq, &can_obstacle_sensor);
-            write_mq(sensors_mq, &can_pedals_sensor);
+        sensors_block *block = &sensors_blocks[block_idx];
+        block->count = 0;
 
-            //printf("New line.\n"); // This line is used for see the break of line
-        }
-        else
+        // Read new lines from the file [SwR-9]
+        while (block->count < rows_per_block && read_sensor_data(file, &block->rows[block->count]))
         {
-            // If a new line can't be read, the end of the file was reached
-            printf("EOF reached.\n");
-            break;
+            block->count++;
         }
+        eof = block->count < rows_per_block;
+        block->eof = eof;
 
-        sleep(1); // Wait for 1 second before reading the next line
+        spsc_push(&filled_blocks, &block_idx); // Cannot fail: there are only SENSORS_BLOCK_COUNT indexes
+        if (rows_event_fd != -1 && write(rows_event_fd, &one, sizeof(one)) != sizeof(one))
+        {
+            perror("Sensors: it wasn't possible to signal the sender thread\n");
+        }
     }
 
     fclose(file);
     return NULL;
 }
+
+/**
+ * @brief Gets the next prefetched scenario row from the reader thread.
+ *
+ * Blocks are taken from the filled_blocks queue and handed back through free_blocks
+ * once all their rows were consumed.
+ *
+ * @param row Pointer to where the next row will be copied.
+ * @param wait If true, waits for the reader instead of returning SENSORS_ROW_PENDING.
+ * @return SENSORS_ROW_READY if a row was copied, SENSORS_ROW_PENDING if none is available yet,
+ *         SENSORS_ROW_EOF if the end of the input was reached.
+ */
+sensors_row_status nextSensorsRow(sensors_input_data *row, bool wait)
+{
+    static sensors_block *block = NULL;
+    static size_t block_idx;
+    static size_t row_idx;
+    static bool eof = false;
+
+    while (block == NULL || row_idx == block->count)
+    {
+        if (block != NULL)
+        {
+            eof = block->eof;
+            spsc_push(&free_blocks, &block_idx); // Give the block back to the reader
+            block = NULL;
+        }
+        if (eof)
+        {
+            return SENSORS_ROW_EOF;
+        }
+
+        while (spsc_pop(&filled_blocks, &block_idx) != 0)
+        {
+            if (!wait)
+            {
+                return SENSORS_ROW_PENDING;
+            }
+            usleep(PIPELINE_POLL_US); // Reader has not finished the next block yet
+        }
+        block = &sensors_blocks[block_idx];
+        row_idx = 0;
+    }
+
+    *row = block->rows[row_idx++];
+    return SENSORS_ROW_READY;
+}
+
+/**
+ * @brief Sends frames to the sensors message queue.
+ */
+static void sendSensorsFrames(can_msg *frames, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        AEB_PROBE1(frame_send, frames[i].identifier);
+        int sent = write_mq(sensors_mq, &frames[i]);
+        metrics_add(&sensors_metrics, sent == 0 ? SENSORS_METRIC_FRAMES_OUT : SENSORS_METRIC_SEND_ERRORS, 1);
+        flight_recorder_frame(FR_ENTRY_FRAME_TX, &frames[i]);
+    }
+}
+
+/**
+ * @brief Fetches the next prefetched row for the scenario replay, waiting for the reader.
+ */
+static bool nextPrefetchedRow(void *source, sensors_input_data *row)
+{
+    return nextSensorsRow(row, true) == SENSORS_ROW_READY;
+}
+
+/**
+ * @brief Waits for the next tick of the transmit timer (or for a new row in streaming mode).
+ *
+ * @param now_ms Time elapsed since the start of the emission, advanced by the elapsed ticks.
+ * @return false if the wait was interrupted.
+ */
+static bool waitSensorsTick(struct pollfd *wait_fds, nfds_t wait_count, unsigned int tick_ms, unsigned long *now_ms)
+{
+    uint64_t counter;
+
+    if (poll(wait_fds, wait_count, -1) == -1)
+    {
+        return false;
+    }
+    // Expirations > 1 means ticks were missed and are skipped
+    if ((wait_fds[0].revents & POLLIN) && read(wait_fds[0].fd, &counter, sizeof(counter)) == sizeof(counter))
+    {
+        *now_ms += counter * tick_ms;
+        metrics_add(&sensors_metrics, SENSORS_METRIC_MISSED_TICKS, counter - 1);
+    }
+    return true;
+}
+
+/**
+ * @brief Function that encapsulates prefetched rows into CAN frames and sends it to the message queue.
+ * 
+ * This function is runned by the thread sensors_thr. A single timerfd ticks at the greatest
+ * common divisor of the transmit periods and of the row interval. On every tick the scenario row
+ * is advanced when its interval is over, and each frame whose period elapsed is encoded and sent
+ * to sensors message queue. Frames sent inside a row interval carry values interpolated between
+ * the current row and the next one (see interpolateSensorsData). Each tick is one sensorsStep.
+ * 
+ * In streaming mode rows are not paced by the row interval: every row is sent as soon as the
+ * reader signals it, and the last row is held (and sent at the transmit periods) until the next
+ * one arrives.
+ * 
+ * The thread publishes the frames it sent, the frames the full queue refused and the timer
+ * ticks it missed in the metrics segment created by main_bin.
+ * 
+ * @param arg Arguments passed to the thread (not used here).
+ * @return NULL.
+ * 
+*/
+void* getSensorsData(void *arg)
+{
+    unsigned long now_ms = 0;
+    uint64_t counter;
+    can_msg frames[SENSORS_TX_FRAMES];
+
+    unsigned int tick_ms = txScheduleTick(tx_schedule, TX_SCHEDULE_SIZE, SCENARIO_ROW_PERIOD_MS);
+    struct itimerspec timer_spec = {
+        .it_interval = {.tv_sec = tick_ms / 1000, .tv_nsec = (tick_ms % 1000) * 1000000L},
+        .it_value = {.tv_sec = tick_ms / 1000, .tv_nsec = (tick_ms % 1000) * 1000000L}};
+
+    int timer_fd = timerfd_create(CLOCK_MONOTONIC, 0);
+    if (timer_fd == -1 || timerfd_settime(timer_fd, 0, &timer_spec, NULL) == -1)
+    {
+        perror("Sensors: it wasn't possible to create the transmit timer\n");
+        exit(52);
+    }
+    struct pollfd wait_fds[2] = {{.fd = timer_fd, .events = POLLIN}, {.fd = rows_event_fd, .events = POLLIN}};
+    static const metric_desc metric_names[SENSORS_METRICS] = {
+        {"frames_out", METRIC_COUNTER}, {"send_errors", METRIC_COUNTER}, {"missed_ticks", METRIC_COUNTER}};
+    metrics_register(&sensors_metrics, METRICS_SHM, "sensors", metric_names, SENSORS_METRICS);
+
+    if (!streaming_input)
+    {
+        // Reads the first line, and the next one to interpolate towards [SwR-9]
+        sensors_replay replay;
+        sensorsReplayStart(&replay, nextPrefetchedRow, NULL);
+        for (;;)
+        {
+            size_t count = sensorsStep(&replay, now_ms, frames);
+            if (!replay.has_row)
+            {
+                break;
+            }
+            sendSensorsFrames(frames, count);
+            waitSensorsTick(wait_fds, 1, tick_ms, &now_ms);
+        }
+    }
+    else
+    {
+        sensors_input_data current_row;
+        unsigned long row_start_ms = 0;
+        bool has_row = nextSensorsRow(&current_row, true) == SENSORS_ROW_READY;
+        while (has_row)
+        {
+            sendSensorsFrames(frames, encodeDueSensorsFrames(&current_row, NULL, now_ms, row_start_ms, frames));
+
+            if (!waitSensorsTick(wait_fds, 2, tick_ms, &now_ms))
+            {
+                continue;
+            }
+            sensors_row_status status;
+            if ((wait_fds[1].revents & POLLIN) && read(rows_event_fd, &counter, sizeof(counter)) != sizeof(counter))
+            {
+                perror("Sensors: it wasn't possible to read the pipeline event\n");
+            }
+            // Send every new row right away, even if several arrived since the last wake-up
+            while ((status = nextSensorsRow(&current_row, false)) == SENSORS_ROW_READY)
+            {
+                row_start_ms = now_ms;
+                txScheduleRestart(tx_schedule, TX_SCHEDULE_SIZE, now_ms);
+                sendSensorsFrames(frames, encodeDueSensorsFrames(&current_row, NULL, now_ms, row_start_ms, frames));
+            }
+            has_row = status != SENSORS_ROW_EOF;
+        }
+    }
+
+    // If a new line can't be read, the end of the file was reached
+    printf("EOF reached.\n");
+    close(timer_fd);
+    metrics_release(&sensors_metrics);
+    return NULL;
+}
 #endif
 
+/**
+ * @brief Computes the tick of the transmit timer for a schedule.
+ *
+ * The tick is the greatest common divisor of every transmit period and of the scenario
+ * row interval, so that every deadline and every row change falls exactly on a tick.
+ *
+ * @param schedule Transmit schedule table.
+ * @param size Number of entries in the table.
+ * @param row_period_ms Interval between two scenario rows.
+ * @return Timer tick in milliseconds.
+ *
+ * \anchor txScheduleTick
+ */
+unsigned int txScheduleTick(const can_tx_schedule *schedule, size_t size, unsigned int row_period_ms)
+{
+    unsigned int tick = row_period_ms;
+    for (size_t i = 0; i < size; i++)
+    {
+        tick = periodGcd(tick, schedule[i].period_ms);
+    }
+    return tick;
+}
+
+/**
+ * @brief Collects the frames of a schedule that are due at a given time.
+ *
+ * Each due entry has its deadline moved forward by whole periods until it is in the future,
+ * so deadlines missed by a late tick are skipped instead of being sent in a burst.
+ *
+ * @param schedule Transmit schedule table.
+ * @param size Number of entries in the table.
+ * @param now_ms Time elapsed since the start of the emission.
+ * @param due_ids Array (with at least size entries) that receives the identifiers of the due frames.
+ * @return Number of identifiers written to due_ids.
+ *
+ * \anchor txScheduleDue
+ */
+size_t txScheduleDue(can_tx_schedule *schedule, size_t size, unsigned long now_ms, uint32_t *due_ids)
+{
+    size_t due_count = 0;
+    for (size_t i = 0; i < size; i++)
+    {
+        if (schedule[i].next_due_ms <= now_ms)
+        {
+            due_ids[due_count++] = schedule[i].identifier;
+            while (schedule[i].next_due_ms <= now_ms)
+            {
+                schedule[i].next_due_ms += schedule[i].period_ms;
+            }
+        }
+    }
+    return due_count;
+}
+
+/**
+ * @brief Makes every frame of a schedule due at the given time.
+ *
+ * Used when a new row arrives from a stream, so that all its frames are sent at once and
+ * the periodic transmission restarts from that point.
+ *
+ * @param schedule Transmit schedule table.
+ * @param size Number of entries in the table.
+ * @param now_ms Time elapsed since the start of the emission.
+ *
+ * \anchor txScheduleRestart
+ */
+void txScheduleRestart(can_tx_schedule *schedule, size_t size, unsigned long now_ms)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        schedule[i].next_due_ms = now_ms;
+    }
+}
+
+/**
+ * @brief Encodes one sensor row into the CAN frame of the given identifier.
+ *
+ * @param identifier CAN identifier of the frame to be encoded.
+ * @param data Sensor row to be encoded.
+ * @return The encoded frame, or a frame with identifier ID_EMPTY if the identifier is unknown.
+ *
+ * \anchor encodeSensorsFrame
+ */
+can_msg encodeSensorsFrame(uint32_t identifier, const sensors_input_data *data)
+{
+    can_msg empty = {.identifier = ID_EMPTY, .dataFrame = BASE_DATA_FRAME};
+
+    switch (identifier)
+    {
+    case ID_CAR_C:
+        return conv2CANCarClusterData(data->aeb_system_enabled);
+    case ID_SPEED_S:
+        return conv2CANVelocityData(data->reverse_enabled, data->relative_velocity, data->relative_acceleration);
+    case ID_OBSTACLE_S:
+        return conv2CANObstacleData(data->has_obstacle, data->obstacle_distance);
+    case ID_PEDALS:
+        return conv2CANPedalsData(data->brake_pedal, data->accelerator_pedal);
+    default:
+        return empty;
+    }
+}
+
+/**
+ * @brief Computes the sensor values at a point between two scenario rows.
+ *
+ * Relative velocity and relative acceleration are interpolated linearly towards the next row.
+ * The obstacle distance is integrated from the current row with the uniformly varied motion
+ * model used by ttc_calc (d = d0 - v0 * t - a0 * t^2 / 2, velocity in km/h), and limited to
+ * the range the Obstacle frame can carry. Boolean inputs are held from the current row.
+ *
+ * @param current Scenario row at the start of the interval.
+ * @param next Scenario row at the end of the interval, or NULL if there is none (values are held).
+ * @param elapsed_s Time elapsed since the start of the interval, in seconds.
+ * @param row_period_s Length of the interval, in seconds.
+ * @return The interpolated sensor values.
+ *
+ * \anchor interpolateSensorsData
+ */
+sensors_input_data interpolateSensorsData(const sensors_input_data *current, const sensors_input_data *next,
+                                          double elapsed_s, double row_period_s)
+{
+    sensors_input_data sample = *current;
+
+    if (elapsed_s <= 0.0)
+    {
+        return sample;
+    }
+
+    if (next != NULL)
+    {
+        double fraction = elapsed_s / row_period_s;
+        sample.relative_velocity += fraction * (next->relative_velocity - current->relative_velocity);
+        sample.relative_acceleration += fraction * (next->relative_acceleration - current->relative_acceleration);
+    }
+
+    if (current->has_obstacle)
+    {
+        sample.obstacle_distance -= (current->relative_velocity / 3.6) * elapsed_s +
+                                    0.5 * current->relative_acceleration * elapsed_s * elapsed_s;
+        if (sample.obstacle_distance < 0.0)
+        {
+            sample.obstacle_distance = 0.0;
+        }
+        else if (sample.obstacle_distance > MAX_OBSTACLE_S)
+        {
+            sample.obstacle_distance = MAX_OBSTACLE_S;
+        }
+    }
+
+    return sample;
+}
+
+/**
+ * @brief Encodes the frames of the transmit schedule that are due.
+ *
+ * @param current Scenario row being sent.
+ * @param next Next scenario row, used for interpolation, or NULL if unknown.
+ * @param now_ms Time elapsed since the start of the emission.
+ * @param row_start_ms Time at which the current row started being sent.
+ * @param frames Array (with at least SENSORS_TX_FRAMES entries) that receives the frames.
+ * @return Number of frames written to frames.
+ */
+static size_t encodeDueSensorsFrames(const sensors_input_data *current, const sensors_input_data *next,
+                                     unsigned long now_ms, unsigned long row_start_ms, can_msg *frames)
+{
+    uint32_t due_ids[TX_SCHEDULE_SIZE];
+    size_t due_count = txScheduleDue(tx_schedule, TX_SCHEDULE_SIZE, now_ms, due_ids);
+
+    if (due_count > 0)
+    {
+        sensorsData = interpolateSensorsData(current, next, (now_ms - row_start_ms) / 1000.0,
+                                             SCENARIO_ROW_PERIOD_MS / 1000.0);
+    }
+    for (size_t i = 0; i < due_count; i++)
+    {
+        frames[i] = encodeSensorsFrame(due_ids[i], &sensorsData); // [SwR-10]
+    }
+    return due_count;
+}
+
+/**
+ * @brief Starts the replay of a scenario with the module's transmit schedule.
+ *
+ * Reads the first row, and the next one to interpolate towards [SwR-9], and makes every frame
+ * of the schedule due at time 0. sensorsStep must then be called every replay->tick_ms.
+ *
+ * @param replay Replay state to be initialized.
+ * @param next_row Fetches the next scenario row; returns false at the end of the input.
+ * @param source Passed to next_row.
+ *
+ * \anchor sensorsReplayStart
+ */
+void sensorsReplayStart(sensors_replay *replay, bool (*next_row)(void *source, sensors_input_data *row), void *source)
+{
+    replay->next_row = next_row;
+    replay->source = source;
+    replay->row_start_ms = 0;
+    replay->tick_ms = txScheduleTick(tx_schedule, TX_SCHEDULE_SIZE, SCENARIO_ROW_PERIOD_MS);
+    replay->has_row = next_row(source, &replay->current);
+    replay->has_next = replay->has_row && next_row(source, &replay->next);
+    txScheduleRestart(tx_schedule, TX_SCHEDULE_SIZE, 0);
+}
+
+/**
+ * @brief Advances the scenario replay to a timer tick and encodes the frames due at it.
+ *
+ * The scenario row is advanced when its interval is over, and each frame whose period elapsed
+ * is encoded with the values interpolated between the current row and the next one. Once the
+ * last row interval is over, replay->has_row becomes false and no frame is returned.
+ *
+ * @param replay Replay state, started with sensorsReplayStart.
+ * @param now_ms Time of the tick, since the start of the replay (never decreasing).
+ * @param frames Array (with at least SENSORS_TX_FRAMES entries) that receives the frames.
+ * @return Number of frames written to frames.
+ *
+ * \anchor sensorsStep
+ */
+size_t sensorsStep(sensors_replay *replay, unsigned long now_ms, can_msg *frames)
+{
+    // Move to the next line once the interval of the current one is over
+    while (replay->has_row && now_ms - replay->row_start_ms >= SCENARIO_ROW_PERIOD_MS)
+    {
+        replay->row_start_ms += SCENARIO_ROW_PERIOD_MS;
+        replay->has_row = replay->has_next;
+        replay->current = replay->next;
+        replay->has_next = replay->has_row && replay->next_row(replay->source, &replay->next);
+    }
+    if (!replay->has_row)
+    {
+        return 0;
+    }
+    return encodeDueSensorsFrames(&replay->current, replay->has_next ? &replay->next : NULL, now_ms,
+                                  replay->row_start_ms, frames);
+}
+
 // The location of information in the data frame location, in the following functions,
 // is according to the dbc file in the requirements specification
 
@@ -271,4 +848,129 @@ can_msg conv2CANPedalsData(bool brake_pedal, bool accelerator_pedal)
     }
 
     return aux;
-}
\ No newline at end of file
+}
+
+
+// Batch encoders: four rows are scaled and converted at once with GCC vector extensions.
+// Conversions go through 64-bit integers and keep the low bytes, exactly like the scalar
+// double -> unsigned int conversions above, so both paths give byte-identical frames.
+#define SENSORS_BATCH_LANES 4
+
+typedef double sensors_v4df __attribute__((vector_size(SENSORS_BATCH_LANES * sizeof(double))));
+typedef int64_t sensors_v4di __attribute__((vector_size(SENSORS_BATCH_LANES * sizeof(int64_t))));
+typedef uint64_t sensors_v4du __attribute__((vector_size(SENSORS_BATCH_LANES * sizeof(uint64_t))));
+
+// Bytes 6 and 7 keep the 0xFF of BASE_DATA_FRAME
+#define SPEED_FRAME_UNUSED_BYTES (0xFFFFULL << 48)
+// Bytes 3 to 7 keep the 0xFF of BASE_DATA_FRAME
+#define OBSTACLE_FRAME_UNUSED_BYTES (0xFFFFFFFFFFULL << 24)
+
+static inline void storeDataFrame(can_msg *msg, uint32_t identifier, uint64_t data)
+{
+    msg->identifier = identifier;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    memcpy(msg->dataFrame, &data, sizeof(msg->dataFrame));
+#else
+    for (int i = 0; i < 8; i++)
+    {
+        msg->dataFrame[i] = data >> (8 * i);
+    }
+#endif
+}
+
+/**
+ * @brief Encodes an array of rows into Speed CAN frames.
+ * 
+ * Batch version of conv2CANVelocityData: speed scaling, acceleration sign/magnitude and byte
+ * packing are computed for SENSORS_BATCH_LANES rows per iteration without branches. The
+ * output is identical to calling conv2CANVelocityData on each row.
+ * 
+ * @param rows Array of sensor rows.
+ * @param count Number of rows.
+ * @param out Array (with at least count entries) that receives the frames.
+ * 
+ * \anchor conv2CANVelocityDataBatch
+ * 
+*/
+void conv2CANVelocityDataBatch(const sensors_input_data *rows, size_t count, can_msg *out)
+{
+    size_t i = 0;
+
+    for (; i + SENSORS_BATCH_LANES <= count; i += SENSORS_BATCH_LANES)
+    {
+        const sensors_input_data *r = &rows[i];
+        sensors_v4df speed = {r[0].relative_velocity, r[1].relative_velocity,
+                              r[2].relative_velocity, r[3].relative_velocity};
+        sensors_v4df accel = {r[0].relative_acceleration, r[1].relative_acceleration,
+                              r[2].relative_acceleration, r[3].relative_acceleration};
+        sensors_v4du direction = {r[0].reverse_enabled != 0, r[1].reverse_enabled != 0,
+                                  r[2].reverse_enabled != 0, r[3].reverse_enabled != 0};
+
+        // Lanes are all ones where the acceleration is negative; the magnitude is the value
+        // with its sign bit cleared
+        sensors_v4du negative = (sensors_v4du)(accel < 0.0);
+        sensors_v4df accel_abs = (sensors_v4df)((sensors_v4du)accel & 0x7FFFFFFFFFFFFFFFULL);
+
+        sensors_v4du data_speed = (sensors_v4du)__builtin_convertvector(speed / RES_SPEED_S, sensors_v4di);
+        sensors_v4du data_acel = (sensors_v4du)__builtin_convertvector(
+            (accel_abs * RES_ACCELERATION_DIV_S) - OFFSET_ACCELERATION_S, sensors_v4di);
+
+        // Byte layout, according to the DBC specification:
+        // [0..1] speed, [2] direction, [3..4] acceleration, [5] acceleration sign
+        sensors_v4du data = (data_speed & 0xFFFF) | (direction << 16) | ((data_acel & 0xFFFF) << 24) |
+                            ((negative & 1) << 40) | SPEED_FRAME_UNUSED_BYTES;
+
+        for (int lane = 0; lane < SENSORS_BATCH_LANES; lane++)
+        {
+            storeDataFrame(&out[i + lane], ID_SPEED_S, data[lane]);
+        }
+    }
+
+    for (; i < count; i++)
+    {
+        out[i] = conv2CANVelocityData(rows[i].reverse_enabled, rows[i].relative_velocity, rows[i].relative_acceleration);
+    }
+}
+
+/**
+ * @brief Encodes an array of rows into Obstacle CAN frames.
+ * 
+ * Batch version of conv2CANObstacleData: distance scaling and byte packing are computed for
+ * SENSORS_BATCH_LANES rows per iteration without branches. The output is identical to calling
+ * conv2CANObstacleData on each row.
+ * 
+ * @param rows Array of sensor rows.
+ * @param count Number of rows.
+ * @param out Array (with at least count entries) that receives the frames.
+ * 
+ * \anchor conv2CANObstacleDataBatch
+ * 
+*/
+void conv2CANObstacleDataBatch(const sensors_input_data *rows, size_t count, can_msg *out)
+{
+    size_t i = 0;
+
+    for (; i + SENSORS_BATCH_LANES <= count; i += SENSORS_BATCH_LANES)
+    {
+        const sensors_input_data *r = &rows[i];
+        sensors_v4df distance = {r[0].obstacle_distance, r[1].obstacle_distance,
+                                 r[2].obstacle_distance, r[3].obstacle_distance};
+        sensors_v4du has_obstacle = {r[0].has_obstacle != 0, r[1].has_obstacle != 0,
+                                     r[2].has_obstacle != 0, r[3].has_obstacle != 0};
+
+        sensors_v4du data_distance = (sensors_v4du)__builtin_convertvector(distance / RES_OBSTACLE_S, sensors_v4di);
+
+        // Byte layout, according to the DBC specification: [0..1] distance, [2] obstacle presence
+        sensors_v4du data = (data_distance & 0xFFFF) | (has_obstacle << 16) | OBSTACLE_FRAME_UNUSED_BYTES;
+
+        for (int lane = 0; lane < SENSORS_BATCH_LANES; lane++)
+        {
+            storeDataFrame(&out[i + lane], ID_OBSTACLE_S, data[lane]);
+        }
+    }
+
+    for (; i < count; i++)
+    {
+        out[i] = conv2CANObstacleData(rows[i].has_obstacle, rows[i].obstacle_distance);
+    }
+}
@@ -0,0 +1,114 @@
+/**
+ * @file spsc_queue.c
+ * @brief Lock-free single-producer/single-consumer queue used between threads of one process.
+ *
+ * The producer only writes the tail counter and the consumer only writes the head counter.
+ * The release store that publishes a counter pairs with the acquire load on the other side,
+ * which makes the element copy visible before the slot is handed over.
+ */
+
+#include "spsc_queue.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief Initializes a queue and allocates its ring buffer.
+ *
+ * @param queue Queue to be initialized.
+ * @param capacity Number of elements the queue can hold (must be a power of two).
+ * @param elem_size Size in bytes of each element.
+ * @return 0 on success, -1 on invalid arguments or allocation failure.
+ * \anchor spsc_init
+ */
+int spsc_init(spsc_queue *queue, size_t capacity, size_t elem_size)
+{
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0 || elem_size == 0)
+    {
+        return -1;
+    }
+
+    queue->buffer = malloc(capacity * elem_size);
+    if (queue->buffer == NULL)
+    {
+        return -1;
+    }
+
+    queue->capacity = capacity;
+    queue->elem_size = elem_size;
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+    return 0;
+}
+
+/**
+ * @brief Releases the ring buffer of a queue.
+ *
+ * @param queue Queue to be destroyed.
+ * \anchor spsc_destroy
+ */
+void spsc_destroy(spsc_queue *queue)
+{
+    free(queue->buffer);
+    queue->buffer = NULL;
+    queue->capacity = 0;
+}
+
+/**
+ * @brief Copies an element into the queue (producer side only).
+ *
+ * @param queue Queue where the element will be stored.
+ * @param elem Pointer to the element to be copied.
+ * @return 0 on success, -1 if the queue is full.
+ * \anchor spsc_push
+ */
+int spsc_push(spsc_queue *queue, const void *elem)
+{
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&queue->head, memory_order_acquire);
+
+    if (tail - head == queue->capacity)
+    {
+        return -1;
+    }
+
+    memcpy(queue->buffer + (tail & (queue->capacity - 1)) * queue->elem_size, elem, queue->elem_size);
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+    return 0;
+}
+
+/**
+ * @brief Copies the oldest element out of the queue (consumer side only).
+ *
+ * @param queue Queue from which the element will be removed.
+ * @param elem Pointer to where the element will be copied.
+ * @return 0 on success, -1 if the queue is empty.
+ * \anchor spsc_pop
+ */
+int spsc_pop(spsc_queue *queue, void *elem)
+{
+    size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+
+    if (head == tail)
+    {
+        return -1;
+    }
+
+    memcpy(elem, queue->buffer + (head & (queue->capacity - 1)) * queue->elem_size, queue->elem_size);
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+    return 0;
+}
+
+/**
+ * @brief Gets the number of elements currently stored in the queue.
+ *
+ * @param queue Queue to be inspected.
+ * @return Number of elements waiting to be consumed.
+ * \anchor spsc_size
+ */
+size_t spsc_size(spsc_queue *queue)
+{
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+    size_t head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    return tail - head;
+}
@@ -3,6 +3,8 @@
 #include "dbc.h"
 #include "constants.h"
 #include "mq_utils.h"
+#include "flight_recorder.h"
+#include "mailbox.h"
 #include <unistd.h>
 
 // Declare the actuatorsResponseLoop function if it's defined elsewhere
@@ -37,23 +39,55 @@ int read_mq(mqd_t mq, can_msg *msg) {
 
 
 
-// Mock to log_event
+// Mock to log_event, which keeps the last logged event
+uint32_t mock_logged_event_id = 0;
+actuators_abstraction mock_logged_actuators = 0;
 void log_event(const char *id_aeb, uint32_t event_id, actuators_abstraction actuators) {
+    mock_logged_event_id = event_id;
+    mock_logged_actuators = actuators;
     printf("[MOCK LOG] ID: %s, Event: 0x%X, BELT: %d, DOOR: %d, ABS: %d, LED: %d, BUZZ: %d\n",
-           id_aeb, event_id, actuators.belt_tightness, actuators.door_lock,
-           actuators.should_activate_abs, actuators.alarm_led, actuators.alarm_buzzer);
+           id_aeb, event_id, actuatorIsActive(actuators, ACTUATOR_BIT_BELT_TIGHTNESS), actuatorIsActive(actuators, ACTUATOR_BIT_DOOR_LOCK),
+           actuatorIsActive(actuators, ACTUATOR_BIT_ABS), actuatorIsActive(actuators, ACTUATOR_BIT_ALARM_LED), actuatorIsActive(actuators, ACTUATOR_BIT_ALARM_BUZZER));
 }
 
+// Mocks to the sources of the actuators metrics (no metrics block in the tests)
+long depth_mq(mqd_t mqd) { return 0; }
+
+unsigned long log_written_bytes(void) { return 0; }
+
+unsigned long log_dropped_events(void) { return 0; }
+
+// Mocks to the flight recorder (not attached in the tests)
+void flight_recorder_frame(flight_recorder_kind kind, const can_msg *frame) {}
+
+void flight_recorder_actuators(actuators_abstraction actuators) {}
+
+// Mock to the mailbox: each ID holds mock_mailbox_versions[i] (0 = never posted)
+uint32_t mock_mailbox_ids[3] = {ID_AEB_S, ID_EMPTY, ID_ACTUATORS_CMD};
+uint32_t mock_mailbox_versions[3] = {0, 0, 0};
+int mailbox_take(mailbox *box, uint32_t identifier, can_msg *frame, uint32_t *version) {
+    for (int i = 0; i < 3; i++) {
+        if (mock_mailbox_ids[i] != identifier)
+            continue;
+        if (mock_mailbox_versions[i] == *version)
+            return mock_mailbox_versions[i] == 0 ? -1 : 0;
+        frame->identifier = identifier;
+        frame->dataFrame[0] = (uint8_t)mock_mailbox_versions[i];
+        *version = mock_mailbox_versions[i];
+        return 1;
+    }
+    return -1;
+}
+
+int readActuatorsCommand(can_msg *command);
+extern mailbox actuators_mailbox;
+
 // Mock to global variable actuators_state
 extern actuators_abstraction actuators_state;
 
 // Funções de setup e teardown
 void setUp(void) {
-    actuators_state.belt_tightness = 0;
-    actuators_state.door_lock = 0;
-    actuators_state.should_activate_abs = 0;
-    actuators_state.alarm_led = 0;
-    actuators_state.alarm_buzzer = 0;
+    actuators_state = 0;
 }
 
 void tearDown(void) {
@@ -78,11 +112,11 @@ void test_actuatorsTranslateCanMsg_AEB_S_Identifier(void) {
 
     // Checks if the actuators' state was updated correctly
     //// Test case ID: TC_AEB_A__001
-    TEST_ASSERT_TRUE(actuators_state.belt_tightness);
-    TEST_ASSERT_FALSE(actuators_state.door_lock);
-    TEST_ASSERT_TRUE(actuators_state.should_activate_abs);
-    TEST_ASSERT_TRUE(actuators_state.alarm_led);
-    TEST_ASSERT_TRUE(actuators_state.alarm_buzzer);
+    TEST_ASSERT_TRUE(actuatorIsActive(actuators_state, ACTUATOR_BIT_BELT_TIGHTNESS));
+    TEST_ASSERT_FALSE(actuatorIsActive(actuators_state, ACTUATOR_BIT_DOOR_LOCK));
+    TEST_ASSERT_TRUE(actuatorIsActive(actuators_state, ACTUATOR_BIT_ABS));
+    TEST_ASSERT_TRUE(actuatorIsActive(actuators_state, ACTUATOR_BIT_ALARM_LED));
+    TEST_ASSERT_TRUE(actuatorIsActive(actuators_state, ACTUATOR_BIT_ALARM_BUZZER));
 }
 
 /**
@@ -101,11 +135,11 @@ void test_actuatorsTranslateCanMsg_Empty_Identifier(void) {
 
     // Checks that the actuators' state remains unchanged
     //// Test case ID: TC_AEB_A__002
-    TEST_ASSERT_FALSE(actuators_state.belt_tightness);
-    TEST_ASSERT_FALSE(actuators_state.door_lock);
-    TEST_ASSERT_FALSE(actuators_state.should_activate_abs);
-    TEST_ASSERT_FALSE(actuators_state.alarm_led);
-    TEST_ASSERT_FALSE(actuators_state.alarm_buzzer);
+    TEST_ASSERT_FALSE(actuatorIsActive(actuators_state, ACTUATOR_BIT_BELT_TIGHTNESS));
+    TEST_ASSERT_FALSE(actuatorIsActive(actuators_state, ACTUATOR_BIT_DOOR_LOCK));
+    TEST_ASSERT_FALSE(actuatorIsActive(actuators_state, ACTUATOR_BIT_ABS));
+    TEST_ASSERT_FALSE(actuatorIsActive(actuators_state, ACTUATOR_BIT_ALARM_LED));
+    TEST_ASSERT_FALSE(actuatorIsActive(actuators_state, ACTUATOR_BIT_ALARM_BUZZER));
 }
 
 /**
@@ -125,11 +159,11 @@ void test_updateInternalActuatorsState_Correct_State(void) {
 
     // Checks the expected state of the actuators
     //// Test case ID: TC_AEB_A__003
-    TEST_ASSERT_TRUE(actuators_state.belt_tightness);
-    TEST_ASSERT_FALSE(actuators_state.door_lock);
-    TEST_ASSERT_TRUE(actuators_state.should_activate_abs);
-    TEST_ASSERT_TRUE(actuators_state.alarm_led);
-    TEST_ASSERT_TRUE(actuators_state.alarm_buzzer);
+    TEST_ASSERT_TRUE(actuatorIsActive(actuators_state, ACTUATOR_BIT_BELT_TIGHTNESS));
+    TEST_ASSERT_FALSE(actuatorIsActive(actuators_state, ACTUATOR_BIT_DOOR_LOCK));
+    TEST_ASSERT_TRUE(actuatorIsActive(actuators_state, ACTUATOR_BIT_ABS));
+    TEST_ASSERT_TRUE(actuatorIsActive(actuators_state, ACTUATOR_BIT_ALARM_LED));
+    TEST_ASSERT_TRUE(actuatorIsActive(actuators_state, ACTUATOR_BIT_ALARM_BUZZER));
 }
 
 /**
@@ -148,11 +182,11 @@ void test_actuatorsTranslateCanMsg(void) {
 
     // Checks if the state was updated correctly
         //// Test case ID: TC_AEB_A__004
-    TEST_ASSERT_TRUE(actuators_state.belt_tightness);
-    TEST_ASSERT_FALSE(actuators_state.door_lock);
-    TEST_ASSERT_TRUE(actuators_state.should_activate_abs);
-    TEST_ASSERT_TRUE(actuators_state.alarm_led);
-    TEST_ASSERT_TRUE(actuators_state.alarm_buzzer);
+    TEST_ASSERT_TRUE(actuatorIsActive(actuators_state, ACTUATOR_BIT_BELT_TIGHTNESS));
+    TEST_ASSERT_FALSE(actuatorIsActive(actuators_state, ACTUATOR_BIT_DOOR_LOCK));
+    TEST_ASSERT_TRUE(actuatorIsActive(actuators_state, ACTUATOR_BIT_ABS));
+    TEST_ASSERT_TRUE(actuatorIsActive(actuators_state, ACTUATOR_BIT_ALARM_LED));
+    TEST_ASSERT_TRUE(actuatorIsActive(actuators_state, ACTUATOR_BIT_ALARM_BUZZER));
 }
 
 /**
@@ -172,11 +206,11 @@ void test_actuatorsTranslateCanMsg_Unknown_Identifier(void) {
 
     // Checks that the actuators' state remains unchanged
     //// Test case ID: TC_AEB_A__005
-    TEST_ASSERT_FALSE(actuators_state.belt_tightness);
-    TEST_ASSERT_FALSE(actuators_state.door_lock);
-    TEST_ASSERT_FALSE(actuators_state.should_activate_abs);
-    TEST_ASSERT_FALSE(actuators_state.alarm_led);
-    TEST_ASSERT_FALSE(actuators_state.alarm_buzzer);
+    TEST_ASSERT_FALSE(actuatorIsActive(actuators_state, ACTUATOR_BIT_BELT_TIGHTNESS));
+    TEST_ASSERT_FALSE(actuatorIsActive(actuators_state, ACTUATOR_BIT_DOOR_LOCK));
+    TEST_ASSERT_FALSE(actuatorIsActive(actuators_state, ACTUATOR_BIT_ABS));
+    TEST_ASSERT_FALSE(actuatorIsActive(actuators_state, ACTUATOR_BIT_ALARM_LED));
+    TEST_ASSERT_FALSE(actuatorIsActive(actuators_state, ACTUATOR_BIT_ALARM_BUZZER));
 }
 
 /** @test 
@@ -195,11 +229,11 @@ void test_updateInternalActuatorsState_DataFrame0_Active(void) {
 
     // Checks the expected state of the actuators
     //// Test case ID: TC_AEB_A__006
-    TEST_ASSERT_FALSE(actuators_state.belt_tightness);
-    TEST_ASSERT_TRUE(actuators_state.door_lock);
-    TEST_ASSERT_FALSE(actuators_state.should_activate_abs);
-    TEST_ASSERT_TRUE(actuators_state.alarm_led);
-    TEST_ASSERT_TRUE(actuators_state.alarm_buzzer);
+    TEST_ASSERT_FALSE(actuatorIsActive(actuators_state, ACTUATOR_BIT_BELT_TIGHTNESS));
+    TEST_ASSERT_TRUE(actuatorIsActive(actuators_state, ACTUATOR_BIT_DOOR_LOCK));
+    TEST_ASSERT_FALSE(actuatorIsActive(actuators_state, ACTUATOR_BIT_ABS));
+    TEST_ASSERT_TRUE(actuatorIsActive(actuators_state, ACTUATOR_BIT_ALARM_LED));
+    TEST_ASSERT_TRUE(actuatorIsActive(actuators_state, ACTUATOR_BIT_ALARM_BUZZER));
 }
 
 
@@ -214,11 +248,11 @@ void test_updateInternalActuatorsState_DataFrame0_Active(void) {
 void test_InitialActuatorsState(void) {
     // Verifies that the initial state of the actuators is zero
     //// Test case ID: TC_AEB_A__007
-    TEST_ASSERT_FALSE(actuators_state.belt_tightness);
-    TEST_ASSERT_FALSE(actuators_state.door_lock);
-    TEST_ASSERT_FALSE(actuators_state.should_activate_abs);
-    TEST_ASSERT_FALSE(actuators_state.alarm_led);
-    TEST_ASSERT_FALSE(actuators_state.alarm_buzzer);
+    TEST_ASSERT_FALSE(actuatorIsActive(actuators_state, ACTUATOR_BIT_BELT_TIGHTNESS));
+    TEST_ASSERT_FALSE(actuatorIsActive(actuators_state, ACTUATOR_BIT_DOOR_LOCK));
+    TEST_ASSERT_FALSE(actuatorIsActive(actuators_state, ACTUATOR_BIT_ABS));
+    TEST_ASSERT_FALSE(actuatorIsActive(actuators_state, ACTUATOR_BIT_ALARM_LED));
+    TEST_ASSERT_FALSE(actuatorIsActive(actuators_state, ACTUATOR_BIT_ALARM_BUZZER));
 }
 
 /** @test 
@@ -237,11 +271,11 @@ void test_actuatorsTranslateCanMsg_Unexpected_DataFrame(void) {
 
     // Expected state: should follow the general rule of the `updateInternalActuatorsState` function
     //// Test case ID: TC_AEB_A__008
-    TEST_ASSERT_FALSE(actuators_state.belt_tightness);
-    TEST_ASSERT_TRUE(actuators_state.door_lock);
-    TEST_ASSERT_FALSE(actuators_state.should_activate_abs);
-    TEST_ASSERT_FALSE(actuators_state.alarm_led);
-    TEST_ASSERT_FALSE(actuators_state.alarm_buzzer);
+    TEST_ASSERT_FALSE(actuatorIsActive(actuators_state, ACTUATOR_BIT_BELT_TIGHTNESS));
+    TEST_ASSERT_TRUE(actuatorIsActive(actuators_state, ACTUATOR_BIT_DOOR_LOCK));
+    TEST_ASSERT_FALSE(actuatorIsActive(actuators_state, ACTUATOR_BIT_ABS));
+    TEST_ASSERT_FALSE(actuatorIsActive(actuators_state, ACTUATOR_BIT_ALARM_LED));
+    TEST_ASSERT_FALSE(actuatorIsActive(actuators_state, ACTUATOR_BIT_ALARM_BUZZER));
 }
 
 /**
@@ -284,11 +318,7 @@ int mock_mq_send(mqd_t mq, const can_msg *msg) {
  */
 void test_actuatorsResponseLoop_UnknownMessages(void) {
     //// Test case ID: TC_AEB_A__010
-    actuators_state.belt_tightness = false;
-    actuators_state.door_lock = true;
-    actuators_state.should_activate_abs = false;
-    actuators_state.alarm_led = false;
-    actuators_state.alarm_buzzer = false;
+    actuators_state = ACTUATORS_STATE_IDLE;
 
     can_msg unknown_msg = {
         .identifier = ID_AEB_S,  // Invalid identifier
@@ -308,17 +338,123 @@ void test_actuatorsResponseLoop_UnknownMessages(void) {
 
     // Checks that the actuators' state did NOT change
     //// Test case ID: TC_AEB_A__011
-    TEST_ASSERT_TRUE(actuators_state.belt_tightness);
-    TEST_ASSERT_FALSE(actuators_state.door_lock);
-    TEST_ASSERT_TRUE(actuators_state.should_activate_abs);
-    TEST_ASSERT_TRUE(actuators_state.alarm_led);
-    TEST_ASSERT_TRUE(actuators_state.alarm_buzzer);
+    TEST_ASSERT_TRUE(actuatorIsActive(actuators_state, ACTUATOR_BIT_BELT_TIGHTNESS));
+    TEST_ASSERT_FALSE(actuatorIsActive(actuators_state, ACTUATOR_BIT_DOOR_LOCK));
+    TEST_ASSERT_TRUE(actuatorIsActive(actuators_state, ACTUATOR_BIT_ABS));
+    TEST_ASSERT_TRUE(actuatorIsActive(actuators_state, ACTUATOR_BIT_ALARM_LED));
+    TEST_ASSERT_TRUE(actuatorIsActive(actuators_state, ACTUATOR_BIT_ALARM_BUZZER));
 
     // Cancels and joins the thread
     pthread_cancel(thread);
     pthread_join(thread, NULL);
 }
 
+/**
+ * @test
+ * @brief Verifies if actuatorsTranslateCanMsg applies the state carried by ID_ACTUATORS_CMD and
+ * ignores a command with unknown bits
+ * \anchor test_actuatorsTranslateCanMsg_Command
+ * test ID [TC_AEB_A__012](@ref TC_AEB_A__012)
+ */
+void test_actuatorsTranslateCanMsg_Command(void) {
+    //// Test case ID: TC_AEB_A__012
+    can_msg command = actuatorsCommandFrame(ACTUATORS_STATE_BRAKING);
+    TEST_ASSERT_EQUAL_HEX32(ID_ACTUATORS_CMD, command.identifier);
+
+    actuatorsTranslateCanMsg(command);
+    TEST_ASSERT_EQUAL_HEX8(ACTUATORS_STATE_BRAKING, actuators_state);
+
+    command.dataFrame[0] = ACTUATORS_STATE_ALARM | 0x80;
+    actuatorsTranslateCanMsg(command);
+    TEST_ASSERT_EQUAL_HEX8(ACTUATORS_STATE_BRAKING, actuators_state);
+}
+
+/**
+ * @test
+ * @brief Verifies if readActuatorsCommand reads only the newest commands of the mailbox, preferring
+ * ID_AEB_S over ID_EMPTY
+ * \anchor test_readActuatorsCommand_Mailbox
+ * test ID [TC_AEB_A__013](@ref TC_AEB_A__013)
+ */
+void test_readActuatorsCommand_Mailbox(void) {
+    //// Test case ID: TC_AEB_A__013
+    mailbox_header header;
+    can_msg command;
+    actuators_mailbox.header = &header;
+
+    TEST_ASSERT_EQUAL(-1, readActuatorsCommand(&command)); // Nothing posted yet
+
+    mock_mailbox_versions[0] = 6; // Three ID_AEB_S and one ID_EMPTY posted since
+    mock_mailbox_versions[1] = 2;
+    TEST_ASSERT_EQUAL(0, readActuatorsCommand(&command));
+    TEST_ASSERT_EQUAL_HEX32(ID_AEB_S, command.identifier);
+    TEST_ASSERT_EQUAL(6, command.dataFrame[0]);
+    TEST_ASSERT_EQUAL(-1, readActuatorsCommand(&command)); // ID_EMPTY was consumed too
+
+    mock_mailbox_versions[1] = 4; // Standby
+    TEST_ASSERT_EQUAL(0, readActuatorsCommand(&command));
+    TEST_ASSERT_EQUAL_HEX32(ID_EMPTY, command.identifier);
+    TEST_ASSERT_EQUAL(-1, readActuatorsCommand(&command));
+
+    actuators_mailbox.header = NULL;
+}
+
+/**
+ * @test
+ * @brief Verifies if actuatorsStep applies a command and logs the new state, and logs the state of
+ * the last command again when there is no command
+ * \anchor test_actuatorsStep
+ * test ID [TC_AEB_A__014](@ref TC_AEB_A__014)
+ */
+void test_actuatorsStep(void) {
+    //// Test case ID: TC_AEB_A__014
+    can_msg command = {.identifier = ID_AEB_S, .dataFrame = BASE_DATA_FRAME};
+    command.dataFrame[0] = 0x01; // Warning only
+
+    actuatorsStep(&command);
+    TEST_ASSERT_EQUAL_HEX8(ACTUATORS_STATE_ALARM, actuators_state);
+    TEST_ASSERT_EQUAL_HEX32(ID_AEB_S, mock_logged_event_id);
+    TEST_ASSERT_EQUAL_HEX8(ACTUATORS_STATE_ALARM, mock_logged_actuators);
+
+    mock_logged_event_id = 0;
+    actuatorsStep(NULL);
+    TEST_ASSERT_EQUAL_HEX8(ACTUATORS_STATE_ALARM, actuators_state);
+    TEST_ASSERT_EQUAL_HEX32(ID_AEB_S, mock_logged_event_id);
+}
+
+/**
+ * @test
+ * @brief Verifies if readActuatorsCommand reads the newest ID_ACTUATORS_CMD mask posted by a
+ * controller running with -k, and if the subscribers decode both command channels alike
+ * \anchor test_readActuatorsCommand_MaskMailbox
+ * test ID [TC_AEB_A__015](@ref TC_AEB_A__015)
+ */
+void test_readActuatorsCommand_MaskMailbox(void) {
+    //// Test case ID: TC_AEB_A__015
+    mailbox_header header;
+    can_msg command;
+    actuators_abstraction state = 0;
+    actuators_mailbox.header = &header;
+
+    mock_mailbox_versions[2] = ACTUATORS_STATE_ALARM; // The mock carries the version in dataFrame[0]
+    TEST_ASSERT_EQUAL(0, readActuatorsCommand(&command));
+    TEST_ASSERT_EQUAL_HEX32(ID_ACTUATORS_CMD, command.identifier);
+    TEST_ASSERT_EQUAL(1, actuatorsStateFromCommand(&command, &state));
+    TEST_ASSERT_EQUAL_HEX8(ACTUATORS_STATE_ALARM, state);
+    TEST_ASSERT_EQUAL(-1, readActuatorsCommand(&command));
+
+    can_msg aeb_s = {.identifier = ID_AEB_S, .dataFrame = BASE_DATA_FRAME};
+    aeb_s.dataFrame[1] = 0x01; // Brake
+    TEST_ASSERT_EQUAL(1, actuatorsStateFromCommand(&aeb_s, &state));
+    TEST_ASSERT_EQUAL_HEX8(ACTUATORS_STATE_BRAKING, state);
+    can_msg empty = {.identifier = ID_EMPTY, .dataFrame = BASE_DATA_FRAME};
+    TEST_ASSERT_EQUAL(0, actuatorsStateFromCommand(&empty, &state));
+    can_msg invalid = actuatorsCommandFrame(0x80);
+    TEST_ASSERT_EQUAL(0, actuatorsStateFromCommand(&invalid, &state));
+    TEST_ASSERT_EQUAL_HEX8(ACTUATORS_STATE_BRAKING, state);
+
+    actuators_mailbox.header = NULL;
+}
 
 int main(void) {
     UNITY_BEGIN();
@@ -330,6 +466,10 @@ int main(void) {
     RUN_TEST(test_updateInternalActuatorsState_DataFrame0_Active);
     RUN_TEST(test_InitialActuatorsState);
     RUN_TEST(test_actuatorsTranslateCanMsg_Unexpected_DataFrame);
+    RUN_TEST(test_actuatorsTranslateCanMsg_Command);
+    RUN_TEST(test_readActuatorsCommand_Mailbox);
+    RUN_TEST(test_actuatorsStep);
+    RUN_TEST(test_readActuatorsCommand_MaskMailbox);
     RUN_TEST(test_actuatorsResponseLoop_UnknownMessages);
     return UNITY_END();
 }
@@ -0,0 +1,68 @@
+#include "unity.h"
+#include "aeb.h"
+
+// Mocks of the programs: each returns its own value, so the program found is known
+int main_main(int argc, char *argv[]) { return 1; }
+int sensors_main(int argc, char *argv[]) { return 2; }
+int aeb_controller_main(int argc, char *argv[]) { return 3; }
+int actuators_main(int argc, char *argv[]) { return 4; }
+int actuator_subscriber_main(int argc, char *argv[]) { return 5; }
+int aeb_loop_main(int argc, char *argv[]) { return 6; }
+int aeb_logcat_main(int argc, char *argv[]) { return 7; }
+int aeb_logq_main(int argc, char *argv[]) { return 8; }
+int aeb_sketch_main(int argc, char *argv[]) { return 9; }
+int aeb_flightrec_main(int argc, char *argv[]) { return 10; }
+int aeb_calibrate_main(int argc, char *argv[]) { return 11; }
+int aeb_stat_main(int argc, char *argv[]) { return 12; }
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+/**
+ * @test
+ * @brief Tests that a program is found by its name, with or without the `_bin` suffix.
+ *
+ * \anchor test_find_program_names
+ * test ID [TC_AEB_MULTICALL_001](@ref TC_AEB_MULTICALL_001)
+ */
+void test_find_program_names()
+{
+    const aeb_program *program = find_program("sensors_bin");
+    TEST_ASSERT_NOT_NULL(program);
+    TEST_ASSERT_EQUAL_STRING("sensors_bin", program->name);
+    TEST_ASSERT_EQUAL(2, program->program_main(0, NULL));
+
+    TEST_ASSERT_EQUAL_PTR(program, find_program("sensors"));
+    TEST_ASSERT_EQUAL(1, find_program("main")->program_main(0, NULL));
+    TEST_ASSERT_EQUAL(5, find_program("actuator_sub")->program_main(0, NULL));
+    TEST_ASSERT_EQUAL(12, find_program("aeb_stat")->program_main(0, NULL));
+}
+
+/**
+ * @test
+ * @brief Tests that an unknown name, a prefix of a name or a suffix other than `_bin` is not found.
+ *
+ * \anchor test_find_program_unknown
+ * test ID [TC_AEB_MULTICALL_002](@ref TC_AEB_MULTICALL_002)
+ */
+void test_find_program_unknown()
+{
+    TEST_ASSERT_NULL(find_program("unknown"));
+    TEST_ASSERT_NULL(find_program(""));
+    TEST_ASSERT_NULL(find_program("sens"));
+    TEST_ASSERT_NULL(find_program("aeb_stat_bin"));
+    TEST_ASSERT_NULL(find_program("sensors_bin_bin"));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_find_program_names);
+    RUN_TEST(test_find_program_unknown);
+    return UNITY_END();
+}
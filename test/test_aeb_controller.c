@@ -5,6 +5,11 @@
 #include "dbc.h"
 #include <mqueue.h>
 #include "ttc_control.h"
+#include "flight_recorder.h"
+#include "aeb_stats.h"
+#include "calibration.h"
+#include "metrics.h"
+#include "actuators.h"
 
 /**
  * @brief Enumeration of AEB controller states.
@@ -21,6 +26,9 @@ extern sensors_input_data aeb_internal_state; /**< Internal AEB system state dat
 extern can_msg captured_can_frame; /**< Captured CAN message */
 extern can_msg out_can_frame; /**< Output CAN message */
 extern can_msg empty_msg; /**< Empty CAN message */
+extern aeb_calibration active_calibration; /**< Calibration snapshot used by getAEBState */
+extern metrics controller_metrics; /**< Metrics block of the controller thread */
+extern bool mask_commands; /**< Commands sent as ID_ACTUATORS_CMD masks (-k) */
 
 void translateAndCallCanMsg(can_msg captured_frame);
 void updateInternalPedalsState(can_msg captured_frame);
@@ -29,6 +37,7 @@ void updateInternalObstacleState(can_msg captured_frame);
 void updateInternalCarCState(can_msg captured_frame);
 can_msg updateCanMsgOutput(aeb_controller_state state);
 aeb_controller_state getAEBState(sensors_input_data aeb_internal_state, double ttc);
+can_msg aebControllerStep(can_msg captured_frame, aeb_stats *stats, long now_ms);
 
 /**
  * @brief Mock function to simulate opening a message queue.
@@ -66,6 +75,35 @@ int read_mq(mqd_t mq, can_msg *msg) {
     return 0;  // Simulate success in reading the message
 }
 
+/**
+ * @brief Mocks of the flight recorder and of the run statistics, which record the last decision.
+ */
+int mock_decision_state = -1;
+long mock_decision_now_ms = -1;
+
+void flight_recorder_decision(uint8_t state, double ttc) {
+    mock_decision_state = state;
+}
+
+void aeb_stats_update(aeb_stats *stats, int state, double ttc, long now_ms) {
+    mock_decision_now_ms = now_ms;
+}
+
+/**
+ * @brief Mock of the calibration block: mock_calibration is returned once as a new snapshot
+ * when mock_calibration_pending is set, otherwise the block is not attached.
+ */
+int mock_calibration_pending = 0;
+aeb_calibration mock_calibration;
+
+int calibration_snapshot(calibration *cal, aeb_calibration *values) {
+    if (!mock_calibration_pending)
+        return -1;
+    mock_calibration_pending = 0;
+    *values = mock_calibration;
+    return 1;
+}
+
 /**
  * @brief Setup function to initialize AEB input state before each test.
  */
@@ -1367,6 +1405,216 @@ void test_TC_AEB_CTRL_024(void)
     TEST_ASSERT_TRUE(aeb_internal_state.aeb_system_enabled);  // AEB system should be ON
 }
 
+/**
+ * @brief Test Case TC_AEB_CTRL_025: aebControllerStep decides on a frame and returns the command
+ * 
+ * This test case verifies that one step of the controller applies the received frame to the
+ * internal state, decides the AEB state from the resulting TTC, records the decision and returns
+ * the command for the actuators.
+ * 
+ * @details
+ * The test uses the following inputs:
+ * - An internal state at 40 km/h with an obstacle 5 meters ahead (TTC below the braking threshold).
+ * - A `ID_CAR_C` frame with the AEB system ON, then one with the AEB system OFF.
+ * 
+ * The expected result is that:
+ * - The first step returns an `ID_AEB_S` command with warning and braking active, and the
+ *   decision is recorded as BRAKE at the given time.
+ * - The second step returns the empty message (standby state).
+ * 
+ * @anchor TC_AEB_CTRL_025
+ */
+void test_TC_AEB_CTRL_025(void)
+{
+    aeb_stats stats;
+    can_msg car_c = {.identifier = ID_CAR_C, .dataFrame = BASE_DATA_FRAME};
+
+    aeb_internal_state.relative_velocity = 40.0;
+    aeb_internal_state.has_obstacle = true;
+    aeb_internal_state.obstacle_distance = 5.0;
+
+    car_c.dataFrame[0] = 0x01; // AEB system ON
+    can_msg command = aebControllerStep(car_c, &stats, 1200);
+    TEST_ASSERT_EQUAL_HEX32(ID_AEB_S, command.identifier);
+    TEST_ASSERT_EQUAL_HEX8(0x01, command.dataFrame[0]); // Warning
+    TEST_ASSERT_EQUAL_HEX8(0x01, command.dataFrame[1]); // Braking
+    TEST_ASSERT_EQUAL(AEB_STATE_BRAKE, mock_decision_state);
+    TEST_ASSERT_EQUAL(1200, mock_decision_now_ms);
+
+    car_c.dataFrame[0] = 0x00; // AEB system OFF
+    command = aebControllerStep(car_c, &stats, 1400);
+    TEST_ASSERT_EQUAL_HEX32(ID_EMPTY, command.identifier);
+    TEST_ASSERT_EQUAL(AEB_STATE_STANDBY, mock_decision_state);
+}
+
+/**
+ * @brief Test Case TC_AEB_CTRL_026: aebControllerStep decides with the calibration snapshot of its cycle
+ * 
+ * This test case verifies that the thresholds retuned in the calibration block are taken at the
+ * start of a step and used by the decision of that step, instead of the compile-time values.
+ * 
+ * @details
+ * The test uses the following inputs:
+ * - An internal state at 40 km/h with an obstacle 10 meters ahead (TTC of 0.9 s, below the
+ *   default braking threshold).
+ * - A new calibration with an alarm threshold of 3.0 s and a braking threshold of 0.5 s.
+ * 
+ * The expected result is that:
+ * - With the default calibration the step decides BRAKE.
+ * - Once the new calibration is published, the next step decides ALARM.
+ * 
+ * @anchor TC_AEB_CTRL_026
+ */
+void test_TC_AEB_CTRL_026(void)
+{
+    aeb_stats stats;
+    aeb_calibration defaults = CALIBRATION_DEFAULTS;
+    can_msg car_c = {.identifier = ID_CAR_C, .dataFrame = BASE_DATA_FRAME};
+    car_c.dataFrame[0] = 0x01; // AEB system ON
+
+    aeb_internal_state.relative_velocity = 40.0;
+    aeb_internal_state.has_obstacle = true;
+    aeb_internal_state.obstacle_distance = 10.0;
+
+    aebControllerStep(car_c, &stats, 200);
+    TEST_ASSERT_EQUAL(AEB_STATE_BRAKE, mock_decision_state);
+
+    mock_calibration = defaults;
+    mock_calibration.threshold_alarm = 3.0;
+    mock_calibration.threshold_braking = 0.5;
+    mock_calibration_pending = 1;
+    aebControllerStep(car_c, &stats, 400);
+    TEST_ASSERT_EQUAL(AEB_STATE_ALARM, mock_decision_state);
+    TEST_ASSERT_EQUAL_DOUBLE(0.5, active_calibration.threshold_braking);
+
+    active_calibration = defaults;
+}
+
+/**
+ * @brief Test Case TC_AEB_CTRL_027: getAEBState interpolates the alarm threshold of a speed map
+ * 
+ * This test case verifies that when the alarm threshold is calibrated as a map by speed, the
+ * decision uses the threshold interpolated at the current speed instead of the scalar value.
+ * 
+ * @details
+ * The test uses the following inputs:
+ * - An alarm map from 1.5 s at 10 km/h to 3.0 s at 60 km/h (2.7 s at 50 km/h, 1.8 s at 20 km/h).
+ * - A TTC of 2.5 s, above the default alarm threshold.
+ * 
+ * The expected result is that:
+ * - At 50 km/h the AEB system is in ALARM state.
+ * - At 20 km/h the AEB system stays ACTIVE.
+ * 
+ * @anchor TC_AEB_CTRL_027
+ */
+void test_TC_AEB_CTRL_027(void)
+{
+    aeb_calibration defaults = CALIBRATION_DEFAULTS;
+    calibration_map *alarm = &active_calibration.alarm_map;
+    alarm->speed_points = 2;
+    alarm->value_count = 2;
+    for (int k = 0; k < CALIBRATION_MAP_POINTS; k++)
+    {
+        alarm->speed[k] = INFINITY; // Prepared map: unused breakpoints hold +inf
+    }
+    alarm->speed[0] = 10.0;
+    alarm->speed[1] = 60.0;
+    alarm->value[0] = 1.5;
+    alarm->value[1] = 3.0;
+    alarm->slope[0] = (3.0 - 1.5) / (60.0 - 10.0);
+
+    aeb_internal_state.relative_velocity = 50.0;
+    TEST_ASSERT_EQUAL(AEB_STATE_ALARM, getAEBState(aeb_internal_state, 2.5));
+    aeb_internal_state.relative_velocity = 20.0;
+    TEST_ASSERT_EQUAL(AEB_STATE_ACTIVE, getAEBState(aeb_internal_state, 2.5));
+
+    active_calibration = defaults;
+}
+
+/**
+ * @brief Test Case TC_AEB_CTRL_028: aebControllerStep counts its decisions per state in the metrics
+ * 
+ * This test case verifies that each decision adds one to the counter of its state in the
+ * metrics block of the controller, and that nothing is published without a block.
+ * 
+ * @details
+ * The test uses the following inputs:
+ * - A metrics block registered for the controller (the decision counters follow frames_in,
+ *   commands_out and send_errors, in the order of the states).
+ * - Two steps at 40 km/h with an obstacle 10 meters ahead, then one step with the AEB system OFF.
+ * - One more step once the block is unregistered.
+ * 
+ * The expected result is that:
+ * - The BRAKE counter is 2 and the STANDBY counter is 1; the other states are 0.
+ * - The step without a block leaves the counters unchanged.
+ * 
+ * @anchor TC_AEB_CTRL_028
+ */
+void test_TC_AEB_CTRL_028(void)
+{
+    static metrics_block block;
+    aeb_stats stats;
+    can_msg car_c = {.identifier = ID_CAR_C, .dataFrame = BASE_DATA_FRAME};
+    controller_metrics.block = &block;
+
+    aeb_internal_state.relative_velocity = 40.0;
+    aeb_internal_state.has_obstacle = true;
+    aeb_internal_state.obstacle_distance = 10.0;
+    car_c.dataFrame[0] = 0x01; // AEB system ON
+    aebControllerStep(car_c, &stats, 200);
+    aebControllerStep(car_c, &stats, 400);
+    car_c.dataFrame[0] = 0x00; // AEB system OFF
+    aebControllerStep(car_c, &stats, 600);
+
+    const int decisions = 3;
+    TEST_ASSERT_EQUAL_UINT64(0, block.value[decisions + AEB_STATE_ACTIVE]);
+    TEST_ASSERT_EQUAL_UINT64(0, block.value[decisions + AEB_STATE_ALARM]);
+    TEST_ASSERT_EQUAL_UINT64(2, block.value[decisions + AEB_STATE_BRAKE]);
+    TEST_ASSERT_EQUAL_UINT64(1, block.value[decisions + AEB_STATE_STANDBY]);
+
+    controller_metrics.block = NULL;
+    aebControllerStep(car_c, &stats, 800);
+    TEST_ASSERT_EQUAL_UINT64(1, block.value[decisions + AEB_STATE_STANDBY]);
+}
+
+/**
+ * @brief Test Case TC_AEB_CTRL_029: with -k, aebControllerStep commands the actuators with a state mask
+ * 
+ * This test case verifies that the controller sends the actuators state as a one-byte
+ * ID_ACTUATORS_CMD mask instead of the ID_AEB_S frame, and still the empty message in standby.
+ * 
+ * @details
+ * The test uses the following inputs:
+ * - Mask commands enabled.
+ * - A step at 40 km/h with an obstacle 5 meters ahead (braking), then one with the AEB system OFF.
+ * 
+ * The expected result is that:
+ * - The first step returns an `ID_ACTUATORS_CMD` frame carrying `ACTUATORS_STATE_BRAKING`.
+ * - The second step returns the empty message (standby state).
+ * 
+ * @anchor TC_AEB_CTRL_029
+ */
+void test_TC_AEB_CTRL_029(void)
+{
+    aeb_stats stats;
+    can_msg car_c = {.identifier = ID_CAR_C, .dataFrame = BASE_DATA_FRAME};
+    mask_commands = true;
+
+    aeb_internal_state.relative_velocity = 40.0;
+    aeb_internal_state.has_obstacle = true;
+    aeb_internal_state.obstacle_distance = 5.0;
+    car_c.dataFrame[0] = 0x01; // AEB system ON
+    can_msg command = aebControllerStep(car_c, &stats, 200);
+    TEST_ASSERT_EQUAL_HEX32(ID_ACTUATORS_CMD, command.identifier);
+    TEST_ASSERT_EQUAL_HEX8(ACTUATORS_STATE_BRAKING, command.dataFrame[0]);
+
+    car_c.dataFrame[0] = 0x00; // AEB system OFF
+    command = aebControllerStep(car_c, &stats, 400);
+    TEST_ASSERT_EQUAL_HEX32(ID_EMPTY, command.identifier);
+
+    mask_commands = false;
+}
+
 /**
  * @brief Test Case: Unknown identifier should print "CAN Identifier unknown"
  * 
@@ -1920,6 +2168,11 @@ int main(void) {
     RUN_TEST(test_TC_AEB_CTRL_022);
     RUN_TEST(test_TC_AEB_CTRL_023);
     RUN_TEST(test_TC_AEB_CTRL_024);
+    RUN_TEST(test_TC_AEB_CTRL_025);
+    RUN_TEST(test_TC_AEB_CTRL_026);
+    RUN_TEST(test_TC_AEB_CTRL_027);
+    RUN_TEST(test_TC_AEB_CTRL_028);
+    RUN_TEST(test_TC_AEB_CTRL_029);
     RUN_TEST(test_TC_AEB_CTRL_X12);
     RUN_TEST(test_TC_AEB_CTRL_X13);
     RUN_TEST(test_TC_AEB_CTRL_X14);
@@ -0,0 +1,110 @@
+#include "unity.h"
+#include "aeb_stats.h"
+#include <string.h>
+
+#define TEST_STATS "test/test_stats.qsk"
+
+aeb_stats stats_test, loaded_test;
+
+void setUp()
+{
+    aeb_stats_init(&stats_test);
+    aeb_stats_init(&loaded_test);
+    remove(TEST_STATS);
+}
+
+void tearDown()
+{
+    remove(TEST_STATS);
+}
+
+/**
+ * @test
+ * @brief Tests the time spent in each state and the alarm-to-brake lead time of a decision sequence.
+ *
+ * \anchor test_aeb_stats_dwell_and_lead_time
+ * test ID [TC_AEB_STATS_001](@ref TC_AEB_STATS_001)
+ */
+void test_aeb_stats_dwell_and_lead_time()
+{
+    aeb_stats_update(&stats_test, AEB_STATS_STATE_ACTIVE, 5.0, 0);
+    aeb_stats_update(&stats_test, AEB_STATS_STATE_ACTIVE, 4.0, 1000);
+    aeb_stats_update(&stats_test, AEB_STATS_STATE_ALARM, 1.5, 2000);
+    aeb_stats_update(&stats_test, AEB_STATS_STATE_BRAKE, 0.8, 2600);
+    aeb_stats_update(&stats_test, AEB_STATS_STATE_STANDBY, 99.0, 4600);
+    aeb_stats_update(&stats_test, AEB_STATS_STATE_ALARM, 1.5, 5000);
+    aeb_stats_update(&stats_test, AEB_STATS_STATE_ACTIVE, 3.0, 6000);
+    aeb_stats_update(&stats_test, AEB_STATS_STATE_BRAKE, 0.5, 7000);
+    aeb_stats_finish(&stats_test, 8000);
+
+    const qsketch *active = &stats_test.sketches[AEB_STATS_DWELL + AEB_STATS_STATE_ACTIVE];
+    const qsketch *alarm = &stats_test.sketches[AEB_STATS_DWELL + AEB_STATS_STATE_ALARM];
+    const qsketch *brake = &stats_test.sketches[AEB_STATS_DWELL + AEB_STATS_STATE_BRAKE];
+    const qsketch *lead = &stats_test.sketches[AEB_STATS_ALARM_TO_BRAKE];
+
+    TEST_ASSERT_EQUAL_UINT64(2, active->count);
+    TEST_ASSERT_EQUAL_DOUBLE(3.0, active->sum);
+    TEST_ASSERT_EQUAL_UINT64(2, alarm->count);
+    TEST_ASSERT_EQUAL_DOUBLE(1.6, alarm->sum);
+    TEST_ASSERT_EQUAL_UINT64(2, brake->count);
+    TEST_ASSERT_EQUAL_DOUBLE(3.0, brake->sum);
+    // Only the first brake follows an alarm
+    TEST_ASSERT_EQUAL_UINT64(1, lead->count);
+    TEST_ASSERT_EQUAL_DOUBLE(0.6, lead->sum);
+}
+
+/**
+ * @test
+ * @brief Tests that only the TTC of a possible collision is added.
+ *
+ * \anchor test_aeb_stats_ttc
+ * test ID [TC_AEB_STATS_002](@ref TC_AEB_STATS_002)
+ */
+void test_aeb_stats_ttc()
+{
+    aeb_stats_update(&stats_test, AEB_STATS_STATE_ACTIVE, 2.5, 0);
+    aeb_stats_update(&stats_test, AEB_STATS_STATE_ACTIVE, AEB_STATS_TTC_MAX, 200);
+    aeb_stats_update(&stats_test, AEB_STATS_STATE_ACTIVE, -1.0, 400);
+    aeb_stats_update(&stats_test, AEB_STATS_STATE_ACTIVE, 1.5, 600);
+
+    TEST_ASSERT_EQUAL_UINT64(2, stats_test.sketches[AEB_STATS_TTC].count);
+    TEST_ASSERT_EQUAL_DOUBLE(1.5, stats_test.sketches[AEB_STATS_TTC].min);
+    TEST_ASSERT_EQUAL_DOUBLE(2.5, stats_test.sketches[AEB_STATS_TTC].max);
+}
+
+/**
+ * @test
+ * @brief Tests that saved statistics are loaded back and merged, and that an invalid file is rejected.
+ *
+ * \anchor test_aeb_stats_save_load_merge
+ * test ID [TC_AEB_STATS_003](@ref TC_AEB_STATS_003)
+ */
+void test_aeb_stats_save_load_merge()
+{
+    for (int i = 1; i <= 100; i++)
+    {
+        aeb_stats_update(&stats_test, AEB_STATS_STATE_ACTIVE, i * 0.05, i * 100);
+    }
+    TEST_ASSERT_EQUAL(0, aeb_stats_save(&stats_test, TEST_STATS));
+    TEST_ASSERT_EQUAL(0, aeb_stats_load(&loaded_test, TEST_STATS));
+    TEST_ASSERT_EQUAL_MEMORY(&stats_test.sketches, &loaded_test.sketches, sizeof(stats_test.sketches));
+
+    aeb_stats_merge(&loaded_test, &stats_test);
+    TEST_ASSERT_EQUAL_UINT64(200, loaded_test.sketches[AEB_STATS_TTC].count);
+    TEST_ASSERT_DOUBLE_WITHIN(0.03, 2.5, qsketch_quantile(&loaded_test.sketches[AEB_STATS_TTC], 0.5));
+
+    FILE *file = fopen(TEST_STATS, "w");
+    fputs("not a statistics file", file);
+    fclose(file);
+    TEST_ASSERT_EQUAL(-1, aeb_stats_load(&loaded_test, TEST_STATS));
+    TEST_ASSERT_EQUAL_UINT64(0, loaded_test.sketches[AEB_STATS_TTC].count);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_aeb_stats_dwell_and_lead_time);
+    RUN_TEST(test_aeb_stats_ttc);
+    RUN_TEST(test_aeb_stats_save_load_merge);
+    return UNITY_END();
+}
@@ -0,0 +1,171 @@
+#include "unity.h"
+#include "broadcast_ring.h"
+#include "dbc.h"
+
+#define TEST_SHM "/shm_aeb_test_broadcast"
+#define TEST_CAPACITY 8
+
+broadcast_ring ring_test;
+
+void setUp()
+{
+    broadcast_destroy(TEST_SHM);
+    TEST_ASSERT_EQUAL(0, broadcast_create(TEST_SHM, TEST_CAPACITY));
+    TEST_ASSERT_EQUAL(0, broadcast_attach(&ring_test, TEST_SHM));
+}
+
+void tearDown()
+{
+    broadcast_detach(&ring_test);
+    broadcast_destroy(TEST_SHM);
+}
+
+/**
+ * @brief Helper function, publishes frames [first, last), frame i carrying i in its first byte.
+ */
+void publish_test(int first, int last)
+{
+    can_msg frame = {.identifier = ID_AEB_S, .dataFrame = BASE_DATA_FRAME};
+    for (int i = first; i < last; i++)
+    {
+        frame.dataFrame[0] = (uint8_t)i;
+        broadcast_publish(&ring_test, &frame);
+    }
+}
+
+/**
+ * @test
+ * @brief Tests that every reader receives every published frame, in order.
+ *
+ * \anchor test_broadcast_every_reader
+ * test ID [TC_BROADCAST_001](@ref TC_BROADCAST_001)
+ */
+void test_broadcast_every_reader()
+{
+    broadcast_reader readers[3];
+    can_msg frame;
+
+    for (int r = 0; r < 3; r++)
+    {
+        TEST_ASSERT_EQUAL(0, broadcast_subscribe(&ring_test, &readers[r]));
+    }
+    publish_test(0, TEST_CAPACITY);
+
+    for (int r = 0; r < 3; r++)
+    {
+        for (int i = 0; i < TEST_CAPACITY; i++)
+        {
+            TEST_ASSERT_EQUAL(0, broadcast_read(&readers[r], &frame, NULL));
+            TEST_ASSERT_EQUAL_HEX32(ID_AEB_S, frame.identifier);
+            TEST_ASSERT_EQUAL(i, frame.dataFrame[0]);
+        }
+        TEST_ASSERT_EQUAL(-1, broadcast_read(&readers[r], &frame, NULL));
+        TEST_ASSERT_EQUAL(0, atomic_load(&readers[r].cursor->lost));
+        broadcast_unsubscribe(&readers[r]);
+    }
+}
+
+/**
+ * @test
+ * @brief Tests that a reader starts at the next published frame and that waiting on an up to date
+ * reader times out.
+ *
+ * \anchor test_broadcast_late_reader
+ * test ID [TC_BROADCAST_002](@ref TC_BROADCAST_002)
+ */
+void test_broadcast_late_reader()
+{
+    broadcast_reader reader;
+    can_msg frame;
+
+    publish_test(0, 3);
+    TEST_ASSERT_EQUAL(0, broadcast_subscribe(&ring_test, &reader));
+    TEST_ASSERT_EQUAL(-1, broadcast_read(&reader, &frame, NULL));
+    TEST_ASSERT_EQUAL(-1, broadcast_wait(&reader, 10));
+
+    publish_test(3, 4);
+    TEST_ASSERT_EQUAL(0, broadcast_wait(&reader, 10));
+    TEST_ASSERT_EQUAL(0, broadcast_read(&reader, &frame, NULL));
+    TEST_ASSERT_EQUAL(3, frame.dataFrame[0]);
+    broadcast_unsubscribe(&reader);
+}
+
+/**
+ * @test
+ * @brief Tests that a reader lapped by the writer resumes at the oldest frame kept and counts the
+ * frames it lost.
+ *
+ * \anchor test_broadcast_lapped_reader
+ * test ID [TC_BROADCAST_003](@ref TC_BROADCAST_003)
+ */
+void test_broadcast_lapped_reader()
+{
+    broadcast_reader reader;
+    can_msg frame;
+
+    TEST_ASSERT_EQUAL(0, broadcast_subscribe(&ring_test, &reader));
+    publish_test(0, TEST_CAPACITY + 5);
+
+    TEST_ASSERT_EQUAL(0, broadcast_read(&reader, &frame, NULL));
+    TEST_ASSERT_EQUAL(5, frame.dataFrame[0]);
+    TEST_ASSERT_EQUAL(5, atomic_load(&reader.cursor->lost));
+    TEST_ASSERT_EQUAL(5 + 1, atomic_load(&reader.cursor->position));
+    broadcast_unsubscribe(&reader);
+}
+
+/**
+ * @test
+ * @brief Tests that no more than BROADCAST_MAX_READERS readers subscribe at the same time and that
+ * a released cursor can be claimed again.
+ *
+ * \anchor test_broadcast_max_readers
+ * test ID [TC_BROADCAST_004](@ref TC_BROADCAST_004)
+ */
+void test_broadcast_max_readers()
+{
+    broadcast_reader readers[BROADCAST_MAX_READERS + 1];
+
+    for (int r = 0; r < BROADCAST_MAX_READERS; r++)
+    {
+        TEST_ASSERT_EQUAL(0, broadcast_subscribe(&ring_test, &readers[r]));
+    }
+    TEST_ASSERT_EQUAL(-1, broadcast_subscribe(&ring_test, &readers[BROADCAST_MAX_READERS]));
+
+    broadcast_unsubscribe(&readers[3]);
+    TEST_ASSERT_EQUAL(0, broadcast_subscribe(&ring_test, &readers[BROADCAST_MAX_READERS]));
+    TEST_ASSERT_EQUAL_PTR(&ring_test.header->cursors[3], readers[BROADCAST_MAX_READERS].cursor);
+}
+
+/**
+ * @test
+ * @brief Tests that a ring whose capacity is zero or not a power of two is not attached.
+ *
+ * \anchor test_broadcast_attach_invalid_capacity
+ * test ID [TC_BROADCAST_005](@ref TC_BROADCAST_005)
+ */
+void test_broadcast_attach_invalid_capacity()
+{
+    broadcast_ring ring;
+
+    ring_test.header->capacity = 0;
+    TEST_ASSERT_EQUAL(-1, broadcast_attach(&ring, TEST_SHM));
+    TEST_ASSERT_NULL(ring.header);
+
+    ring_test.header->capacity = TEST_CAPACITY - 2;
+    TEST_ASSERT_EQUAL(-1, broadcast_attach(&ring, TEST_SHM));
+
+    ring_test.header->capacity = TEST_CAPACITY;
+    TEST_ASSERT_EQUAL(0, broadcast_attach(&ring, TEST_SHM));
+    broadcast_detach(&ring);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_broadcast_every_reader);
+    RUN_TEST(test_broadcast_late_reader);
+    RUN_TEST(test_broadcast_lapped_reader);
+    RUN_TEST(test_broadcast_max_readers);
+    RUN_TEST(test_broadcast_attach_invalid_capacity);
+    return UNITY_END();
+}
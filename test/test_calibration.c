@@ -0,0 +1,223 @@
+#include "unity.h"
+#include "calibration.h"
+
+#define TEST_SHM "/shm_aeb_test_calibration"
+#define TEST_FILE "test/test_calibration.txt"
+
+calibration cal_test;
+aeb_calibration defaults = CALIBRATION_DEFAULTS;
+
+void setUp()
+{
+    calibration_destroy(TEST_SHM);
+    TEST_ASSERT_EQUAL(0, calibration_create(TEST_SHM, &defaults));
+    TEST_ASSERT_EQUAL(0, calibration_attach(&cal_test, TEST_SHM));
+}
+
+void tearDown()
+{
+    calibration_detach(&cal_test);
+    calibration_destroy(TEST_SHM);
+    remove(TEST_FILE);
+}
+
+/**
+ * @test
+ * @brief Tests that a snapshot copies the values once per update, and that updates are seen by
+ * the next snapshot.
+ *
+ * \anchor test_calibration_snapshot_update
+ * test ID [TC_CALIBRATION_001](@ref TC_CALIBRATION_001)
+ */
+void test_calibration_snapshot_update()
+{
+    aeb_calibration values = {0};
+
+    TEST_ASSERT_EQUAL(1, calibration_snapshot(&cal_test, &values));
+    TEST_ASSERT_EQUAL_DOUBLE(THRESHOLD_ALARM, values.threshold_alarm);
+    TEST_ASSERT_EQUAL_DOUBLE(MAX_SPD_ENABLED, values.max_spd_enabled);
+    TEST_ASSERT_EQUAL(0, calibration_snapshot(&cal_test, &values)); // Unchanged
+
+    aeb_calibration retuned = defaults;
+    retuned.threshold_alarm = 2.5;
+    retuned.min_spd_enabled = 5.0;
+    TEST_ASSERT_EQUAL(0, calibration_write(&cal_test, &retuned));
+    TEST_ASSERT_EQUAL(1, calibration_snapshot(&cal_test, &values));
+    TEST_ASSERT_EQUAL_DOUBLE(2.5, values.threshold_alarm);
+    TEST_ASSERT_EQUAL_DOUBLE(5.0, values.min_spd_enabled);
+    TEST_ASSERT_EQUAL_DOUBLE(THRESHOLD_BRAKING, values.threshold_braking);
+
+    calibration detached = {.header = NULL};
+    TEST_ASSERT_EQUAL(-1, calibration_snapshot(&detached, &values));
+    TEST_ASSERT_EQUAL(-1, calibration_write(&detached, &retuned));
+}
+
+/**
+ * @test
+ * @brief Tests that invalid values are rejected without touching the block, and that a snapshot
+ * keeps the previous values while the block is being written.
+ *
+ * \anchor test_calibration_invalid_and_busy
+ * test ID [TC_CALIBRATION_002](@ref TC_CALIBRATION_002)
+ */
+void test_calibration_invalid_and_busy()
+{
+    aeb_calibration values;
+    TEST_ASSERT_EQUAL(1, calibration_snapshot(&cal_test, &values));
+
+    aeb_calibration invalid = defaults;
+    invalid.threshold_braking = invalid.threshold_alarm + 1.0; // Brakes before the alarm
+    TEST_ASSERT_EQUAL(-1, calibration_write(&cal_test, &invalid));
+    invalid = defaults;
+    invalid.min_spd_enabled = invalid.max_spd_enabled + 1.0; // Empty speed range
+    TEST_ASSERT_EQUAL(-1, calibration_write(&cal_test, &invalid));
+    TEST_ASSERT_EQUAL(-1, calibration_create(TEST_SHM, &invalid));
+    TEST_ASSERT_EQUAL(0, calibration_snapshot(&cal_test, &values)); // No update was made
+
+    // A writer holds the block: the reader keeps its snapshot instead of waiting
+    atomic_fetch_add(&cal_test.header->sequence, 1);
+    cal_test.header->values.threshold_alarm = 9.0;
+    TEST_ASSERT_EQUAL(0, calibration_snapshot(&cal_test, &values));
+    TEST_ASSERT_EQUAL_DOUBLE(THRESHOLD_ALARM, values.threshold_alarm);
+    atomic_fetch_add(&cal_test.header->sequence, 1);
+    TEST_ASSERT_EQUAL(1, calibration_snapshot(&cal_test, &values));
+    TEST_ASSERT_EQUAL_DOUBLE(9.0, values.threshold_alarm);
+}
+
+/**
+ * @test
+ * @brief Tests the calibration file format: comments, partial files, unknown names and invalid
+ * values.
+ *
+ * \anchor test_calibration_load_file
+ * test ID [TC_CALIBRATION_003](@ref TC_CALIBRATION_003)
+ */
+void test_calibration_load_file()
+{
+    aeb_calibration values = defaults;
+
+    FILE *file = fopen(TEST_FILE, "w");
+    fprintf(file, "# Retuned thresholds\n\nthreshold_alarm = 3.0\n  threshold_braking=1.5\n");
+    fclose(file);
+    TEST_ASSERT_EQUAL(0, calibration_load(TEST_FILE, &values));
+    TEST_ASSERT_EQUAL_DOUBLE(3.0, values.threshold_alarm);
+    TEST_ASSERT_EQUAL_DOUBLE(1.5, values.threshold_braking);
+    TEST_ASSERT_EQUAL_DOUBLE(MIN_SPD_ENABLED, values.min_spd_enabled); // Not in the file
+
+    file = fopen(TEST_FILE, "w");
+    fprintf(file, "threshold_alarm = 4.0\nthreshold_brake = 1.0\n"); // Unknown name
+    fclose(file);
+    TEST_ASSERT_EQUAL(-1, calibration_load(TEST_FILE, &values));
+    TEST_ASSERT_EQUAL_DOUBLE(3.0, values.threshold_alarm); // Nothing applied
+
+    file = fopen(TEST_FILE, "w");
+    fprintf(file, "threshold_braking = 3.5\n"); // Above the alarm threshold
+    fclose(file);
+    TEST_ASSERT_EQUAL(-1, calibration_load(TEST_FILE, &values));
+    TEST_ASSERT_EQUAL_DOUBLE(1.5, values.threshold_braking);
+
+    TEST_ASSERT_EQUAL(-1, calibration_set(&values, "max_spd_enabled = fast"));
+    TEST_ASSERT_EQUAL(-1, calibration_set(&values, "max_spd_enabled = 70 km/h"));
+    TEST_ASSERT_EQUAL(0, calibration_set(&values, "max_spd_enabled=70"));
+    TEST_ASSERT_EQUAL_DOUBLE(70.0, values.max_spd_enabled);
+    TEST_ASSERT_EQUAL(-1, calibration_load("test/missing_calibration.txt", &values));
+}
+
+/**
+ * @test
+ * @brief Tests the interpolation of 1D and 2D threshold maps loaded from a file: values at and
+ * between the breakpoints, and held beyond them.
+ *
+ * \anchor test_calibration_maps
+ * test ID [TC_CALIBRATION_004](@ref TC_CALIBRATION_004)
+ */
+void test_calibration_maps()
+{
+    aeb_calibration values = defaults;
+
+    FILE *file = fopen(TEST_FILE, "w");
+    fprintf(file, "threshold_alarm_map.speed = 10 30 60\n"
+                  "threshold_alarm_map.value = 1.6 2.0 2.6\n"
+                  "threshold_braking_map.speed = 20 60\n"
+                  "threshold_braking_map.accel = -4 0\n"
+                  "threshold_braking_map.value = 1.0 0.8 1.4 1.0\n");
+    fclose(file);
+    TEST_ASSERT_EQUAL(0, calibration_load(TEST_FILE, &values));
+
+    const calibration_map *alarm = &values.alarm_map;
+    TEST_ASSERT_EQUAL_DOUBLE(1.6, calibration_map_eval(alarm, 10.0, 0.0));
+    TEST_ASSERT_EQUAL_DOUBLE(1.8, calibration_map_eval(alarm, 20.0, 0.0));
+    TEST_ASSERT_EQUAL_DOUBLE(2.0, calibration_map_eval(alarm, 30.0, 0.0));
+    TEST_ASSERT_EQUAL_DOUBLE(2.3, calibration_map_eval(alarm, 45.0, 0.0));
+    TEST_ASSERT_EQUAL_DOUBLE(2.6, calibration_map_eval(alarm, 60.0, 0.0));
+    TEST_ASSERT_EQUAL_DOUBLE(1.6, calibration_map_eval(alarm, 0.0, 0.0));   // Held below the first speed
+    TEST_ASSERT_EQUAL_DOUBLE(2.6, calibration_map_eval(alarm, 120.0, 0.0)); // and above the last
+
+    const calibration_map *braking = &values.braking_map;
+    TEST_ASSERT_EQUAL_DOUBLE(1.0, calibration_map_eval(braking, 20.0, -4.0));
+    TEST_ASSERT_EQUAL_DOUBLE(0.8, calibration_map_eval(braking, 20.0, 0.0));
+    TEST_ASSERT_EQUAL_DOUBLE(1.05, calibration_map_eval(braking, 40.0, -2.0)); // Center: mean of the corners
+    TEST_ASSERT_EQUAL_DOUBLE(1.4, calibration_map_eval(braking, 80.0, -9.0));
+
+    TEST_ASSERT_EQUAL_DOUBLE(THRESHOLD_ALARM, calibration_threshold(&defaults.alarm_map, THRESHOLD_ALARM, 40.0, 0.0));
+    TEST_ASSERT_EQUAL_DOUBLE(2.3, calibration_threshold(alarm, THRESHOLD_ALARM, 45.0, 0.0));
+
+    // An empty list of speeds disables the map again
+    TEST_ASSERT_EQUAL(0, calibration_set(&values, "threshold_alarm_map.speed ="));
+    TEST_ASSERT_EQUAL(0, calibration_prepare(&values));
+    TEST_ASSERT_EQUAL_DOUBLE(THRESHOLD_ALARM, calibration_threshold(alarm, THRESHOLD_ALARM, 45.0, 0.0));
+}
+
+/**
+ * @test
+ * @brief Tests that maps with a wrong shape, breakpoints that don't increase or a braking
+ * threshold not below the alarm threshold at some speed are rejected at load.
+ *
+ * \anchor test_calibration_invalid_maps
+ * test ID [TC_CALIBRATION_005](@ref TC_CALIBRATION_005)
+ */
+void test_calibration_invalid_maps()
+{
+    aeb_calibration values = defaults;
+
+    TEST_ASSERT_EQUAL(0, calibration_set(&values, "threshold_alarm_map.speed = 10 30 60"));
+    TEST_ASSERT_EQUAL(0, calibration_set(&values, "threshold_alarm_map.value = 1.6 2.0"));
+    TEST_ASSERT_EQUAL(-1, calibration_prepare(&values)); // One value missing
+
+    TEST_ASSERT_EQUAL(0, calibration_set(&values, "threshold_alarm_map.speed = 10 60 30"));
+    TEST_ASSERT_EQUAL(0, calibration_set(&values, "threshold_alarm_map.value = 1.6 2.0 2.6"));
+    TEST_ASSERT_EQUAL(-1, calibration_prepare(&values)); // Speeds don't increase
+
+    // Valid on its own, but the scalar braking threshold (1.0 s) is above 0.8 s at 10 km/h
+    TEST_ASSERT_EQUAL(0, calibration_set(&values, "threshold_alarm_map.speed = 10 30 60"));
+    TEST_ASSERT_EQUAL(0, calibration_set(&values, "threshold_alarm_map.value = 0.8 2.0 2.6"));
+    TEST_ASSERT_EQUAL(-1, calibration_prepare(&values));
+    TEST_ASSERT_EQUAL(0, calibration_set(&values, "threshold_alarm_map.value = 1.6 2.0 2.6"));
+    TEST_ASSERT_EQUAL(0, calibration_prepare(&values));
+
+    // A 2D braking map below the alarm map at its own breakpoints (0 and 100 km/h), but reaching
+    // it at a breakpoint of the alarm map (1.6 s at 10 km/h)
+    TEST_ASSERT_EQUAL(0, calibration_set(&values, "threshold_braking_map.speed = 0 100"));
+    TEST_ASSERT_EQUAL(0, calibration_set(&values, "threshold_braking_map.accel = -4 0"));
+    TEST_ASSERT_EQUAL(0, calibration_set(&values, "threshold_braking_map.value = 1.5 1.5 2.5 2.5"));
+    TEST_ASSERT_EQUAL(-1, calibration_prepare(&values));
+    TEST_ASSERT_EQUAL(0, calibration_set(&values, "threshold_braking_map.value = 1.0 1.0 1.2 1.2"));
+    TEST_ASSERT_EQUAL(0, calibration_prepare(&values));
+
+    TEST_ASSERT_EQUAL(0, calibration_set(&values, "threshold_braking_map.accel = -4"));
+    TEST_ASSERT_EQUAL(-1, calibration_prepare(&values)); // A single acceleration breakpoint
+    TEST_ASSERT_EQUAL(-1, calibration_set(&values, "threshold_braking_map.speed = 1 2 3 4 5 6 7 8 9"));
+    TEST_ASSERT_EQUAL(-1, calibration_set(&values, "threshold_braking_map.gain = 1 2"));
+    TEST_ASSERT_EQUAL(-1, calibration_set(&values, "threshold_brake_map.speed = 1 2"));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_calibration_snapshot_update);
+    RUN_TEST(test_calibration_invalid_and_busy);
+    RUN_TEST(test_calibration_load_file);
+    RUN_TEST(test_calibration_maps);
+    RUN_TEST(test_calibration_invalid_maps);
+    return UNITY_END();
+}
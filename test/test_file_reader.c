@@ -162,6 +162,70 @@ void test_read_sensor_data_eof()
     TEST_ASSERT_EQUAL(0, read_sensor_data(test_file, &test_sensor_data));
 }
 
+/** 
+ * @test
+ * @brief Tests that open_stream() skips the header of a scenario file [SwR-9] (@ref SwR-9)
+ * \anchor test_open_stream_skip_header
+ * test ID [TC_FILE_READER_005](@ref TC_FILE_READER_005)
+*/
+void test_open_stream_skip_header()
+{
+    sensors_input_data test_sensor_data;
+    test_file = open_stream("tcs/cenario.txt");
+
+    // Test Case ID: TC_FILE_READER_005
+    TEST_ASSERT_NOT_NULL(test_file);
+    TEST_ASSERT_EQUAL(1, read_sensor_data(test_file, &test_sensor_data));
+    TEST_ASSERT_EQUAL_FLOAT(60.0, test_sensor_data.obstacle_distance);
+}
+
+/** 
+ * @test
+ * @brief Tests that open_stream() keeps the first row of an input without header [SwR-9] (@ref SwR-9)
+ * \anchor test_open_stream_without_header
+ * test ID [TC_FILE_READER_006](@ref TC_FILE_READER_006)
+*/
+void test_open_stream_without_header()
+{
+    sensors_input_data test_sensor_data;
+    const char *test_filename = "test/test_stream.txt";
+    FILE *out = fopen(test_filename, "w");
+    fprintf(out, "-1.5 1 50 0 0 1 0 -2.5\n");
+    fclose(out);
+
+    test_file = open_stream(test_filename);
+
+    // Test Case ID: TC_FILE_READER_006
+    TEST_ASSERT_EQUAL(1, read_sensor_data(test_file, &test_sensor_data));
+    TEST_ASSERT_EQUAL_FLOAT(-1.5, test_sensor_data.obstacle_distance);
+    TEST_ASSERT_EQUAL_FLOAT(-2.5, test_sensor_data.relative_acceleration);
+    TEST_ASSERT_EQUAL(0, read_sensor_data(test_file, &test_sensor_data));
+
+    remove(test_filename);
+}
+
+/** 
+ * @test
+ * @brief Tests open_stream() when fopen fails
+ * \anchor test_open_stream_fopen_fail_should_exit
+ * test ID [TC_FILE_READER_007](@ref TC_FILE_READER_007)
+ */
+void test_open_stream_fopen_fail_should_exit() 
+{
+    wrap_fopen_fail = true;
+
+    // Test Case ID: TC_FILE_READER_007
+    if (setjmp(exit_env) == 0) {
+        open_stream("invalid/fifo");
+        TEST_FAIL_MESSAGE("exit() was not called as expected");
+    }
+
+    TEST_ASSERT_TRUE(wrap_perror_called);
+    TEST_ASSERT_TRUE(wrap_exit_called);
+    TEST_ASSERT_EQUAL(EXIT_FAILURE, wrap_exit_status);
+}
+
+
 
 
 
@@ -172,6 +236,9 @@ int main()
     RUN_TEST(test_open_file_not_null_and_skip_header);
     RUN_TEST(test_read_sensor_data_valid_data);
     RUN_TEST(test_read_sensor_data_eof);
+    RUN_TEST(test_open_stream_skip_header);
+    RUN_TEST(test_open_stream_without_header);
+    RUN_TEST(test_open_stream_fopen_fail_should_exit);
     return UNITY_END();
 
 }
\ No newline at end of file
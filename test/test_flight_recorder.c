@@ -0,0 +1,190 @@
+#include "unity.h"
+#include "flight_recorder.h"
+#include "dbc.h"
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#define TEST_SHM "/shm_aeb_test_flight_recorder"
+#define TEST_DUMP "test/test_flight_recorder.txt"
+#define TEST_CAPACITY 8
+
+void setUp()
+{
+    flight_recorder_destroy(TEST_SHM);
+    remove(TEST_DUMP);
+}
+
+void tearDown()
+{
+    flight_recorder_detach();
+    flight_recorder_destroy(TEST_SHM);
+    remove(TEST_DUMP);
+}
+
+/**
+ * @brief Helper function, dumps the test flight recorder and reads back one of its lines.
+ * @param index Line number, 0 being the header.
+ * @return Number of dumped entries.
+ */
+long dump_test(int index, char *line, size_t size)
+{
+    FILE *out = fopen(TEST_DUMP, "w");
+    long dumped = flight_recorder_dump(TEST_SHM, out);
+    fclose(out);
+
+    char buffer[256];
+    FILE *in = fopen(TEST_DUMP, "r");
+    for (int i = 0; i <= index && fgets(buffer, sizeof(buffer), in) != NULL; i++)
+    {
+        if (i == index && line != NULL)
+        {
+            snprintf(line, size, "%s", buffer);
+        }
+    }
+    fclose(in);
+    return dumped;
+}
+
+/**
+ * @test
+ * @brief Tests that frames, decisions and actuators states written by a process are dumped in order.
+ *
+ * \anchor test_flight_recorder_dump_entries
+ * test ID [TC_FLIGHT_REC_001](@ref TC_FLIGHT_REC_001)
+ */
+void test_flight_recorder_dump_entries()
+{
+    can_msg frame = {.identifier = ID_SPEED_S, .dataFrame = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08}};
+    actuators_abstraction actuators = ACTUATOR_BIT_ABS | ACTUATOR_BIT_ALARM_LED;
+    char line[256];
+
+    TEST_ASSERT_EQUAL(0, flight_recorder_create(TEST_SHM, TEST_CAPACITY));
+    TEST_ASSERT_EQUAL(0, flight_recorder_attach(TEST_SHM, FR_SOURCE_CONTROLLER));
+
+    flight_recorder_frame(FR_ENTRY_FRAME_RX, &frame);
+    flight_recorder_decision(3, 0.5);
+    flight_recorder_actuators(actuators);
+
+    TEST_ASSERT_EQUAL(3, dump_test(1, line, sizeof(line)));
+    TEST_ASSERT_NOT_NULL(strstr(line, "CONTROLLER | RX | 18FFFD64 | 01 02 03 04 05 06 07 08"));
+    dump_test(2, line, sizeof(line));
+    TEST_ASSERT_NOT_NULL(strstr(line, "DECISION | STATE 3 | TTC 0.500"));
+    dump_test(3, line, sizeof(line));
+    TEST_ASSERT_NOT_NULL(strstr(line, "ACTUATORS | 0 | 0 | 1 | 1 | 0"));
+}
+
+/**
+ * @test
+ * @brief Tests that after wrapping around only the last entries are kept, oldest first.
+ *
+ * \anchor test_flight_recorder_wrap_around
+ * test ID [TC_FLIGHT_REC_002](@ref TC_FLIGHT_REC_002)
+ */
+void test_flight_recorder_wrap_around()
+{
+    char line[256];
+    flight_recorder_create(TEST_SHM, TEST_CAPACITY);
+    flight_recorder_attach(TEST_SHM, FR_SOURCE_CONTROLLER);
+
+    for (int i = 0; i < 3 * TEST_CAPACITY + 2; i++)
+    {
+        flight_recorder_decision(0, i);
+    }
+
+    TEST_ASSERT_EQUAL(TEST_CAPACITY, dump_test(1, line, sizeof(line)));
+    TEST_ASSERT_NOT_NULL(strstr(line, "TTC 18.000"));
+    dump_test(TEST_CAPACITY, line, sizeof(line));
+    TEST_ASSERT_NOT_NULL(strstr(line, "TTC 25.000"));
+}
+
+/**
+ * @test
+ * @brief Tests that an entry left half written by a dead writer is skipped by the dump.
+ *
+ * \anchor test_flight_recorder_torn_entry
+ * test ID [TC_FLIGHT_REC_003](@ref TC_FLIGHT_REC_003)
+ */
+void test_flight_recorder_torn_entry()
+{
+    char line[256];
+    flight_recorder_create(TEST_SHM, TEST_CAPACITY);
+    flight_recorder_attach(TEST_SHM, FR_SOURCE_ACTUATORS);
+    for (int i = 0; i < 3; i++)
+    {
+        flight_recorder_decision(0, i);
+    }
+
+    // Writer killed after taking the ticket of the second entry
+    int fd = shm_open(TEST_SHM, O_RDWR, 0);
+    size_t size = FLIGHT_RECORDER_HEADER_SIZE + TEST_CAPACITY * sizeof(flight_recorder_entry);
+    char *segment = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    flight_recorder_entry *entries = (flight_recorder_entry *)(segment + FLIGHT_RECORDER_HEADER_SIZE);
+    atomic_store(&entries[1].sequence, 0);
+    munmap(segment, size);
+
+    TEST_ASSERT_EQUAL(2, dump_test(2, line, sizeof(line)));
+    TEST_ASSERT_NOT_NULL(strstr(line, "TTC 2.000"));
+}
+
+/**
+ * @test
+ * @brief Tests that the capacity must be a power of two, also in a segment being attached, and
+ * that a missing recorder is reported.
+ *
+ * \anchor test_flight_recorder_invalid
+ * test ID [TC_FLIGHT_REC_004](@ref TC_FLIGHT_REC_004)
+ */
+void test_flight_recorder_invalid()
+{
+    TEST_ASSERT_EQUAL(-1, flight_recorder_create(TEST_SHM, 0));
+    TEST_ASSERT_EQUAL(-1, flight_recorder_create(TEST_SHM, 6));
+    TEST_ASSERT_EQUAL(-1, flight_recorder_attach(TEST_SHM, FR_SOURCE_SENSORS));
+    TEST_ASSERT_EQUAL(-1, flight_recorder_dump(TEST_SHM, stdout));
+
+    // Header of an existing segment with a capacity of zero
+    TEST_ASSERT_EQUAL(0, flight_recorder_create(TEST_SHM, TEST_CAPACITY));
+    int fd = shm_open(TEST_SHM, O_RDWR, 0);
+    flight_recorder_header *header = mmap(NULL, FLIGHT_RECORDER_HEADER_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    header->capacity = 0;
+    TEST_ASSERT_EQUAL(-1, flight_recorder_attach(TEST_SHM, FR_SOURCE_SENSORS));
+    TEST_ASSERT_EQUAL(-1, flight_recorder_dump(TEST_SHM, stdout));
+    header->capacity = TEST_CAPACITY;
+    TEST_ASSERT_EQUAL(0, flight_recorder_attach(TEST_SHM, FR_SOURCE_SENSORS));
+    munmap(header, FLIGHT_RECORDER_HEADER_SIZE);
+}
+
+/**
+ * @test
+ * @brief Tests that entries recorded while detached are ignored.
+ *
+ * \anchor test_flight_recorder_detached
+ * test ID [TC_FLIGHT_REC_005](@ref TC_FLIGHT_REC_005)
+ */
+void test_flight_recorder_detached()
+{
+    can_msg frame = {.identifier = ID_AEB_S, .dataFrame = BASE_DATA_FRAME};
+    flight_recorder_create(TEST_SHM, TEST_CAPACITY);
+
+    flight_recorder_frame(FR_ENTRY_FRAME_TX, &frame);
+    flight_recorder_decision(1, 1.0);
+    flight_recorder_attach(TEST_SHM, FR_SOURCE_SENSORS);
+    flight_recorder_detach();
+    flight_recorder_frame(FR_ENTRY_FRAME_TX, &frame);
+
+    TEST_ASSERT_EQUAL(0, dump_test(0, NULL, 0));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_flight_recorder_dump_entries);
+    RUN_TEST(test_flight_recorder_wrap_around);
+    RUN_TEST(test_flight_recorder_torn_entry);
+    RUN_TEST(test_flight_recorder_invalid);
+    RUN_TEST(test_flight_recorder_detached);
+    return UNITY_END();
+}
@@ -0,0 +1,244 @@
+#include "unity.h"
+#include "log_index.h"
+#include "log_binary.h"
+#include "dbc.h"
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TEST_LOG "test/test_logq.txt"
+#define TEST_BIN_LOG "test/test_logq.bin"
+#define TEST_OUTPUT "test/test_logq.out"
+#define TEST_EVENTS 1000
+#define TEST_START_MS 1700000000000
+
+log_index index_test;
+
+void setUp()
+{
+    memset(&index_test, 0, sizeof(index_test));
+    remove(TEST_LOG);
+    remove(TEST_LOG LOG_INDEX_SUFFIX);
+    remove(TEST_BIN_LOG);
+    remove(TEST_BIN_LOG LOG_INDEX_SUFFIX);
+}
+
+void tearDown()
+{
+    log_index_close(&index_test);
+    remove(TEST_LOG);
+    remove(TEST_LOG LOG_INDEX_SUFFIX);
+    remove(TEST_BIN_LOG);
+    remove(TEST_BIN_LOG LOG_INDEX_SUFFIX);
+    remove(TEST_OUTPUT);
+}
+
+/**
+ * @brief Helper function, event i of the test logs: one event every 10 ms, an AEB command
+ * every 10th event, the alarm on between events 500 and 599.
+ */
+log_record event_test(int i)
+{
+    log_record record = {
+        .timestamp_ms = TEST_START_MS + 10L * i,
+        .event_id = i % 10 == 0 ? ID_AEB_S : ID_EMPTY,
+        .id_aeb = "AEB1",
+        .actuators = i >= 500 && i < 600 ? ACTUATOR_BIT_ALARM_LED : 0,
+        .kind = LOG_RECORD_EVENT};
+    return record;
+}
+
+/**
+ * @brief Helper function, writes events [first, last) to the text test log.
+ */
+void write_text_log_test(int first, int last)
+{
+    char line[LOG_LINE_MAX];
+    FILE *file = fopen(TEST_LOG, "a");
+    if (first == 0)
+    {
+        fputs(LOG_HEADER, file);
+    }
+    for (int i = first; i < last; i++)
+    {
+        log_record record = event_test(i);
+        log_format_line(line, sizeof(line), &record);
+        fputs(line, file);
+    }
+    fclose(file);
+}
+
+/**
+ * @brief Helper function, writes events [0, count) to the binary test log.
+ */
+void write_binary_log_test(int count)
+{
+    log_bin_block block = {0};
+    FILE *file = fopen(TEST_BIN_LOG, "wb");
+    log_bin_write_file_header(file);
+    for (int i = 0; i < count; i++)
+    {
+        log_record record = event_test(i);
+        log_bin_append(&block, file, &record);
+    }
+    log_bin_write_block(&block, file);
+    fclose(file);
+}
+
+/**
+ * @brief Helper function, runs a query and reads back the timestamp of one output line.
+ * @param line Line number, 1 being the first record.
+ * @return Number of printed records.
+ */
+long query_test(const log_query *query, int line, long *timestamp_ms)
+{
+    FILE *out = fopen(TEST_OUTPUT, "w");
+    long printed = log_index_query(&index_test, query, out);
+    fclose(out);
+
+    char buffer[LOG_LINE_MAX];
+    FILE *in = fopen(TEST_OUTPUT, "r");
+    for (int i = 0; i <= line && fgets(buffer, sizeof(buffer), in) != NULL; i++)
+    {
+        if (i == line && timestamp_ms != NULL)
+        {
+            sscanf(buffer, "%*[^|] | %*x | %ld", timestamp_ms);
+        }
+    }
+    fclose(in);
+    return printed;
+}
+
+/**
+ * @test
+ * @brief Verifies that the index is built on first use and that a time-range query on a text log
+ * returns exactly the records of the range.
+ *
+ * \anchor test_log_index_time_range
+ * test ID [TC_LOG_INDEX_001](@ref TC_LOG_INDEX_001)
+ */
+void test_log_index_time_range()
+{
+    long timestamp_ms = 0;
+    write_text_log_test(0, TEST_EVENTS);
+
+    TEST_ASSERT_EQUAL(0, log_index_open(&index_test, TEST_LOG));
+    TEST_ASSERT_EQUAL(0, access(TEST_LOG LOG_INDEX_SUFFIX, F_OK));
+    TEST_ASSERT_EQUAL(TEST_EVENTS, index_test.header->records);
+    TEST_ASSERT_EQUAL(LOG_FORMAT_TEXT, index_test.header->format);
+
+    log_query query = {.from_ms = TEST_START_MS + 3005, .to_ms = TEST_START_MS + 4000};
+    TEST_ASSERT_EQUAL(100, query_test(&query, 1, &timestamp_ms));
+    TEST_ASSERT_EQUAL(TEST_START_MS + 3010, timestamp_ms);
+    query_test(&query, 100, &timestamp_ms);
+    TEST_ASSERT_EQUAL(TEST_START_MS + 4000, timestamp_ms);
+
+    query.from_ms = LONG_MIN;
+    query.to_ms = LONG_MAX;
+    TEST_ASSERT_EQUAL(TEST_EVENTS, query_test(&query, 1, &timestamp_ms));
+    TEST_ASSERT_EQUAL(TEST_START_MS, timestamp_ms);
+}
+
+/**
+ * @test
+ * @brief Verifies that an event-ID query on a binary log returns the records of that EVENT_ID in the
+ * time range, and none for an unknown EVENT_ID.
+ *
+ * \anchor test_log_index_event_id
+ * test ID [TC_LOG_INDEX_002](@ref TC_LOG_INDEX_002)
+ */
+void test_log_index_event_id()
+{
+    long timestamp_ms = 0;
+    write_binary_log_test(TEST_EVENTS);
+
+    TEST_ASSERT_EQUAL(0, log_index_open(&index_test, TEST_BIN_LOG));
+    TEST_ASSERT_EQUAL(LOG_FORMAT_BINARY, index_test.header->format);
+    TEST_ASSERT_EQUAL(2, index_test.header->event_count);
+
+    log_query query = {.from_ms = LONG_MIN, .to_ms = LONG_MAX, .by_event = true, .event_id = ID_AEB_S};
+    TEST_ASSERT_EQUAL(TEST_EVENTS / 10, query_test(&query, 2, &timestamp_ms));
+    TEST_ASSERT_EQUAL(TEST_START_MS + 100, timestamp_ms);
+
+    query.from_ms = TEST_START_MS + 9000;
+    TEST_ASSERT_EQUAL(10, query_test(&query, 1, &timestamp_ms));
+    TEST_ASSERT_EQUAL(TEST_START_MS + 9000, timestamp_ms);
+
+    query.event_id = ID_SPEED_S;
+    TEST_ASSERT_EQUAL(0, query_test(&query, 1, NULL));
+}
+
+/**
+ * @test
+ * @brief Verifies that a transition query returns the first record and every change of the actuators
+ * state, in both formats.
+ *
+ * \anchor test_log_index_transitions
+ * test ID [TC_LOG_INDEX_003](@ref TC_LOG_INDEX_003)
+ */
+void test_log_index_transitions()
+{
+    long timestamp_ms = 0;
+    log_query query = {.from_ms = LONG_MIN, .to_ms = LONG_MAX, .transitions = true};
+
+    write_text_log_test(0, TEST_EVENTS);
+    TEST_ASSERT_EQUAL(0, log_index_open(&index_test, TEST_LOG));
+    TEST_ASSERT_EQUAL(3, query_test(&query, 2, &timestamp_ms));
+    TEST_ASSERT_EQUAL(TEST_START_MS + 5000, timestamp_ms);
+    log_index_close(&index_test);
+
+    write_binary_log_test(TEST_EVENTS);
+    TEST_ASSERT_EQUAL(0, log_index_open(&index_test, TEST_BIN_LOG));
+    query.from_ms = TEST_START_MS + 5001;
+    TEST_ASSERT_EQUAL(1, query_test(&query, 1, &timestamp_ms));
+    TEST_ASSERT_EQUAL(TEST_START_MS + 6000, timestamp_ms);
+}
+
+/**
+ * @test
+ * @brief Verifies that the index is rebuilt when the log grew since it was built.
+ *
+ * \anchor test_log_index_rebuild
+ * test ID [TC_LOG_INDEX_004](@ref TC_LOG_INDEX_004)
+ */
+void test_log_index_rebuild()
+{
+    long timestamp_ms = 0;
+    log_query query = {.from_ms = TEST_START_MS + 5000, .to_ms = LONG_MAX};
+
+    write_text_log_test(0, TEST_EVENTS / 2);
+    TEST_ASSERT_EQUAL(0, log_index_open(&index_test, TEST_LOG));
+    TEST_ASSERT_EQUAL(TEST_EVENTS / 2, index_test.header->records);
+    TEST_ASSERT_EQUAL(0, query_test(&query, 1, NULL));
+    log_index_close(&index_test);
+
+    write_text_log_test(TEST_EVENTS / 2, TEST_EVENTS);
+    TEST_ASSERT_EQUAL(0, log_index_open(&index_test, TEST_LOG));
+    TEST_ASSERT_EQUAL(TEST_EVENTS, index_test.header->records);
+    TEST_ASSERT_EQUAL(TEST_EVENTS / 2, query_test(&query, 1, &timestamp_ms));
+    TEST_ASSERT_EQUAL(TEST_START_MS + 5000, timestamp_ms);
+}
+
+/**
+ * @test
+ * @brief Verifies that opening the index of a missing log fails.
+ *
+ * \anchor test_log_index_missing_log
+ * test ID [TC_LOG_INDEX_005](@ref TC_LOG_INDEX_005)
+ */
+void test_log_index_missing_log()
+{
+    TEST_ASSERT_EQUAL(-1, log_index_open(&index_test, TEST_LOG));
+    TEST_ASSERT_EQUAL(-1, access(TEST_LOG LOG_INDEX_SUFFIX, F_OK));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_log_index_time_range);
+    RUN_TEST(test_log_index_event_id);
+    RUN_TEST(test_log_index_transitions);
+    RUN_TEST(test_log_index_rebuild);
+    RUN_TEST(test_log_index_missing_log);
+    return UNITY_END();
+}
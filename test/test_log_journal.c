@@ -0,0 +1,202 @@
+#include "unity.h"
+#include "log_journal.h"
+#include "log_utils.h"
+#include "dbc.h"
+#include <string.h>
+#include <sys/stat.h>
+
+#define TEST_JOURNAL "test/test_journal.bin"
+#define TEST_DECODED "test/test_journal.txt"
+
+log_journal journal;
+
+log_record record_test = {
+    .timestamp_ms = 1700000000000,
+    .event_id = ID_AEB_S,
+    .id_aeb = "AEB1",
+    .actuators = ACTUATOR_BIT_DOOR_LOCK,
+    .kind = LOG_RECORD_EVENT};
+
+void setUp()
+{
+    remove(TEST_JOURNAL);
+    remove(TEST_DECODED);
+}
+
+void tearDown()
+{
+    log_journal_close(&journal);
+    log_shutdown();
+    remove(TEST_JOURNAL);
+    remove(TEST_DECODED);
+}
+
+/**
+ * @brief Helper function, decodes the test journal and reads back the event ID of a line.
+ * @param index Line number, 0 being the header.
+ * @return Number of decoded records.
+ */
+long decode_journal_test(int index, uint32_t *event_id)
+{
+    FILE *out = fopen(TEST_DECODED, "w");
+    long decoded = log_journal_decode(TEST_JOURNAL, out);
+    fclose(out);
+
+    FILE *in = fopen(TEST_DECODED, "r");
+    char line[256];
+    for (int i = 0; i <= index && fgets(line, sizeof(line), in) != NULL; i++)
+    {
+        if (i == index && event_id != NULL)
+        {
+            sscanf(line, "%*[^|] | %x", event_id);
+        }
+    }
+    fclose(in);
+    return decoded;
+}
+
+/**
+ * @test
+ * @brief Verifies that a new journal is created at its full size and that committed records
+ * can be decoded while the journal is still open for writing.
+ *
+ * \anchor test_log_journal_read_while_writing
+ * test ID [TC_LOG_JOURNAL_001](@ref TC_LOG_JOURNAL_001)
+ */
+void test_log_journal_read_while_writing()
+{
+    struct stat st;
+    uint32_t event_id = 0;
+
+    TEST_ASSERT_EQUAL(0, log_journal_open(&journal, TEST_JOURNAL, 64));
+    stat(TEST_JOURNAL, &st);
+    TEST_ASSERT_EQUAL(LOG_JOURNAL_HEADER_SIZE + 64 * sizeof(log_bin_record), st.st_size);
+
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        record_test.event_id = i + 1;
+        TEST_ASSERT_EQUAL(0, log_journal_append(&journal, &record_test));
+    }
+
+    TEST_ASSERT_EQUAL(3, decode_journal_test(3, &event_id));
+    TEST_ASSERT_EQUAL_HEX32(3, event_id);
+    stat(TEST_JOURNAL, &st);
+    TEST_ASSERT_EQUAL(LOG_JOURNAL_HEADER_SIZE + 64 * sizeof(log_bin_record), st.st_size);
+}
+
+/**
+ * @test
+ * @brief Verifies crash recovery: a reopened journal resumes after the last committed record,
+ * and a record written but not committed is overwritten.
+ *
+ * \anchor test_log_journal_recovery
+ * test ID [TC_LOG_JOURNAL_002](@ref TC_LOG_JOURNAL_002)
+ */
+void test_log_journal_recovery()
+{
+    uint32_t event_id = 0;
+
+    TEST_ASSERT_EQUAL(0, log_journal_open(&journal, TEST_JOURNAL, 64));
+    for (uint32_t i = 0; i < 5; i++)
+    {
+        record_test.event_id = i + 1;
+        log_journal_append(&journal, &record_test);
+    }
+    // Crash between the record store and the commit
+    record_test.event_id = 0xDEAD;
+    log_bin_pack(&journal.records[5], &record_test);
+    log_journal_close(&journal);
+
+    TEST_ASSERT_EQUAL(5, decode_journal_test(5, &event_id));
+    TEST_ASSERT_EQUAL_HEX32(5, event_id);
+
+    TEST_ASSERT_EQUAL(0, log_journal_open(&journal, TEST_JOURNAL, 0));
+    TEST_ASSERT_EQUAL(64, journal.header->capacity); // Capacity comes from the existing journal
+    record_test.event_id = 6;
+    TEST_ASSERT_EQUAL(0, log_journal_append(&journal, &record_test));
+
+    TEST_ASSERT_EQUAL(6, decode_journal_test(6, &event_id));
+    TEST_ASSERT_EQUAL_HEX32(6, event_id);
+}
+
+/**
+ * @test
+ * @brief Verifies that appends fail once the journal is full.
+ *
+ * \anchor test_log_journal_full
+ * test ID [TC_LOG_JOURNAL_003](@ref TC_LOG_JOURNAL_003)
+ */
+void test_log_journal_full()
+{
+    TEST_ASSERT_EQUAL(0, log_journal_open(&journal, TEST_JOURNAL, 4));
+    for (int i = 0; i < 4; i++)
+    {
+        TEST_ASSERT_EQUAL(0, log_journal_append(&journal, &record_test));
+    }
+    TEST_ASSERT_EQUAL(-1, log_journal_append(&journal, &record_test));
+    TEST_ASSERT_EQUAL(4, decode_journal_test(0, NULL));
+}
+
+/**
+ * @test
+ * @brief Verifies that a file that isn't a journal is rejected.
+ *
+ * \anchor test_log_journal_invalid_file
+ * test ID [TC_LOG_JOURNAL_004](@ref TC_LOG_JOURNAL_004)
+ */
+void test_log_journal_invalid_file()
+{
+    FILE *file = fopen(TEST_JOURNAL, "w");
+    for (int i = 0; i < 100; i++)
+    {
+        fputs(LOG_HEADER, file);
+    }
+    fclose(file);
+
+    TEST_ASSERT_EQUAL(-1, log_journal_open(&journal, TEST_JOURNAL, 0));
+    TEST_ASSERT_EQUAL(-1, log_journal_decode(TEST_JOURNAL, stdout));
+}
+
+/**
+ * @test
+ * @brief Verifies the journal as a log_utils backend, with the logger thread, and that
+ * a full journal counts the discarded events.
+ *
+ * \anchor test_log_journal_backend
+ * test ID [TC_LOG_JOURNAL_005](@ref TC_LOG_JOURNAL_005)
+ */
+void test_log_journal_backend()
+{
+    log_config config = {.path = TEST_JOURNAL, .format = LOG_FORMAT_JOURNAL, .async = true, .journal_records = 1000};
+    actuators_abstraction braking = ACTUATORS_STATE_BRAKING;
+
+    TEST_ASSERT_EQUAL(0, log_init(&config));
+    for (int i = 0; i < 1200; i++)
+    {
+        log_event("AEB1", ID_AEB_S, braking);
+    }
+    log_shutdown();
+
+    unsigned long dropped = log_dropped_events();
+    TEST_ASSERT_TRUE(dropped >= 200);
+    TEST_ASSERT_EQUAL(1200 - dropped, decode_journal_test(0, NULL));
+
+    FILE *in = fopen(TEST_DECODED, "r");
+    char line[256];
+    fgets(line, sizeof(line), in);
+    fgets(line, sizeof(line), in);
+    fclose(in);
+    TEST_ASSERT_NOT_NULL(strstr(line, "AEB1 | 18FFA027 |"));
+    TEST_ASSERT_NOT_NULL(strstr(line, "| WARNING | 1 | 0 | 1 | 1 | 1"));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_log_journal_read_while_writing);
+    RUN_TEST(test_log_journal_recovery);
+    RUN_TEST(test_log_journal_full);
+    RUN_TEST(test_log_journal_invalid_file);
+    RUN_TEST(test_log_journal_backend);
+    return UNITY_END();
+}
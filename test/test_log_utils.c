@@ -3,8 +3,10 @@
 #include "log_utils.h"
 #include "actuators.h"
 #include "dbc.h"
+#include "log_binary.h"
 #include <time.h>
 #include <string.h>
+#include <unistd.h>
 
 static bool wrap_fopen_fail = false;
 static bool wrap_perror_called = false;
@@ -17,13 +19,7 @@ can_msg can_frame_empty = {
     .identifier = ID_EMPTY,
     .dataFrame = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}};
 
-actuators_abstraction actuators_test = {
-    .belt_tightness = false,
-    .door_lock = true,
-    .should_activate_abs = false,
-    .alarm_led = false,
-    .alarm_buzzer = false
-};
+actuators_abstraction actuators_test = ACTUATORS_STATE_IDLE;
 
 actuators_abstraction actuators_try;
 
@@ -51,6 +47,62 @@ void __wrap_perror(const char *s) {
     __real_perror(s); 
 }
 
+log_config test_log_config = {.path = LOG_FILE_PATH, .flush_policy = LOG_FLUSH_EVERY_EVENT};
+
+/**
+ * @brief Helper function, used to count the lines already written to the log file.
+ * @return Number of lines in the file, or -1 if it can't be opened.
+ */
+int count_lines_test(){
+    FILE *file = fopen("test/test_log.txt", "r");
+    if (file == NULL) {
+        return -1;
+    }
+
+    int lines = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), file) != NULL) {
+        lines++;
+    }
+    fclose(file);
+    return lines;
+}
+
+/**
+ * @brief Helper function, removes the segments of the rotation tests.
+ */
+void remove_segments_test(){
+    char path[64];
+    remove("test/test_rot.txt");
+    remove("test/test_rot.txt.spare");
+    for (int k = 1; k <= 10; k++) {
+        snprintf(path, sizeof(path), "test/test_rot.txt.%d", k);
+        remove(path);
+    }
+}
+
+/**
+ * @brief Helper function, counts the events (non header lines) of a segment.
+ * @return Number of events, or -1 if the segment doesn't exist.
+ */
+int count_segment_events_test(const char *path, long *size){
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        return -1;
+    }
+    char line[256];
+    int events = 0;
+    if (fgets(line, sizeof(line), file) != NULL) {
+        TEST_ASSERT_EQUAL_STRING(LOG_HEADER, line);
+    }
+    while (fgets(line, sizeof(line), file) != NULL) {
+        events++;
+    }
+    *size = ftell(file);
+    fclose(file);
+    return events;
+}
+
 void setUp(){
     wrap_fopen_fail = false; // std -> fopen don't fail
     wrap_perror_called = false; // Resets perror state
@@ -58,7 +110,10 @@ void setUp(){
 
 void tearDown(){
     // clean stuff up here
+    log_shutdown();
     remove("test/test_log.txt");
+    remove("test/test_log.bin");
+    remove_segments_test();
 }
 
 /**
@@ -99,11 +154,8 @@ actuators_abstraction read_line_test(){
         if (sscanf(line, "%*[^|] | %d | %d | %d | %d | %d", &v1, &v2, &v3, &v4, &v5) == 5) {
             printf("Valores extraídos: %d %d %d %d %d\n", v1, v2, v3, v4, v5);
         }
-        actuators_test.belt_tightness = v1;
-        actuators_test.door_lock = v2;
-        actuators_test.should_activate_abs = v3;
-        actuators_test.alarm_led = v4;
-        actuators_test.alarm_buzzer = v5;
+        actuators_test = (v1 ? ACTUATOR_BIT_BELT_TIGHTNESS : 0) | (v2 ? ACTUATOR_BIT_DOOR_LOCK : 0) |
+                         (v3 ? ACTUATOR_BIT_ABS : 0) | (v4 ? ACTUATOR_BIT_ALARM_LED : 0) | (v5 ? ACTUATOR_BIT_ALARM_BUZZER : 0);
     }
     fclose(file);
 
@@ -131,11 +183,11 @@ void test_log_event_check_writing_no1(){
     
     actuators_try = read_line_test();
 
-    TEST_ASSERT_EQUAL(actuators_test.belt_tightness, actuators_try.belt_tightness);
-    TEST_ASSERT_EQUAL(actuators_test.door_lock, actuators_try.door_lock);
-    TEST_ASSERT_EQUAL(actuators_test.should_activate_abs, actuators_try.should_activate_abs);
-    TEST_ASSERT_EQUAL(actuators_test.alarm_led, actuators_try.alarm_led);
-    TEST_ASSERT_EQUAL(actuators_test.alarm_buzzer, actuators_try.alarm_buzzer);
+    TEST_ASSERT_EQUAL(actuatorIsActive(actuators_test, ACTUATOR_BIT_BELT_TIGHTNESS), actuatorIsActive(actuators_try, ACTUATOR_BIT_BELT_TIGHTNESS));
+    TEST_ASSERT_EQUAL(actuatorIsActive(actuators_test, ACTUATOR_BIT_DOOR_LOCK), actuatorIsActive(actuators_try, ACTUATOR_BIT_DOOR_LOCK));
+    TEST_ASSERT_EQUAL(actuatorIsActive(actuators_test, ACTUATOR_BIT_ABS), actuatorIsActive(actuators_try, ACTUATOR_BIT_ABS));
+    TEST_ASSERT_EQUAL(actuatorIsActive(actuators_test, ACTUATOR_BIT_ALARM_LED), actuatorIsActive(actuators_try, ACTUATOR_BIT_ALARM_LED));
+    TEST_ASSERT_EQUAL(actuatorIsActive(actuators_test, ACTUATOR_BIT_ALARM_BUZZER), actuatorIsActive(actuators_try, ACTUATOR_BIT_ALARM_BUZZER));
 }
 
 void test_log_event_file_already_exists(){
@@ -147,11 +199,503 @@ void test_log_event_file_already_exists(){
 
     // The same as the previous test 
     actuators_try = read_line_test();
-    TEST_ASSERT_EQUAL(actuators_test.belt_tightness, actuators_try.belt_tightness);
-    TEST_ASSERT_EQUAL(actuators_test.door_lock, actuators_try.door_lock);
-    TEST_ASSERT_EQUAL(actuators_test.should_activate_abs, actuators_try.should_activate_abs);
-    TEST_ASSERT_EQUAL(actuators_test.alarm_led, actuators_try.alarm_led);
-    TEST_ASSERT_EQUAL(actuators_test.alarm_buzzer, actuators_try.alarm_buzzer);
+    TEST_ASSERT_EQUAL(actuatorIsActive(actuators_test, ACTUATOR_BIT_BELT_TIGHTNESS), actuatorIsActive(actuators_try, ACTUATOR_BIT_BELT_TIGHTNESS));
+    TEST_ASSERT_EQUAL(actuatorIsActive(actuators_test, ACTUATOR_BIT_DOOR_LOCK), actuatorIsActive(actuators_try, ACTUATOR_BIT_DOOR_LOCK));
+    TEST_ASSERT_EQUAL(actuatorIsActive(actuators_test, ACTUATOR_BIT_ABS), actuatorIsActive(actuators_try, ACTUATOR_BIT_ABS));
+    TEST_ASSERT_EQUAL(actuatorIsActive(actuators_test, ACTUATOR_BIT_ALARM_LED), actuatorIsActive(actuators_try, ACTUATOR_BIT_ALARM_LED));
+    TEST_ASSERT_EQUAL(actuatorIsActive(actuators_test, ACTUATOR_BIT_ALARM_BUZZER), actuatorIsActive(actuators_try, ACTUATOR_BIT_ALARM_BUZZER));
+}
+
+/**
+ * @brief Helper function, parses every column of the last line of the log file.
+ * @return Actuators state of the last event in the file.
+ */
+actuators_abstraction read_last_event_test(){
+    FILE *file = fopen("test/test_log.txt", "r");
+    actuators_abstraction actuators = 0;
+    char line[256];
+
+    while (fgets(line, sizeof(line), file) != NULL) {
+        int v1, v2, v3, v4, v5;
+        if (sscanf(line, "%*[^|] | %*x | %*d | %*s | %d | %d | %d | %d | %d", &v1, &v2, &v3, &v4, &v5) == 5) {
+            actuators = (v1 ? ACTUATOR_BIT_BELT_TIGHTNESS : 0) | (v2 ? ACTUATOR_BIT_DOOR_LOCK : 0) |
+                        (v3 ? ACTUATOR_BIT_ABS : 0) | (v4 ? ACTUATOR_BIT_ALARM_LED : 0) | (v5 ? ACTUATOR_BIT_ALARM_BUZZER : 0);
+        }
+    }
+    fclose(file);
+    return actuators;
+}
+
+/**
+ * @test
+ * @brief Verifies that log_init writes the header only once and that events go to the open file.
+ * 
+ * \anchor test_log_init_header_once
+ * test ID [TC_LOG_UTILS_003](@ref TC_LOG_UTILS_003)
+ */
+void test_log_init_header_once(){
+    TEST_ASSERT_EQUAL(0, log_init(&test_log_config));
+    TEST_ASSERT_EQUAL(1, count_lines_test());
+
+    log_event("Persistent", can_frame_test.identifier, actuators_test);
+    TEST_ASSERT_EQUAL(2, count_lines_test());
+
+    // Reopening an existing log doesn't write a second header
+    log_shutdown();
+    TEST_ASSERT_EQUAL(0, log_init(&test_log_config));
+    log_event("Persistent", can_frame_test.identifier, actuators_test);
+    TEST_ASSERT_EQUAL(3, count_lines_test());
+
+    actuators_try = read_last_event_test();
+    TEST_ASSERT_EQUAL(actuatorIsActive(actuators_test, ACTUATOR_BIT_DOOR_LOCK), actuatorIsActive(actuators_try, ACTUATOR_BIT_DOOR_LOCK));
+    TEST_ASSERT_EQUAL(actuatorIsActive(actuators_test, ACTUATOR_BIT_ALARM_LED), actuatorIsActive(actuators_try, ACTUATOR_BIT_ALARM_LED));
+}
+
+/**
+ * @test
+ * @brief Verifies that with LOG_FLUSH_EVERY_N events stay buffered until the N-th one.
+ * 
+ * \anchor test_log_flush_every_n
+ * test ID [TC_LOG_UTILS_004](@ref TC_LOG_UTILS_004)
+ */
+void test_log_flush_every_n(){
+    log_config config = {.path = LOG_FILE_PATH, .flush_policy = LOG_FLUSH_EVERY_N, .flush_every_n = 3};
+    TEST_ASSERT_EQUAL(0, log_init(&config));
+
+    log_event("Every_N", can_frame_test.identifier, actuators_test);
+    log_event("Every_N", can_frame_test.identifier, actuators_test);
+    TEST_ASSERT_EQUAL(1, count_lines_test()); // Only the header reached the file
+
+    log_event("Every_N", can_frame_test.identifier, actuators_test);
+    TEST_ASSERT_EQUAL(4, count_lines_test());
+
+    // Remaining events are written by log_shutdown
+    log_event("Every_N", can_frame_test.identifier, actuators_test);
+    log_shutdown();
+    TEST_ASSERT_EQUAL(5, count_lines_test());
+}
+
+/**
+ * @test
+ * @brief Verifies that with LOG_FLUSH_INTERVAL events are flushed once the interval elapsed.
+ * 
+ * \anchor test_log_flush_interval
+ * test ID [TC_LOG_UTILS_005](@ref TC_LOG_UTILS_005)
+ */
+void test_log_flush_interval(){
+    log_config config = {.path = LOG_FILE_PATH, .flush_policy = LOG_FLUSH_INTERVAL, .flush_interval_ms = 50};
+    TEST_ASSERT_EQUAL(0, log_init(&config));
+
+    log_event("Interval", can_frame_test.identifier, actuators_test);
+    TEST_ASSERT_EQUAL(1, count_lines_test());
+
+    usleep(60000);
+    log_event("Interval", can_frame_test.identifier, actuators_test);
+    TEST_ASSERT_EQUAL(3, count_lines_test());
+}
+
+/**
+ * @test
+ * @brief Verifies that log_init reports a file that can't be opened.
+ * 
+ * \anchor test_log_init_fopen_fail
+ * test ID [TC_LOG_UTILS_006](@ref TC_LOG_UTILS_006)
+ */
+void test_log_init_fopen_fail(){
+    wrap_fopen_fail = true;
+
+    TEST_ASSERT_EQUAL(-1, log_init(&test_log_config));
+    TEST_ASSERT_TRUE(wrap_perror_called);
+}
+
+/**
+ * @test
+ * @brief Verifies that in asynchronous mode the logger thread writes every event by log_shutdown.
+ * 
+ * \anchor test_log_async_writes_all
+ * test ID [TC_LOG_UTILS_007](@ref TC_LOG_UTILS_007)
+ */
+void test_log_async_writes_all(){
+    log_config config = {.path = LOG_FILE_PATH, .flush_policy = LOG_FLUSH_EVERY_EVENT, .async = true};
+    TEST_ASSERT_EQUAL(0, log_init(&config));
+
+    for (int i = 0; i < 100; i++) {
+        log_event("Async", can_frame_test.identifier, actuators_test);
+    }
+    log_shutdown();
+
+    TEST_ASSERT_EQUAL(0, log_dropped_events());
+    TEST_ASSERT_EQUAL(101, count_lines_test());
+
+    actuators_try = read_last_event_test();
+    TEST_ASSERT_EQUAL(actuatorIsActive(actuators_test, ACTUATOR_BIT_DOOR_LOCK), actuatorIsActive(actuators_try, ACTUATOR_BIT_DOOR_LOCK));
+    TEST_ASSERT_EQUAL(actuatorIsActive(actuators_test, ACTUATOR_BIT_BELT_TIGHTNESS), actuatorIsActive(actuators_try, ACTUATOR_BIT_BELT_TIGHTNESS));
+}
+
+/**
+ * @test
+ * @brief Verifies that a full logger ring drops events instead of blocking, and counts them.
+ * 
+ * \anchor test_log_async_ring_full
+ * test ID [TC_LOG_UTILS_008](@ref TC_LOG_UTILS_008)
+ */
+void test_log_async_ring_full(){
+    log_config config = {.path = LOG_FILE_PATH, .flush_policy = LOG_FLUSH_EVERY_EVENT, .async = true, .ring_capacity = 2};
+    TEST_ASSERT_EQUAL(0, log_init(&config));
+
+    for (int i = 0; i < 1000; i++) {
+        log_event("Async", can_frame_test.identifier, actuators_test);
+    }
+    log_shutdown();
+
+    // Every event is either in the file or counted as dropped
+    unsigned long dropped = log_dropped_events();
+    TEST_ASSERT_TRUE(dropped > 0);
+    TEST_ASSERT_EQUAL(1 + 1000 - dropped, count_lines_test());
+}
+
+/**
+ * @test
+ * @brief Verifies that log_init rejects a logger ring capacity that isn't a power of two.
+ * 
+ * \anchor test_log_async_invalid_capacity
+ * test ID [TC_LOG_UTILS_009](@ref TC_LOG_UTILS_009)
+ */
+void test_log_async_invalid_capacity(){
+    log_config config = {.path = LOG_FILE_PATH, .async = true, .ring_capacity = 100};
+    TEST_ASSERT_EQUAL(-1, log_init(&config));
+
+    // The legacy path is still available
+    log_event("Legacy", can_frame_test.identifier, actuators_test);
+    TEST_ASSERT_EQUAL(2, count_lines_test());
+}
+
+/**
+ * @test
+ * @brief Verifies that every actuators state survives log_bin_pack/log_bin_unpack.
+ * 
+ * \anchor test_log_bin_pack_unpack
+ * test ID [TC_LOG_UTILS_010](@ref TC_LOG_UTILS_010)
+ */
+void test_log_bin_pack_unpack(){
+    log_bin_record entry;
+    log_record record = {0}, unpacked = {0};
+    for (actuators_abstraction bits = 0; bits <= ACTUATOR_BITS_ALL; bits++) {
+        record.actuators = bits;
+        log_bin_pack(&entry, &record);
+        log_bin_unpack(&unpacked, &entry);
+        TEST_ASSERT_EQUAL_UINT8(bits, entry.actuators);
+        TEST_ASSERT_EQUAL_UINT8(bits, unpacked.actuators);
+    }
+}
+
+/**
+ * @brief Helper function, writes events to the binary test log alternating two actuators states.
+ */
+void write_binary_log_test(int events){
+    log_config config = {.path = "test/test_log.bin", .format = LOG_FORMAT_BINARY, .flush_policy = LOG_FLUSH_EVERY_N, .flush_every_n = 1000};
+    actuators_abstraction idle = ACTUATORS_STATE_IDLE;
+    actuators_abstraction active = ACTUATORS_STATE_BRAKING;
+
+    TEST_ASSERT_EQUAL(0, log_init(&config));
+    for (int i = 0; i < events; i++) {
+        log_event("AEB1", can_frame_test.identifier + i, (i % 2) ? active : idle);
+    }
+    log_shutdown();
+}
+
+/**
+ * @test
+ * @brief Verifies the binary log layout and that log_bin_decode gives back the text log.
+ * 
+ * \anchor test_log_binary_round_trip
+ * test ID [TC_LOG_UTILS_011](@ref TC_LOG_UTILS_011)
+ */
+void test_log_binary_round_trip(){
+    write_binary_log_test(100);
+
+    // File header, a full block of 64 records and a partial block of 36
+    FILE *in = fopen("test/test_log.bin", "rb");
+    fseek(in, 0, SEEK_END);
+    TEST_ASSERT_EQUAL(sizeof(log_bin_file_header) + 2 * sizeof(log_bin_block_header) + 100 * sizeof(log_bin_record), ftell(in));
+    rewind(in);
+
+    FILE *out = fopen("log/log.txt", "w");
+    TEST_ASSERT_EQUAL(100, log_bin_decode(in, out));
+    fclose(in);
+    fclose(out);
+
+    TEST_ASSERT_EQUAL(101, count_lines_test());
+    actuators_try = read_last_event_test(); // Last event is the active state
+    TEST_ASSERT_TRUE(actuatorIsActive(actuators_try, ACTUATOR_BIT_BELT_TIGHTNESS));
+    TEST_ASSERT_FALSE(actuatorIsActive(actuators_try, ACTUATOR_BIT_DOOR_LOCK));
+    TEST_ASSERT_TRUE(actuatorIsActive(actuators_try, ACTUATOR_BIT_ABS));
+    TEST_ASSERT_TRUE(actuatorIsActive(actuators_try, ACTUATOR_BIT_ALARM_LED));
+    TEST_ASSERT_TRUE(actuatorIsActive(actuators_try, ACTUATOR_BIT_ALARM_BUZZER));
+
+    // Same line as the text log would have
+    char line[256], expected[LOG_LINE_MAX];
+    in = fopen("test/test_log.txt", "r");
+    fgets(line, sizeof(line), in);
+    fgets(line, sizeof(line), in);
+    fclose(in);
+    long timestamp;
+    sscanf(line, "AEB1 | %*s | %ld", &timestamp);
+    log_record first = {.timestamp_ms = timestamp, .event_id = can_frame_test.identifier, .id_aeb = "AEB1", .actuators = ACTUATORS_STATE_IDLE};
+    log_format_line(expected, sizeof(expected), &first);
+    TEST_ASSERT_EQUAL_STRING(expected, line);
+}
+
+/**
+ * @test
+ * @brief Verifies that a block with a wrong checksum is skipped and the other blocks are decoded.
+ * 
+ * \anchor test_log_binary_bad_checksum
+ * test ID [TC_LOG_UTILS_012](@ref TC_LOG_UTILS_012)
+ */
+void test_log_binary_bad_checksum(){
+    write_binary_log_test(100);
+
+    // Flip one bit in the first record of the first block
+    FILE *file = fopen("test/test_log.bin", "r+b");
+    long offset = sizeof(log_bin_file_header) + sizeof(log_bin_block_header);
+    fseek(file, offset, SEEK_SET);
+    int byte = fgetc(file);
+    fseek(file, offset, SEEK_SET);
+    fputc(byte ^ 0x01, file);
+    rewind(file);
+
+    FILE *out = fopen("/dev/null", "w");
+    TEST_ASSERT_EQUAL(36, log_bin_decode(file, out));
+    fclose(out);
+    fclose(file);
+}
+
+/**
+ * @test
+ * @brief Verifies that log_bin_decode rejects a file that isn't a binary log.
+ * 
+ * \anchor test_log_binary_not_binary
+ * test ID [TC_LOG_UTILS_013](@ref TC_LOG_UTILS_013)
+ */
+void test_log_binary_not_binary(){
+    log_event("Text", can_frame_test.identifier, actuators_test);
+
+    FILE *in = fopen("log/log.txt", "rb");
+    FILE *out = fopen("/dev/null", "w");
+    TEST_ASSERT_EQUAL(-1, log_bin_decode(in, out));
+    fclose(out);
+    fclose(in);
+}
+
+/**
+ * @brief Helper function, copies the MESSAGE column of a line of the log file.
+ * @param index Line number, 0 being the header.
+ */
+void read_message_test(int index, char *message, size_t size){
+    FILE *file = fopen("test/test_log.txt", "r");
+    char line[256];
+    message[0] = '\0';
+    for (int i = 0; i <= index && fgets(line, sizeof(line), file) != NULL; i++) {
+        if (i == index) {
+            sscanf(line, "%*[^|] | %*x | %*d | %15[^|]", message);
+        }
+    }
+    fclose(file);
+    size_t length = strlen(message);
+    while (length > 0 && message[length - 1] == ' ') {
+        message[--length] = '\0';
+    }
+}
+
+/**
+ * @test
+ * @brief Verifies that only transitions are written, and that the repeated events before a
+ * transition are written as one summary record.
+ * 
+ * \anchor test_log_filter_transitions
+ * test ID [TC_LOG_UTILS_014](@ref TC_LOG_UTILS_014)
+ */
+void test_log_filter_transitions(){
+    log_config config = {.path = LOG_FILE_PATH, .filter = LOG_FILTER_TRANSITIONS};
+    actuators_abstraction idle = ACTUATORS_STATE_IDLE;
+    actuators_abstraction braking = ACTUATORS_STATE_BRAKING;
+    char message[16];
+
+    TEST_ASSERT_EQUAL(0, log_init(&config));
+    for (int i = 0; i < 10; i++) {
+        log_event("AEB1", ID_EMPTY, idle);
+    }
+    TEST_ASSERT_EQUAL(2, count_lines_test()); // Header and the first event
+
+    log_event("AEB1", ID_AEB_S, braking);
+    TEST_ASSERT_EQUAL(4, count_lines_test());
+    read_message_test(2, message, sizeof(message));
+    TEST_ASSERT_EQUAL_STRING("SUMMARY 9", message);
+    read_message_test(3, message, sizeof(message));
+    TEST_ASSERT_EQUAL_STRING("WARNING", message);
+
+    actuators_try = read_last_event_test();
+    TEST_ASSERT_TRUE(actuatorIsActive(actuators_try, ACTUATOR_BIT_ABS));
+    TEST_ASSERT_TRUE(actuatorIsActive(actuators_try, ACTUATOR_BIT_ALARM_BUZZER));
+}
+
+/**
+ * @test
+ * @brief Verifies that a summary record is written when the summary interval elapsed.
+ * 
+ * \anchor test_log_filter_summary_interval
+ * test ID [TC_LOG_UTILS_015](@ref TC_LOG_UTILS_015)
+ */
+void test_log_filter_summary_interval(){
+    log_config config = {.path = LOG_FILE_PATH, .filter = LOG_FILTER_TRANSITIONS, .summary_interval_ms = 50};
+    char message[16];
+
+    TEST_ASSERT_EQUAL(0, log_init(&config));
+    log_event("AEB1", ID_EMPTY, actuators_test);
+    log_event("AEB1", ID_EMPTY, actuators_test);
+    TEST_ASSERT_EQUAL(2, count_lines_test());
+
+    usleep(60000);
+    log_event("AEB1", ID_EMPTY, actuators_test);
+    TEST_ASSERT_EQUAL(3, count_lines_test());
+    read_message_test(2, message, sizeof(message));
+    TEST_ASSERT_EQUAL_STRING("SUMMARY 2", message);
+}
+
+/**
+ * @test
+ * @brief Verifies that log_shutdown writes the pending summary and that summaries survive the binary log.
+ * 
+ * \anchor test_log_filter_binary_shutdown
+ * test ID [TC_LOG_UTILS_016](@ref TC_LOG_UTILS_016)
+ */
+void test_log_filter_binary_shutdown(){
+    log_config config = {.path = "test/test_log.bin", .format = LOG_FORMAT_BINARY, .filter = LOG_FILTER_TRANSITIONS, .async = true};
+    char message[16];
+
+    TEST_ASSERT_EQUAL(0, log_init(&config));
+    for (int i = 0; i < 500; i++) {
+        log_event("AEB1", ID_EMPTY, actuators_test);
+    }
+    log_shutdown();
+
+    FILE *in = fopen("test/test_log.bin", "rb");
+    FILE *out = fopen("log/log.txt", "w");
+    TEST_ASSERT_EQUAL(2, log_bin_decode(in, out));
+    fclose(in);
+    fclose(out);
+
+    read_message_test(2, message, sizeof(message));
+    TEST_ASSERT_EQUAL_STRING("SUMMARY 499", message);
+}
+
+/**
+ * @test
+ * @brief Verifies size based rotation: bounded segments, each starting with the header,
+ * only rotate_keep rotated segments kept.
+ * 
+ * \anchor test_log_rotate_size
+ * test ID [TC_LOG_UTILS_017](@ref TC_LOG_UTILS_017)
+ */
+void test_log_rotate_size(){
+    log_config config = {.path = "test/test_rot.txt", .rotate_max_bytes = 1000, .rotate_keep = 2};
+    long size;
+
+    TEST_ASSERT_EQUAL(0, log_init(&config));
+    for (int i = 0; i < 100; i++) {
+        log_event("AEB1", ID_AEB_S, actuators_test);
+    }
+    log_shutdown();
+
+    TEST_ASSERT_TRUE(count_segment_events_test("test/test_rot.txt", &size) > 0);
+    TEST_ASSERT_TRUE(size <= 1000);
+    TEST_ASSERT_TRUE(count_segment_events_test("test/test_rot.txt.1", &size) > 0);
+    TEST_ASSERT_TRUE(size <= 1000);
+    TEST_ASSERT_TRUE(count_segment_events_test("test/test_rot.txt.2", &size) > 0);
+    TEST_ASSERT_EQUAL(-1, count_segment_events_test("test/test_rot.txt.3", &size));
+    TEST_ASSERT_EQUAL(-1, count_segment_events_test("test/test_rot.txt.spare", &size));
+}
+
+/**
+ * @test
+ * @brief Verifies that no event is lost across rotations.
+ * 
+ * \anchor test_log_rotate_no_loss
+ * test ID [TC_LOG_UTILS_018](@ref TC_LOG_UTILS_018)
+ */
+void test_log_rotate_no_loss(){
+    log_config config = {.path = "test/test_rot.txt", .rotate_max_bytes = 1000, .rotate_keep = 10};
+    char path[64];
+    long size;
+    int events = 0;
+
+    TEST_ASSERT_EQUAL(0, log_init(&config));
+    for (int i = 0; i < 100; i++) {
+        log_event("AEB1", ID_AEB_S, actuators_test);
+    }
+    log_shutdown();
+
+    events += count_segment_events_test("test/test_rot.txt", &size);
+    for (int k = 1; k <= 10; k++) {
+        snprintf(path, sizeof(path), "test/test_rot.txt.%d", k);
+        int segment_events = count_segment_events_test(path, &size);
+        if (segment_events > 0) {
+            events += segment_events;
+        }
+    }
+    TEST_ASSERT_EQUAL(100, events);
+}
+
+/**
+ * @test
+ * @brief Verifies time based rotation.
+ * 
+ * \anchor test_log_rotate_interval
+ * test ID [TC_LOG_UTILS_019](@ref TC_LOG_UTILS_019)
+ */
+void test_log_rotate_interval(){
+    log_config config = {.path = "test/test_rot.txt", .rotate_interval_ms = 50};
+    long size;
+
+    TEST_ASSERT_EQUAL(0, log_init(&config));
+    log_event("AEB1", ID_AEB_S, actuators_test);
+    log_event("AEB1", ID_AEB_S, actuators_test);
+    usleep(60000);
+    log_event("AEB1", ID_AEB_S, actuators_test);
+    log_shutdown();
+
+    TEST_ASSERT_EQUAL(1, count_segment_events_test("test/test_rot.txt", &size));
+    TEST_ASSERT_EQUAL(2, count_segment_events_test("test/test_rot.txt.1", &size));
+}
+
+/**
+ * @test
+ * @brief Verifies that log_written_bytes counts the bytes of the events written to the file,
+ * without the header, and restarts at 0 with log_init.
+ * 
+ * \anchor test_log_written_bytes
+ * test ID [TC_LOG_UTILS_020](@ref TC_LOG_UTILS_020)
+ */
+void test_log_written_bytes(){
+    log_config config = {.path = LOG_FILE_PATH, .flush_policy = LOG_FLUSH_EVERY_EVENT};
+    TEST_ASSERT_EQUAL(0, log_init(&config));
+    TEST_ASSERT_EQUAL(0, log_written_bytes());
+
+    for (int i = 0; i < 3; i++) {
+        log_event("Bytes", can_frame_test.identifier, actuators_test);
+    }
+    log_shutdown();
+
+    FILE *file = fopen(LOG_FILE_PATH, "r");
+    TEST_ASSERT_NOT_NULL(file);
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    TEST_ASSERT_EQUAL(size - (long)strlen(LOG_HEADER), (long)log_written_bytes());
+
+    TEST_ASSERT_EQUAL(0, log_init(&config));
+    TEST_ASSERT_EQUAL(0, log_written_bytes());
 }
 
 int main(){
@@ -159,5 +703,23 @@ int main(){
     RUN_TEST(test_log_event_fopen_fail);
     RUN_TEST(test_log_event_check_writing_no1);
     RUN_TEST(test_log_event_file_already_exists);
+    RUN_TEST(test_log_init_header_once);
+    RUN_TEST(test_log_flush_every_n);
+    RUN_TEST(test_log_flush_interval);
+    RUN_TEST(test_log_init_fopen_fail);
+    RUN_TEST(test_log_async_writes_all);
+    RUN_TEST(test_log_async_ring_full);
+    RUN_TEST(test_log_async_invalid_capacity);
+    RUN_TEST(test_log_bin_pack_unpack);
+    RUN_TEST(test_log_binary_round_trip);
+    RUN_TEST(test_log_binary_bad_checksum);
+    RUN_TEST(test_log_binary_not_binary);
+    RUN_TEST(test_log_filter_transitions);
+    RUN_TEST(test_log_filter_summary_interval);
+    RUN_TEST(test_log_filter_binary_shutdown);
+    RUN_TEST(test_log_rotate_size);
+    RUN_TEST(test_log_rotate_no_loss);
+    RUN_TEST(test_log_rotate_interval);
+    RUN_TEST(test_log_written_bytes);
     return UNITY_END();
 }
\ No newline at end of file
@@ -0,0 +1,122 @@
+#include "unity.h"
+#include "mailbox.h"
+#include "dbc.h"
+
+#define TEST_SHM "/shm_aeb_test_mailbox"
+
+mailbox box_test;
+
+void setUp()
+{
+    mailbox_destroy(TEST_SHM);
+    TEST_ASSERT_EQUAL(0, mailbox_create(TEST_SHM));
+    TEST_ASSERT_EQUAL(0, mailbox_attach(&box_test, TEST_SHM));
+}
+
+void tearDown()
+{
+    mailbox_detach(&box_test);
+    mailbox_destroy(TEST_SHM);
+}
+
+/**
+ * @brief Helper function, posts a frame of the given ID carrying value in its first byte.
+ */
+int post_test(uint32_t identifier, uint8_t value)
+{
+    can_msg frame = {.identifier = identifier, .dataFrame = BASE_DATA_FRAME};
+    frame.dataFrame[0] = value;
+    return mailbox_post(&box_test, &frame);
+}
+
+/**
+ * @test
+ * @brief Tests that a reader gets only the newest of many posted frames, once.
+ *
+ * \anchor test_mailbox_latest_wins
+ * test ID [TC_MAILBOX_001](@ref TC_MAILBOX_001)
+ */
+void test_mailbox_latest_wins()
+{
+    can_msg frame;
+    uint32_t version = 0;
+
+    TEST_ASSERT_EQUAL(-1, mailbox_take(&box_test, ID_AEB_S, &frame, &version));
+    for (int i = 0; i < 100; i++)
+    {
+        TEST_ASSERT_EQUAL(0, post_test(ID_AEB_S, (uint8_t)i));
+    }
+
+    TEST_ASSERT_EQUAL(1, mailbox_take(&box_test, ID_AEB_S, &frame, &version));
+    TEST_ASSERT_EQUAL_HEX32(ID_AEB_S, frame.identifier);
+    TEST_ASSERT_EQUAL(99, frame.dataFrame[0]);
+    TEST_ASSERT_EQUAL(0, mailbox_take(&box_test, ID_AEB_S, &frame, &version));
+
+    post_test(ID_AEB_S, 100);
+    TEST_ASSERT_EQUAL(1, mailbox_take(&box_test, ID_AEB_S, &frame, &version));
+    TEST_ASSERT_EQUAL(100, frame.dataFrame[0]);
+}
+
+/**
+ * @test
+ * @brief Tests that each CAN ID, ID_EMPTY included, keeps its own newest frame.
+ *
+ * \anchor test_mailbox_per_id
+ * test ID [TC_MAILBOX_002](@ref TC_MAILBOX_002)
+ */
+void test_mailbox_per_id()
+{
+    can_msg frame;
+    uint32_t aeb_s_version = 0, empty_version = 0;
+
+    post_test(ID_AEB_S, 1);
+    post_test(ID_EMPTY, 2);
+    post_test(ID_SPEED_S, 3);
+
+    TEST_ASSERT_EQUAL(1, mailbox_take(&box_test, ID_EMPTY, &frame, &empty_version));
+    TEST_ASSERT_EQUAL(2, frame.dataFrame[0]);
+    TEST_ASSERT_EQUAL(1, mailbox_take(&box_test, ID_AEB_S, &frame, &aeb_s_version));
+    TEST_ASSERT_EQUAL(1, frame.dataFrame[0]);
+    TEST_ASSERT_EQUAL(-1, mailbox_take(&box_test, ID_OBSTACLE_S, &frame, &aeb_s_version));
+}
+
+/**
+ * @test
+ * @brief Tests that a frame being written (odd sequence) is not read and that the mailbox holds at
+ * most MAILBOX_SLOTS IDs.
+ *
+ * \anchor test_mailbox_busy_and_full
+ * test ID [TC_MAILBOX_003](@ref TC_MAILBOX_003)
+ */
+void test_mailbox_busy_and_full()
+{
+    can_msg frame = {.identifier = ID_EMPTY, .dataFrame = BASE_DATA_FRAME};
+    uint32_t version = 0;
+
+    post_test(ID_AEB_S, 7);
+    for (int i = 0; i < MAILBOX_SLOTS; i++)
+    {
+        if (box_test.header->slot[i].identifier == ID_AEB_S)
+        {
+            atomic_fetch_add(&box_test.header->slot[i].sequence, 1); // Writer stopped in the middle
+        }
+    }
+    TEST_ASSERT_EQUAL(0, mailbox_take(&box_test, ID_AEB_S, &frame, &version));
+    TEST_ASSERT_EQUAL_HEX32(ID_EMPTY, frame.identifier);
+
+    for (uint32_t id = 1; id < MAILBOX_SLOTS; id++)
+    {
+        TEST_ASSERT_EQUAL(0, post_test(id, 0));
+    }
+    TEST_ASSERT_EQUAL(-1, post_test(MAILBOX_SLOTS, 0));
+    TEST_ASSERT_EQUAL(0, post_test(3, 1));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_mailbox_latest_wins);
+    RUN_TEST(test_mailbox_per_id);
+    RUN_TEST(test_mailbox_busy_and_full);
+    return UNITY_END();
+}
@@ -0,0 +1,172 @@
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "unity.h"
+#include "metrics.h"
+
+#define TEST_SHM "/shm_aeb_test_metrics"
+
+enum
+{
+    TEST_METRIC_FRAMES,
+    TEST_METRIC_DEPTH,
+    TEST_METRIC_CYCLE_MAX,
+    TEST_METRICS
+};
+
+static const metric_desc test_desc[TEST_METRICS] = {
+    {"frames", METRIC_COUNTER}, {"depth", METRIC_GAUGE}, {"cycle_max", METRIC_GAUGE}};
+
+void setUp()
+{
+    metrics_destroy(TEST_SHM);
+    TEST_ASSERT_EQUAL(0, metrics_create(TEST_SHM));
+}
+
+void tearDown()
+{
+    metrics_destroy(TEST_SHM);
+}
+
+/**
+ * @brief Helper function, finds the registered block with the given name.
+ *
+ * @return 1 if the block was found and copied, 0 otherwise.
+ */
+int find_block(const metrics_header *header, const char *name, metrics_sample *sample)
+{
+    for (uint32_t i = 0; i < METRICS_BLOCKS; i++)
+    {
+        if (metrics_read(header, i, sample) == 1 && strcmp(sample->name, name) == 0)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @test
+ * @brief Tests that the counters and gauges updated by a thread are read by a sampler mapping
+ * the segment, with the names and kinds given at registration.
+ *
+ * \anchor test_metrics_register_and_read
+ * test ID [TC_METRICS_001](@ref TC_METRICS_001)
+ */
+void test_metrics_register_and_read()
+{
+    metrics m;
+    TEST_ASSERT_EQUAL(0, metrics_register(&m, TEST_SHM, "controller", test_desc, TEST_METRICS));
+    for (int i = 0; i < 5; i++)
+    {
+        metrics_add(&m, TEST_METRIC_FRAMES, 2);
+    }
+    metrics_set(&m, TEST_METRIC_DEPTH, 7);
+    metrics_max(&m, TEST_METRIC_CYCLE_MAX, 40);
+    metrics_max(&m, TEST_METRIC_CYCLE_MAX, 30);
+
+    const metrics_header *header = metrics_open(TEST_SHM);
+    TEST_ASSERT_NOT_NULL(header);
+    metrics_sample sample;
+    TEST_ASSERT_EQUAL(1, find_block(header, "controller", &sample));
+    TEST_ASSERT_EQUAL(getpid(), sample.pid);
+    TEST_ASSERT_EQUAL(TEST_METRICS, sample.count);
+    TEST_ASSERT_EQUAL_STRING("frames", sample.metric_name[TEST_METRIC_FRAMES]);
+    TEST_ASSERT_EQUAL(METRIC_COUNTER, sample.kind[TEST_METRIC_FRAMES]);
+    TEST_ASSERT_EQUAL(METRIC_GAUGE, sample.kind[TEST_METRIC_DEPTH]);
+    TEST_ASSERT_EQUAL_UINT64(10, sample.value[TEST_METRIC_FRAMES]);
+    TEST_ASSERT_EQUAL_UINT64(7, sample.value[TEST_METRIC_DEPTH]);
+    TEST_ASSERT_EQUAL_UINT64(40, sample.value[TEST_METRIC_CYCLE_MAX]);
+
+    // A released block is no longer sampled
+    metrics_release(&m);
+    TEST_ASSERT_NULL(m.block);
+    TEST_ASSERT_EQUAL(0, find_block(header, "controller", &sample));
+    metrics_close(header);
+}
+
+/**
+ * @test
+ * @brief Tests that registration fails without a segment or once every block is taken, and
+ * that the updates of an unregistered handle are ignored.
+ *
+ * \anchor test_metrics_unregistered
+ * test ID [TC_METRICS_002](@ref TC_METRICS_002)
+ */
+void test_metrics_unregistered()
+{
+    metrics blocks[METRICS_BLOCKS];
+    metrics extra;
+
+    for (int i = 0; i < METRICS_BLOCKS; i++)
+    {
+        TEST_ASSERT_EQUAL(0, metrics_register(&blocks[i], TEST_SHM, "thread", test_desc, TEST_METRICS));
+    }
+    TEST_ASSERT_EQUAL(-1, metrics_register(&extra, TEST_SHM, "thread", test_desc, TEST_METRICS));
+    TEST_ASSERT_NULL(extra.block);
+    metrics_add(&extra, TEST_METRIC_FRAMES, 1); // Ignored
+    metrics_set(&extra, TEST_METRIC_DEPTH, 1);
+
+    metrics_release(&blocks[0]);
+    TEST_ASSERT_EQUAL(0, metrics_register(&extra, TEST_SHM, "thread", test_desc, TEST_METRICS));
+    metrics_release(&extra);
+    for (int i = 1; i < METRICS_BLOCKS; i++)
+    {
+        metrics_release(&blocks[i]);
+    }
+
+    TEST_ASSERT_EQUAL(-1, metrics_register(&extra, TEST_SHM, "thread", test_desc, METRICS_PER_BLOCK + 1));
+    metrics_destroy(TEST_SHM);
+    TEST_ASSERT_EQUAL(-1, metrics_register(&extra, TEST_SHM, "thread", test_desc, TEST_METRICS));
+    TEST_ASSERT_NULL(metrics_open(TEST_SHM));
+}
+
+/**
+ * @test
+ * @brief Tests that the block of a process that exited without releasing it is claimed again,
+ * with its values reset.
+ *
+ * \anchor test_metrics_reclaim_dead_owner
+ * test ID [TC_METRICS_003](@ref TC_METRICS_003)
+ */
+void test_metrics_reclaim_dead_owner()
+{
+    pid_t child = fork();
+    TEST_ASSERT_NOT_EQUAL(-1, child);
+    if (child == 0)
+    {
+        metrics m;
+        metrics_register(&m, TEST_SHM, "crashed", test_desc, TEST_METRICS);
+        metrics_add(&m, TEST_METRIC_FRAMES, 99);
+        _exit(0); // No metrics_release
+    }
+    waitpid(child, NULL, 0);
+
+    const metrics_header *header = metrics_open(TEST_SHM);
+    metrics_sample sample;
+    TEST_ASSERT_EQUAL(1, find_block(header, "crashed", &sample));
+    TEST_ASSERT_EQUAL(child, sample.pid);
+
+    metrics blocks[METRICS_BLOCKS];
+    for (int i = 0; i < METRICS_BLOCKS; i++)
+    {
+        TEST_ASSERT_EQUAL(0, metrics_register(&blocks[i], TEST_SHM, "thread", test_desc, TEST_METRICS));
+        TEST_ASSERT_EQUAL_UINT64(0, atomic_load(&blocks[i].block->value[TEST_METRIC_FRAMES]));
+    }
+    TEST_ASSERT_EQUAL(0, find_block(header, "crashed", &sample));
+
+    for (int i = 0; i < METRICS_BLOCKS; i++)
+    {
+        metrics_release(&blocks[i]);
+    }
+    metrics_close(header);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_metrics_register_and_read);
+    RUN_TEST(test_metrics_unregistered);
+    RUN_TEST(test_metrics_reclaim_dead_owner);
+    return UNITY_END();
+}
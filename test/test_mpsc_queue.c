@@ -0,0 +1,131 @@
+#include "unity.h"
+#include "mpsc_queue.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+
+#define TEST_PRODUCERS 4
+#define TEST_STREAM_LENGTH 50000
+
+mpsc_queue queue;
+
+void setUp()
+{
+    // Each test initializes the queue with the capacity it needs
+}
+
+void tearDown()
+{
+    mpsc_destroy(&queue);
+}
+
+/**
+ * @test
+ * @brief Tests that the queue only accepts power of two capacities.
+ *
+ * \anchor test_mpsc_init_invalid_capacity
+ * test ID [TC_MPSC_001](@ref TC_MPSC_001)
+ */
+void test_mpsc_init_invalid_capacity()
+{
+    TEST_ASSERT_EQUAL(-1, mpsc_init(&queue, 0, sizeof(int)));
+    TEST_ASSERT_EQUAL(-1, mpsc_init(&queue, 6, sizeof(int)));
+    TEST_ASSERT_EQUAL(0, mpsc_init(&queue, 8, sizeof(int)));
+    TEST_ASSERT_EQUAL(0, mpsc_size(&queue));
+}
+
+/**
+ * @test
+ * @brief Tests FIFO order, push failing on a full queue and slots reused after wrapping around.
+ *
+ * \anchor test_mpsc_full_and_wrap_around
+ * test ID [TC_MPSC_002](@ref TC_MPSC_002)
+ */
+void test_mpsc_full_and_wrap_around()
+{
+    int value;
+    mpsc_init(&queue, 2, sizeof(int));
+
+    TEST_ASSERT_EQUAL(-1, mpsc_pop(&queue, &value));
+    for (int round = 0; round < 5; round++)
+    {
+        int first = 2 * round, second = 2 * round + 1;
+        TEST_ASSERT_EQUAL(0, mpsc_push(&queue, &first));
+        TEST_ASSERT_EQUAL(0, mpsc_push(&queue, &second));
+        TEST_ASSERT_EQUAL(-1, mpsc_push(&queue, &second));
+        TEST_ASSERT_EQUAL(2, mpsc_size(&queue));
+
+        TEST_ASSERT_EQUAL(0, mpsc_pop(&queue, &value));
+        TEST_ASSERT_EQUAL(first, value);
+        TEST_ASSERT_EQUAL(0, mpsc_pop(&queue, &value));
+        TEST_ASSERT_EQUAL(second, value);
+    }
+    TEST_ASSERT_EQUAL(-1, mpsc_pop(&queue, &value));
+}
+
+void *producer_thread(void *arg)
+{
+    uint32_t producer = (uint32_t)(uintptr_t)arg;
+    for (uint32_t i = 0; i < TEST_STREAM_LENGTH; i++)
+    {
+        // Producer number in the high bits, sequence in the low bits
+        uint32_t value = (producer << 24) | i;
+        while (mpsc_push(&queue, &value) != 0)
+        {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @test
+ * @brief Tests that several producer threads and one consumer exchange their streams without
+ * loss, and that each producer's elements keep their order.
+ *
+ * \anchor test_mpsc_several_producers
+ * test ID [TC_MPSC_003](@ref TC_MPSC_003)
+ */
+void test_mpsc_several_producers()
+{
+    pthread_t producers[TEST_PRODUCERS];
+    uint32_t expected[TEST_PRODUCERS] = {0};
+    uint32_t value;
+    uint32_t received = 0;
+    mpsc_init(&queue, 16, sizeof(uint32_t));
+
+    for (uintptr_t p = 0; p < TEST_PRODUCERS; p++)
+    {
+        pthread_create(&producers[p], NULL, producer_thread, (void *)p);
+    }
+    while (received < TEST_PRODUCERS * TEST_STREAM_LENGTH)
+    {
+        if (mpsc_pop(&queue, &value) == 0)
+        {
+            uint32_t producer = value >> 24;
+            TEST_ASSERT_LESS_THAN_UINT32(TEST_PRODUCERS, producer);
+            TEST_ASSERT_EQUAL_UINT32(expected[producer], value & 0xFFFFFF);
+            expected[producer]++;
+            received++;
+        }
+        else
+        {
+            sched_yield();
+        }
+    }
+    for (int p = 0; p < TEST_PRODUCERS; p++)
+    {
+        pthread_join(producers[p], NULL);
+    }
+
+    TEST_ASSERT_EQUAL(0, mpsc_size(&queue));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_mpsc_init_invalid_capacity);
+    RUN_TEST(test_mpsc_full_and_wrap_around);
+    RUN_TEST(test_mpsc_several_producers);
+    return UNITY_END();
+}
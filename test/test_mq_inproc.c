@@ -0,0 +1,76 @@
+#include "unity.h"
+#include "mq_utils.h"
+
+#define TEST_MQ_SENSORS "/test_mq_inproc_sensors"
+#define TEST_MQ_ACTUATORS "/test_mq_inproc_actuators"
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+/**
+ * @test
+ * @brief Tests that the module that opens a queue and the module that creates it get the same
+ * queue, whichever comes first, and that different names get different queues.
+ *
+ * \anchor test_mq_inproc_same_name
+ * test ID [TC_MQ_INPROC_001](@ref TC_MQ_INPROC_001)
+ */
+void test_mq_inproc_same_name()
+{
+    mqd_t reader = open_mq(TEST_MQ_SENSORS);
+    mqd_t writer = create_mq(TEST_MQ_SENSORS);
+    mqd_t other = create_mq(TEST_MQ_ACTUATORS);
+
+    TEST_ASSERT_NOT_EQUAL((mqd_t)-1, reader);
+    TEST_ASSERT_EQUAL(reader, writer);
+    TEST_ASSERT_NOT_EQUAL(reader, other);
+
+    close_mq(writer, TEST_MQ_SENSORS);
+    close_mq(other, TEST_MQ_ACTUATORS);
+}
+
+/**
+ * @test
+ * @brief Tests that frames are read in the order they were written, that a read from an empty
+ * queue and a write to a full queue fail, and that the attributes report the capacity.
+ *
+ * \anchor test_mq_inproc_fifo
+ * test ID [TC_MQ_INPROC_002](@ref TC_MQ_INPROC_002)
+ */
+void test_mq_inproc_fifo()
+{
+    mqd_t mqd = create_mq(TEST_MQ_SENSORS);
+    struct mq_attr attr = get_mq_attr();
+    can_msg frame = {.identifier = ID_SPEED_S, .dataFrame = BASE_DATA_FRAME};
+
+    TEST_ASSERT_EQUAL(-1, read_mq(mqd, &frame));
+    for (long i = 0; i < attr.mq_maxmsg; i++)
+    {
+        frame.dataFrame[0] = (uint8_t)i;
+        TEST_ASSERT_EQUAL(0, write_mq(mqd, &frame));
+    }
+    TEST_ASSERT_EQUAL(-1, write_mq(mqd, &frame));
+
+    for (long i = 0; i < attr.mq_maxmsg; i++)
+    {
+        TEST_ASSERT_EQUAL(0, read_mq(mqd, &frame));
+        TEST_ASSERT_EQUAL_HEX32(ID_SPEED_S, frame.identifier);
+        TEST_ASSERT_EQUAL(i, frame.dataFrame[0]);
+    }
+    TEST_ASSERT_EQUAL(-1, read_mq(mqd, &frame));
+
+    close_mq(mqd, TEST_MQ_SENSORS);
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_mq_inproc_same_name);
+    RUN_TEST(test_mq_inproc_fifo);
+    return UNITY_END();
+}
@@ -257,6 +257,29 @@ void test_read_and_write_mq_valid_can_msg()
     close_mq(mqd, mq_name);
 }
 
+/**
+ * @test
+ * @brief Tests that depth_mq() counts the messages waiting in the queue, and fails for a
+ * descriptor that isn't a queue.
+ *
+ * \anchor test_depth_mq
+ * test ID [TC_MQ_UTILS_012](@ref TC_MQ_UTILS_012)
+ */
+void test_depth_mq()
+{
+    mqd = create_mq(mq_name);
+    can_msg msg = {0};
+    TEST_ASSERT_EQUAL(0, depth_mq(mqd));
+    write_mq(mqd, &msg);
+    write_mq(mqd, &msg);
+    TEST_ASSERT_EQUAL(2, depth_mq(mqd));
+    read_mq(mqd, &msg);
+    TEST_ASSERT_EQUAL(1, depth_mq(mqd));
+    close_mq(mqd, mq_name);
+
+    TEST_ASSERT_EQUAL(-1, depth_mq((mqd_t)-1));
+}
+
 int main()
 {
     UNITY_BEGIN();
@@ -271,5 +294,6 @@ int main()
     RUN_TEST(test_write_mq_full_queue);
     RUN_TEST(test_read_and_write_mq_empty_can_msg);
     RUN_TEST(test_read_and_write_mq_valid_can_msg);
+    RUN_TEST(test_depth_mq);
     return UNITY_END();
 }
\ No newline at end of file
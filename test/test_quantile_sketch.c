@@ -0,0 +1,102 @@
+#include "unity.h"
+#include "quantile_sketch.h"
+#include <math.h>
+
+qsketch sketch_test, other_test;
+
+void setUp()
+{
+    qsketch_init(&sketch_test);
+    qsketch_init(&other_test);
+}
+
+void tearDown()
+{
+}
+
+/**
+ * @brief Helper function, checks that a quantile estimate is within the relative accuracy.
+ */
+void assert_relative_test(double expected, double actual)
+{
+    TEST_ASSERT_DOUBLE_WITHIN(expected * QSKETCH_RELATIVE_ACCURACY + 1e-9, expected, actual);
+}
+
+/**
+ * @test
+ * @brief Tests that the quantiles of 100000 values are within the relative accuracy and that
+ * min, max and count are exact.
+ *
+ * \anchor test_qsketch_accuracy
+ * test ID [TC_QSKETCH_001](@ref TC_QSKETCH_001)
+ */
+void test_qsketch_accuracy()
+{
+    for (int i = 1; i <= 100000; i++)
+    {
+        qsketch_add(&sketch_test, i / 1000.0);
+    }
+
+    TEST_ASSERT_EQUAL_UINT64(100000, sketch_test.count);
+    TEST_ASSERT_EQUAL_DOUBLE(0.001, qsketch_quantile(&sketch_test, 0.0));
+    TEST_ASSERT_EQUAL_DOUBLE(100.0, qsketch_quantile(&sketch_test, 1.0));
+    assert_relative_test(50.0, qsketch_quantile(&sketch_test, 0.5));
+    assert_relative_test(90.0, qsketch_quantile(&sketch_test, 0.9));
+    assert_relative_test(99.0, qsketch_quantile(&sketch_test, 0.99));
+    assert_relative_test(99.9, qsketch_quantile(&sketch_test, 0.999));
+}
+
+/**
+ * @test
+ * @brief Tests that merging two sketches gives the sketch of the union of their values.
+ *
+ * \anchor test_qsketch_merge
+ * test ID [TC_QSKETCH_002](@ref TC_QSKETCH_002)
+ */
+void test_qsketch_merge()
+{
+    qsketch all;
+    qsketch_init(&all);
+    for (int i = 1; i <= 1000; i++)
+    {
+        qsketch_add(i % 3 == 0 ? &sketch_test : &other_test, i * 0.01);
+        qsketch_add(&all, i * 0.01);
+    }
+
+    qsketch_merge(&sketch_test, &other_test);
+
+    TEST_ASSERT_EQUAL_UINT64(all.count, sketch_test.count);
+    TEST_ASSERT_EQUAL_DOUBLE(all.min, sketch_test.min);
+    TEST_ASSERT_EQUAL_DOUBLE(all.max, sketch_test.max);
+    TEST_ASSERT_EQUAL_MEMORY(all.buckets, sketch_test.buckets, sizeof(all.buckets));
+    TEST_ASSERT_EQUAL_DOUBLE(qsketch_quantile(&all, 0.9), qsketch_quantile(&sketch_test, 0.9));
+}
+
+/**
+ * @test
+ * @brief Tests an empty sketch and values outside the range of the buckets.
+ *
+ * \anchor test_qsketch_limits
+ * test ID [TC_QSKETCH_003](@ref TC_QSKETCH_003)
+ */
+void test_qsketch_limits()
+{
+    TEST_ASSERT_TRUE(isnan(qsketch_quantile(&sketch_test, 0.5)));
+
+    qsketch_add(&sketch_test, 0.0);
+    qsketch_add(&sketch_test, 1e-6);
+    qsketch_add(&sketch_test, 1e9);
+    TEST_ASSERT_EQUAL_UINT64(2, sketch_test.zero_count);
+    TEST_ASSERT_EQUAL_UINT64(1, sketch_test.buckets[QSKETCH_BUCKETS - 1]);
+    TEST_ASSERT_EQUAL_DOUBLE(0.0, qsketch_quantile(&sketch_test, 0.5));
+    TEST_ASSERT_EQUAL_DOUBLE(1e9, qsketch_quantile(&sketch_test, 1.0));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_qsketch_accuracy);
+    RUN_TEST(test_qsketch_merge);
+    RUN_TEST(test_qsketch_limits);
+    return UNITY_END();
+}
@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "unity.h"
+#include "readiness.h"
+
+int pipe_test[2];
+int hook_calls;
+
+void count_hook_calls(void)
+{
+    hook_calls++;
+}
+
+void setUp()
+{
+    TEST_ASSERT_EQUAL(0, pipe(pipe_test));
+}
+
+void tearDown()
+{
+    close(pipe_test[0]);
+    close(pipe_test[1]);
+    unsetenv(READINESS_ENV);
+}
+
+/**
+ * @test
+ * @brief Tests that a process notifies the descriptor named in READINESS_ENV once, and that
+ * nothing is written without it.
+ *
+ * \anchor test_readiness_notify_once
+ * test ID [TC_READINESS_001](@ref TC_READINESS_001)
+ */
+void test_readiness_notify_once()
+{
+    char fd[8];
+    int notified = dup(pipe_test[1]); // Closed by readiness_notify
+    snprintf(fd, sizeof(fd), "%d", notified);
+    setenv(READINESS_ENV, fd, 1);
+
+    readiness_notify();
+    TEST_ASSERT_NULL(getenv(READINESS_ENV));
+    readiness_notify(); // Already notified: nothing written
+    TEST_ASSERT_EQUAL(-1, write(notified, "x", 1));
+
+    TEST_ASSERT_EQUAL(1, readiness_wait(pipe_test[0], 2, 50));
+}
+
+/**
+ * @test
+ * @brief Tests that the launcher counts the processes that are ready and stops waiting at the
+ * timeout.
+ *
+ * \anchor test_readiness_wait_timeout
+ * test ID [TC_READINESS_002](@ref TC_READINESS_002)
+ */
+void test_readiness_wait_timeout()
+{
+    struct timespec start, end;
+    TEST_ASSERT_EQUAL(3, write(pipe_test[1], "\1\1\1", 3)); // Three processes ready
+
+    TEST_ASSERT_EQUAL(2, readiness_wait(pipe_test[0], 2, 50));
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    TEST_ASSERT_EQUAL(1, readiness_wait(pipe_test[0], 4, 50));
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    long waited_ms = (end.tv_sec - start.tv_sec) * 1000 + (end.tv_nsec - start.tv_nsec) / 1000000;
+    TEST_ASSERT_INT_WITHIN(25, 50, waited_ms);
+}
+
+/**
+ * @test
+ * @brief Tests that with a hook set, as aeb_all_bin does, each module notification calls the hook
+ * and nothing is written to the pipe, even with READINESS_ENV set.
+ *
+ * \anchor test_readiness_hook
+ * test ID [TC_READINESS_003](@ref TC_READINESS_003)
+ */
+void test_readiness_hook()
+{
+    char fd[8];
+    snprintf(fd, sizeof(fd), "%d", pipe_test[1]);
+    setenv(READINESS_ENV, fd, 1);
+    hook_calls = 0;
+
+    readiness_set_hook(count_hook_calls);
+    readiness_notify();
+    readiness_notify(); // One call per module, not once per process
+    readiness_set_hook(NULL);
+
+    TEST_ASSERT_EQUAL(2, hook_calls);
+    TEST_ASSERT_NOT_NULL(getenv(READINESS_ENV));
+    TEST_ASSERT_EQUAL(0, readiness_wait(pipe_test[0], 1, 20));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_readiness_notify_once);
+    RUN_TEST(test_readiness_wait_timeout);
+    RUN_TEST(test_readiness_hook);
+    return UNITY_END();
+}
@@ -2,6 +2,8 @@
 #include <sys/stat.h>
 #include "sensors_input.h"
 #include "dbc.h"
+#include "sensors.h"
+#include "constants.h"
 
 // Declaration of functions implemented in sensors.c that will be tested
 can_msg conv2CANCarClusterData(bool aeb_system_enabled);
@@ -241,6 +243,286 @@ void test_conv2CANPedalsData_NoneActive()
 }
 
 
+
+/** 
+ * @test
+ * @brief Tests that the transmit timer ticks at the greatest common divisor of the periods
+ * [SwR-9] (@ref SwR-9)
+ * \anchor test_txScheduleTick_Gcd
+ * [TC_SENSORS_011](@ref TC_SENSORS_011)
+*/
+void test_txScheduleTick_Gcd()
+{
+    can_tx_schedule schedule[] = {
+        {.identifier = ID_CAR_C, .period_ms = TX_PERIOD_CAR_C_MS},
+        {.identifier = ID_SPEED_S, .period_ms = TX_PERIOD_SPEED_MS},
+        {.identifier = ID_OBSTACLE_S, .period_ms = TX_PERIOD_OBSTACLE_MS},
+        {.identifier = ID_PEDALS, .period_ms = TX_PERIOD_PEDALS_MS}};
+
+    TEST_ASSERT_EQUAL_UINT(10, txScheduleTick(schedule, 4, SCENARIO_ROW_PERIOD_MS));
+    TEST_ASSERT_EQUAL_UINT(SCENARIO_ROW_PERIOD_MS, txScheduleTick(schedule, 0, SCENARIO_ROW_PERIOD_MS));
+
+    schedule[0].period_ms = 300;
+    TEST_ASSERT_EQUAL_UINT(100, txScheduleTick(schedule, 1, SCENARIO_ROW_PERIOD_MS));
+}
+
+/** 
+ * @test
+ * @brief Tests that each frame is reported as due once per period, in table order
+ * [SwR-9] (@ref SwR-9)
+ * \anchor test_txScheduleDue_Periods
+ * [TC_SENSORS_012](@ref TC_SENSORS_012)
+*/
+void test_txScheduleDue_Periods()
+{
+    can_tx_schedule schedule[] = {
+        {.identifier = ID_CAR_C, .period_ms = 100},
+        {.identifier = ID_SPEED_S, .period_ms = 10},
+        {.identifier = ID_OBSTACLE_S, .period_ms = 20}};
+    uint32_t due_ids[3];
+    int speed_count = 0, obstacle_count = 0, cluster_count = 0;
+
+    // At t = 0 every frame is due, in table order
+    TEST_ASSERT_EQUAL(3, txScheduleDue(schedule, 3, 0, due_ids));
+    TEST_ASSERT_EQUAL_HEX32(ID_CAR_C, due_ids[0]);
+    TEST_ASSERT_EQUAL_HEX32(ID_SPEED_S, due_ids[1]);
+    TEST_ASSERT_EQUAL_HEX32(ID_OBSTACLE_S, due_ids[2]);
+
+    for (unsigned long now = 10; now < 1000; now += 10)
+    {
+        size_t count = txScheduleDue(schedule, 3, now, due_ids);
+        for (size_t i = 0; i < count; i++)
+        {
+            speed_count += due_ids[i] == ID_SPEED_S;
+            obstacle_count += due_ids[i] == ID_OBSTACLE_S;
+            cluster_count += due_ids[i] == ID_CAR_C;
+        }
+    }
+
+    TEST_ASSERT_EQUAL(99, speed_count);
+    TEST_ASSERT_EQUAL(49, obstacle_count);
+    TEST_ASSERT_EQUAL(9, cluster_count);
+}
+
+/** 
+ * @test
+ * @brief Tests that missed deadlines are skipped instead of sent in a burst, and that a restart makes frames due
+ * [SwR-9] (@ref SwR-9)
+ * \anchor test_txScheduleDue_LateTick
+ * [TC_SENSORS_013](@ref TC_SENSORS_013)
+*/
+void test_txScheduleDue_LateTick()
+{
+    can_tx_schedule schedule[] = {{.identifier = ID_SPEED_S, .period_ms = 10}};
+    uint32_t due_ids[1];
+
+    TEST_ASSERT_EQUAL(1, txScheduleDue(schedule, 1, 0, due_ids));
+    TEST_ASSERT_EQUAL(1, txScheduleDue(schedule, 1, 55, due_ids));
+    TEST_ASSERT_EQUAL_UINT32(60, schedule[0].next_due_ms);
+    TEST_ASSERT_EQUAL(0, txScheduleDue(schedule, 1, 59, due_ids));
+
+    // A restart (new streamed row) makes the frame due immediately
+    txScheduleRestart(schedule, 1, 59);
+    TEST_ASSERT_EQUAL(1, txScheduleDue(schedule, 1, 59, due_ids));
+    TEST_ASSERT_EQUAL_UINT32(69, schedule[0].next_due_ms);
+}
+
+/** 
+ * @test
+ * @brief Tests that encodeSensorsFrame dispatches to the conv2CAN function of each identifier
+ * [SwR-9] (@ref SwR-9), [SwR-10] (@ref SwR-10)
+ * \anchor test_encodeSensorsFrame_Dispatch
+ * [TC_SENSORS_014](@ref TC_SENSORS_014)
+*/
+void test_encodeSensorsFrame_Dispatch()
+{
+    sensors_input_data row = {
+        .relative_velocity = 108.0, .has_obstacle = 1, .obstacle_distance = 60.0, .brake_pedal = 1,
+        .accelerator_pedal = 0, .aeb_system_enabled = 1, .reverse_enabled = 0, .relative_acceleration = -1.5};
+    can_msg expected[] = {
+        conv2CANCarClusterData(true),
+        conv2CANVelocityData(false, 108.0, -1.5),
+        conv2CANObstacleData(true, 60.0),
+        conv2CANPedalsData(true, false)};
+
+    for (int i = 0; i < 4; i++)
+    {
+        can_msg result = encodeSensorsFrame(expected[i].identifier, &row);
+        TEST_ASSERT_EQUAL_HEX32(expected[i].identifier, result.identifier);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(expected[i].dataFrame, result.dataFrame, 8);
+    }
+
+    TEST_ASSERT_EQUAL_HEX32(ID_EMPTY, encodeSensorsFrame(ID_AEB_S, &row).identifier);
+}
+
+
+/** 
+ * @test
+ * @brief Tests that values between two rows are interpolated and the distance is integrated
+ * [SwR-9] (@ref SwR-9), [SwR-10] (@ref SwR-10)
+ * \anchor test_interpolateSensorsData_Midpoint
+ * [TC_SENSORS_015](@ref TC_SENSORS_015)
+*/
+void test_interpolateSensorsData_Midpoint()
+{
+    sensors_input_data current = {
+        .relative_velocity = 36.0, .has_obstacle = 1, .obstacle_distance = 50.0, .brake_pedal = 1,
+        .accelerator_pedal = 0, .aeb_system_enabled = 1, .reverse_enabled = 0, .relative_acceleration = 2.0};
+    sensors_input_data next = {
+        .relative_velocity = 72.0, .has_obstacle = 0, .obstacle_distance = 10.0, .brake_pedal = 0,
+        .accelerator_pedal = 1, .aeb_system_enabled = 0, .reverse_enabled = 1, .relative_acceleration = -2.0};
+
+    sensors_input_data sample = interpolateSensorsData(&current, &next, 0.5, 1.0);
+
+    TEST_ASSERT_EQUAL_DOUBLE(54.0, sample.relative_velocity);
+    TEST_ASSERT_EQUAL_DOUBLE(0.0, sample.relative_acceleration);
+    // 50 - (36 / 3.6) * 0.5 - 0.5 * 2.0 * 0.25
+    TEST_ASSERT_EQUAL_DOUBLE(44.75, sample.obstacle_distance);
+    // Booleans are held from the current row
+    TEST_ASSERT_EQUAL_INT(1, sample.has_obstacle);
+    TEST_ASSERT_EQUAL_INT(1, sample.brake_pedal);
+    TEST_ASSERT_EQUAL_INT(0, sample.accelerator_pedal);
+    TEST_ASSERT_EQUAL_INT(1, sample.aeb_system_enabled);
+    TEST_ASSERT_EQUAL_INT(0, sample.reverse_enabled);
+}
+
+/** 
+ * @test
+ * @brief Tests the start of an interval, the last row and the distance limits of the interpolation
+ * [SwR-9] (@ref SwR-9), [SwR-10] (@ref SwR-10)
+ * \anchor test_interpolateSensorsData_Limits
+ * [TC_SENSORS_016](@ref TC_SENSORS_016)
+*/
+void test_interpolateSensorsData_Limits()
+{
+    sensors_input_data current = {
+        .relative_velocity = 108.0, .has_obstacle = 1, .obstacle_distance = 20.0, .relative_acceleration = 0.0};
+    sensors_input_data next = {
+        .relative_velocity = 0.0, .has_obstacle = 1, .obstacle_distance = 0.0, .relative_acceleration = 0.0};
+
+    // At the start of the interval the current row is sent unchanged
+    sensors_input_data sample = interpolateSensorsData(&current, &next, 0.0, 1.0);
+    TEST_ASSERT_EQUAL_DOUBLE(108.0, sample.relative_velocity);
+    TEST_ASSERT_EQUAL_DOUBLE(20.0, sample.obstacle_distance);
+
+    // Without a next row the velocity is held, and the distance never goes below zero
+    sample = interpolateSensorsData(&current, NULL, 0.9, 1.0);
+    TEST_ASSERT_EQUAL_DOUBLE(108.0, sample.relative_velocity);
+    TEST_ASSERT_EQUAL_DOUBLE(0.0, sample.obstacle_distance);
+
+    // An obstacle moving away never goes above the Obstacle frame maximum
+    current.obstacle_distance = 299.0;
+    current.relative_velocity = -36.0;
+    sample = interpolateSensorsData(&current, NULL, 0.5, 1.0);
+    TEST_ASSERT_EQUAL_DOUBLE(MAX_OBSTACLE_S, sample.obstacle_distance);
+}
+
+
+// Rows covering both acceleration signs, negative zero, out-of-DBC-range values and a tail
+// that doesn't fill a whole batch
+sensors_input_data batch_rows[] = {
+    {.relative_velocity = 108.0, .has_obstacle = 1, .obstacle_distance = 60.0, .reverse_enabled = 0, .relative_acceleration = 0.0},
+    {.relative_velocity = 100.0, .has_obstacle = 1, .obstacle_distance = 50.0, .reverse_enabled = 0, .relative_acceleration = -1.999},
+    {.relative_velocity = 200.0, .has_obstacle = 0, .obstacle_distance = 30.0, .reverse_enabled = 1, .relative_acceleration = -12.523},
+    {.relative_velocity = 251.0, .has_obstacle = 1, .obstacle_distance = 300.0, .reverse_enabled = 0, .relative_acceleration = 9.1234},
+    {.relative_velocity = 0.0, .has_obstacle = 1, .obstacle_distance = 0.0, .reverse_enabled = 2, .relative_acceleration = -0.0},
+    {.relative_velocity = 12.34, .has_obstacle = 3, .obstacle_distance = 12.34, .reverse_enabled = 0, .relative_acceleration = 13.3},
+    {.relative_velocity = 59.99, .has_obstacle = 1, .obstacle_distance = 0.05, .reverse_enabled = 1, .relative_acceleration = 12.5}};
+#define BATCH_ROWS (sizeof(batch_rows) / sizeof(batch_rows[0]))
+
+/** 
+ * @test
+ * @brief Tests that the batch Speed encoder gives the same frames as conv2CANVelocityData
+ * [SwR-10] (@ref SwR-10)
+ * \anchor test_conv2CANVelocityDataBatch_MatchesScalar
+ * [TC_SENSORS_017](@ref TC_SENSORS_017)
+*/
+void test_conv2CANVelocityDataBatch_MatchesScalar()
+{
+    can_msg batch[BATCH_ROWS];
+    conv2CANVelocityDataBatch(batch_rows, BATCH_ROWS, batch);
+
+    for (size_t i = 0; i < BATCH_ROWS; i++)
+    {
+        can_msg scalar = conv2CANVelocityData(batch_rows[i].reverse_enabled, batch_rows[i].relative_velocity,
+                                              batch_rows[i].relative_acceleration);
+        TEST_ASSERT_EQUAL_HEX32(scalar.identifier, batch[i].identifier);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(scalar.dataFrame, batch[i].dataFrame, 8);
+    }
+}
+
+/** 
+ * @test
+ * @brief Tests that the batch Obstacle encoder gives the same frames as conv2CANObstacleData
+ * [SwR-10] (@ref SwR-10)
+ * \anchor test_conv2CANObstacleDataBatch_MatchesScalar
+ * [TC_SENSORS_018](@ref TC_SENSORS_018)
+*/
+void test_conv2CANObstacleDataBatch_MatchesScalar()
+{
+    can_msg batch[BATCH_ROWS];
+    conv2CANObstacleDataBatch(batch_rows, BATCH_ROWS, batch);
+
+    for (size_t i = 0; i < BATCH_ROWS; i++)
+    {
+        can_msg scalar = conv2CANObstacleData(batch_rows[i].has_obstacle, batch_rows[i].obstacle_distance);
+        TEST_ASSERT_EQUAL_HEX32(scalar.identifier, batch[i].identifier);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(scalar.dataFrame, batch[i].dataFrame, 8);
+    }
+}
+
+/**
+ * @brief Helper function, fetches the rows of replay_rows one by one (source: index of the next row).
+ */
+static sensors_input_data replay_rows[2] = {
+    {.relative_velocity = 20.0, .aeb_system_enabled = true},
+    {.relative_velocity = 40.0, .aeb_system_enabled = true}};
+
+static bool nextReplayRow(void *source, sensors_input_data *row)
+{
+    size_t *next = source;
+    if (*next == sizeof(replay_rows) / sizeof(replay_rows[0]))
+        return false;
+    *row = replay_rows[(*next)++];
+    return true;
+}
+
+/** 
+ * @test
+ * @brief Tests that the scenario replay sends every frame of a row at its start, interpolates within
+ * the row interval, advances the rows and ends after the interval of the last row
+ * [SwR-9] (@ref SwR-9), [SwR-10] (@ref SwR-10)
+ * \anchor test_sensorsStep_Replay
+ * [TC_SENSORS_019](@ref TC_SENSORS_019)
+*/
+void test_sensorsStep_Replay()
+{
+    sensors_replay replay;
+    can_msg frames[SENSORS_TX_FRAMES];
+    size_t next = 0;
+
+    sensorsReplayStart(&replay, nextReplayRow, &next);
+    TEST_ASSERT_EQUAL_UINT(SCENARIO_ROW_PERIOD_MS, replay.tick_ms);
+
+    TEST_ASSERT_EQUAL(SENSORS_TX_FRAMES, sensorsStep(&replay, 0, frames));
+    TEST_ASSERT_EQUAL_HEX32(ID_CAR_C, frames[0].identifier);
+    TEST_ASSERT_EQUAL_HEX32(ID_SPEED_S, frames[1].identifier);
+    TEST_ASSERT_EQUAL_HEX32(ID_OBSTACLE_S, frames[2].identifier);
+    TEST_ASSERT_EQUAL_HEX32(ID_PEDALS, frames[3].identifier);
+    can_msg expected = conv2CANVelocityData(false, 20.0, 0.0);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected.dataFrame, frames[1].dataFrame, 8);
+
+    TEST_ASSERT_EQUAL(0, sensorsStep(&replay, SCENARIO_ROW_PERIOD_MS / 2, frames)); // Nothing due
+
+    TEST_ASSERT_EQUAL(SENSORS_TX_FRAMES, sensorsStep(&replay, SCENARIO_ROW_PERIOD_MS, frames));
+    expected = conv2CANVelocityData(false, 40.0, 0.0); // Second row, held: there is no next row
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected.dataFrame, frames[1].dataFrame, 8);
+    TEST_ASSERT_TRUE(replay.has_row);
+
+    TEST_ASSERT_EQUAL(0, sensorsStep(&replay, 2 * SCENARIO_ROW_PERIOD_MS, frames));
+    TEST_ASSERT_FALSE(replay.has_row);
+}
+
 int main()
 {
     UNITY_BEGIN();
@@ -254,6 +536,15 @@ int main()
     RUN_TEST(test_conv2CANPedalsData_BrakeOnly);
     RUN_TEST(test_conv2CANPedalsData_AcceleratorOnly);
     RUN_TEST(test_conv2CANPedalsData_NoneActive);
+    RUN_TEST(test_txScheduleTick_Gcd);
+    RUN_TEST(test_txScheduleDue_Periods);
+    RUN_TEST(test_txScheduleDue_LateTick);
+    RUN_TEST(test_encodeSensorsFrame_Dispatch);
+    RUN_TEST(test_interpolateSensorsData_Midpoint);
+    RUN_TEST(test_interpolateSensorsData_Limits);
+    RUN_TEST(test_conv2CANVelocityDataBatch_MatchesScalar);
+    RUN_TEST(test_conv2CANObstacleDataBatch_MatchesScalar);
+    RUN_TEST(test_sensorsStep_Replay);
     return UNITY_END();
 
 }
\ No newline at end of file
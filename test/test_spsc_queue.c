@@ -0,0 +1,143 @@
+#include "unity.h"
+#include "spsc_queue.h"
+#include "dbc.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+
+#define TEST_STREAM_LENGTH 100000
+
+spsc_queue queue;
+
+void setUp()
+{
+    // Each test initializes the queue with the capacity it needs
+}
+
+void tearDown()
+{
+    spsc_destroy(&queue);
+}
+
+/**
+ * @test
+ * @brief Tests that the queue only accepts power of two capacities.
+ *
+ * \anchor test_spsc_init_invalid_capacity
+ * test ID [TC_SPSC_001](@ref TC_SPSC_001)
+ */
+void test_spsc_init_invalid_capacity()
+{
+    TEST_ASSERT_EQUAL(-1, spsc_init(&queue, 0, sizeof(int)));
+    TEST_ASSERT_EQUAL(-1, spsc_init(&queue, 3, sizeof(int)));
+    TEST_ASSERT_EQUAL(0, spsc_init(&queue, 4, sizeof(int)));
+    TEST_ASSERT_EQUAL(0, spsc_size(&queue));
+}
+
+/**
+ * @test
+ * @brief Tests that elements come out in FIFO order and that pop fails on an empty queue.
+ *
+ * \anchor test_spsc_push_pop_order
+ * test ID [TC_SPSC_002](@ref TC_SPSC_002)
+ */
+void test_spsc_push_pop_order()
+{
+    int value;
+    spsc_init(&queue, 4, sizeof(int));
+
+    TEST_ASSERT_EQUAL(-1, spsc_pop(&queue, &value));
+    for (int i = 1; i <= 3; i++)
+    {
+        TEST_ASSERT_EQUAL(0, spsc_push(&queue, &i));
+    }
+    TEST_ASSERT_EQUAL(3, spsc_size(&queue));
+
+    for (int i = 1; i <= 3; i++)
+    {
+        TEST_ASSERT_EQUAL(0, spsc_pop(&queue, &value));
+        TEST_ASSERT_EQUAL(i, value);
+    }
+    TEST_ASSERT_EQUAL(-1, spsc_pop(&queue, &value));
+}
+
+/**
+ * @test
+ * @brief Tests that push fails when the queue is full and that slots are reused after wrapping around.
+ *
+ * \anchor test_spsc_full_and_wrap_around
+ * test ID [TC_SPSC_003](@ref TC_SPSC_003)
+ */
+void test_spsc_full_and_wrap_around()
+{
+    can_msg msg = {.identifier = ID_SPEED_S, .dataFrame = BASE_DATA_FRAME};
+    can_msg read;
+    spsc_init(&queue, 2, sizeof(can_msg));
+
+    for (int round = 0; round < 5; round++)
+    {
+        msg.dataFrame[0] = round;
+        TEST_ASSERT_EQUAL(0, spsc_push(&queue, &msg));
+        TEST_ASSERT_EQUAL(0, spsc_push(&queue, &msg));
+        TEST_ASSERT_EQUAL(-1, spsc_push(&queue, &msg));
+
+        TEST_ASSERT_EQUAL(0, spsc_pop(&queue, &read));
+        TEST_ASSERT_EQUAL(ID_SPEED_S, read.identifier);
+        TEST_ASSERT_EQUAL_UINT8(round, read.dataFrame[0]);
+        TEST_ASSERT_EQUAL(0, spsc_pop(&queue, &read));
+    }
+}
+
+void *producer_thread(void *arg)
+{
+    for (uint32_t i = 0; i < TEST_STREAM_LENGTH; i++)
+    {
+        while (spsc_push(&queue, &i) != 0)
+        {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @test
+ * @brief Tests that a producer and a consumer thread exchange a long stream without loss or reordering.
+ *
+ * \anchor test_spsc_two_threads
+ * test ID [TC_SPSC_004](@ref TC_SPSC_004)
+ */
+void test_spsc_two_threads()
+{
+    pthread_t producer;
+    uint32_t value;
+    uint32_t expected = 0;
+    spsc_init(&queue, 8, sizeof(uint32_t));
+
+    pthread_create(&producer, NULL, producer_thread, NULL);
+    while (expected < TEST_STREAM_LENGTH)
+    {
+        if (spsc_pop(&queue, &value) == 0)
+        {
+            TEST_ASSERT_EQUAL_UINT32(expected, value);
+            expected++;
+        }
+        else
+        {
+            sched_yield();
+        }
+    }
+    pthread_join(producer, NULL);
+
+    TEST_ASSERT_EQUAL(0, spsc_size(&queue));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_spsc_init_invalid_capacity);
+    RUN_TEST(test_spsc_push_pop_order);
+    RUN_TEST(test_spsc_full_and_wrap_around);
+    RUN_TEST(test_spsc_two_threads);
+    return UNITY_END();
+}